@@ -26,8 +26,20 @@ struct _CCSGSettingsBackendPrivate
     CCSIntegration *integration;
 
     CCSGNOMEValueChangeData *valueChangeData;
+
+    /* Keys changed since the last flush, in the order in which
+     * they first changed, deduplicated by pendingChangeKeys */
+    GQueue     pendingChanges;
+    GHashTable *pendingChangeKeys;
+    guint      pendingChangesSource;
 };
 
+typedef struct _CCSGSettingsPendingChange
+{
+    gchar *schemaName;
+    gchar *keyName;
+} CCSGSettingsPendingChange;
+
 static void
 ccsGSettingsWrapperDestroyNotify (gpointer o)
 {
@@ -74,6 +86,80 @@ ccsGSettingsGetExistingProfiles (CCSBackend *backend, CCSContext *context)
     return ret;
 }
 
+static void
+ccsGSettingsPendingChangeFree (gpointer data)
+{
+    CCSGSettingsPendingChange *change = (CCSGSettingsPendingChange *) data;
+
+    g_free (change->schemaName);
+    g_free (change->keyName);
+    g_free (change);
+}
+
+static void
+ccsGSettingsBackendClearPendingChanges (CCSGSettingsBackendPrivate *priv)
+{
+    if (priv->pendingChangesSource)
+    {
+	g_source_remove (priv->pendingChangesSource);
+	priv->pendingChangesSource = 0;
+    }
+
+    if (priv->pendingChangeKeys)
+	g_hash_table_remove_all (priv->pendingChangeKeys);
+
+    while (!g_queue_is_empty (&priv->pendingChanges))
+	ccsGSettingsPendingChangeFree (g_queue_pop_head (&priv->pendingChanges));
+}
+
+void
+ccsGSettingsBackendFlushPendingChanges (CCSBackend *backend)
+{
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+    CCSBackendInterface *backendInterface = (CCSBackendInterface *) GET_INTERFACE (CCSBackendInterface, backend);
+    GQueue              changes;
+
+    if (priv->pendingChangesSource)
+    {
+	g_source_remove (priv->pendingChangesSource);
+	priv->pendingChangesSource = 0;
+    }
+
+    /* Take the whole batch first, updating a setting may write keys
+     * and so queue up more changes for the next batch */
+    changes = priv->pendingChanges;
+    g_queue_init (&priv->pendingChanges);
+
+    if (priv->pendingChangeKeys)
+	g_hash_table_remove_all (priv->pendingChangeKeys);
+
+    while (!g_queue_is_empty (&changes))
+    {
+	CCSGSettingsPendingChange *change = (CCSGSettingsPendingChange *) g_queue_pop_head (&changes);
+
+	/* Wrappers don't outlive a profile change, so look the
+	 * settings object up again rather than keeping it around */
+	CCSGSettingsWrapper *wrapper = findCCSGSettingsWrapperBySchemaName (change->schemaName, priv->settingsList);
+
+	if (wrapper)
+	    updateSettingWithGSettingsKeyName (backend, wrapper, change->keyName, backendInterface->updateSetting);
+
+	ccsGSettingsPendingChangeFree (change);
+    }
+}
+
+static gboolean
+ccsGSettingsBackendFlushPendingChangesIdle (gpointer user_data)
+{
+    CCSBackend                 *backend = (CCSBackend *) user_data;
+    CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
+
+    priv->pendingChangesSource = 0;
+    ccsGSettingsBackendFlushPendingChanges (backend);
+
+    return FALSE;
+}
+
 void
 ccsGSettingsValueChanged (GSettings   *settings,
 			  gchar	      *keyName,
@@ -82,19 +168,37 @@ ccsGSettingsValueChanged (GSettings   *settings,
     CCSBackend   *backend = (CCSBackend *)user_data;
     GValue       schemaNameValue = G_VALUE_INIT;
     CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
-    CCSBackendInterface *backendInterface = (CCSBackendInterface *) GET_INTERFACE (CCSBackendInterface, backend);
-
 
     g_value_init (&schemaNameValue, G_TYPE_STRING);
     g_object_get_property (G_OBJECT (settings), "schema-id", &schemaNameValue);
 
     const char *schemaName = g_value_get_string (&schemaNameValue);
-    CCSGSettingsWrapper *wrapper = findCCSGSettingsWrapperBySchemaName (schemaName, priv->settingsList);
+    gchar      *changeKey = g_strconcat (schemaName, "/", keyName, NULL);
+
+    if (!priv->pendingChangeKeys)
+	priv->pendingChangeKeys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    /* Something like a dconf load or a profile switch changes lots
+     * of keys at once, so only note the change here and deliver
+     * each key once, with its latest value, when the main loop
+     * next goes idle */
+    if (!g_hash_table_contains (priv->pendingChangeKeys, changeKey))
+    {
+	CCSGSettingsPendingChange *change = g_new (CCSGSettingsPendingChange, 1);
+
+	change->schemaName = g_strdup (schemaName);
+	change->keyName = g_strdup (keyName);
+
+	g_queue_push_tail (&priv->pendingChanges, change);
+	g_hash_table_add (priv->pendingChangeKeys, changeKey);
+    }
+    else
+	g_free (changeKey);
 
     g_value_unset (&schemaNameValue);
 
-    if (wrapper)
-	updateSettingWithGSettingsKeyName (backend, wrapper, keyName, backendInterface->updateSetting);
+    if (!priv->pendingChangesSource)
+	priv->pendingChangesSource = g_idle_add (ccsGSettingsBackendFlushPendingChangesIdle, backend);
 }
 
 static CCSGSettingsWrapper *
@@ -289,6 +393,9 @@ ccsGSettingsBackendSetCurrentProfileDefault (CCSBackend *backend, const gchar *v
     if (priv->currentProfileSettings)
 	ccsGSettingsWrapperUnref (priv->currentProfileSettings);
 
+    /* The new profile gets read in full */
+    ccsGSettingsBackendClearPendingChanges (priv);
+
     g_list_free_full (priv->settingsList, ccsGSettingsWrapperDestroyNotify);
     priv->settingsList = NULL;
 
@@ -390,6 +497,11 @@ ccsGSettingsBackendDetachFromBackend (CCSBackend *backend)
 {
     CCSGSettingsBackendPrivate *priv = (CCSGSettingsBackendPrivate *) ccsObjectGetPrivate (backend);
 
+    ccsGSettingsBackendClearPendingChanges (priv);
+
+    if (priv->pendingChangeKeys)
+	g_hash_table_unref (priv->pendingChangeKeys);
+
     if (priv->currentProfile)
     {
 	free (priv->currentProfile);
@@ -22,6 +22,11 @@ ccsGSettingsBackendAttachNewToBackend (CCSBackend                 *backend,
 void
 ccsGSettingsBackendDetachFromBackend (CCSBackend *backend);
 
+/* Changed keys are queued up and delivered from an idle source,
+ * this delivers everything queued so far right away */
+void
+ccsGSettingsBackendFlushPendingChanges (CCSBackend *backend);
+
 /* Default implementations, should be moved */
 
 void
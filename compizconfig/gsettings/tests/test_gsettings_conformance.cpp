@@ -34,7 +34,9 @@
 #include <compizconfig_backend_concept_test.h>
 
 #include <gsettings_util.h>
+#include <ccs_gsettings_backend.h>
 #include <ccs_gsettings_backend_interface.h>
+#include <ccs_gsettings_interface.h>
 
 #include "gtest_shared_autodestroy.h"
 #include "test_gsettings_tests.h"
@@ -43,8 +45,10 @@
 #include "compizconfig_ccs_integration_mock.h"
 
 using ::testing::AtLeast;
+using ::testing::ElementsAre;
 using ::testing::Pointee;
 using ::testing::ReturnNull;
+using ::testing::StrEq;
 
 namespace cci = compiz::config::impl;
 
@@ -288,6 +292,20 @@ class CCSGSettingsBackendEnv :
 	    return false;
 	}
 
+	/* Behave as though GSettings told us that the key for
+	 * setting in the mock plugin changed */
+	void ChangeKeyForSetting (const std::string &setting)
+	{
+	    CharacterWrapper keyName (translateKeyForGSettings (setting.c_str ()));
+
+	    ccsGSettingsValueChanged (ccsGSettingsWrapperGetGSettings (mSettings), keyName, mGSettingsBackend);
+	}
+
+	CCSBackend * GetGSettingsBackend ()
+	{
+	    return mGSettingsBackend;
+	}
+
 	void WriteBoolAtKey (const std::string &plugin,
 			     const std::string &key,
 			     const VariantTypes &value)
@@ -447,6 +465,117 @@ class CCSGSettingsBackendEnv :
 
 const std::string CCSGSettingsBackendEnv::profileName = "mock";
 
+namespace
+{
+    std::vector <std::string> updatedSettings;
+
+    void recordUpdatedSetting (CCSBackend *backend,
+			       CCSContext *context,
+			       CCSPlugin  *plugin,
+			       CCSSetting *setting)
+    {
+	updatedSettings.push_back (ccsSettingGetName (setting));
+    }
+
+    const std::string pluginName ("mock");
+    const std::string integerSettingName ("integer_setting");
+    const std::string booleanSettingName ("boolean_setting");
+    const std::string floatSettingName ("float_setting");
+}
+
+class CCSGSettingsBackendChangeDeliveryTest :
+    public CCSBackendConformanceSpawnObjectsTestFixtureBase,
+    public ::testing::Test
+{
+    public:
+
+	virtual void SetUp ()
+	{
+	    SetupContext ();
+	    mBackend = mEnv.BackendSetUp (context.get (), gmockContext);
+
+	    SpawnPlugin (pluginName, context, plugin);
+	    gmockPlugin = (CCSPluginGMock *) ccsObjectGetPrivate (plugin.get ());
+
+	    SpawnSettingToUpdate (integerSettingName, TypeInt, integerSetting);
+	    SpawnSettingToUpdate (booleanSettingName, TypeBool, booleanSetting);
+	    SpawnSettingToUpdate (floatSettingName, TypeFloat, floatSetting);
+
+	    ON_CALL (*gmockContext, findPlugin (StrEq (pluginName))).WillByDefault (Return (plugin.get ()));
+
+	    /* Record the order in which the backend updates settings */
+	    CCSBackendInterface *backendInterface = GET_INTERFACE (CCSBackendInterface, mEnv.GetGSettingsBackend ());
+
+	    mUpdateSetting = backendInterface->updateSetting;
+	    backendInterface->updateSetting = recordUpdatedSetting;
+	    updatedSettings.clear ();
+	}
+
+	virtual void TearDown ()
+	{
+	    GET_INTERFACE (CCSBackendInterface, mEnv.GetGSettingsBackend ())->updateSetting = mUpdateSetting;
+	    mEnv.BackendTearDown (mBackend);
+	}
+
+    protected:
+
+	void SpawnSettingToUpdate (const std::string              &name,
+				   CCSSettingType                 type,
+				   boost::shared_ptr <CCSSetting> &setting)
+	{
+	    SpawnSetting (name, type, plugin, setting);
+	    ON_CALL (*gmockPlugin, findSetting (StrEq (name))).WillByDefault (Return (setting.get ()));
+	}
+
+	void RunMainLoop ()
+	{
+	    while (g_main_context_iteration (NULL, FALSE));
+	}
+
+	CCSGSettingsBackendEnv         mEnv;
+	CCSBackendUpdateFunc           mUpdateSetting;
+	boost::shared_ptr <CCSPlugin>  plugin;
+	CCSPluginGMock                 *gmockPlugin;
+	boost::shared_ptr <CCSSetting> integerSetting;
+	boost::shared_ptr <CCSSetting> booleanSetting;
+	boost::shared_ptr <CCSSetting> floatSetting;
+};
+
+TEST_F (CCSGSettingsBackendChangeDeliveryTest, TestChangesDeliveredOnceEachInOrderOfFirstChange)
+{
+    mEnv.ChangeKeyForSetting (floatSettingName);
+    mEnv.ChangeKeyForSetting (integerSettingName);
+    mEnv.ChangeKeyForSetting (floatSettingName);
+    mEnv.ChangeKeyForSetting (booleanSettingName);
+    mEnv.ChangeKeyForSetting (integerSettingName);
+
+    /* Nothing happens until the main loop runs */
+    EXPECT_TRUE (updatedSettings.empty ());
+
+    RunMainLoop ();
+
+    EXPECT_THAT (updatedSettings, ElementsAre (floatSettingName,
+					       integerSettingName,
+					       booleanSettingName));
+}
+
+TEST_F (CCSGSettingsBackendChangeDeliveryTest, TestChangesAfterFlushAreDeliveredInNextBatch)
+{
+    mEnv.ChangeKeyForSetting (booleanSettingName);
+    ccsGSettingsBackendFlushPendingChanges (mEnv.GetGSettingsBackend ());
+
+    EXPECT_THAT (updatedSettings, ElementsAre (booleanSettingName));
+
+    mEnv.ChangeKeyForSetting (integerSettingName);
+    mEnv.ChangeKeyForSetting (booleanSettingName);
+
+    RunMainLoop ();
+
+    EXPECT_THAT (updatedSettings, ElementsAre (booleanSettingName,
+					       integerSettingName,
+					       booleanSettingName));
+}
+
 INSTANTIATE_TEST_CASE_P (CCSGSettingsBackendConcept, CCSBackendConformanceTestReadWrite,
 			 compizconfig::test::GenerateTestingParametersForBackendInterface <CCSGSettingsBackendEnv> ());
 
@@ -930,6 +930,22 @@ Bool ccsStringToColor (const char           *value,
 void ccsProcessEvents (CCSContext   *context,
 		       unsigned int flags);
 
+/* Writes plugin metadata read from XML since the last call out to the
+   metadata cache. Done by ccsProcessEvents and when a context is freed,
+   callers loading the settings of many plugins at once can call it
+   once they are done */
+void ccsSyncMetadataCache (void);
+
+/* Called when a context's list of changed settings stops being empty,
+   so that changes can be picked up from the caller's main loop instead
+   of by polling ccsContextGetChangedSettings */
+typedef void (*CCSChangedSettingsNotifyProc) (CCSContext *context,
+					      void       *closure);
+
+void ccsSetChangedSettingsNotify (CCSContext                   *context,
+				  CCSChangedSettingsNotifyProc notify,
+				  void                         *closure);
+
 /* Read all setting values from disk */
 void ccsReadSettings (CCSContext *context);
 
@@ -968,23 +984,16 @@ void ccsRemoveFileWatch (unsigned int watchId);
 void ccsDisableFileWatch (unsigned int watchId);
 void ccsEnableFileWatch (unsigned int watchId);
 
+/* Returns the descriptor that becomes readable when a watched file
+   changes, or -1 if nothing is being watched. ccsProcessEvents
+   dispatches the watch callbacks. */
+int ccsGetFileWatchFd (void);
+
 /* INI file stuff
  * FIXME: This should not be part of the
  * public API */
 
-typedef struct _dictionary_
-{
-    /** Number of entries in dictionary */
-    int n;
-    /** Storage size */
-    int size;
-    /** List of string values */
-    char **val;
-    /** List of string keys */
-    char **key ;
-    /** List of hash values for keys */
-    unsigned *hash;
-} IniDictionary;
+typedef struct _dictionary_ IniDictionary;
 
 IniDictionary* ccsIniNew (void);
 IniDictionary* ccsIniOpen (const char *fileName);
@@ -53,6 +53,8 @@ typedef struct _CCSContextPrivate
 
     CCSSettingList    changedSettings; /* list of settings changed since last
                                           settings write */
+    CCSChangedSettingsNotifyProc changedSettingsNotify;
+    void                         *changedSettingsNotifyClosure;
 
     unsigned int screenNum; /* screen number this context is assigned to */
     const CCSInterfaceTable *object_interfaces;
@@ -93,7 +95,7 @@ typedef struct _CCSPluginPrivate
     char *	   xmlFile;
     char *	   xmlPath;
 #ifdef USE_PROTOBUF
-    char *	   pbFilePath;
+    Bool	   cachedMetadata; /* brief metadata is in the cache */
 #endif
 
     CCSStrExtensionList stringExtensions;
@@ -0,0 +1,644 @@
+/*
+ * Compiz configuration system library
+ *
+ * ccs_metadata_cache.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "ccs_metadata_cache.h"
+
+#define CACHE_MAGIC		"CCSMETA"
+#define CACHE_FORMAT_VERSION	1
+#define CACHE_ALIGNMENT		8
+
+typedef struct _CCSMetadataCacheHeader
+{
+    char     magic[8];
+    uint32_t format;
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t stringsOffset;
+    uint32_t stringsSize;
+    uint32_t size;
+} CCSMetadataCacheHeader;
+
+typedef struct _CCSMetadataCacheEntry
+{
+    uint32_t keyOffset;
+    uint32_t padding;
+    int64_t  mtime;
+    uint64_t sourceSize;
+    uint32_t recordOffset[CCSMetadataCacheNumRecords];
+    uint32_t recordSize[CCSMetadataCacheNumRecords];
+} CCSMetadataCacheEntry;
+
+typedef struct _CCSMetadataCachePending
+{
+    char     *key;
+    int64_t  mtime;
+    uint64_t sourceSize;
+    void     *record[CCSMetadataCacheNumRecords];
+    size_t   recordSize[CCSMetadataCacheNumRecords];
+    Bool     hasRecord[CCSMetadataCacheNumRecords];
+} CCSMetadataCachePending;
+
+struct _CCSMetadataCache
+{
+    char         *path;
+    unsigned int version;
+
+    void                        *map;
+    size_t                      mapSize;
+    const CCSMetadataCacheEntry *entries;
+    unsigned int                numEntries;
+    const char                  *strings;
+
+    CCSMetadataCachePending *pending;
+    unsigned int            numPending;
+};
+
+static size_t
+align (size_t offset)
+{
+    return (offset + CACHE_ALIGNMENT - 1) & ~((size_t) CACHE_ALIGNMENT - 1);
+}
+
+static Bool
+stampMatches (int64_t mtime, uint64_t size, const struct stat *source)
+{
+    return mtime == (int64_t) source->st_mtime &&
+	   size == (uint64_t) source->st_size;
+}
+
+static void
+unmapImage (CCSMetadataCache *cache)
+{
+    if (cache->map)
+	munmap (cache->map, cache->mapSize);
+
+    cache->map        = NULL;
+    cache->mapSize    = 0;
+    cache->entries    = NULL;
+    cache->numEntries = 0;
+    cache->strings    = NULL;
+}
+
+static Bool
+validImage (const CCSMetadataCache *cache, const void *map, size_t size)
+{
+    const CCSMetadataCacheHeader *header = (const CCSMetadataCacheHeader *) map;
+    const CCSMetadataCacheEntry  *entries;
+    const char                   *strings;
+    unsigned int                 i, r;
+
+    if (size < sizeof (CCSMetadataCacheHeader) ||
+	memcmp (header->magic, CACHE_MAGIC, sizeof (header->magic)) ||
+	header->format != CACHE_FORMAT_VERSION ||
+	header->version != cache->version ||
+	header->size != size)
+	return FALSE;
+
+    if ((size - sizeof (CCSMetadataCacheHeader)) / sizeof (CCSMetadataCacheEntry) <
+	header->numEntries)
+	return FALSE;
+
+    if (header->stringsOffset > size ||
+	header->stringsSize > size - header->stringsOffset ||
+	(header->stringsSize && ((const char *) map)[header->stringsOffset +
+						     header->stringsSize - 1]))
+	return FALSE;
+
+    entries = (const CCSMetadataCacheEntry *) (header + 1);
+    strings = (const char *) map + header->stringsOffset;
+
+    for (i = 0; i < header->numEntries; ++i)
+    {
+	if (entries[i].keyOffset >= header->stringsSize)
+	    return FALSE;
+
+	/* The manifest is searched by bisection */
+	if (i && strcmp (strings + entries[i - 1].keyOffset,
+			 strings + entries[i].keyOffset) >= 0)
+	    return FALSE;
+
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	    if (entries[i].recordOffset[r] > size ||
+		entries[i].recordSize[r] > size - entries[i].recordOffset[r])
+		return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+mapImage (CCSMetadataCache *cache)
+{
+    struct stat st;
+    void        *map;
+    int         fd = open (cache->path, O_RDONLY);
+
+    if (fd == -1)
+	return;
+
+    if (fstat (fd, &st) || !st.st_size)
+    {
+	close (fd);
+	return;
+    }
+
+    map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close (fd);
+
+    if (map == MAP_FAILED)
+	return;
+
+    if (!validImage (cache, map, st.st_size))
+    {
+	munmap (map, st.st_size);
+	return;
+    }
+
+    cache->map        = map;
+    cache->mapSize    = st.st_size;
+    cache->entries    = (const CCSMetadataCacheEntry *)
+			((const CCSMetadataCacheHeader *) map + 1);
+    cache->numEntries = ((const CCSMetadataCacheHeader *) map)->numEntries;
+    cache->strings    = (const char *) map +
+			((const CCSMetadataCacheHeader *) map)->stringsOffset;
+}
+
+static const CCSMetadataCacheEntry *
+findEntry (const CCSMetadataCache *cache, const char *key)
+{
+    unsigned int low = 0, high = cache->numEntries;
+
+    while (low < high)
+    {
+	unsigned int middle = low + (high - low) / 2;
+	int          cmp    = strcmp (key, cache->strings +
+					   cache->entries[middle].keyOffset);
+
+	if (!cmp)
+	    return &cache->entries[middle];
+
+	if (cmp < 0)
+	    high = middle;
+	else
+	    low = middle + 1;
+    }
+
+    return NULL;
+}
+
+static CCSMetadataCachePending *
+findPending (const CCSMetadataCache *cache, const char *key)
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->numPending; ++i)
+	if (!strcmp (cache->pending[i].key, key))
+	    return &cache->pending[i];
+
+    return NULL;
+}
+
+static void
+freePending (CCSMetadataCache *cache)
+{
+    unsigned int i, r;
+
+    for (i = 0; i < cache->numPending; ++i)
+    {
+	free (cache->pending[i].key);
+
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	    free (cache->pending[i].record[r]);
+    }
+
+    free (cache->pending);
+
+    cache->pending    = NULL;
+    cache->numPending = 0;
+}
+
+CCSMetadataCache *
+ccsMetadataCacheOpen (const char *path, unsigned int version)
+{
+    CCSMetadataCache *cache = (CCSMetadataCache *) calloc (1, sizeof (CCSMetadataCache));
+
+    if (!cache)
+	return NULL;
+
+    cache->path    = strdup (path);
+    cache->version = version;
+
+    if (!cache->path)
+    {
+	free (cache);
+	return NULL;
+    }
+
+    mapImage (cache);
+
+    return cache;
+}
+
+void
+ccsMetadataCacheFree (CCSMetadataCache *cache)
+{
+    if (!cache)
+	return;
+
+    unmapImage (cache);
+    freePending (cache);
+    free (cache->path);
+    free (cache);
+}
+
+Bool
+ccsMetadataCacheLookup (CCSMetadataCache       *cache,
+			const char             *key,
+			const struct stat      *source,
+			CCSMetadataCacheRecord record,
+			const void             **data,
+			size_t                 *size)
+{
+    const CCSMetadataCachePending *pending = findPending (cache, key);
+    const CCSMetadataCacheEntry   *entry;
+
+    if (pending && stampMatches (pending->mtime, pending->sourceSize, source))
+    {
+	if (pending->hasRecord[record])
+	{
+	    *data = pending->record[record];
+	    *size = pending->recordSize[record];
+
+	    return TRUE;
+	}
+    }
+    else if (pending)
+	return FALSE;
+
+    entry = findEntry (cache, key);
+
+    if (!entry || !entry->recordSize[record] ||
+	!stampMatches (entry->mtime, entry->sourceSize, source))
+	return FALSE;
+
+    *data = (const char *) cache->map + entry->recordOffset[record];
+    *size = entry->recordSize[record];
+
+    return TRUE;
+}
+
+Bool
+ccsMetadataCacheUpdate (CCSMetadataCache       *cache,
+			const char             *key,
+			const struct stat      *source,
+			CCSMetadataCacheRecord record,
+			const void             *data,
+			size_t                 size)
+{
+    CCSMetadataCachePending *pending = findPending (cache, key);
+    void                    *copy;
+    unsigned int            r;
+
+    if (!size || size > UINT32_MAX)
+	return FALSE;
+
+    copy = malloc (size);
+
+    if (!copy)
+	return FALSE;
+
+    memcpy (copy, data, size);
+
+    if (!pending)
+    {
+	CCSMetadataCachePending *grown =
+	    (CCSMetadataCachePending *) realloc (cache->pending,
+						 (cache->numPending + 1) *
+						 sizeof (CCSMetadataCachePending));
+
+	if (!grown)
+	{
+	    free (copy);
+	    return FALSE;
+	}
+
+	cache->pending = grown;
+	pending = &cache->pending[cache->numPending];
+	memset (pending, 0, sizeof (CCSMetadataCachePending));
+
+	pending->key        = strdup (key);
+	pending->mtime      = source->st_mtime;
+	pending->sourceSize = source->st_size;
+
+	if (!pending->key)
+	{
+	    free (copy);
+	    return FALSE;
+	}
+
+	++cache->numPending;
+    }
+    else if (!stampMatches (pending->mtime, pending->sourceSize, source))
+    {
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	{
+	    free (pending->record[r]);
+
+	    pending->record[r]    = NULL;
+	    pending->recordSize[r] = 0;
+	    pending->hasRecord[r] = FALSE;
+	}
+
+	pending->mtime      = source->st_mtime;
+	pending->sourceSize = source->st_size;
+    }
+
+    free (pending->record[record]);
+
+    pending->record[record]     = copy;
+    pending->recordSize[record] = size;
+    pending->hasRecord[record]  = TRUE;
+
+    return TRUE;
+}
+
+/* An entry of the image being written, pointing either into the
+ * mapping or at a pending update */
+typedef struct _CCSMetadataCacheOutput
+{
+    const char *key;
+    int64_t    mtime;
+    uint64_t   sourceSize;
+    const void *record[CCSMetadataCacheNumRecords];
+    size_t     recordSize[CCSMetadataCacheNumRecords];
+} CCSMetadataCacheOutput;
+
+static int
+compareOutput (const void *a, const void *b)
+{
+    return strcmp (((const CCSMetadataCacheOutput *) a)->key,
+		   ((const CCSMetadataCacheOutput *) b)->key);
+}
+
+static Bool
+sourceUnchanged (const char *key, int64_t mtime, uint64_t size)
+{
+    struct stat source;
+
+    return !stat (key, &source) && stampMatches (mtime, size, &source);
+}
+
+static unsigned int
+collectOutput (CCSMetadataCache *cache, CCSMetadataCacheOutput *output)
+{
+    unsigned int num = 0;
+    unsigned int i, r;
+
+    for (i = 0; i < cache->numPending; ++i)
+    {
+	const CCSMetadataCachePending *pending = &cache->pending[i];
+	const CCSMetadataCacheEntry   *entry   = findEntry (cache, pending->key);
+	CCSMetadataCacheOutput        *out     = &output[num++];
+
+	out->key        = pending->key;
+	out->mtime      = pending->mtime;
+	out->sourceSize = pending->sourceSize;
+
+	/* Records which were not updated are kept from the image if
+	 * they were generated from the same source */
+	if (entry && entry->mtime == pending->mtime &&
+	    entry->sourceSize == pending->sourceSize)
+	{
+	    for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	    {
+		out->record[r]     = (const char *) cache->map + entry->recordOffset[r];
+		out->recordSize[r] = entry->recordSize[r];
+	    }
+	}
+
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	{
+	    if (pending->hasRecord[r])
+	    {
+		out->record[r]     = pending->record[r];
+		out->recordSize[r] = pending->recordSize[r];
+	    }
+	}
+    }
+
+    for (i = 0; i < cache->numEntries; ++i)
+    {
+	const CCSMetadataCacheEntry *entry = &cache->entries[i];
+	const char                  *key   = cache->strings + entry->keyOffset;
+	CCSMetadataCacheOutput      *out;
+
+	if (findPending (cache, key) ||
+	    !sourceUnchanged (key, entry->mtime, entry->sourceSize))
+	    continue;
+
+	out = &output[num++];
+
+	out->key        = key;
+	out->mtime      = entry->mtime;
+	out->sourceSize = entry->sourceSize;
+
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	{
+	    out->record[r]     = (const char *) cache->map + entry->recordOffset[r];
+	    out->recordSize[r] = entry->recordSize[r];
+	}
+    }
+
+    qsort (output, num, sizeof (CCSMetadataCacheOutput), compareOutput);
+
+    return num;
+}
+
+static Bool
+writePadding (FILE *file, size_t *offset)
+{
+    static const char zeros[CACHE_ALIGNMENT] = { 0 };
+    size_t            padding = align (*offset) - *offset;
+
+    *offset += padding;
+
+    return fwrite (zeros, 1, padding, file) == padding;
+}
+
+static Bool
+writeImage (FILE *file, unsigned int version,
+	    const CCSMetadataCacheOutput *output, unsigned int num)
+{
+    CCSMetadataCacheHeader header;
+    size_t                 offset, recordsOffset, stringsSize = 0;
+    unsigned int           i, r;
+
+    for (i = 0; i < num; ++i)
+	stringsSize += strlen (output[i].key) + 1;
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, CACHE_MAGIC, sizeof (header.magic));
+
+    header.format        = CACHE_FORMAT_VERSION;
+    header.version       = version;
+    header.numEntries    = num;
+    header.stringsOffset = sizeof (header) + num * sizeof (CCSMetadataCacheEntry);
+    header.stringsSize   = stringsSize;
+
+    recordsOffset = align (header.stringsOffset + stringsSize);
+    offset        = recordsOffset;
+
+    for (i = 0; i < num; ++i)
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	    offset = align (offset + output[i].recordSize[r]);
+
+    if (offset > UINT32_MAX)
+	return FALSE;
+
+    header.size = offset;
+
+    if (fwrite (&header, sizeof (header), 1, file) != 1)
+	return FALSE;
+
+    offset      = recordsOffset;
+    stringsSize = 0;
+
+    for (i = 0; i < num; ++i)
+    {
+	CCSMetadataCacheEntry entry;
+
+	memset (&entry, 0, sizeof (entry));
+
+	entry.keyOffset  = stringsSize;
+	entry.mtime      = output[i].mtime;
+	entry.sourceSize = output[i].sourceSize;
+
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	{
+	    entry.recordOffset[r] = output[i].recordSize[r] ? offset : 0;
+	    entry.recordSize[r]   = output[i].recordSize[r];
+
+	    offset = align (offset + output[i].recordSize[r]);
+	}
+
+	stringsSize += strlen (output[i].key) + 1;
+
+	if (fwrite (&entry, sizeof (entry), 1, file) != 1)
+	    return FALSE;
+    }
+
+    for (i = 0; i < num; ++i)
+	if (fwrite (output[i].key, strlen (output[i].key) + 1, 1, file) != 1)
+	    return FALSE;
+
+    offset = header.stringsOffset + stringsSize;
+
+    for (i = 0; i < num; ++i)
+    {
+	for (r = 0; r < CCSMetadataCacheNumRecords; ++r)
+	{
+	    if (!writePadding (file, &offset))
+		return FALSE;
+
+	    if (output[i].recordSize[r] &&
+		fwrite (output[i].record[r], output[i].recordSize[r], 1, file) != 1)
+		return FALSE;
+
+	    offset += output[i].recordSize[r];
+	}
+    }
+
+    return writePadding (file, &offset);
+}
+
+Bool
+ccsMetadataCacheSync (CCSMetadataCache *cache)
+{
+    CCSMetadataCacheOutput *output;
+    unsigned int           num;
+    char                   *tmpPath;
+    FILE                   *file;
+    Bool                   success;
+    int                    fd;
+
+    if (!cache->numPending)
+	return TRUE;
+
+    output = (CCSMetadataCacheOutput *) calloc (cache->numPending + cache->numEntries,
+						sizeof (CCSMetadataCacheOutput));
+    if (!output)
+	return FALSE;
+
+    if (asprintf (&tmpPath, "%s.XXXXXX", cache->path) == -1)
+    {
+	free (output);
+	return FALSE;
+    }
+
+    num = collectOutput (cache, output);
+    fd  = mkstemp (tmpPath);
+    file = fd != -1 ? fdopen (fd, "wb") : NULL;
+
+    if (!file)
+    {
+	if (fd != -1)
+	{
+	    close (fd);
+	    unlink (tmpPath);
+	}
+
+	free (tmpPath);
+	free (output);
+
+	return FALSE;
+    }
+
+    success = writeImage (file, cache->version, output, num);
+    success = !fclose (file) && success;
+    free (output);
+
+    if (success)
+	success = !rename (tmpPath, cache->path);
+
+    if (!success)
+	unlink (tmpPath);
+
+    free (tmpPath);
+
+    /* Pending records were written out or could not be, either way
+     * the new image is what lookups go to from now on */
+    unmapImage (cache);
+    freePending (cache);
+    mapImage (cache);
+
+    return success;
+}
@@ -0,0 +1,92 @@
+/*
+ * Compiz configuration system library
+ *
+ * ccs_metadata_cache.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef CCS_METADATA_CACHE_H
+#define CCS_METADATA_CACHE_H
+
+#include <ccs-defs.h>
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+COMPIZCONFIG_BEGIN_DECLS
+
+/*
+ * A single memory-mapped image holding the cached metadata of every
+ * plugin, replacing one cache file per plugin.
+ *
+ * The image starts with a versioned header and a manifest of entries
+ * sorted by key. Every entry records the modification time and size
+ * of the source file it was generated from and the offsets of its
+ * records, keys are interned in a string table. Records are opaque to
+ * the cache, lookups return pointers straight into the mapping.
+ *
+ * Updates are kept in memory until ccsMetadataCacheSync, which writes
+ * a new image next to the old one and renames it into place, so other
+ * processes still mapping the old image are unaffected.
+ */
+
+typedef struct _CCSMetadataCache CCSMetadataCache;
+
+typedef enum _CCSMetadataCacheRecord
+{
+    CCSMetadataCacheBrief = 0,	/* plugin info, read for every plugin */
+    CCSMetadataCacheFull,	/* options, read when settings are loaded */
+    CCSMetadataCacheNumRecords
+} CCSMetadataCacheRecord;
+
+/* Maps the image at path. An image that is missing, damaged or was
+ * written with another version behaves as an empty cache and is
+ * replaced on the next sync. */
+CCSMetadataCache *
+ccsMetadataCacheOpen (const char *path, unsigned int version);
+
+void
+ccsMetadataCacheFree (CCSMetadataCache *cache);
+
+/* Finds the record for key if it was generated from a source file
+ * with the modification time and size in source. The data stays
+ * valid until the next sync or until the cache is freed. */
+Bool
+ccsMetadataCacheLookup (CCSMetadataCache       *cache,
+			const char             *key,
+			const struct stat      *source,
+			CCSMetadataCacheRecord record,
+			const void             **data,
+			size_t                 *size);
+
+/* Stores a copy of data as the record for key. Storing a record for
+ * a changed source file drops the other records of that key. */
+Bool
+ccsMetadataCacheUpdate (CCSMetadataCache       *cache,
+			const char             *key,
+			const struct stat      *source,
+			CCSMetadataCacheRecord record,
+			const void             *data,
+			size_t                 size);
+
+/* Writes out pending updates, dropping entries whose source files
+ * have since changed or disappeared. Does nothing if there are no
+ * pending updates. */
+Bool
+ccsMetadataCacheSync (CCSMetadataCache *cache);
+
+COMPIZCONFIG_END_DECLS
+
+#endif
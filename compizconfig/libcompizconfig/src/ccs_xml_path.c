@@ -0,0 +1,540 @@
+/*
+ * Compiz configuration system library
+ *
+ * ccs_xml_path.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "ccs_xml_path.h"
+
+typedef struct _CCSXmlNodeSet
+{
+    xmlNode **nodes;
+    int     num;
+    int     size;
+} CCSXmlNodeSet;
+
+typedef enum _CCSXmlAxis
+{
+    AxisChild,
+    AxisAncestor,
+    AxisAttribute
+} CCSXmlAxis;
+
+static Bool
+addNode (CCSXmlNodeSet *set, xmlNode *node)
+{
+    if (set->num == set->size)
+    {
+	int     size  = set->size ? set->size * 2 : 8;
+	xmlNode **nodes = (xmlNode **) realloc (set->nodes, size * sizeof (xmlNode *));
+
+	if (!nodes)
+	    return FALSE;
+
+	set->nodes = nodes;
+	set->size  = size;
+    }
+
+    set->nodes[set->num++] = node;
+
+    return TRUE;
+}
+
+static void
+freeNodeSet (CCSXmlNodeSet *set)
+{
+    free (set->nodes);
+
+    set->nodes = NULL;
+    set->num   = 0;
+    set->size  = 0;
+}
+
+static int
+nodeDepth (xmlNode *node)
+{
+    int depth = 0;
+
+    for (; node->parent; node = node->parent)
+	++depth;
+
+    return depth;
+}
+
+static int
+compareDocumentOrder (const void *a, const void *b)
+{
+    xmlNode *first  = *(xmlNode * const *) a;
+    xmlNode *second = *(xmlNode * const *) b;
+    int     firstDepth, secondDepth;
+    xmlNode *n;
+
+    if (first == second)
+	return 0;
+
+    firstDepth  = nodeDepth (first);
+    secondDepth = nodeDepth (second);
+
+    while (firstDepth > secondDepth)
+    {
+	first = first->parent;
+	--firstDepth;
+
+	if (first == second)
+	    return 1;
+    }
+
+    while (secondDepth > firstDepth)
+    {
+	second = second->parent;
+	--secondDepth;
+
+	if (first == second)
+	    return -1;
+    }
+
+    while (first->parent != second->parent)
+    {
+	first  = first->parent;
+	second = second->parent;
+    }
+
+    /* Attributes of an element come before its children */
+    if ((first->type == XML_ATTRIBUTE_NODE) != (second->type == XML_ATTRIBUTE_NODE))
+	return first->type == XML_ATTRIBUTE_NODE ? -1 : 1;
+
+    for (n = first->next; n; n = n->next)
+	if (n == second)
+	    return -1;
+
+    return 1;
+}
+
+/* Sorts into document order and drops duplicates */
+static void
+sortNodeSet (CCSXmlNodeSet *set)
+{
+    int i, j;
+
+    if (set->num < 2)
+	return;
+
+    qsort (set->nodes, set->num, sizeof (xmlNode *), compareDocumentOrder);
+
+    for (i = 1, j = 1; i < set->num; ++i)
+	if (set->nodes[i] != set->nodes[j - 1])
+	    set->nodes[j++] = set->nodes[i];
+
+    set->num = j;
+}
+
+static void
+skipSpace (const char **path)
+{
+    while (**path == ' ' || **path == '\t')
+	++*path;
+}
+
+static Bool
+skipToken (const char **path, const char *token)
+{
+    size_t length = strlen (token);
+
+    skipSpace (path);
+
+    if (strncmp (*path, token, length))
+	return FALSE;
+
+    *path += length;
+
+    return TRUE;
+}
+
+static size_t
+nameLength (const char *path)
+{
+    size_t length = 0;
+
+    while (path[length] &&
+	   (path[length] == '_' || path[length] == '-' ||
+	    path[length] == '.' ||
+	    (path[length] >= 'a' && path[length] <= 'z') ||
+	    (path[length] >= 'A' && path[length] <= 'Z') ||
+	    (path[length] >= '0' && path[length] <= '9')))
+	++length;
+
+    return length;
+}
+
+/* Reads 'literal', the quotes are not part of the result */
+static Bool
+readLiteral (const char **path, const char **literal, size_t *length)
+{
+    const char *end;
+
+    skipSpace (path);
+
+    if (**path != '\'')
+	return FALSE;
+
+    end = strchr (*path + 1, '\'');
+
+    if (!end)
+	return FALSE;
+
+    *literal = *path + 1;
+    *length  = end - *literal;
+    *path    = end + 1;
+
+    return TRUE;
+}
+
+static Bool
+nameEquals (const xmlChar *name, const char *test, size_t length)
+{
+    return name &&
+	   strlen ((const char *) name) == length &&
+	   !strncmp ((const char *) name, test, length);
+}
+
+/* As XPath lang (): the language of the node is lang, or a dialect
+ * of it */
+static Bool
+langMatches (xmlNode *node, const char *lang, size_t length)
+{
+    xmlChar *nodeLang = xmlNodeGetLang (node);
+    Bool    matches   = FALSE;
+
+    if (nodeLang)
+    {
+	matches = !strncasecmp ((const char *) nodeLang, lang, length) &&
+		  (nodeLang[length] == '\0' || nodeLang[length] == '-');
+	xmlFree (nodeLang);
+    }
+
+    return matches;
+}
+
+static Bool
+attributeEquals (xmlNode *node, const char *name, size_t nameLength,
+		 const char *value, size_t valueLength)
+{
+    xmlAttr *attr;
+
+    if (node->type != XML_ELEMENT_NODE)
+	return FALSE;
+
+    for (attr = node->properties; attr; attr = attr->next)
+    {
+	if (nameEquals (attr->name, name, nameLength))
+	{
+	    xmlChar *content = xmlNodeGetContent ((xmlNode *) attr);
+	    Bool    equals   = content &&
+			       strlen ((const char *) content) == valueLength &&
+			       !strncmp ((const char *) content, value, valueLength);
+
+	    xmlFree (content);
+
+	    return equals;
+	}
+    }
+
+    return FALSE;
+}
+
+#define MAX_PREDICATES 4
+
+typedef struct _CCSXmlPredicate
+{
+    Bool       lang;
+    const char *name;
+    size_t     nameLength;
+    const char *literal;
+    size_t     literalLength;
+} CCSXmlPredicate;
+
+/* Reads [lang ('x')] or [@name = 'x'], the opening bracket has
+ * already been consumed */
+static Bool
+readPredicate (const char **path, CCSXmlPredicate *predicate)
+{
+    memset (predicate, 0, sizeof (CCSXmlPredicate));
+
+    if (skipToken (path, "lang"))
+    {
+	predicate->lang = TRUE;
+
+	if (!skipToken (path, "(") ||
+	    !readLiteral (path, &predicate->literal, &predicate->literalLength) ||
+	    !skipToken (path, ")"))
+	    return FALSE;
+    }
+    else if (skipToken (path, "@"))
+    {
+	predicate->name       = *path;
+	predicate->nameLength = nameLength (*path);
+	*path                += predicate->nameLength;
+
+	if (!predicate->nameLength ||
+	    !skipToken (path, "=") ||
+	    !readLiteral (path, &predicate->literal, &predicate->literalLength))
+	    return FALSE;
+    }
+    else
+	return FALSE;
+
+    return skipToken (path, "]");
+}
+
+static Bool
+predicateMatches (const CCSXmlPredicate *predicate, xmlNode *node)
+{
+    if (predicate->lang)
+	return langMatches (node, predicate->literal, predicate->literalLength);
+
+    return attributeEquals (node, predicate->name, predicate->nameLength,
+			    predicate->literal, predicate->literalLength);
+}
+
+static Bool
+testNode (xmlNode *node, Bool text, const char *name, size_t length)
+{
+    if (text)
+	return node->type == XML_TEXT_NODE ||
+	       node->type == XML_CDATA_SECTION_NODE;
+
+    if (node->type != XML_ELEMENT_NODE &&
+	node->type != XML_ATTRIBUTE_NODE)
+	return FALSE;
+
+    return (length == 1 && *name == '*') || nameEquals (node->name, name, length);
+}
+
+/* Evaluates the step at *path for every node of context */
+static Bool
+applyStep (const char **path, CCSXmlNodeSet *context, CCSXmlNodeSet *result)
+{
+    CCSXmlPredicate predicates[MAX_PREDICATES];
+    CCSXmlAxis      axis = AxisChild;
+    const char      *name;
+    size_t          length = 0;
+    Bool            text = FALSE;
+    int             numPredicates = 0;
+    int             i;
+
+    skipSpace (path);
+
+    if (skipToken (path, "@"))
+	axis = AxisAttribute;
+    else if (skipToken (path, "ancestor::"))
+	axis = AxisAncestor;
+    else
+	skipToken (path, "child::");
+
+    name = *path;
+
+    if (skipToken (path, "text()"))
+	text = TRUE;
+    else if (**path == '*')
+    {
+	length = 1;
+	++*path;
+    }
+    else
+    {
+	length = nameLength (name);
+	*path += length;
+
+	if (!length)
+	    return FALSE;
+    }
+
+    while (skipToken (path, "["))
+	if (numPredicates == MAX_PREDICATES ||
+	    !readPredicate (path, &predicates[numPredicates++]))
+	    return FALSE;
+
+    for (i = 0; i < context->num; ++i)
+    {
+	xmlNode *node = context->nodes[i];
+	xmlNode *n;
+
+	switch (axis)
+	{
+	    case AxisChild:
+		n = node->children;
+		break;
+	    case AxisAttribute:
+		n = (node->type == XML_ELEMENT_NODE && !text) ?
+		    (xmlNode *) node->properties : NULL;
+		break;
+	    case AxisAncestor:
+	    default:
+		n = node->parent;
+		break;
+	}
+
+	for (; n; n = axis == AxisAncestor ? n->parent : n->next)
+	{
+	    int j;
+
+	    if (!testNode (n, text, name, length))
+		continue;
+
+	    for (j = 0; j < numPredicates; ++j)
+		if (!predicateMatches (&predicates[j], n))
+		    break;
+
+	    if (j == numPredicates && !addNode (result, n))
+		return FALSE;
+	}
+    }
+
+    /* Steps from several context nodes can reach the same node, and
+     * ancestors are found in reverse document order */
+    if (axis == AxisAncestor || context->num > 1)
+	sortNodeSet (result);
+
+    return TRUE;
+}
+
+/* Evaluates one path of a union, adding what it matches to result */
+static Bool
+applyPath (const char **path, xmlDoc *doc, xmlNode *base, CCSXmlNodeSet *result)
+{
+    CCSXmlNodeSet context = { NULL, 0, 0 };
+    Bool          ok      = TRUE;
+
+    skipSpace (path);
+
+    if (**path == '/')
+    {
+	++*path;
+	ok = addNode (&context, (xmlNode *) doc);
+    }
+    else
+	ok = addNode (&context, base ? base : (xmlNode *) doc);
+
+    while (ok)
+    {
+	CCSXmlNodeSet next = { NULL, 0, 0 };
+
+	ok = applyStep (path, &context, &next);
+
+	freeNodeSet (&context);
+	context = next;
+
+	skipSpace (path);
+
+	if (**path != '/')
+	    break;
+
+	++*path;
+    }
+
+    if (ok)
+    {
+	int i;
+
+	for (i = 0; ok && i < context.num; ++i)
+	    ok = addNode (result, context.nodes[i]);
+    }
+
+    freeNodeSet (&context);
+
+    return ok;
+}
+
+static Bool
+evaluate (xmlDoc *doc, xmlNode *base, const char *path, CCSXmlNodeSet *result)
+{
+    Bool ok;
+    int  paths = 0;
+
+    if (!doc)
+	doc = base ? base->doc : NULL;
+
+    if (!doc || !path)
+	return FALSE;
+
+    do
+    {
+	ok = applyPath (&path, doc, base, result);
+	++paths;
+    }
+    while (ok && skipToken (&path, "|"));
+
+    skipSpace (&path);
+
+    if (!ok || *path)
+    {
+	freeNodeSet (result);
+	return FALSE;
+    }
+
+    if (paths > 1)
+	sortNodeSet (result);
+
+    return TRUE;
+}
+
+char *
+ccsXmlPathString (xmlDoc *doc, xmlNode *base, const char *path)
+{
+    CCSXmlNodeSet result = { NULL, 0, 0 };
+    char          *rv    = NULL;
+    xmlChar       *content;
+
+    if (!evaluate (doc, base, path, &result) || !result.num)
+    {
+	freeNodeSet (&result);
+	return NULL;
+    }
+
+    /* The string value of a node set is that of its first node */
+    content = xmlNodeGetContent (result.nodes[0]);
+
+    if (content && *content)
+	rv = strdup ((const char *) content);
+
+    xmlFree (content);
+    freeNodeSet (&result);
+
+    return rv;
+}
+
+xmlNode **
+ccsXmlPathNodes (xmlDoc *doc, xmlNode *base, const char *path, int *num)
+{
+    CCSXmlNodeSet result = { NULL, 0, 0 };
+
+    *num = 0;
+
+    if (!evaluate (doc, base, path, &result) || !result.num)
+    {
+	freeNodeSet (&result);
+	return NULL;
+    }
+
+    *num = result.num;
+
+    return result.nodes;
+}
@@ -0,0 +1,62 @@
+/*
+ * Compiz configuration system library
+ *
+ * ccs_xml_path.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef CCS_XML_PATH_H
+#define CCS_XML_PATH_H
+
+#include <ccs-defs.h>
+
+#include <libxml/tree.h>
+
+COMPIZCONFIG_BEGIN_DECLS
+
+/*
+ * Looks up nodes in metadata documents by walking the tree directly,
+ * without building an XPath context and compiling an expression for
+ * every lookup.
+ *
+ * Only the part of XPath that the metadata loader uses is understood:
+ *
+ *   path      := step ('/' step)* , optionally starting with '/'
+ *   step      := ['child::' | 'ancestor::' | '@'] test predicate*
+ *   test      := name | '*' | 'text()'
+ *   predicate := "[lang('x')]" | "[@name = 'x']"
+ *
+ * and unions of paths separated by '|'. Nodes are returned in document
+ * order, the same way XPath would return them. Anything else matches
+ * nothing.
+ */
+
+/*
+ * String value of the first node matched, or NULL if nothing matched
+ * or it is empty. Free with free ().
+ */
+char *
+ccsXmlPathString (xmlDoc *doc, xmlNode *base, const char *path);
+
+/*
+ * All nodes matched, in document order, or NULL if there are none.
+ * Free the array with free ().
+ */
+xmlNode **
+ccsXmlPathNodes (xmlDoc *doc, xmlNode *base, const char *path, int *num);
+
+COMPIZCONFIG_END_DECLS
+
+#endif
@@ -46,6 +46,8 @@
 
 #include <ccs.h>
 #include "ccs-private.h"
+#include "ccs_xml_path.h"
+#include "ccs_metadata_cache.h"
 
 #include <string>
 
@@ -126,6 +128,9 @@ PluginMetadata persistentPluginPB; // Made global so that it gets reused,
 
 std::string metadataCacheDir = "";
 
+// All cached plugin metadata, mapped from a single image in the cache dir
+CCSMetadataCache *metadataCache = NULL;
+
 std::string curLocale = std::string (getLocale ());
 std::string shortLocale = curLocale.find ('.') == std::string::npos ?
     curLocale : curLocale.substr (0, curLocale.find ('.'));
@@ -855,7 +860,6 @@ initRulesFromPB (CCSPlugin * plugin, const PluginInfoMetadata & pluginInfoPB)
 static void
 addPluginFromPB (CCSContext * context,
 		 const PluginInfoMetadata & pluginInfoPB,
-		 char *file,
 		 char *xmlFile)
 {
     const char *name;
@@ -895,8 +899,7 @@ addPluginFromPB (CCSContext * context,
     ccsObjectSetPrivate (plugin, (CCSPrivate *) pPrivate);
     ccsObjectAddInterface (plugin, (CCSInterface *) cPrivate->object_interfaces->pluginInterface, GET_INTERFACE_TYPE (CCSPluginInterface));
 
-    if (file)
-	pPrivate->pbFilePath = strdup (file);
+    pPrivate->cachedMetadata = TRUE;
 
     if (xmlFile)
     {
@@ -937,7 +940,6 @@ addPluginFromPB (CCSContext * context,
 static void
 addCoreSettingsFromPB (CCSContext * context,
 		       const PluginInfoMetadata & pluginInfoPB,
-		       char *file,
 		       char *xmlFile)
 {
     CCSPlugin *plugin;
@@ -966,8 +968,7 @@ addCoreSettingsFromPB (CCSContext * context,
     ccsObjectSetPrivate (plugin, (CCSPrivate *) pPrivate);
     ccsObjectAddInterface (plugin, (CCSInterface *) cPrivate->object_interfaces->pluginInterface, GET_INTERFACE_TYPE (CCSPluginInterface));
 
-    if (file)
-	pPrivate->pbFilePath = strdup (file);
+    pPrivate->cachedMetadata = TRUE;
 
     if (xmlFile)
     {
@@ -1068,86 +1069,13 @@ getOptionType (const char *name)
 static char *
 getStringFromXPath (xmlDoc * doc, xmlNode * base, const char *path)
 {
-    xmlXPathObjectPtr xpathObj;
-    xmlXPathContextPtr xpathCtx;
-    char *rv = NULL;
-
-    xpathCtx = xmlXPathNewContext (doc);
-    if (!xpathCtx)
-	return NULL;
-
-    if (base)
-	xpathCtx->node = base;
-
-    xpathObj = xmlXPathEvalExpression (BAD_CAST path, xpathCtx);
-
-    if (!xpathObj)
-    {
-	xmlXPathFreeContext (xpathCtx);
-	return NULL;
-    }
-
-    xpathObj = xmlXPathConvertString (xpathObj);
-
-    if (xpathObj->type == XPATH_STRING && xpathObj->stringval
-	&& strlen ((char *) xpathObj->stringval))
-    {
-	rv = strdup ((char *) xpathObj->stringval);
-    }
-
-    xmlXPathFreeObject (xpathObj);
-    xmlXPathFreeContext (xpathCtx);
-    return rv;
+    return ccsXmlPathString (doc, base, path);
 }
 
 static xmlNode **
 getNodesFromXPath (xmlDoc * doc, xmlNode * base, const char *path, int *num)
 {
-    xmlXPathObjectPtr xpathObj;
-    xmlXPathContextPtr xpathCtx;
-    xmlNode **rv = NULL;
-    int size;
-
-    *num = 0;
-
-    xpathCtx = xmlXPathNewContext (doc);
-    if (!xpathCtx)
-	return NULL;
-
-    if (base)
-	xpathCtx->node = base;
-
-    xpathObj = xmlXPathEvalExpression (BAD_CAST path, xpathCtx);
-    if (!xpathObj)
-    {
-	xmlXPathFreeContext (xpathCtx);
-	return NULL;
-    }
-
-    size = (xpathObj->nodesetval) ? xpathObj->nodesetval->nodeNr : 0;
-    if (!size)
-    {
-	xmlXPathFreeObject (xpathObj);
-	xmlXPathFreeContext (xpathCtx);
-	return NULL;
-    }
-
-    rv = (xmlNode **) malloc (size * sizeof (xmlNode *));
-    if (!rv)
-    {
-	xmlXPathFreeObject (xpathObj);
-	xmlXPathFreeContext (xpathCtx);
-	return NULL;
-    }
-    *num = size;
-
-    for (int i = 0; i < size; ++i)
-	rv[i] = xpathObj->nodesetval->nodeTab[i];
-
-    xmlXPathFreeObject (xpathObj);
-    xmlXPathFreeContext (xpathCtx);
-
-    return rv;
+    return ccsXmlPathNodes (doc, base, path, num);
 }
 
 static Bool
@@ -1189,6 +1117,7 @@ static char *
 stringFromNodeDefTrans (xmlNode * node, const char *path, const char *def)
 {
     const char *lang = getLocale ();
+    const char *separators[] = { ".", "_" };
     char newPath[1024];
     char *rv = NULL;
 
@@ -1200,15 +1129,19 @@ stringFromNodeDefTrans (xmlNode * node, const char *path, const char *def)
     if (rv)
 	return rv;
 
-    snprintf (newPath, 1023, "%s[lang(substring-before('%s','.'))]", path, lang);
-    rv = stringFromNodeDef (node, newPath, NULL);
-    if (rv)
-	return rv;
+    /* The language without its encoding, then without its territory */
+    for (unsigned int i = 0; i < sizeof (separators) / sizeof (separators[0]); ++i)
+    {
+	const char *end = strstr (lang, separators[i]);
 
-    snprintf (newPath, 1023, "%s[lang(substring-before('%s','_'))]", path, lang);
-    rv = stringFromNodeDef (node, newPath, NULL);
-    if (rv)
-	return rv;
+	if (!end)
+	    continue;
+
+	snprintf (newPath, 1023, "%s[lang('%.*s')]", path, (int) (end - lang), lang);
+	rv = stringFromNodeDef (node, newPath, NULL);
+	if (rv)
+	    return rv;
+    }
 
     snprintf (newPath, 1023, "%s[lang('C')]", path);
     rv = stringFromNodeDef (node, newPath, NULL);
@@ -1936,13 +1869,42 @@ checkAddGroupSubgroup (OptionMetadata *optPB,
     }
 }
 
+static int
+protoBufFileFilter (const struct dirent *name)
+{
+    int length = strlen (name->d_name);
+
+    return length > 3 && !strcmp (name->d_name + length - 3, ".pb");
+}
+
+// Remove the per plugin .pb files that the metadata image replaces
+static void
+removeProtoBufFiles ()
+{
+    struct dirent **nameList;
+    int nFile = scandir (metadataCacheDir.c_str (), &nameList,
+			 protoBufFileFilter, NULL);
+
+    if (nFile <= 0)
+	return;
+
+    for (int i = 0; i < nFile; ++i)
+    {
+	std::string pbFilePath = metadataCacheDir + "/" + nameList[i]->d_name;
+
+	unlink (pbFilePath.c_str ());
+	free (nameList[i]);
+    }
+    free (nameList);
+}
+
 static Bool
-createProtoBufCacheDir ()
+openMetadataCache ()
 {
-    if (metadataCacheDir.length () > 0)
+    if (metadataCache)
     {
-	// Cache dir must have been created already, since otherwise it would
-	// be "". So we can return here.
+	// Cache must have been opened already, since otherwise it would
+	// be NULL. So we can return here.
 	return TRUE;
     }
     char *cacheBaseDir = NULL;
@@ -1969,22 +1931,32 @@ createProtoBufCacheDir ()
 	if (metadataCacheDir[metadataCacheDir.length () - 1] != '/')
 	    metadataCacheDir += "/";
 	metadataCacheDir += "compizconfig-1";
-	std::string metadataCacheFileDummy = metadataCacheDir + "/dummy";
+	std::string metadataCachePath = metadataCacheDir + "/metadata.cache";
 
 	// Create cache dir
-	Bool success = ccsCreateDirFor (metadataCacheFileDummy.c_str ());
+	Bool success = ccsCreateDirFor (metadataCachePath.c_str ());
 	if (!success)
 	    ccsError ("Error creating directory \"%s\"",
 		      metadataCacheDir.c_str ());
 	free (cacheBaseDir);
 
 	if (success)
-	    return TRUE; // metadataCacheDir will be used later in this case
+	{
+	    struct stat cacheStat;
+
+	    if (stat (metadataCachePath.c_str (), &cacheStat))
+		removeProtoBufFiles ();
+
+	    metadataCache = ccsMetadataCacheOpen (metadataCachePath.c_str (),
+						  PB_ABI_VERSION);
+	    if (metadataCache)
+		return TRUE; // metadataCache will be used later in this case
+	}
 
 	metadataCacheDir = ""; // invalidate metadataCacheDir
     }
 
-    usingProtobuf = FALSE; // Disable protobuf if cache dir cannot be created
+    usingProtobuf = FALSE; // Disable protobuf if cache cannot be opened
     return FALSE;
 }
 
@@ -2673,70 +2645,65 @@ addCoreSettingsFromXMLNode (CCSContext * context,
 
 #ifdef USE_PROTOBUF
 
-// Either pluginMinMetadata or pluginMetadata should be non-NULL
+// Parses a record of the metadata image straight from the mapping
 static Bool
-loadPluginMetadataFromProtoBuf (char *pbPath,
-				PluginBriefMetadata *pluginMinMetadata,
-				PluginMetadata *pluginMetadata)
+loadPluginMetadataFromCache (const char *xmlFilePath,
+			     struct stat *xmlStat,
+			     CCSMetadataCacheRecord record,
+			     google::protobuf::Message *pluginMetadata)
 {
-    Bool success = FALSE;
+    const void *data;
+    size_t size;
 
-    FILE *pbFile = fopen (pbPath, "rb");
-    if (pbFile)
-    {
-	google::protobuf::io::FileInputStream inputStream (fileno (pbFile));
-	if ((pluginMinMetadata &&
-	     pluginMinMetadata->ParseFromZeroCopyStream (&inputStream)) ||
-	    (pluginMetadata &&
-	     pluginMetadata->ParseFromZeroCopyStream (&inputStream)))
-	    success = TRUE;
-	inputStream.Close ();
-	fclose (pbFile);
-    }
+    if (!openMetadataCache () ||
+	!ccsMetadataCacheLookup (metadataCache, xmlFilePath, xmlStat, record,
+				 &data, &size))
+	return FALSE;
 
-    return success;
+    return pluginMetadata->ParseFromArray (data, size);
 }
 
-// Returns TRUE if successfully loads .pb file and .pb is up to date.
+// Returns TRUE if the brief metadata is cached and up to date.
 static Bool
-checkAndLoadProtoBuf (char *pbPath,
-		      struct stat *pbStat,
+checkAndLoadProtoBuf (const char *xmlFilePath,
 		      struct stat *xmlStat,
 		      PluginBriefMetadata *pluginBriefPB)
 {
     const PluginInfoMetadata &pluginInfoPB = pluginBriefPB->info ();
 
-    if (pbStat->st_mtime < xmlStat->st_mtime ||     // is .pb older than .xml?
-	!loadPluginMetadataFromProtoBuf (pbPath, pluginBriefPB, NULL) ||
+    if (!loadPluginMetadataFromCache (xmlFilePath, xmlStat,
+				      CCSMetadataCacheBrief, pluginBriefPB) ||
 	(!basicMetadata && pluginBriefPB->info ().basic_metadata ()) ||
 	pluginInfoPB.pb_abi_version () != PB_ABI_VERSION ||
-	pluginInfoPB.time () != (unsigned long)xmlStat->st_mtime ||
-	// xml modification time mismatch?
 	(pluginInfoPB.locale () != "NONE" &&
 	 pluginInfoPB.locale () != shortLocale))
     {
-	// .pb needs update
+	// Cached metadata needs update
 	return FALSE;
     }
     return TRUE;
 }
 
-// Write .pb data to .pb file
+// Store metadata in the cache, it is written out on the next sync
 static void
-writePBFile (char *pbFilePath,
+writePBFile (const char *xmlFilePath,
 	     PluginMetadata *pluginPB,
 	     PluginBriefMetadata *pluginBriefPB,
 	     struct stat *xmlStat)
 {
-    if (!createProtoBufCacheDir ())
+    if (!openMetadataCache ())
 	return;
 
     PluginInfoMetadata *pluginInfoPB;
+    google::protobuf::Message *message;
+    CCSMetadataCacheRecord record;
 
     if (pluginPB)
     {
 	pluginInfoPB = pluginPB->mutable_info ();
 	pluginInfoPB->set_brief_metadata (FALSE);
+	message = pluginPB;
+	record = CCSMetadataCacheFull;
     }
     else
     {
@@ -2745,26 +2712,34 @@ writePBFile (char *pbFilePath,
 	pluginInfoPB->set_locale (shortLocale);
 	pluginInfoPB->set_time ((unsigned long)xmlStat->st_mtime);
 	pluginInfoPB->set_brief_metadata (TRUE);
+	message = pluginBriefPB;
+	record = CCSMetadataCacheBrief;
     }
 
     pluginInfoPB->set_basic_metadata (basicMetadata);
 
-    FILE *pbFile = fopen (pbFilePath, "wb");
-    if (pbFile)
-    {
-	google::protobuf::io::FileOutputStream
-	    outputStream (fileno (pbFile));
-	if (pluginPB)
-	    pluginPB->SerializeToZeroCopyStream (&outputStream);
-	else
-	    pluginBriefPB->SerializeToZeroCopyStream (&outputStream);
-	outputStream.Close ();
+    std::string data;
+    if (message->SerializeToString (&data))
+	ccsMetadataCacheUpdate (metadataCache, xmlFilePath, xmlStat, record,
+				data.data (), data.size ());
+}
 
-	fclose (pbFile);
-    }
+static void
+syncMetadataCache ()
+{
+    if (metadataCache)
+	ccsMetadataCacheSync (metadataCache);
 }
 #endif
 
+void
+ccsSyncMetadataCache (void)
+{
+#ifdef USE_PROTOBUF
+    syncMetadataCache ();
+#endif
+}
+
 /* Returns TRUE on success. */
 static Bool
 loadPluginFromXML (CCSContext * context,
@@ -2797,16 +2772,14 @@ loadPluginFromXML (CCSContext * context,
 
 #ifdef USE_PROTOBUF
 static void
-updatePBFilePath (CCSContext * context, char *name, char *pbFilePath)
+markMetadataCached (CCSContext * context, char *name)
 {
     CCSPlugin *plugin = ccsFindPlugin (context, name);
     if (plugin)
     {
 	CCSPluginPrivate *pPrivate = GET_PRIVATE (CCSPluginPrivate, plugin);
 
-	if (pPrivate->pbFilePath)
-	    free (pPrivate->pbFilePath);
-	pPrivate->pbFilePath = strdup (pbFilePath);
+	pPrivate->cachedMetadata = TRUE;
     }
 }
 #endif
@@ -2828,9 +2801,7 @@ loadPluginFromXMLFile (CCSContext * context, char *xmlName, char *xmlDirPath)
 
 #ifdef USE_PROTOBUF
     char *name = NULL;
-    char *pbFilePath = NULL;
     struct stat xmlStat;
-    Bool removePB = FALSE;
 
     if (usingProtobuf)
     {
@@ -2840,10 +2811,6 @@ loadPluginFromXMLFile (CCSContext * context, char *xmlName, char *xmlDirPath)
 	    return;
 	}
 
-	// Check if the corresponding .pb exists in cache
-	Bool error = TRUE;
-	struct stat pbStat;
-
 	name = strndup (xmlName, strlen (xmlName) - 4);
 	if (!name)
 	{
@@ -2852,47 +2819,21 @@ loadPluginFromXMLFile (CCSContext * context, char *xmlName, char *xmlDirPath)
 	    return;
 	}
 
-	if (createProtoBufCacheDir () &&
-	    metadataCacheDir.length () > 0)
-	{
-	    if (asprintf (&pbFilePath, "%s/%s.pb", metadataCacheDir.c_str (), name) == -1)
-		pbFilePath = NULL;
-
-	    if (!pbFilePath)
-	    {
-		ccsError ("Can't allocate memory");
-		free (xmlFilePath);
-		free (name);
-		return;
-	    }
-	    error = stat (pbFilePath, &pbStat);
-	}
-
-	if (!error)
+	// Check if the metadata of this file is in the cache
+	if (checkAndLoadProtoBuf (xmlFilePath, &xmlStat,
+				  &persistentPluginBriefPB))
 	{
-	    if (checkAndLoadProtoBuf (pbFilePath, &pbStat, &xmlStat,
-				      &persistentPluginBriefPB))
-	    {
-		// Found and loaded .pb
-		if (!strcmp (name, "core"))
-		    addCoreSettingsFromPB (context,
-					   persistentPluginBriefPB.info (),
-					   pbFilePath, xmlFilePath);
-		else
-		    addPluginFromPB (context, persistentPluginBriefPB.info (),
-				     pbFilePath, xmlFilePath);
-    
-		updatePBFilePath (context, name, pbFilePath);
-    
-		free (xmlFilePath);
-		free (pbFilePath);
-		free (name);
-		return;
-	    }
+	    if (!strcmp (name, "core"))
+		addCoreSettingsFromPB (context,
+				       persistentPluginBriefPB.info (),
+				       xmlFilePath);
 	    else
-	    {
-		removePB = TRUE;
-	    }
+		addPluginFromPB (context, persistentPluginBriefPB.info (),
+				 xmlFilePath);
+
+	    free (xmlFilePath);
+	    free (name);
+	    return;
 	}
 
 	persistentPluginBriefPB.Clear ();
@@ -2929,22 +2870,18 @@ loadPluginFromXMLFile (CCSContext * context, char *xmlName, char *xmlDirPath)
 	}
 	close (fd);
     }
-    free (xmlFilePath);
 
 #ifdef USE_PROTOBUF
     if (usingProtobuf && xmlLoaded)
     {
-	if (removePB)
-	    remove (pbFilePath); // Attempt to remove .pb
-	writePBFile (pbFilePath, NULL, &persistentPluginBriefPB, &xmlStat);
-	updatePBFilePath (context, name, pbFilePath);
+	writePBFile (xmlFilePath, NULL, &persistentPluginBriefPB, &xmlStat);
+	markMetadataCached (context, name);
     }
 
-    if (pbFilePath)
-	free (pbFilePath);
     if (name)
 	free (name);
 #endif
+    free (xmlFilePath);
 }
 
 static void
@@ -3146,6 +3083,10 @@ ccsLoadPluginsDefault (CCSContext * context)
     }
     loadPluginsFromXMLFiles (context, (char *)METADATADIR);
 
+#ifdef USE_PROTOBUF
+    syncMetadataCache ();
+#endif
+
     if (home && strlen (home))
     {
 	char *homeplugins = NULL;
@@ -3218,7 +3159,6 @@ ccsLoadPluginSettings (CCSPlugin * plugin)
     void *pluginPBToWrite = NULL;
 
 #ifdef USE_PROTOBUF
-    Bool loadedAtLeastBriefPB = FALSE;
     initPBLoading ();
 #endif
 
@@ -3230,41 +3170,42 @@ ccsLoadPluginSettings (CCSPlugin * plugin)
     pPrivate->loaded = TRUE;
     ccsDebug ("Initializing %s options...", pPrivate->name);
 
+    struct stat xmlStat;
+
 #ifdef USE_PROTOBUF
-    if (usingProtobuf && pPrivate->pbFilePath)
-    {
-	loadedAtLeastBriefPB =
-	    loadPluginMetadataFromProtoBuf (pPrivate->pbFilePath,
-					    NULL, &persistentPluginPB);
-	if (loadedAtLeastBriefPB)
+    if (usingProtobuf && pPrivate->cachedMetadata &&
+	!stat (pPrivate->xmlFile, &xmlStat))
+    {
+	if (loadPluginMetadataFromCache (pPrivate->xmlFile, &xmlStat,
+					 CCSMetadataCacheFull,
+					 &persistentPluginPB) &&
+	    (basicMetadata ||
+	     !persistentPluginPB.info ().basic_metadata ()))
 	{
-	    if (!persistentPluginPB.info ().brief_metadata () &&
-		(basicMetadata ||
-		 !persistentPluginPB.info ().basic_metadata ()))
-	    {
-		initOptionsFromPB (plugin, persistentPluginPB);
-		if (!basicMetadata)
-		    initStringExtensionsFromPB (plugin, persistentPluginPB);
-		ignoreXML = TRUE;
-	    }
-	    else
-		pluginPBToWrite = &persistentPluginPB;
+	    initOptionsFromPB (plugin, persistentPluginPB);
+	    if (!basicMetadata)
+		initStringExtensionsFromPB (plugin, persistentPluginPB);
+	    ignoreXML = TRUE;
 	}
-	else
+	else if (loadPluginMetadataFromCache (pPrivate->xmlFile, &xmlStat,
+					      CCSMetadataCacheBrief,
+					      &persistentPluginPB))
 	    pluginPBToWrite = &persistentPluginPB;
     }
 #endif
 
-    struct stat xmlStat;
-
     // Load from .xml
     if (!ignoreXML && pPrivate->xmlFile)
 	loadOptionsStringExtensionsFromXML (plugin, pluginPBToWrite, &xmlStat);
 
 #ifdef USE_PROTOBUF
-    if (pluginPBToWrite && pPrivate->pbFilePath && loadedAtLeastBriefPB)
-	writePBFile (pPrivate->pbFilePath, (PluginMetadata *) pluginPBToWrite,
+    if (pluginPBToWrite)
+    {
+	/* Written out by ccsSyncMetadataCache, once for all plugins
+	 * loaded together */
+	writePBFile (pPrivate->xmlFile, (PluginMetadata *) pluginPBToWrite,
 		     NULL, &xmlStat);
+    }
 #endif
     ccsDebug ("done");
 
@@ -95,6 +95,14 @@ void ccsCheckFileWatches (void)
 #endif
 }
 
+int ccsGetFileWatchFd (void)
+{
+    if (!inotifyFd)
+	return -1;
+
+    return inotifyFd;
+}
+
 unsigned int ccsAddFileWatch (const char            *fileName,
 			      Bool                  enable,
 			      FileWatchCallbackProc callback,
@@ -107,16 +107,7 @@ getIniString (IniDictionary *dictionary,
 	      const char    *section,
 	      const char    *entry)
 {
-    char *sectionName;
-    char *retValue;
-
-    if (asprintf (&sectionName, "%s:%s", section, entry) == -1)
-	return NULL;
-
-    retValue = iniparser_getstring (dictionary, sectionName, NULL);
-    free (sectionName);
-
-    return retValue;
+    return iniparser_getsecstring (dictionary, section, entry, NULL);
 }
 
 static void
@@ -125,17 +116,7 @@ setIniString (IniDictionary *dictionary,
 	      const char    *entry,
 	      const char    *value)
 {
-    char *sectionName;
-
-    if (asprintf (&sectionName, "%s:%s", section, entry) == -1)
-	return;
-
-    if (!iniparser_find_entry (dictionary, (char*) section))
-	iniparser_add_entry (dictionary, (char*) section, NULL, NULL);
-
-    iniparser_setstr (dictionary, sectionName, (char*) value);
-
-    free (sectionName);
+    iniparser_setsecstr (dictionary, section, entry, value);
 }
 
 Bool ccsIniParseString (char       *str,
@@ -819,11 +800,5 @@ void ccsIniRemoveEntry (IniDictionary * dictionary,
 			const char * section,
 			const char * entry)
 {
-    char *sectionName;
-
-    if (asprintf (&sectionName, "%s:%s", section, entry) == -1)
-	return;
-
-    iniparser_unset (dictionary, sectionName);
-    free (sectionName);
+    iniparser_unsetsec (dictionary, section, entry);
 }
@@ -199,32 +199,18 @@ strcrop (char * s)
 
 /* dictionary.c.c following */
 
-/** Maximum value size for integers and doubles. */
-#define MAXVALSZ    1024
-
 /** Minimal allocated number of entries in a dictionary */
 #define DICTMINSZ   128
 
-/** Invalid key token */
-#define DICT_INVALID_KEY    ((char*)-1)
-
-/*
-   Doubles the allocated size associated to a pointer
-   'size' is the current allocated size.
-   */
-static void*
-mem_double (void * ptr, int size)
-{
-    void *newptr;
+/** Size of the arena blocks strings read from a file are allocated from */
+#define DICT_ARENA_BLOCKSZ  4096
 
-    newptr = calloc (2 * size, 1);
-    if (!newptr)
-	return NULL;
+/** Markers for hash table slots which hold no entry */
+#define DICT_SLOT_EMPTY     0
+#define DICT_SLOT_DELETED   -1
 
-    memcpy (newptr, ptr, size);
-    free (ptr);
-    return newptr;
-}
+/** Text offset of a section whose text cannot be reused */
+#define DICT_NO_TEXT        ((size_t) -1)
 
 /*---------------------------------------------------------------------------
   Function codes
@@ -233,30 +219,49 @@ mem_double (void * ptr, int size)
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Compute the hash key for a string.
-  @param    key     Character string to use for key.
+  @param    hash    Hash of the characters before s.
+  @param    s       Characters to add to the hash.
+  @param    len     Number of characters to add.
   @return   1 unsigned int on at least 32 bits.
 
   This hash function has been taken from an Article in Dr Dobbs Journal.
   This is normally a collision-free function, distributing keys evenly.
   The key is stored anyway in the struct so that collision can be avoided
   by comparing the key itself in last resort.
+
+  Keys are looked up without regard to case, so the characters are
+  lowered before being added.
   */
 /*--------------------------------------------------------------------------*/
-static unsigned dictionary_hash (char * key)
+static unsigned
+dictionary_hash_add (unsigned hash, const char * s, size_t len)
 {
-    int         len;
-    unsigned    hash;
-    int         i;
+    size_t i;
 
-    len = strlen (key);
-
-    for (hash = 0, i = 0; i < len; ++i)
+    for (i = 0; i < len; ++i)
     {
-	hash += (unsigned) key[i];
+	hash += (unsigned) tolower ((unsigned char) s[i]);
 	hash += (hash << 10);
 	hash ^= (hash >> 6);
     }
 
+    return hash;
+}
+
+/* Hash of the key "sec:key", or of "sec" if key is NULL */
+static unsigned
+dictionary_hash (const char * sec, size_t seclen, const char * key)
+{
+    unsigned hash;
+
+    hash = dictionary_hash_add (0, sec, seclen);
+
+    if (key)
+    {
+	hash = dictionary_hash_add (hash, ":", 1);
+	hash = dictionary_hash_add (hash, key, strlen (key));
+    }
+
     hash += (hash << 3);
 
     hash ^= (hash >> 11);
@@ -264,6 +269,85 @@ static unsigned dictionary_hash (char * key)
     return hash;
 }
 
+/* Compares a stored key with "sec:key" without copying the latter */
+static Bool
+dictionary_key_matches (const char * stored,
+			const char * sec,
+			size_t       seclen,
+			const char * key)
+{
+    size_t i;
+
+    for (i = 0; i < seclen; ++i)
+	if (stored[i] != (char) tolower ((unsigned char) sec[i]))
+	    return FALSE;
+
+    stored += seclen;
+
+    if (key)
+    {
+	if (*stored++ != ':')
+	    return FALSE;
+
+	for (; *key; ++key, ++stored)
+	    if (*stored != (char) tolower ((unsigned char) *key))
+		return FALSE;
+    }
+
+    return *stored == '\0';
+}
+
+/* Allocates strings read from a file out of larger blocks, as they
+ * mostly live as long as the dictionary */
+static char*
+dictionary_arena_alloc (dictionary * d, size_t size)
+{
+    IniArenaBlock *block = d->arena;
+    char          *ptr;
+
+    if (!block || block->size - block->used < size)
+    {
+	size_t blockSize = DICT_ARENA_BLOCKSZ;
+
+	if (size > blockSize / 4)
+	    blockSize = size;
+
+	block = malloc (sizeof (IniArenaBlock) + blockSize);
+	if (!block)
+	    return NULL;
+
+	block->used = 0;
+	block->size = blockSize;
+
+	/* Keep filling the current block if this one is just for a
+	 * large string */
+	if (d->arena && blockSize == size)
+	{
+	    block->next = d->arena->next;
+	    d->arena->next = block;
+	}
+	else
+	{
+	    block->next = d->arena;
+	    d->arena = block;
+	}
+    }
+
+    ptr = block->data + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+static char*
+dictionary_alloc (dictionary * d, size_t size, Bool inArena)
+{
+    if (inArena)
+	return dictionary_arena_alloc (d, size);
+
+    return malloc (size);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Create a new dictionary object.
@@ -279,39 +363,39 @@ dictionary*
 dictionary_new (int size)
 {
     dictionary *d;
+    int        nSlots;
 
     /* If no size was specified, allocate space for DICTMINSZ */
     if (size < DICTMINSZ)
 	size = DICTMINSZ;
 
+    /* Keep the hash table at most half full */
+    nSlots = DICTMINSZ;
+    while (nSlots < size * 2)
+	nSlots *= 2;
+
     d = (dictionary *) calloc (1, sizeof (dictionary));
     if (!d)
 	return NULL;
 
-    d->size = size;
-    d->val  = (char **) calloc (size, sizeof (char*));
-    if (!d->val)
+    d->entries = (IniEntry *) malloc (size * sizeof (IniEntry));
+    if (!d->entries)
     {
 	free (d);
 	return NULL;
     }
 
-    d->key  = (char **) calloc (size, sizeof (char*));
-    if (!d->key)
+    d->slots = (int *) calloc (nSlots, sizeof (int));
+    if (!d->slots)
     {
-	free (d->val);
+	free (d->entries);
 	free (d);
 	return NULL;
     }
 
-    d->hash = (unsigned int *) calloc (size, sizeof (unsigned));
-    if (!d->hash)
-    {
-	free (d->key);
-	free (d->val);
-	free (d);
-	return NULL;
-    }
+    d->entriesSize = size;
+    d->nSlots      = nSlots;
+    d->freeEntry   = -1;
 
     return d;
 }
@@ -328,76 +412,284 @@ dictionary_new (int size)
 static void
 dictionary_del (dictionary * d)
 {
-    int     i;
+    IniArenaBlock *block, *next;
+    int           i;
 
     if (!d)
 	return;
 
-    for (i = 0; i < d->size; ++i)
+    for (i = 0; i < d->nEntries; ++i)
     {
-	if (d->key[i])
-	    free (d->key[i]);
+	if (!d->entries[i].key)
+	    continue;
 
-	if (d->val[i])
-	    free (d->val[i]);
+	if (!d->entries[i].keyInArena)
+	    free (d->entries[i].key);
+
+	if (!d->entries[i].valInArena)
+	    free (d->entries[i].val);
     }
 
-    free (d->val);
-    free (d->key);
-    free (d->hash);
-    free (d);
+    for (block = d->arena; block; block = next)
+    {
+	next = block->next;
+	free (block);
+    }
 
-    return;
+    free (d->entries);
+    free (d->slots);
+    free (d->sections);
+    free (d->text);
+    free (d->fileName);
+    free (d);
 }
 
 /*-------------------------------------------------------------------------*/
 /**
-  @brief    Get a value from a dictionary.
+  @brief    Find the hash table slot of a key.
   @param    d       dictionary object to search.
-  @param    key     Key to look for in the dictionary.
-  @param    def     Default value to return if key not found.
-  @return   1 pointer to internally allocated character string.
-
-  This function locates a key in a dictionary and returns a pointer to its
-  value, or the passed 'def' pointer if no such key can be found in
-  dictionary. The returned character pointer points to data internal to the
-  dictionary object, you should not try to free it or modify it.
+  @param    hash    Hash of the key.
+  @param    sec     Section part of the key.
+  @param    seclen  Length of sec.
+  @param    key     Part of the key after the colon, NULL for a section.
+  @return   Slot index, -1 if the key is not in the dictionary.
   */
 /*--------------------------------------------------------------------------*/
-static char*
-dictionary_get (dictionary * d, char * key, char * def)
+static int
+dictionary_lookup (dictionary * d,
+		   unsigned     hash,
+		   const char * sec,
+		   size_t       seclen,
+		   const char * key)
 {
-    unsigned    hash;
-    int         i;
+    unsigned mask = (unsigned) d->nSlots - 1;
+    unsigned i    = hash & mask;
+
+    while (d->slots[i] != DICT_SLOT_EMPTY)
+    {
+	if (d->slots[i] != DICT_SLOT_DELETED)
+	{
+	    IniEntry *e = &d->entries[d->slots[i] - 1];
+
+	    if (e->hash == hash &&
+		dictionary_key_matches (e->key, sec, seclen, key))
+		return (int) i;
+	}
+
+	i = (i + 1) & mask;
+    }
+
+    return -1;
+}
+
+/* Returns the entry for a key, -1 if there is none */
+static int
+dictionary_find (dictionary * d,
+		 const char * sec,
+		 size_t       seclen,
+		 const char * key)
+{
+    int slot;
+
+    slot = dictionary_lookup (d, dictionary_hash (sec, seclen, key),
+			      sec, seclen, key);
+
+    return slot < 0 ? -1 : d->slots[slot] - 1;
+}
+
+/* Rebuilds the hash table with nSlots slots, dropping deleted ones */
+static Bool
+dictionary_rehash (dictionary * d, int nSlots)
+{
+    unsigned mask = (unsigned) nSlots - 1;
+    int      *slots;
+    int      i;
+
+    slots = (int *) calloc (nSlots, sizeof (int));
+    if (!slots)
+	return FALSE;
+
+    for (i = 0; i < d->nEntries; ++i)
+    {
+	unsigned j;
+
+	if (!d->entries[i].key)
+	    continue;
+
+	j = d->entries[i].hash & mask;
+	while (slots[j] != DICT_SLOT_EMPTY)
+	    j = (j + 1) & mask;
+
+	slots[j] = i + 1;
+    }
+
+    free (d->slots);
+    d->slots      = slots;
+    d->nSlots     = nSlots;
+    d->nSlotsUsed = d->n;
+
+    return TRUE;
+}
+
+/* Records that the entry no longer matches the file */
+static void
+dictionary_touch (dictionary * d, IniEntry * e)
+{
+    d->changed = TRUE;
+
+    if (e->section >= 0)
+	d->sections[e->section].dirty = TRUE;
+}
+
+static void
+dictionary_link (dictionary * d, int e, int s)
+{
+    IniSection *section = &d->sections[s];
+    IniEntry   *entry   = &d->entries[e];
+
+    entry->section = s;
+    entry->prev    = section->last;
+    entry->next    = -1;
+
+    if (section->last >= 0)
+	d->entries[section->last].next = e;
+    else
+	section->first = e;
+
+    section->last = e;
+}
+
+static void
+dictionary_unlink (dictionary * d, int e)
+{
+    IniEntry   *entry   = &d->entries[e];
+    IniSection *section = &d->sections[entry->section];
+
+    if (entry->prev >= 0)
+	d->entries[entry->prev].next = entry->next;
+    else
+	section->first = entry->next;
+
+    if (entry->next >= 0)
+	d->entries[entry->next].prev = entry->prev;
+    else
+	section->last = entry->prev;
+}
+
+/* Makes entry e, named "section", a section, and moves keys in it
+ * which were added while it did not exist over to it */
+static void
+dictionary_add_section (dictionary * d, int e)
+{
+    const char *name = d->entries[e].key;
+    size_t     len = strlen (name);
+    int        s, i;
 
-    hash = dictionary_hash (key);
+    s = -1;
 
-    for (i = 0; i < d->size; ++i)
+    /* A section that was unset keeps its keys, bring it back */
+    if (d->nRemovedSections)
     {
-	if (!d->key)
-    	    continue;
+	for (i = 0; i < d->nSections; ++i)
+	{
+	    if (d->sections[i].entry < 0 && !strcmp (d->sections[i].name, name))
+	    {
+		s = i;
+		--d->nRemovedSections;
+		break;
+	    }
+	}
+    }
 
-	/* Compare hash */
-	if (hash == d->hash[i])
+    if (s < 0)
+    {
+	if (d->nSections == d->sectionsSize)
 	{
-	    /* Compare string, to avoid hash collisions */
-	    if (!strcmp (key, d->key[i]))
+	    int        size = d->sectionsSize ? d->sectionsSize * 2 : 16;
+	    IniSection *sections;
+
+	    sections = realloc (d->sections, size * sizeof (IniSection));
+	    if (!sections)
 	    {
-		return d->val[i];
+		d->entries[e].section = -1;
+		return;
 	    }
+
+	    d->sections     = sections;
+	    d->sectionsSize = size;
 	}
+
+	s = d->nSections++;
+
+	d->sections[s].name = dictionary_alloc (d, len + 1, TRUE);
+	if (d->sections[s].name)
+	    memcpy (d->sections[s].name, name, len + 1);
+	else
+	    d->sections[s].name = "";
+
+	d->sections[s].first      = -1;
+	d->sections[s].last       = -1;
+	d->sections[s].textOffset = 0;
+	d->sections[s].textLength = 0;
     }
 
-    return def;
+    d->sections[s].entry = e;
+    d->sections[s].dirty = TRUE;
+    d->entries[e].section = s;
+
+    if (d->nOrphans)
+    {
+	for (i = 0; i < d->nEntries; ++i)
+	{
+	    const char *key = d->entries[i].key;
+
+	    if (!key || d->entries[i].section >= 0 ||
+		strncmp (key, name, len) || key[len] != ':')
+		continue;
+
+	    dictionary_link (d, i, s);
+	    --d->nOrphans;
+	}
+    }
 }
 
+/* Sets the value of an entry, reusing its storage when it is big
+ * enough */
+static void
+dictionary_assign (dictionary * d, IniEntry * e, const char * val, Bool fromFile)
+{
+    size_t len;
+
+    if (val && e->val && strlen (e->val) >= (len = strlen (val)))
+    {
+	memmove (e->val, val, len + 1);
+	return;
+    }
+
+    if (e->val && !e->valInArena)
+	free (e->val);
+
+    e->val        = NULL;
+    e->valInArena = fromFile;
+
+    if (!val)
+	return;
+
+    len = strlen (val);
+    e->val = dictionary_alloc (d, len + 1, fromFile);
+    if (e->val)
+	memcpy (e->val, val, len + 1);
+}
 
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Set a value in a dictionary.
-  @param    d       dictionary object to modify.
-  @param    key     Key to modify or add.
-  @param    val     Value to add.
+  @param    d           dictionary object to modify.
+  @param    sec         Section part of the key to modify or add.
+  @param    seclen      Length of sec.
+  @param    key         Part of the key after the colon, NULL for a section.
+  @param    val         Value to add.
+  @param    fromFile    Whether the value is being read from a file.
   @return   void
 
   If the given key is found in the dictionary, the associated value is
@@ -417,79 +709,146 @@ dictionary_get (dictionary * d, char * key, char * def)
   */
 /*--------------------------------------------------------------------------*/
 static void
-dictionary_set (dictionary * d, char * key, char * val)
+dictionary_set (dictionary * d,
+		const char * sec,
+		size_t       seclen,
+		const char * key,
+		const char * val,
+		Bool         fromFile)
 {
-    int         i;
     unsigned    hash;
-
-    if (!d || !key)
+    unsigned    mask;
+    unsigned    j;
+    int         slot, e, i, s;
+    size_t      keylen;
+    IniEntry    *entry;
+    char        *colon;
+
+    if (!d || !sec)
 	return;
 
     /* Compute hash for this key */
-    hash = dictionary_hash (key);
+    hash = dictionary_hash (sec, seclen, key);
 
     /* Find if value is already in blackboard */
-    if (d->n > 0)
+    slot = dictionary_lookup (d, hash, sec, seclen, key);
+    if (slot >= 0)
     {
-	for (i = 0; i < d->size; ++i)
-	{
-	    if (!d->key[i])
-		continue;
+	entry = &d->entries[d->slots[slot] - 1];
 
-	    if (hash == d->hash[i])
-    	    {
-		/* Same hash value */
-	    	if (!strcmp (key, d->key[i]))
-		{
-		    /* Same key */
-		    /* Found a value: modify and return */
-		    if (d->val[i])
-			free (d->val[i]);
-
-		    d->val[i] = val ? strdup (val) : NULL;
-		    /* Value has been modified: return */
-		    return;
-		}
-	    }
-	}
+	if (val == entry->val ||
+	    (val && entry->val && !strcmp (val, entry->val)))
+	    return;
+
+	dictionary_assign (d, entry, val, fromFile);
+	dictionary_touch (d, entry);
+	return;
     }
 
     /* Add a new value */
-    /* See if dictionary needs to grow */
-    if (d->n == d->size)
+    /* See if the hash table needs to grow */
+    if ((d->nSlotsUsed + 1) * 4 > d->nSlots * 3)
     {
-	/* Reached maximum size: reallocate blackboard */
-	d->val  = (char **) mem_double (d->val,  d->size * sizeof (char*));
-	d->key  = (char **) mem_double (d->key,  d->size * sizeof (char*));
-	d->hash = (unsigned int *) mem_double (d->hash,
-					       d->size * sizeof (unsigned));
+	int nSlots = d->nSlots;
 
-	/* Double size */
-	d->size *= 2;
+	while ((d->n + 1) * 2 > nSlots)
+	    nSlots *= 2;
+
+	if (!dictionary_rehash (d, nSlots))
+	    return;
     }
 
-    /* Insert key in the first empty slot */
-    for (i = 0; i < d->size; ++i)
+    if (d->freeEntry >= 0)
+    {
+	e = d->freeEntry;
+	d->freeEntry = d->entries[e].next;
+    }
+    else
     {
-	if (!d->key[i])
+	if (d->nEntries == d->entriesSize)
 	{
-	    /* Add key here */
-    	    break;
+	    IniEntry *entries;
+
+	    entries = realloc (d->entries,
+			       2 * d->entriesSize * sizeof (IniEntry));
+	    if (!entries)
+		return;
+
+	    d->entries      = entries;
+	    d->entriesSize *= 2;
 	}
+
+	e = d->nEntries++;
     }
 
+    entry = &d->entries[e];
+
     /* Copy key */
-    d->key[i]  = strdup (key);
-    d->val[i]  = val ? strdup (val) : NULL;
-    d->hash[i] = hash;
+    keylen = seclen + (key ? strlen (key) + 1 : 0);
+    entry->key = dictionary_alloc (d, keylen + 1, fromFile);
+    if (!entry->key)
+    {
+	entry->next  = d->freeEntry;
+	d->freeEntry = e;
+	return;
+    }
+
+    memcpy (entry->key, sec, seclen);
+    if (key)
+    {
+	entry->key[seclen] = ':';
+	memcpy (entry->key + seclen + 1, key, keylen - seclen - 1);
+    }
+    entry->key[keylen] = '\0';
+
+    for (i = 0; entry->key[i]; ++i)
+	entry->key[i] = (char) tolower ((unsigned char) entry->key[i]);
+
+    entry->keyInArena = fromFile;
+    entry->val        = NULL;
+    entry->valInArena = fromFile;
+    entry->hash       = hash;
+    entry->section    = -1;
+    entry->prev       = -1;
+    entry->next       = -1;
+
+    dictionary_assign (d, entry, val, fromFile);
+
+    mask = (unsigned) d->nSlots - 1;
+    j    = hash & mask;
+    while (d->slots[j] > 0)
+	j = (j + 1) & mask;
+
+    if (d->slots[j] == DICT_SLOT_EMPTY)
+	++d->nSlotsUsed;
+
+    d->slots[j] = e + 1;
     ++d->n;
+
+    /* Put the key in its section */
+    colon = strchr (entry->key, ':');
+    if (!colon)
+	dictionary_add_section (d, e);
+    else
+    {
+	s = dictionary_find (d, entry->key, colon - entry->key, NULL);
+
+	if (s >= 0 && d->entries[s].section >= 0)
+	    dictionary_link (d, e, d->entries[s].section);
+	else
+	    ++d->nOrphans;
+    }
+
+    dictionary_touch (d, &d->entries[e]);
 }
 
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Delete a key in a dictionary
   @param    d       dictionary object to modify.
-  @param    key     Key to remove.
+  @param    sec     Section part of the key to remove.
+  @param    seclen  Length of sec.
+  @param    key     Part of the key after the colon, NULL for a section.
   @return   void
 
   This function deletes a key in a dictionary. Nothing is done if the
@@ -497,44 +856,50 @@ dictionary_set (dictionary * d, char * key, char * val)
   */
 /*--------------------------------------------------------------------------*/
 static void
-dictionary_unset (dictionary * d, char * key)
+dictionary_unset (dictionary * d,
+		  const char * sec,
+		  size_t       seclen,
+		  const char * key)
 {
-    unsigned    hash;
-    int         i;
-
-    hash = dictionary_hash (key);
-
-    for (i = 0; i < d->size; ++i)
-    {
-	if (!d->key[i])
-	    continue;
+    IniEntry *entry;
+    int      slot, e;
 
-	/* Compare hash */
-	if (hash == d->hash[i])
-      	{
-	    /* Compare string, to avoid hash collisions */
-	    if (!strcmp (key, d->key[i]))
-	    {
-		/* Found key */
-		break;
-	    }
-	}
-    }
+    if (!d || !sec)
+	return;
 
-    if (i >= d->size)
+    slot = dictionary_lookup (d, dictionary_hash (sec, seclen, key),
+			      sec, seclen, key);
+    if (slot < 0)
 	/* Key not found */
 	return;
 
-    free (d->key[i]);
+    e     = d->slots[slot] - 1;
+    entry = &d->entries[e];
+
+    dictionary_touch (d, entry);
 
-    d->key[i] = NULL;
-    if (d->val[i])
+    if (entry->section < 0)
+	--d->nOrphans;
+    else if (d->sections[entry->section].entry == e)
     {
-	free (d->val[i]);
-	d->val[i] = NULL;
+	d->sections[entry->section].entry = -1;
+	++d->nRemovedSections;
     }
+    else
+	dictionary_unlink (d, e);
+
+    if (!entry->keyInArena)
+	free (entry->key);
+
+    if (entry->val && !entry->valInArena)
+	free (entry->val);
+
+    entry->key   = NULL;
+    entry->val   = NULL;
+    entry->next  = d->freeEntry;
+    d->freeEntry = e;
 
-    d->hash[i] = 0;
+    d->slots[slot] = DICT_SLOT_DELETED;
     --d->n;
 }
 
@@ -549,17 +914,11 @@ iniparser_add_entry (dictionary * d,
 		     char * key,
 		     char * val)
 {
-    char longkey[2*ASCIILINESZ+1];
+    if (!sec)
+	return;
 
     /* Make a key as section:keyword */
-
-    if (key)
-	sprintf (longkey, "%s:%s", sec, key);
-    else
-	strcpy (longkey, sec);
-
-    /* Add (key,val) to dictionary */
-    dictionary_set (d, longkey, val);
+    dictionary_set (d, sec, strlen (sec), key, val, FALSE);
 }
 
 /*-------------------------------------------------------------------------*/
@@ -569,10 +928,9 @@ iniparser_add_entry (dictionary * d,
   @return   int Number of sections found in dictionary
 
   This function returns the number of sections found in a dictionary.
-  The test to recognize sections is done on the string stored in the
-  dictionary: a section name is given as "section" whereas a key is
-  stored as "section:key", thus the test looks for entries that do not
-  contain a colon.
+  A section name is given as "section" whereas a key is stored as
+  "section:key", thus the dictionary tells a section from a key by
+  the absence of a colon.
 
   This clearly fails in the case a section name contains a colon, but
   this should simply be avoided.
@@ -583,23 +941,10 @@ iniparser_add_entry (dictionary * d,
 int
 iniparser_getnsec (dictionary * d)
 {
-    int i;
-    int nsec;
-
     if (!d)
 	return -1;
 
-    nsec = 0;
-    for (i = 0; i < d->size; ++i)
-    {
-	if (!d->key[i])
-	    continue;
-
-	if (!strchr (d->key[i], ':'))
-	    ++nsec;
-    }
-
-    return nsec;
+    return d->nSections - d->nRemovedSections;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -620,110 +965,240 @@ char*
 iniparser_getsecname (dictionary * d, int n)
 {
     int i;
-    int foundsec;
 
     if (!d || n < 0)
 	return NULL;
 
-    foundsec = 0;
-    for (i = 0; i < d->size; ++i)
+    if (!d->nRemovedSections)
+	return n < d->nSections ? d->sections[n].name : NULL;
+
+    for (i = 0; i < d->nSections; ++i)
     {
-	if (!d->key[i])
+	if (d->sections[i].entry < 0)
 	    continue;
 
-	if (!strchr (d->key[i], ':'))
+	if (!n--)
+	    return d->sections[i].name;
+    }
+
+    return NULL;
+}
+
+/* Output buffer the ini file is assembled in before being written */
+typedef struct _IniBuffer
+{
+    char   *data;
+    size_t size;
+    size_t capacity;
+    Bool   failed;
+} IniBuffer;
+
+static void
+ini_buffer_append (IniBuffer *buffer, const char *s, size_t len)
+{
+    if (buffer->failed)
+	return;
+
+    if (buffer->size + len > buffer->capacity)
+    {
+	size_t capacity = buffer->capacity ? buffer->capacity : ASCIILINESZ;
+	char   *data;
+
+	while (buffer->size + len > capacity)
+	    capacity *= 2;
+
+	data = realloc (buffer->data, capacity);
+	if (!data)
 	{
-	    ++foundsec;
-	    if (foundsec > n)
-		break;
+	    buffer->failed = TRUE;
+	    return;
 	}
+
+	buffer->data     = data;
+	buffer->capacity = capacity;
     }
 
-    if (foundsec <= n)
-	return NULL;
+    memcpy (buffer->data + buffer->size, s, len);
+    buffer->size += len;
+}
 
-    return d->key[i];
+static void
+ini_buffer_append_string (IniBuffer *buffer, const char *s)
+{
+    ini_buffer_append (buffer, s, strlen (s));
+}
+
+/* Whether file_name is the file the dictionary was read from or written
+ * to last, and still is as it was left then */
+static Bool
+iniparser_file_is_current (dictionary * d, const char * file_name)
+{
+    struct stat st;
+
+    if (!d->fileName || strcmp (d->fileName, file_name))
+	return FALSE;
+
+    if (stat (file_name, &st))
+	return FALSE;
+
+    return st.st_ino == d->fileIno &&
+	   st.st_size == d->fileSize &&
+	   st.st_mtim.tv_sec == d->fileMtime.tv_sec &&
+	   st.st_mtim.tv_nsec == d->fileMtime.tv_nsec;
+}
+
+/* Remembers the text last read from or written to file_name */
+static void
+iniparser_set_file (dictionary  * d,
+		    const char  * file_name,
+		    char        * text,
+		    size_t      textSize,
+		    struct stat * st)
+{
+    if (!d->fileName || strcmp (d->fileName, file_name))
+    {
+	free (d->fileName);
+	d->fileName = strdup (file_name);
+    }
+
+    if (d->text != text)
+	free (d->text);
+
+    d->text      = text;
+    d->textSize  = textSize;
+    d->fileIno   = st->st_ino;
+    d->fileSize  = st->st_size;
+    d->fileMtime = st->st_mtim;
 }
 
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Save a dictionary to a loadable ini file
-  @param    d   Dictionary to dump
-  @param    f   Opened file pointer to dump to
+  @param    d           Dictionary to dump
+  @param    file_name   Name of the file to write
   @return   void
 
   This function dumps a given dictionary into a loadable ini file.
-  It is Ok to specify @c stderr or @c stdout as output files.
+
+  Sections which did not change since the dictionary was read from or
+  written to a file are copied from the text of that file instead of
+  being formatted again, and the file is not written at all if nothing
+  changed since it was.
   */
 /*--------------------------------------------------------------------------*/
 void
 iniparser_dump_ini (dictionary * d, const char * file_name)
 {
-    int     i, j;
-    char    keym[ASCIILINESZ+1];
-    int     nsec;
-    char *  secname;
-    int     seclen;
-    FILE *  f;
-    FileLock *lock;
+    IniBuffer   buffer;
+    struct stat st;
+    int         i, e;
+    FILE *      f;
+    FileLock    *lock;
+    Bool        written;
 
     if (!d)
     	return;
 
-    lock = ini_file_lock (file_name, TRUE);
-    if (!lock)
+    if (!d->changed && iniparser_file_is_current (d, file_name))
 	return;
 
-    f = fdopen (lock->fd, "w");
-    if (!f)
-    {
-	ini_file_unlock (lock);
-	return;
-    }
+    memset (&buffer, 0, sizeof (IniBuffer));
 
-    nsec = iniparser_getnsec (d);
-    if (nsec < 1)
+    if (iniparser_getnsec (d) < 1)
     {
 	/* No section in file: dump all keys as they are */
-	for (i = 0; i < d->size; ++i)
+	for (e = 0; e < d->nEntries; ++e)
 	{
-	    if (!d->key[i])
+	    if (!d->entries[e].key)
 		continue;
-	    fprintf (f, "%s = %s\n", d->key[i], d->val[i]);
-	}
 
-	fflush (f);
-	fclose (f);
-	ini_file_unlock (lock);
-	return;
+	    ini_buffer_append_string (&buffer, d->entries[e].key);
+	    ini_buffer_append_string (&buffer, " = ");
+	    if (d->entries[e].val)
+		ini_buffer_append_string (&buffer, d->entries[e].val);
+	    ini_buffer_append_string (&buffer, "\n");
+	}
     }
 
-    for (i = 0; i < nsec; ++i)
+    for (i = 0; i < d->nSections; ++i)
     {
-	secname = iniparser_getsecname (d, i);
-	seclen  = (int) strlen (secname);
-	fprintf (f, "[%s]\n", secname);
-	sprintf (keym, "%s:", secname);
+	IniSection *section = &d->sections[i];
+	size_t     offset = buffer.size;
+	size_t     seclen;
 
-	for (j = 0; j < d->size; ++j)
+	if (section->entry < 0)
+	    continue;
+
+	if (!section->dirty)
 	{
-	    if (!d->key[j])
-		continue;
+	    ini_buffer_append (&buffer, d->text + section->textOffset,
+			       section->textLength);
+	    if (!section->textLength ||
+		d->text[section->textOffset + section->textLength - 1] != '\n')
+		ini_buffer_append_string (&buffer, "\n");
+	}
+	else
+	{
+	    seclen = strlen (section->name);
 
-	    if (!strncmp (d->key[j], keym, seclen + 1))
+	    ini_buffer_append_string (&buffer, "[");
+	    ini_buffer_append (&buffer, section->name, seclen);
+	    ini_buffer_append_string (&buffer, "]\n");
+
+	    for (e = section->first; e >= 0; e = d->entries[e].next)
 	    {
-    		fprintf (f, "%s = %s\n",
-		       	 d->key[j] + seclen + 1,
-	    		 d->val[j] ? d->val[j] : "");
-    	    }
+		ini_buffer_append_string (&buffer,
+					  d->entries[e].key + seclen + 1);
+		ini_buffer_append_string (&buffer, " = ");
+		if (d->entries[e].val)
+		    ini_buffer_append_string (&buffer, d->entries[e].val);
+		ini_buffer_append_string (&buffer, "\n");
+	    }
+
+	    ini_buffer_append_string (&buffer, "\n");
 	}
 
-    	fprintf (f, "\n");
+	section->textOffset = offset;
+	section->textLength = buffer.size - offset;
+    }
+
+    written = FALSE;
+
+    if (!buffer.failed)
+    {
+	lock = ini_file_lock (file_name, TRUE);
+	if (lock)
+	{
+	    f = fdopen (lock->fd, "w");
+	    if (f)
+	    {
+		written = fwrite (buffer.data, 1, buffer.size, f) == buffer.size &&
+			  !fflush (f) && !fstat (lock->fd, &st);
+		fclose (f);
+	    }
+
+	    ini_file_unlock (lock);
+	}
     }
 
-    fflush (f);
-    fclose (f);
-    ini_file_unlock (lock );
+    if (!written)
+    {
+	/* The text offsets now point into the buffer, so format everything
+	 * again next time */
+	for (i = 0; i < d->nSections; ++i)
+	    d->sections[i].dirty = TRUE;
+
+	d->changed = TRUE;
+	free (buffer.data);
+	return;
+    }
+
+    iniparser_set_file (d, file_name, buffer.data, buffer.size, &st);
+
+    for (i = 0; i < d->nSections; ++i)
+	d->sections[i].dirty = FALSE;
+
+    d->changed = FALSE;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -744,17 +1219,38 @@ iniparser_dump_ini (dictionary * d, const char * file_name)
 char*
 iniparser_getstring (dictionary * d, char * key, char * def)
 {
-    char * lc_key;
-    char * sval;
+    return iniparser_getsecstring (d, key, NULL, def);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Get the string associated to a key in a section
+  @param    d       Dictionary to search
+  @param    sec     Section of the key
+  @param    key     Key string to look for
+  @param    def     Default value to return if key not found.
+  @return   pointer to statically allocated character string
+
+  Same as iniparser_getstring for the key "sec:key", without building
+  that string.
+  */
+/*--------------------------------------------------------------------------*/
+char*
+iniparser_getsecstring (dictionary * d,
+			const char * sec,
+			const char * key,
+			char       * def)
+{
+    int e;
 
-    if (!d || !key)
+    if (!d || !sec)
 	return def;
 
-    lc_key = strdup (strlwc (key));
-    sval = dictionary_get (d, lc_key, def);
-    free (lc_key);
+    e = dictionary_find (d, sec, strlen (sec), key);
+    if (e < 0)
+	return def;
 
-    return sval;
+    return d->entries[e].val;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -798,10 +1294,42 @@ iniparser_find_entry (dictionary  *ini, char *entry)
 int
 iniparser_setstr (dictionary * ini, char * entry, char * val)
 {
-    dictionary_set (ini, strlwc (entry), val);
+    if (!entry)
+	return -1;
+
+    dictionary_set (ini, entry, strlen (entry), NULL, val, FALSE);
     return 0;
 }
 
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Set an entry of a section in a dictionary.
+  @param    ini     Dictionary to modify.
+  @param    sec     Section of the entry, added if it does not exist
+  @param    key     Entry to modify (entry name)
+  @param    val     New value to associate to the entry.
+  @return   void
+  */
+/*--------------------------------------------------------------------------*/
+void
+iniparser_setsecstr (dictionary * ini,
+		     const char * sec,
+		     const char * key,
+		     const char * val)
+{
+    size_t seclen;
+
+    if (!ini || !sec || !key)
+	return;
+
+    seclen = strlen (sec);
+
+    if (dictionary_find (ini, sec, seclen, NULL) < 0)
+	dictionary_set (ini, sec, seclen, NULL, NULL, FALSE);
+
+    dictionary_set (ini, sec, seclen, key, val, FALSE);
+}
+
 /*-------------------------------------------------------------------------*/
 /**
   @brief    Delete an entry in a dictionary
@@ -815,7 +1343,68 @@ iniparser_setstr (dictionary * ini, char * entry, char * val)
 void
 iniparser_unset (dictionary * ini, char * entry)
 {
-    dictionary_unset (ini, strlwc (entry));
+    if (!entry)
+	return;
+
+    dictionary_unset (ini, entry, strlen (entry), NULL);
+}
+
+/*-------------------------------------------------------------------------*/
+/**
+  @brief    Delete an entry of a section in a dictionary
+  @param    ini     Dictionary to modify
+  @param    sec     Section of the entry
+  @param    key     Entry to delete (entry name)
+  @return   void
+  */
+/*--------------------------------------------------------------------------*/
+void
+iniparser_unsetsec (dictionary * ini, const char * sec, const char * key)
+{
+    if (!sec || !key)
+	return;
+
+    dictionary_unset (ini, sec, strlen (sec), key);
+}
+
+/* Reads the whole of an ini file into memory */
+static Bool
+iniparser_read_text (FILE *ini, char **text, size_t *textSize, struct stat *st)
+{
+    size_t capacity, size, n;
+    char   *data, *newData;
+
+    if (fstat (fileno (ini), st))
+	return FALSE;
+
+    capacity = st->st_size + 1;
+    size     = 0;
+    data     = malloc (capacity);
+    if (!data)
+	return FALSE;
+
+    while ((n = fread (data + size, 1, capacity - size, ini)) > 0)
+    {
+	size += n;
+	if (size < capacity)
+	    continue;
+
+	/* The file grew while being read */
+	newData = realloc (data, capacity * 2);
+	if (!newData)
+	{
+	    free (data);
+	    return FALSE;
+	}
+
+	data      = newData;
+	capacity *= 2;
+    }
+
+    *text     = data;
+    *textSize = size;
+
+    return TRUE;
 }
 
 /*-------------------------------------------------------------------------*/
@@ -829,6 +1418,9 @@ iniparser_unset (dictionary * ini, char * entry)
   should not be accessed directly, but through accessor functions
   instead.
 
+  The text of the file is kept with the dictionary, so that sections
+  which are not changed can be written back as they were.
+
   The returned dictionary must be freed using iniparser_free().
   */
 /*--------------------------------------------------------------------------*/
@@ -841,9 +1433,18 @@ iniparser_new (char *ininame)
     char        key[ASCIILINESZ+1];
     char        val[ASCIILINESZ+1];
     char    *   where;
+    char    *   text;
+    char    *   end;
+    size_t      textSize;
+    size_t      offset;
+    size_t      length;
+    struct stat st;
     FILE    *   ini;
     int         lineno;
+    int         current;
+    int         i;
     FileLock *  lock;
+    Bool        read;
 
     lock = ini_file_lock (ininame, FALSE);
     if (!lock)
@@ -857,16 +1458,44 @@ iniparser_new (char *ininame)
 	return NULL;
     }
 
+    read = iniparser_read_text (ini, &text, &textSize, &st);
+
+    fclose (ini);
+    if (lock)
+	ini_file_unlock (lock );
+
+    if (!read)
+	return NULL;
+
     sec[0] = 0;
 
     /*
      * Initialize a new dictionary entry
      */
     d = dictionary_new (0);
-    lineno = 0;
+    if (!d)
+    {
+	free (text);
+	return NULL;
+    }
+
+    iniparser_set_file (d, ininame, text, textSize, &st);
 
-    while (fgets (lin, ASCIILINESZ, ini) != NULL)
+    lineno  = 0;
+    offset  = 0;
+    current = -1;
+
+    /* Split the text into lines the way fgets would */
+    for (offset = 0; offset < textSize; offset += length)
     {
+	end = memchr (text + offset, '\n', textSize - offset);
+	length = end ? (size_t) (end - text) - offset + 1 : textSize - offset;
+	if (length > ASCIILINESZ - 1)
+	    length = ASCIILINESZ - 1;
+
+	memcpy (lin, text + offset, length);
+	lin[length] = '\0';
+
 	++lineno;
 	where = strskp (lin); /* Skip leading spaces */
 
@@ -878,9 +1507,38 @@ iniparser_new (char *ininame)
 
 	    if (sscanf (where, "[%[^]]", sec) == 1)
 	    {
+		IniSection *section;
+		int        e;
+
 		/* Valid section name */
 		strcpy (sec, strlwc (sec));
-		iniparser_add_entry (d, sec, NULL, NULL);
+		dictionary_set (d, sec, strlen (sec), NULL, NULL, TRUE);
+
+		/* The text of a section runs up to the next one */
+		if (current >= 0)
+		    d->sections[current].textLength =
+			offset - d->sections[current].textOffset;
+
+		current = -1;
+
+		e = dictionary_find (d, sec, strlen (sec), NULL);
+		if (e < 0 || d->entries[e].section < 0)
+		    continue;
+
+		section = &d->sections[d->entries[e].section];
+
+		/* Sections appearing twice are formatted again */
+		if (section->textLength ||
+		    section->textOffset == DICT_NO_TEXT)
+		{
+		    section->textOffset = DICT_NO_TEXT;
+		    section->textLength = 0;
+		    continue;
+		}
+
+		current             = d->entries[e].section;
+		section->textOffset = offset;
+		section->textLength = length;
 	    }
 	    else if (sscanf (where, "%[^=] = \"%[^\"]\"", key, val) == 2 ||
 		     sscanf (where, "%[^=] = '%[^\']'",   key, val) == 2 ||
@@ -901,14 +1559,20 @@ iniparser_new (char *ininame)
 		    strcpy (val, strcrop (val));
 		}
 
-	    	iniparser_add_entry (d, sec, key, val);
+		dictionary_set (d, sec, strlen (sec), key, val, TRUE);
     	    }
 	}
     }
 
-    fclose (ini);
-    if (lock)
-	ini_file_unlock (lock );
+    if (current >= 0)
+	d->sections[current].textLength =
+	    textSize - d->sections[current].textOffset;
+
+    /* Everything read so far matches the file */
+    for (i = 0; i < d->nSections; ++i)
+	d->sections[i].dirty = !d->sections[i].textLength;
+
+    d->changed = FALSE;
 
     return d;
 }
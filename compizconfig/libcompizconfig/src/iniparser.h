@@ -36,8 +36,13 @@
 #include <unistd.h>
 #include <ctype.h>
 
+#include <sys/types.h>
+#include <time.h>
+
 #include <ccs.h>
 
+COMPIZCONFIG_BEGIN_DECLS
+
 typedef IniDictionary dictionary;
 
 typedef struct _FileLock
@@ -45,6 +50,82 @@ typedef struct _FileLock
 	int fd;
 } FileLock;
 
+/* Block of memory the keys and values read from a file are carved from */
+typedef struct _IniArenaBlock
+{
+    struct _IniArenaBlock *next;
+    size_t                used;
+    size_t                size;
+    char                  data[];
+} IniArenaBlock;
+
+typedef struct _IniEntry
+{
+    /** Key as "section" or "section:key", in lower case. NULL once unset */
+    char     *key;
+    /** Value, NULL for sections */
+    char     *val;
+    /** Whether key and val point into the arena rather than being malloc'd */
+    Bool     keyInArena;
+    Bool     valInArena;
+    /** Hash of the key */
+    unsigned hash;
+    /** Section this entry names or belongs to, -1 if there is none */
+    int      section;
+    /** Neighbouring keys of the same section, -1 at either end. Unset
+     * entries are chained through next for reuse */
+    int      prev;
+    int      next;
+} IniEntry;
+
+typedef struct _IniSection
+{
+    /** Section name, same as the key of its entry */
+    char   *name;
+    /** Entry naming the section, -1 if the section was unset */
+    int    entry;
+    /** Keys of the section, in insertion order */
+    int    first;
+    int    last;
+    /** Whether the section differs from its text in the file */
+    Bool   dirty;
+    /** Where the section is in the text of the file, if it is clean */
+    size_t textOffset;
+    size_t textLength;
+} IniSection;
+
+struct _dictionary_
+{
+    /** Number of live entries */
+    int           n;
+    /** Entries, in insertion order */
+    IniEntry      *entries;
+    int           nEntries;
+    int           entriesSize;
+    int           freeEntry;
+    /** Open addressing table of entry indices */
+    int           *slots;
+    int           nSlots;
+    int           nSlotsUsed;
+    /** Sections, in insertion order */
+    IniSection    *sections;
+    int           nSections;
+    int           sectionsSize;
+    int           nRemovedSections;
+    /** Keys whose section does not exist */
+    int           nOrphans;
+    IniArenaBlock *arena;
+    /** Whether anything was changed since the file was read or written */
+    Bool          changed;
+    /** File last read or written, its contents and its stamp */
+    char          *fileName;
+    char          *text;
+    size_t        textSize;
+    struct timespec fileMtime;
+    off_t         fileSize;
+    ino_t         fileIno;
+};
+
 /* generated by genproto */
 
 dictionary * iniparser_new(char *ininame);
@@ -56,10 +137,15 @@ int iniparser_getnsec(dictionary * d);
 char * iniparser_getsecname(dictionary * d, int n);
 void iniparser_dump_ini(dictionary * d, const char * file_name);
 char * iniparser_getstring(dictionary * d, char * key, char * def);
+char * iniparser_getsecstring(dictionary * d, const char * sec, const char * key, char * def);
 void iniparser_add_entry(dictionary * d, char * sec, char * key, char * val);
 int iniparser_find_entry(dictionary  *   ini, char        *   entry);
 int iniparser_setstr(dictionary * ini, char * entry, char * val);
+void iniparser_setsecstr(dictionary * ini, const char * sec, const char * key, const char * val);
 void iniparser_unset(dictionary * ini, char * entry);
+void iniparser_unsetsec(dictionary * ini, const char * sec, const char * key);
+
+COMPIZCONFIG_END_DECLS
 
 #endif
 
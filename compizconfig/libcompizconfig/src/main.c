@@ -418,9 +418,13 @@ static Bool
 ccsContextAddChangedSettingDefault (CCSContext *context, CCSSetting *setting)
 {
     CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, context);
+    Bool              wasEmpty = (cPrivate->changedSettings == NULL);
 
     cPrivate->changedSettings = ccsSettingListAppend (cPrivate->changedSettings, setting);
 
+    if (wasEmpty && cPrivate->changedSettingsNotify)
+	(*cPrivate->changedSettingsNotify) (context, cPrivate->changedSettingsNotifyClosure);
+
     return TRUE;
 }
 
@@ -818,6 +822,8 @@ ccsFreeContextDefault (CCSContext * c)
 
     CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, c);
 
+    ccsSyncMetadataCache ();
+
     if (cPrivate->profile)
 	free (cPrivate->profile);
 
@@ -877,11 +883,6 @@ ccsFreePluginDefault (CCSPlugin * p)
     if (pPrivate->xmlPath)
 	free (pPrivate->xmlPath);
 
-#ifdef USE_PROTOBUF
-    if (pPrivate->pbFilePath)
-	free (pPrivate->pbFilePath);
-#endif
-
     ccsObjectFinalize (p);
     free (p);
 }
@@ -3467,6 +3468,7 @@ ccsProcessEventsDefault (CCSContext * context, unsigned int flags)
     CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, context);
 
     ccsCheckFileWatches ();
+    ccsSyncMetadataCache ();
 
     if (cPrivate->backend)
 	ccsBackendExecuteEvents ((CCSBackend *) cPrivate->backend, flags);
@@ -3481,6 +3483,20 @@ ccsProcessEvents (CCSContext *context, unsigned int flags)
     (*(GET_INTERFACE (CCSContextInterface, context))->contextProcessEvents) (context, flags);
 }
 
+void
+ccsSetChangedSettingsNotify (CCSContext                   *context,
+			     CCSChangedSettingsNotifyProc notify,
+			     void                         *closure)
+{
+    if (!context)
+	return;
+
+    CCSContextPrivate *cPrivate = GET_PRIVATE (CCSContextPrivate, context);
+
+    cPrivate->changedSettingsNotify = notify;
+    cPrivate->changedSettingsNotifyClosure = closure;
+}
+
 void
 ccsReadSettingsDefault (CCSContext * context)
 {
@@ -4356,6 +4372,8 @@ ccsExportToFileDefault (CCSContext *context,
     ccsIniSave (exportFile, fileName);
     ccsIniClose (exportFile);
 
+    ccsSyncMetadataCache ();
+
     return TRUE;
 }
 
@@ -5164,6 +5182,8 @@ ccsImportFromFileDefault (CCSContext *context,
 
     ccsIniClose (importFile);
 
+    ccsSyncMetadataCache ();
+
     return TRUE;
 }
 
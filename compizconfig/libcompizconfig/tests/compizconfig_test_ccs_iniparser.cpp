@@ -0,0 +1,347 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "iniparser.h"
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::NotNull;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::StrEq;
+
+namespace
+{
+    const char *iniContents =
+	"[core]\n"
+	"; kept as is\n"
+	"s0_active_plugins = core;composite;opengl\n"
+	"s0_hsize = 4\n"
+	"\n"
+	"[Wall]\n"
+	"s0_edgeflip_pointer = true\n"
+	"\n";
+}
+
+class CCSIniParserTest :
+    public ::testing::Test
+{
+    public:
+
+	virtual void SetUp ()
+	{
+	    char dirTemplate[] = "/tmp/ccs_iniparser_test.XXXXXX";
+
+	    ASSERT_THAT (mkdtemp (dirTemplate), NotNull ());
+
+	    dir  = dirTemplate;
+	    path = dir + "/profile.ini";
+	}
+
+	virtual void TearDown ()
+	{
+	    std::string command = "rm -rf '" + dir + "'";
+	    ASSERT_THAT (system (command.c_str ()), Eq (0));
+	}
+
+	void writeFile (const std::string &contents)
+	{
+	    std::ofstream file (path.c_str ());
+	    file << contents;
+	}
+
+	std::string readFile ()
+	{
+	    std::ifstream     file (path.c_str ());
+	    std::stringstream contents;
+
+	    contents << file.rdbuf ();
+	    return contents.str ();
+	}
+
+	std::string dir;
+	std::string path;
+};
+
+TEST_F (CCSIniParserTest, TestLookupIgnoresCase)
+{
+    dictionary *d = dictionary_new (0);
+
+    iniparser_setsecstr (d, "Plugin", "Key", "value");
+
+    EXPECT_THAT (iniparser_getstring (d, (char *) "plugin:key", NULL), StrEq ("value"));
+    EXPECT_THAT (iniparser_getsecstring (d, "PLUGIN", "kEy", NULL), StrEq ("value"));
+    EXPECT_THAT (iniparser_find_entry (d, (char *) "Plugin"), Eq (1));
+    EXPECT_THAT (iniparser_getsecname (d, 0), StrEq ("plugin"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestSetReplacesAndUnsetRemoves)
+{
+    dictionary *d = dictionary_new (0);
+    char       def[] = "default";
+
+    iniparser_setsecstr (d, "plugin", "key", "a rather long value");
+    iniparser_setsecstr (d, "plugin", "key", "short");
+    EXPECT_THAT (iniparser_getsecstring (d, "plugin", "key", NULL), StrEq ("short"));
+
+    iniparser_setsecstr (d, "plugin", "key", "a value longer than the first one");
+    EXPECT_THAT (iniparser_getsecstring (d, "plugin", "key", NULL),
+		 StrEq ("a value longer than the first one"));
+
+    iniparser_unsetsec (d, "plugin", "key");
+    EXPECT_THAT (iniparser_getsecstring (d, "plugin", "key", def), Eq (def));
+    EXPECT_THAT (iniparser_find_entry (d, (char *) "plugin:key"), Eq (0));
+
+    iniparser_setsecstr (d, "plugin", "key", "again");
+    EXPECT_THAT (iniparser_getsecstring (d, "plugin", "key", NULL), StrEq ("again"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestManyKeys)
+{
+    const int  nSections = 200;
+    const int  nKeys = 200;
+    dictionary *d = dictionary_new (0);
+    char       sec[32], key[32], val[32];
+
+    for (int i = 0; i < nSections; ++i)
+	for (int j = 0; j < nKeys; ++j)
+	{
+	    snprintf (sec, sizeof (sec), "plugin%d", i);
+	    snprintf (key, sizeof (key), "s0_setting%d", j);
+	    snprintf (val, sizeof (val), "%d", i * nKeys + j);
+	    iniparser_setsecstr (d, sec, key, val);
+	}
+
+    /* Remove every other key of the first section */
+    for (int j = 0; j < nKeys; j += 2)
+    {
+	snprintf (key, sizeof (key), "s0_setting%d", j);
+	iniparser_unsetsec (d, "plugin0", key);
+    }
+
+    EXPECT_THAT (iniparser_getnsec (d), Eq (nSections));
+
+    for (int i = 0; i < nSections; ++i)
+    {
+	snprintf (sec, sizeof (sec), "plugin%d", i);
+	EXPECT_THAT (iniparser_getsecname (d, i), StrEq (sec));
+
+	for (int j = 0; j < nKeys; ++j)
+	{
+	    snprintf (key, sizeof (key), "s0_setting%d", j);
+	    snprintf (val, sizeof (val), "%d", i * nKeys + j);
+
+	    if (!i && !(j % 2))
+		EXPECT_THAT (iniparser_getsecstring (d, sec, key, NULL), IsNull ());
+	    else
+		EXPECT_THAT (iniparser_getsecstring (d, sec, key, NULL), StrEq (val));
+	}
+    }
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestReadsFile)
+{
+    writeFile (iniContents);
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+    EXPECT_THAT (iniparser_getnsec (d), Eq (2));
+    EXPECT_THAT (iniparser_getsecname (d, 1), StrEq ("wall"));
+    EXPECT_THAT (iniparser_getsecstring (d, "core", "s0_hsize", NULL), StrEq ("4"));
+    EXPECT_THAT (iniparser_getsecstring (d, "wall", "s0_edgeflip_pointer", NULL),
+		 StrEq ("true"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestRoundTrip)
+{
+    dictionary *d = dictionary_new (0);
+
+    iniparser_setsecstr (d, "core", "s0_hsize", "4");
+    iniparser_setsecstr (d, "core", "s0_vsize", "");
+    iniparser_setsecstr (d, "wall", "s0_edgeflip_pointer", "true");
+    iniparser_dump_ini (d, path.c_str ());
+    iniparser_free (d);
+
+    EXPECT_THAT (readFile (), StrEq ("[core]\n"
+				     "s0_hsize = 4\n"
+				     "s0_vsize = \n"
+				     "\n"
+				     "[wall]\n"
+				     "s0_edgeflip_pointer = true\n"
+				     "\n"));
+
+    d = iniparser_new ((char *) path.c_str ());
+    ASSERT_THAT (d, NotNull ());
+    EXPECT_THAT (iniparser_getsecstring (d, "core", "s0_hsize", NULL), StrEq ("4"));
+    EXPECT_THAT (iniparser_getsecstring (d, "core", "s0_vsize", NULL), StrEq (""));
+    EXPECT_THAT (iniparser_getsecstring (d, "wall", "s0_edgeflip_pointer", NULL),
+		 StrEq ("true"));
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestSaveKeepsUnchangedSections)
+{
+    writeFile (iniContents);
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+
+    iniparser_setsecstr (d, "wall", "s0_edgeflip_pointer", "false");
+    iniparser_dump_ini (d, path.c_str ());
+
+    EXPECT_THAT (readFile (), StrEq ("[core]\n"
+				     "; kept as is\n"
+				     "s0_active_plugins = core;composite;opengl\n"
+				     "s0_hsize = 4\n"
+				     "\n"
+				     "[wall]\n"
+				     "s0_edgeflip_pointer = false\n"
+				     "\n"));
+
+    /* Sections written out are clean again */
+    iniparser_setsecstr (d, "core", "s0_hsize", "2");
+    iniparser_dump_ini (d, path.c_str ());
+
+    EXPECT_THAT (readFile (), StrEq ("[core]\n"
+				     "s0_active_plugins = core;composite;opengl\n"
+				     "s0_hsize = 2\n"
+				     "\n"
+				     "[wall]\n"
+				     "s0_edgeflip_pointer = false\n"
+				     "\n"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestSaveWithoutChangesLeavesFileAlone)
+{
+    writeFile (iniContents);
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+
+    /* Setting a value to what it already is is not a change */
+    iniparser_setsecstr (d, "core", "s0_hsize", "4");
+
+    /* Replace the file behind the dictionary's back, keeping its stamp */
+    struct stat st;
+    ASSERT_THAT (stat (path.c_str (), &st), Eq (0));
+
+    std::string contents (iniContents);
+    contents[contents.find ("4")] = '5';
+
+    int fd = open (path.c_str (), O_WRONLY);
+    ASSERT_THAT (fd, Not (Eq (-1)));
+    ASSERT_THAT (write (fd, contents.c_str (), contents.size ()),
+		 Eq ((ssize_t) contents.size ()));
+
+    struct timespec times[2] = { st.st_atim, st.st_mtim };
+    ASSERT_THAT (futimens (fd, times), Eq (0));
+    close (fd);
+
+    iniparser_dump_ini (d, path.c_str ());
+    EXPECT_THAT (readFile (), StrEq (contents));
+
+    /* Another file is always written */
+    std::string otherPath = dir + "/other.ini";
+    iniparser_dump_ini (d, otherPath.c_str ());
+
+    std::ifstream other (otherPath.c_str ());
+    std::string   firstLine;
+    std::getline (other, firstLine);
+    EXPECT_THAT (firstLine, StrEq ("[core]"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestSaveAfterOutsideChangeRewritesFile)
+{
+    writeFile (iniContents);
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+
+    writeFile ("[core]\ns0_hsize = 9\n");
+    iniparser_dump_ini (d, path.c_str ());
+
+    EXPECT_THAT (readFile (), HasSubstr ("s0_hsize = 4\n"));
+    EXPECT_THAT (readFile (), HasSubstr ("s0_edgeflip_pointer = true\n"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestRepeatedSectionsAreMerged)
+{
+    writeFile ("[core]\n"
+	       "s0_hsize = 4\n"
+	       "[wall]\n"
+	       "s0_edgeflip_pointer = true\n"
+	       "[core]\n"
+	       "s0_vsize = 2\n");
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+    EXPECT_THAT (iniparser_getnsec (d), Eq (2));
+
+    iniparser_setsecstr (d, "wall", "s0_edgeflip_pointer", "false");
+    iniparser_dump_ini (d, path.c_str ());
+
+    EXPECT_THAT (readFile (), StrEq ("[core]\n"
+				     "s0_hsize = 4\n"
+				     "s0_vsize = 2\n"
+				     "\n"
+				     "[wall]\n"
+				     "s0_edgeflip_pointer = false\n"
+				     "\n"));
+
+    iniparser_free (d);
+}
+
+TEST_F (CCSIniParserTest, TestUnsetSectionIsNotWritten)
+{
+    writeFile (iniContents);
+
+    dictionary *d = iniparser_new ((char *) path.c_str ());
+
+    ASSERT_THAT (d, NotNull ());
+
+    iniparser_unset (d, (char *) "wall");
+    EXPECT_THAT (iniparser_getnsec (d), Eq (1));
+
+    iniparser_dump_ini (d, path.c_str ());
+    EXPECT_THAT (readFile (), Not (HasSubstr ("wall")));
+
+    /* Its keys come back with it */
+    iniparser_setstr (d, (char *) "wall", NULL);
+    EXPECT_THAT (iniparser_getnsec (d), Eq (2));
+    EXPECT_THAT (iniparser_getsecname (d, 1), StrEq ("wall"));
+
+    iniparser_dump_ini (d, path.c_str ());
+    EXPECT_THAT (readFile (), HasSubstr ("[wall]\ns0_edgeflip_pointer = true\n"));
+
+    iniparser_free (d);
+}
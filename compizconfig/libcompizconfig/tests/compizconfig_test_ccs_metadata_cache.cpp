@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "ccs_metadata_cache.h"
+
+using ::testing::Eq;
+using ::testing::NotNull;
+
+namespace
+{
+    const unsigned int CACHE_VERSION = 1;
+
+    MATCHER(BoolTrue, "Boolean True") { if (arg) return true; else return false; }
+    MATCHER(BoolFalse, "Boolean False") { if (!arg) return true; else return false; }
+}
+
+class CCSMetadataCacheTest :
+    public ::testing::Test
+{
+    public:
+
+	virtual void SetUp ()
+	{
+	    char dirTemplate[] = "/tmp/ccs_metadata_cache_test.XXXXXX";
+
+	    ASSERT_THAT (mkdtemp (dirTemplate), NotNull ());
+
+	    dir       = dirTemplate;
+	    imagePath = dir + "/metadata.cache";
+	    cache     = ccsMetadataCacheOpen (imagePath.c_str (), CACHE_VERSION);
+
+	    ASSERT_THAT (cache, NotNull ());
+	}
+
+	virtual void TearDown ()
+	{
+	    ccsMetadataCacheFree (cache);
+
+	    std::string command = "rm -rf '" + dir + "'";
+	    ASSERT_THAT (system (command.c_str ()), Eq (0));
+	}
+
+	/* Creates a source file and returns its stamp */
+	struct stat writeSource (const std::string &name, const std::string &contents)
+	{
+	    std::string path = dir + "/" + name;
+	    FILE        *file = fopen (path.c_str (), "w");
+	    struct stat st;
+
+	    fputs (contents.c_str (), file);
+	    fclose (file);
+	    stat (path.c_str (), &st);
+
+	    return st;
+	}
+
+	std::string source (const std::string &name)
+	{
+	    return dir + "/" + name;
+	}
+
+	void update (const std::string &name, const struct stat &st,
+		     CCSMetadataCacheRecord record, const std::string &data)
+	{
+	    EXPECT_THAT (ccsMetadataCacheUpdate (cache, source (name).c_str (), &st,
+						 record, data.data (), data.size ()),
+			 BoolTrue ());
+	}
+
+	std::string lookup (CCSMetadataCache       *c,
+			    const std::string      &name,
+			    const struct stat      &st,
+			    CCSMetadataCacheRecord record)
+	{
+	    const void *data;
+	    size_t     size;
+
+	    if (!ccsMetadataCacheLookup (c, source (name).c_str (), &st, record,
+					 &data, &size))
+		return "";
+
+	    return std::string (static_cast <const char *> (data), size);
+	}
+
+	void reopen ()
+	{
+	    ccsMetadataCacheFree (cache);
+	    cache = ccsMetadataCacheOpen (imagePath.c_str (), CACHE_VERSION);
+	}
+
+	std::string      dir;
+	std::string      imagePath;
+	CCSMetadataCache *cache;
+};
+
+TEST_F (CCSMetadataCacheTest, TestMissingImageIsEmpty)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheBrief), Eq (""));
+}
+
+TEST_F (CCSMetadataCacheTest, TestPendingUpdatesAreVisible)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheBrief), Eq ("brief"));
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheFull), Eq (""));
+}
+
+TEST_F (CCSMetadataCacheTest, TestSyncedRecordsAreMapped)
+{
+    struct stat core = writeSource ("core.xml", "<compiz/>");
+    struct stat move = writeSource ("move.xml", "<compiz></compiz>");
+
+    update ("move.xml", move, CCSMetadataCacheBrief, "move brief");
+    update ("core.xml", core, CCSMetadataCacheBrief, "core brief");
+    update ("core.xml", core, CCSMetadataCacheFull, std::string ("core\0full", 9));
+
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+    reopen ();
+
+    EXPECT_THAT (lookup (cache, "core.xml", core, CCSMetadataCacheBrief), Eq ("core brief"));
+    EXPECT_THAT (lookup (cache, "core.xml", core, CCSMetadataCacheFull),
+		 Eq (std::string ("core\0full", 9)));
+    EXPECT_THAT (lookup (cache, "move.xml", move, CCSMetadataCacheBrief), Eq ("move brief"));
+    EXPECT_THAT (lookup (cache, "move.xml", move, CCSMetadataCacheFull), Eq (""));
+}
+
+TEST_F (CCSMetadataCacheTest, TestUpdatingOneRecordKeepsTheOther)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    update ("core.xml", st, CCSMetadataCacheFull, "full");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+    reopen ();
+
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheBrief), Eq ("brief"));
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheFull), Eq ("full"));
+}
+
+TEST_F (CCSMetadataCacheTest, TestChangedSourceMisses)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    struct stat changed = writeSource ("core.xml", "<compiz><plugin/></compiz>");
+
+    EXPECT_THAT (lookup (cache, "core.xml", changed, CCSMetadataCacheBrief), Eq (""));
+}
+
+TEST_F (CCSMetadataCacheTest, TestBriefForChangedSourceDropsFull)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    update ("core.xml", st, CCSMetadataCacheFull, "full");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    struct stat changed = writeSource ("core.xml", "<compiz><plugin/></compiz>");
+
+    update ("core.xml", changed, CCSMetadataCacheBrief, "new brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+    reopen ();
+
+    EXPECT_THAT (lookup (cache, "core.xml", changed, CCSMetadataCacheBrief), Eq ("new brief"));
+    EXPECT_THAT (lookup (cache, "core.xml", changed, CCSMetadataCacheFull), Eq (""));
+}
+
+TEST_F (CCSMetadataCacheTest, TestSyncDropsEntriesForRemovedSources)
+{
+    struct stat core = writeSource ("core.xml", "<compiz/>");
+    struct stat move = writeSource ("move.xml", "<compiz></compiz>");
+
+    update ("core.xml", core, CCSMetadataCacheBrief, "core brief");
+    update ("move.xml", move, CCSMetadataCacheBrief, "move brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    unlink (source ("move.xml").c_str ());
+    update ("core.xml", core, CCSMetadataCacheFull, "core full");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    EXPECT_THAT (lookup (cache, "move.xml", move, CCSMetadataCacheBrief), Eq (""));
+    EXPECT_THAT (lookup (cache, "core.xml", core, CCSMetadataCacheBrief), Eq ("core brief"));
+}
+
+TEST_F (CCSMetadataCacheTest, TestOtherVersionIsIgnored)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    CCSMetadataCache *other = ccsMetadataCacheOpen (imagePath.c_str (), CACHE_VERSION + 1);
+
+    EXPECT_THAT (lookup (other, "core.xml", st, CCSMetadataCacheBrief), Eq (""));
+    ccsMetadataCacheFree (other);
+}
+
+TEST_F (CCSMetadataCacheTest, TestDamagedImageIsIgnoredAndReplaced)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    struct stat image;
+    ASSERT_THAT (stat (imagePath.c_str (), &image), Eq (0));
+    ASSERT_THAT (truncate (imagePath.c_str (), image.st_size - 1), Eq (0));
+    reopen ();
+
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheBrief), Eq (""));
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+    reopen ();
+
+    EXPECT_THAT (lookup (cache, "core.xml", st, CCSMetadataCacheBrief), Eq ("brief"));
+}
+
+TEST_F (CCSMetadataCacheTest, TestSyncWithoutUpdatesKeepsImage)
+{
+    struct stat st = writeSource ("core.xml", "<compiz/>");
+
+    update ("core.xml", st, CCSMetadataCacheBrief, "brief");
+    ASSERT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+
+    struct stat before, after;
+    ASSERT_THAT (stat (imagePath.c_str (), &before), Eq (0));
+    EXPECT_THAT (ccsMetadataCacheSync (cache), BoolTrue ());
+    ASSERT_THAT (stat (imagePath.c_str (), &after), Eq (0));
+
+    EXPECT_THAT (after.st_ino, Eq (before.st_ino));
+}
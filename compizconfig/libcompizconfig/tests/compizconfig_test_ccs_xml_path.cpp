@@ -0,0 +1,382 @@
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+
+#include "ccs_xml_path.h"
+
+using ::testing::Eq;
+using ::testing::IsNull;
+
+namespace
+{
+    /* Every kind of path the metadata loader asks for */
+    const char *loaderPaths[] =
+    {
+	"@name",
+	"@type",
+	"@read_only",
+	"@start",
+	"@base_plugin",
+	"child::text()",
+	"min/child::text()",
+	"max/child::text()",
+	"value/child::text()",
+	"type/child::text()",
+	"_short/child::text()",
+	"_long/child::text()",
+	"default",
+	"desc",
+	"edge",
+	"value",
+	"restriction",
+	"sort",
+	"options",
+	"extension",
+	"option | group/subgroup/option | group/option | subgroup/option",
+	"ancestor::group/_short/child::text()",
+	"ancestor::subgroup/_short/child::text()",
+	"deps/requirement/plugin",
+	"deps/relation[@type = 'after']/plugin",
+	"deps/relation[@type='before']/plugin",
+	"/compiz/*/extension",
+	"/compiz/plugin",
+	"/compiz/plugin[@name='core']",
+	"/compiz/core"
+    };
+
+    const char *translatedDocument =
+	"<?xml version=\"1.0\"?>"
+	"<compiz>"
+	"  <plugin name=\"test\">"
+	"    <short>Test</short>"
+	"    <short xml:lang=\"de\">Prüfung</short>"
+	"    <short xml:lang=\"pt_BR\">Teste</short>"
+	"    <short xml:lang=\"en-GB\">Trial</short>"
+	"    <short xml:lang=\"C\">Test (C)</short>"
+	"    <options>"
+	"      <group xml:lang=\"fr\">"
+	"        <short>Groupe</short>"
+	"        <option name=\"o\" type=\"int\">"
+	"          <short><![CDATA[Option]]></short>"
+	"          <default>1</default>"
+	"        </option>"
+	"      </group>"
+	"      <option name=\"p\" type=\"bool\"/>"
+	"    </options>"
+	"  </plugin>"
+	"</compiz>";
+
+    std::vector <xmlNode *>
+    xpathNodes (xmlDoc *doc, xmlNode *base, const char *path)
+    {
+	std::vector <xmlNode *> nodes;
+	xmlXPathContextPtr      context = xmlXPathNewContext (doc);
+
+	context->node = base;
+
+	xmlXPathObjectPtr object = xmlXPathEvalExpression (BAD_CAST path, context);
+
+	if (object && object->nodesetval)
+	    nodes.assign (object->nodesetval->nodeTab,
+			  object->nodesetval->nodeTab + object->nodesetval->nodeNr);
+
+	xmlXPathFreeObject (object);
+	xmlXPathFreeContext (context);
+
+	return nodes;
+    }
+
+    std::string
+    xpathString (xmlDoc *doc, xmlNode *base, const char *path)
+    {
+	std::string        string;
+	xmlXPathContextPtr context = xmlXPathNewContext (doc);
+
+	context->node = base;
+
+	xmlXPathObjectPtr object =
+	    xmlXPathConvertString (xmlXPathEvalExpression (BAD_CAST path, context));
+
+	if (object && object->stringval)
+	    string = reinterpret_cast <const char *> (object->stringval);
+
+	xmlXPathFreeObject (object);
+	xmlXPathFreeContext (context);
+
+	return string;
+    }
+
+    std::vector <xmlNode *>
+    pathNodes (xmlDoc *doc, xmlNode *base, const char *path)
+    {
+	std::vector <xmlNode *> nodes;
+	int                     num;
+	xmlNode                 **found = ccsXmlPathNodes (doc, base, path, &num);
+
+	nodes.assign (found, found + num);
+	free (found);
+
+	return nodes;
+    }
+
+    std::string
+    pathString (xmlDoc *doc, xmlNode *base, const char *path)
+    {
+	std::string string;
+	char        *found = ccsXmlPathString (doc, base, path);
+
+	if (found)
+	    string = found;
+
+	free (found);
+
+	return string;
+    }
+
+    void
+    collectElements (xmlNode *node, std::vector <xmlNode *> &elements)
+    {
+	for (; node; node = node->next)
+	{
+	    if (node->type != XML_ELEMENT_NODE)
+		continue;
+
+	    elements.push_back (node);
+	    collectElements (node->children, elements);
+	}
+    }
+
+    std::vector <std::string>
+    metadataFiles (const std::string &directory)
+    {
+	std::vector <std::string> files;
+	DIR                       *dir = opendir (directory.c_str ());
+
+	if (!dir)
+	    return files;
+
+	while (struct dirent *entry = readdir (dir))
+	{
+	    std::string name (entry->d_name);
+
+	    if (name.size () > 7 &&
+		name.compare (name.size () - 7, 7, ".xml.in") == 0)
+		files.push_back (directory + "/" + name);
+	}
+
+	closedir (dir);
+
+	return files;
+    }
+
+    std::vector <std::string>
+    treeMetadataFiles ()
+    {
+	std::vector <std::string> files = metadataFiles (METADATA_SOURCE_DIR);
+	DIR                       *dir = opendir (PLUGINS_SOURCE_DIR);
+
+	if (!dir)
+	    return files;
+
+	while (struct dirent *entry = readdir (dir))
+	{
+	    if (entry->d_name[0] == '.')
+		continue;
+
+	    std::vector <std::string> plugin =
+		metadataFiles (std::string (PLUGINS_SOURCE_DIR) + "/" + entry->d_name);
+
+	    files.insert (files.end (), plugin.begin (), plugin.end ());
+	}
+
+	closedir (dir);
+
+	return files;
+    }
+
+    double
+    elapsed (const timespec &start)
+    {
+	timespec now;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start.tv_sec) * 1000.0 +
+	       (now.tv_nsec - start.tv_nsec) / 1000000.0;
+    }
+}
+
+class CCSXmlPathTest :
+    public ::testing::Test
+{
+    public:
+
+	CCSXmlPathTest () :
+	    doc (xmlReadMemory (translatedDocument, strlen (translatedDocument),
+				"test.xml", NULL, 0)),
+	    root (xmlDocGetRootElement (doc))
+	{
+	}
+
+	~CCSXmlPathTest ()
+	{
+	    xmlFreeDoc (doc);
+	}
+
+	xmlNode * plugin ()
+	{
+	    return pathNodes (doc, NULL, "/compiz/plugin").front ();
+	}
+
+	xmlDoc  *doc;
+	xmlNode *root;
+};
+
+TEST_F (CCSXmlPathTest, TestAbsolutePathIgnoresBase)
+{
+    EXPECT_THAT (pathNodes (doc, plugin (), "/compiz/plugin[@name = 'test']"),
+		 Eq (xpathNodes (doc, plugin (), "/compiz/plugin[@name = 'test']")));
+    EXPECT_THAT (pathNodes (doc, plugin (), "/compiz/plugin[@name = 'other']").size (),
+		 Eq (0));
+}
+
+TEST_F (CCSXmlPathTest, TestLangMatchesExactAndDialects)
+{
+    EXPECT_THAT (pathString (doc, plugin (), "short/child::text()[lang('de')]"),
+		 Eq ("Prüfung"));
+    EXPECT_THAT (pathString (doc, plugin (), "short/child::text()[lang('EN')]"),
+		 Eq ("Trial"));
+    EXPECT_THAT (pathString (doc, plugin (), "short/child::text()[lang('pt_BR')]"),
+		 Eq ("Teste"));
+    EXPECT_THAT (pathString (doc, plugin (), "short/child::text()[lang('pt')]"),
+		 Eq (""));
+    EXPECT_THAT (pathString (doc, plugin (), "short/child::text()[lang('C')]"),
+		 Eq ("Test (C)"));
+}
+
+TEST_F (CCSXmlPathTest, TestLangIsInherited)
+{
+    EXPECT_THAT (pathString (doc, plugin (),
+			     "options/group/option/short/child::text()[lang('fr')]"),
+		 Eq ("Option"));
+}
+
+TEST_F (CCSXmlPathTest, TestStringOfEmptyResultIsNull)
+{
+    char *value = ccsXmlPathString (doc, plugin (), "@missing");
+
+    EXPECT_THAT (value, IsNull ());
+    free (value);
+}
+
+TEST_F (CCSXmlPathTest, TestMalformedPathFindsNothing)
+{
+    int num = -1;
+
+    EXPECT_THAT (ccsXmlPathNodes (doc, plugin (), "short[position() = 1]", &num),
+		 IsNull ());
+    EXPECT_THAT (num, Eq (0));
+}
+
+TEST_F (CCSXmlPathTest, TestUnionIsInDocumentOrder)
+{
+    std::vector <xmlNode *> elements;
+    collectElements (root, elements);
+
+    for (std::vector <xmlNode *>::iterator it = elements.begin ();
+	 it != elements.end (); ++it)
+	EXPECT_THAT (pathNodes (doc, *it, loaderPaths[20]),
+		     Eq (xpathNodes (doc, *it, loaderPaths[20])));
+}
+
+TEST_F (CCSXmlPathTest, TestTranslatedPathsMatchXPath)
+{
+    const char *paths[] =
+    {
+	"short/child::text()[lang('de')]",
+	"short/child::text()[lang('de_DE')]",
+	"short/child::text()[lang('en')]",
+	"short/child::text()[lang('C')]",
+	"short[lang('fr')]",
+	"ancestor::group/short/child::text()[lang('fr')]",
+	"short/child::text()"
+    };
+
+    std::vector <xmlNode *> elements;
+    collectElements (root, elements);
+
+    for (std::vector <xmlNode *>::iterator it = elements.begin ();
+	 it != elements.end (); ++it)
+	for (unsigned int i = 0; i < sizeof (paths) / sizeof (paths[0]); ++i)
+	{
+	    EXPECT_THAT (pathNodes (doc, *it, paths[i]),
+			 Eq (xpathNodes (doc, *it, paths[i]))) << paths[i];
+	    EXPECT_THAT (pathString (doc, *it, paths[i]),
+			 Eq (xpathString (doc, *it, paths[i]))) << paths[i];
+	}
+}
+
+/* Evaluates every loader path from every element of the metadata
+ * shipped in the tree, compares the result with libxml2's XPath and
+ * records how long each took */
+TEST (CCSXmlPathMetadataTest, TestTreeMetadataMatchesXPath)
+{
+    std::vector <std::string> files = treeMetadataFiles ();
+    const unsigned int        numPaths = sizeof (loaderPaths) / sizeof (loaderPaths[0]);
+    double                    xpathTime = 0, pathTime = 0;
+    unsigned int              lookups = 0;
+
+    ASSERT_FALSE (files.empty ());
+
+    for (std::vector <std::string>::iterator file = files.begin ();
+	 file != files.end (); ++file)
+    {
+	xmlDoc *doc = xmlReadFile (file->c_str (), NULL, 0);
+
+	ASSERT_TRUE (doc) << *file;
+
+	std::vector <xmlNode *> elements;
+	collectElements (xmlDocGetRootElement (doc), elements);
+
+	for (std::vector <xmlNode *>::iterator it = elements.begin ();
+	     it != elements.end (); ++it)
+	{
+	    for (unsigned int i = 0; i < numPaths; ++i)
+	    {
+		timespec                start;
+		std::vector <xmlNode *> expected, found;
+		std::string             expectedString, foundString;
+
+		clock_gettime (CLOCK_MONOTONIC, &start);
+		expected = xpathNodes (doc, *it, loaderPaths[i]);
+		expectedString = xpathString (doc, *it, loaderPaths[i]);
+		xpathTime += elapsed (start);
+
+		clock_gettime (CLOCK_MONOTONIC, &start);
+		found = pathNodes (doc, *it, loaderPaths[i]);
+		foundString = pathString (doc, *it, loaderPaths[i]);
+		pathTime += elapsed (start);
+
+		EXPECT_THAT (found, Eq (expected)) << *file << ": " << loaderPaths[i];
+		EXPECT_THAT (foundString, Eq (expectedString)) << *file << ": " << loaderPaths[i];
+
+		++lookups;
+	    }
+	}
+
+	xmlFreeDoc (doc);
+    }
+
+    ::testing::Test::RecordProperty ("lookups", lookups);
+    ::testing::Test::RecordProperty ("xpath_us", static_cast <int> (xpathTime * 1000));
+    ::testing::Test::RecordProperty ("xml_path_us", static_cast <int> (pathTime * 1000));
+}
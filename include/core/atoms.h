@@ -124,6 +124,7 @@ namespace Atoms {
     extern Atom wmSyncRequest;
 
     extern Atom wmSyncRequestCounter;
+    extern Atom wmFrameDrawn;
 
     extern Atom wmFullscreenMonitors;
 
@@ -230,6 +230,12 @@ class CompOption
 
 		virtual bool setOption (const CompString &name,
 					Value            &value) = 0;
+
+		/* Sets several options in one go, so that work depending
+		 * on more than one of them only has to be done once.
+		 * Returns true if any of them changed. By default they
+		 * are set one at a time through setOption. */
+		virtual bool setOptions (Vector &options);
 	};
 
     public:
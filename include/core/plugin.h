@@ -148,6 +148,8 @@ class CompPlugin {
 		virtual bool setOption (const CompString  &name,
 					CompOption::Value &value);
 
+		virtual bool setOptions (CompOption::Vector &options);
+
 		virtual CompAction::Vector & getActions ();
 	    private:
 		CompString   mName;
@@ -170,6 +172,7 @@ class CompPlugin {
 		CompOption::Vector & getOptions ();
 		bool setOption (const CompString &name,
 				CompOption::Value &value);
+		bool setOptions (CompOption::Vector &options);
 		CompAction::Vector & getActions ();
 
 	    private:
@@ -194,6 +197,7 @@ class CompPlugin {
 		void finiScreen (CompScreen *s);
 		CompOption::Vector & getOptions ();
 		bool setOption (const CompString &name, CompOption::Value &value);
+		bool setOptions (CompOption::Vector &options);
 		CompAction::Vector & getActions ();
 
 	    private:
@@ -369,6 +373,16 @@ CompPlugin::VTableForScreenAndWindow<T, T2, ABI>::setOption (const CompString  &
     return oc->setOption (name, value);
 }
 
+template <typename T, typename T2, int ABI>
+bool
+CompPlugin::VTableForScreenAndWindow<T, T2, ABI>::setOptions (CompOption::Vector &options)
+{
+    CompOption::Class *oc = dynamic_cast<CompOption::Class *> (T::get (screen));
+    if (!oc)
+	return false;
+    return oc->setOptions (options);
+}
+
 template <typename T, typename T2, int ABI>
 CompAction::Vector & CompPlugin::VTableForScreenAndWindow<T, T2, ABI>::getActions ()
 {
@@ -449,6 +463,16 @@ CompPlugin::VTableForScreen<T, ABI>::setOption (const CompString  &name,
     return oc->setOption (name, value);
 }
 
+template <typename T, int ABI>
+bool
+CompPlugin::VTableForScreen<T, ABI>::setOptions (CompOption::Vector &options)
+{
+    CompOption::Class *oc = dynamic_cast<CompOption::Class *> (T::get (screen));
+    if (!oc)
+	return false;
+    return oc->setOptions (options);
+}
+
 template <typename T, int ABI>
 CompAction::Vector &
 CompPlugin::VTableForScreen<T, ABI>::getActions ()
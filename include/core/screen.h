@@ -37,6 +37,7 @@
 #include <core/region.h>
 #include <core/modifierhandler.h>
 #include <core/valueholder.h>
+#include <core/eventcoalescer.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -128,6 +129,12 @@ class ScreenInterface : public WrapableInterface<CompScreen, ScreenInterface> {
 					 const char *name,
 					 CompOption::Value &v);
 
+	/* Applies a set of changed options to a plugin at once, see
+	 * CompOption::Class::setOptions. On return options only holds
+	 * the options whose values actually changed. */
+	virtual bool setOptionsForPlugin (const char         *plugin,
+					  CompOption::Vector &options);
+
 	virtual void sessionEvent (CompSession::Event event,
 				   CompOption::Vector &options);
 
@@ -223,7 +230,7 @@ protected:
 }
 
 class CompScreen :
-    public WrapableHandler<ScreenInterface, 20>,
+    public WrapableHandler<ScreenInterface, 21>,
     public PluginClassStorage, // TODO should be an interface here
     public CompSize,
     public virtual ::compiz::DesktopWindowCount,
@@ -277,6 +284,8 @@ public:
 		  const CompString&, int);
     WRAPABLE_HND (19, ScreenInterface, void, averageColorChangeNotify,
 		  const unsigned short *);
+    WRAPABLE_HND (20, ScreenInterface, bool, setOptionsForPlugin,
+		  const char *, CompOption::Vector &);
 
     unsigned int allocPluginClassIndex ();
     void freePluginClassIndex (unsigned int index);
@@ -409,6 +418,11 @@ public:
     virtual void processEvents () = 0;
     virtual void alwaysHandleEvent (XEvent *event) = 0;
 
+    /* Collapses redundant events before they are handled. Plugins which
+     * need every event of a type inhibit it here, plugins handling
+     * extension events may add rules for them. */
+    virtual compiz::core::EventCoalescer & eventCoalescer () = 0;
+
     virtual ServerGrabInterface * serverGrabInterface () = 0;
 
     // Replacements for friends accessing priv. They are declared virtual to
@@ -459,6 +473,7 @@ private:
     virtual void _outputChangeNotify() = 0;
     virtual void _cursorChangeNotify(const CompString&, int) = 0;
     virtual void _averageColorChangeNotify(const unsigned short*) = 0;
+    virtual bool _setOptionsForPlugin(const char *, CompOption::Vector &) = 0;
 };
 
 #endif
@@ -423,6 +423,10 @@ class CompWindow :
 
 	void sendSyncRequest ();
 
+	/* Tells a client using the extended sync counter that the last
+	 * frame it finished is on screen now (_NET_WM_FRAME_DRAWN) */
+	void frameDrawn ();
+
 	XSyncAlarm syncAlarm () const;
 
 	void map ();
@@ -67,6 +67,55 @@ class GridAnim :
 			  int decorTopHeight, int decorBottomHeight);
     };
 
+private:
+    /// Undeformed geometry of one glAddGeometry call, retained for the
+    /// lifetime of the animation. Texture coordinates and the grid cell
+    /// each vertex falls into never change between frames, so only the
+    /// deformed positions need to be recomputed.
+    class GridMesh
+    {
+    public:
+	enum
+	{
+	    MAX_TEXTURES = 4 ///< As many as GLVertexBuffer keeps
+	};
+
+	struct Vertex
+	{
+	    unsigned int topLeft; ///< Index of the object to the top left
+	    float        inx;     ///< Position inside the cell, in [0,1]
+	    float        iny;
+	};
+
+	bool matches (const GLTexture::MatrixList &matrix,
+		      const CompRegion            &region,
+		      const CompRegion            &clip,
+		      const CompRect              &outRect) const;
+
+	GLTexture::MatrixList mMatrix;
+	CompRegion            mRegion;
+	CompRegion            mClip;
+	CompRect              mOutRect;
+
+	std::vector<Vertex>   mVertices;
+	std::vector<GLfloat>  mTexCoords[MAX_TEXTURES];
+	unsigned int          mNTextures;
+    };
+
+    /// Retained meshes, one per texture painted each frame
+    std::vector<GridMesh> mMeshes;
+    std::vector<GLfloat>  mDeformed;
+
+    GridMesh *findMesh (const GLTexture::MatrixList &matrix,
+			const CompRegion            &region,
+			const CompRegion            &clip,
+			const CompRect              &outRect);
+    void generateMesh (GridMesh                    &mesh,
+		       const GLTexture::MatrixList &matrix,
+		       const CompRegion            &region,
+		       const CompRegion            &clip,
+		       const CompRect              &outRect);
+
 protected:
     GridModel *mModel;
 
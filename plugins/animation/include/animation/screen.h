@@ -22,6 +22,7 @@ public:
     bool getMousePointerXY (short *x, short *y);
     CompOption::Vector &getOptions ();
     bool setOption (const CompString &name, CompOption::Value &value);
+    bool setOptions (CompOption::Vector &options);
     CompOutput &output ();
     AnimEffect getMatchingAnimSelection (CompWindow *w,
 					 AnimEvent e,
@@ -1065,45 +1065,100 @@ AnimScreen::setOption (const CompString  &name,
     return priv->setOption (name, value);
 }
 
+bool
+AnimScreen::setOptions (CompOption::Vector &options)
+{
+    return priv->setOptions (options);
+}
+
+/// Sets a batch of options, rebuilding the effect lists and option
+/// sets of each affected event only once when the batch is done.
+bool
+PrivateAnimScreen::setOptions (CompOption::Vector &options)
+{
+    bool rv = false;
+
+    mDeferOptionUpdates = true;
+
+    foreach (CompOption &o, options)
+	if (setOption (o.name (), o.value ()))
+	    rv = true;
+
+    mDeferOptionUpdates = false;
+
+    updatePendingOptions ();
+
+    return rv;
+}
+
+void
+PrivateAnimScreen::updatePendingOptions ()
+{
+    if (mPendingAnimationList && mExtensionPlugins.empty ())
+	initAnimationList ();
+
+    for (int e = 0; e < AnimEventNum; ++e)
+    {
+	unsigned int bit = 1 << e;
+
+	if (mPendingOptionSets & bit)
+	    updateOptionSets ((AnimEvent) e);
+	if (mPendingEventEffects & bit)
+	    updateEventEffects ((AnimEvent) e, false);
+	if (mPendingRandomEffects & bit)
+	    updateEventEffects ((AnimEvent) e, true);
+    }
+
+    mPendingAnimationList = false;
+    mPendingOptionSets = 0;
+    mPendingEventEffects = 0;
+    mPendingRandomEffects = 0;
+}
+
 void
 PrivateAnimScreen::eventMatchesChanged (CompOption                *opt,
 					AnimationOptions::Options num)
 {
-    if (mExtensionPlugins.empty ())
-	initAnimationList ();
+    mPendingAnimationList = true;
 
     foreach (CompOption::Value &val, opt->value ().list ())
 	val.match ().update ();
+
+    if (!mDeferOptionUpdates)
+	updatePendingOptions ();
 }
 
 void
 PrivateAnimScreen::eventOptionsChanged (CompOption                *opt,
 					AnimationOptions::Options num)
 {
-    if (mExtensionPlugins.empty ())
-	initAnimationList ();
+    mPendingAnimationList = true;
+    mPendingOptionSets |= 1 << getCorrespondingAnimEvent (num);
 
-    updateOptionSets (getCorrespondingAnimEvent (num));
+    if (!mDeferOptionUpdates)
+	updatePendingOptions ();
 }
 
 void
 PrivateAnimScreen::eventEffectsChanged (CompOption                *opt,
 					AnimationOptions::Options num)
 {
-    if (mExtensionPlugins.empty ())
-	initAnimationList ();
+    mPendingAnimationList = true;
+    mPendingEventEffects |= 1 << getCorrespondingAnimEvent (num);
 
-    updateEventEffects (getCorrespondingAnimEvent (num), false);
+    if (!mDeferOptionUpdates)
+	updatePendingOptions ();
 }
 
 void
 PrivateAnimScreen::eventRandomEffectsChanged (CompOption                *opt,
 					      AnimationOptions::Options num)
 {
-    if (mExtensionPlugins.empty ())
-	initAnimationList ();
+    mPendingAnimationList = true;
+    mPendingRandomEffects |= 1 << getCorrespondingAnimEvent (num);
 
-    updateEventEffects (getCorrespondingAnimEvent (num), true);
+    if (!mDeferOptionUpdates)
+	updatePendingOptions ();
 }
 
 void
@@ -2722,7 +2777,12 @@ PrivateAnimScreen::PrivateAnimScreen (CompScreen *s, AnimScreen *as) :
     mOutput (0),
     mLockedPaintList (NULL),
     mLockedPaintListCnt (0),
-    mGetWindowPaintListEnableCnt (0)
+    mGetWindowPaintListEnableCnt (0),
+    mDeferOptionUpdates (false),
+    mPendingAnimationList (false),
+    mPendingOptionSets (0),
+    mPendingEventEffects (0),
+    mPendingRandomEffects (0)
 {
     for (int i = 0; i < WatchedScreenPluginNum; ++i)
 	mPluginActive[i] = false;
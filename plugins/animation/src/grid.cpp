@@ -38,6 +38,9 @@
 
 #include "private.h"
 
+/// Upper bound on the number of retained meshes per animation
+static const unsigned int MAX_RETAINED_MESHES = 8;
+
 // =====================  Effect: Dodge  =========================
 
 GridAnim::GridModel::GridObject::GridObject () :
@@ -217,22 +220,54 @@ GridAnim::~GridAnim ()
 	delete mModel;
 }
 
-void
-GridAnim::addGeometry (const GLTexture::MatrixList &matrix,
-		       const CompRegion            &region,
-		       const CompRegion            &clip,
-		       unsigned int                maxGridWidth,
-		       unsigned int                maxGridHeight)
+bool
+GridAnim::GridMesh::matches (const GLTexture::MatrixList &matrix,
+			     const CompRegion            &region,
+			     const CompRegion            &clip,
+			     const CompRect              &outRect) const
 {
-    if (region.isEmpty ()) // nothing to do
-	return;
+    if (mOutRect != outRect ||
+	mMatrix.size () != matrix.size () ||
+	mRegion != region ||
+	mClip != clip)
+	return false;
+
+    for (unsigned int i = 0; i < matrix.size (); ++i)
+    {
+	const GLTexture::Matrix &a = mMatrix[i];
+	const GLTexture::Matrix &b = matrix[i];
+
+	if (a.xx != b.xx || a.yx != b.yx ||
+	    a.xy != b.xy || a.yy != b.yy ||
+	    a.x0 != b.x0 || a.y0 != b.y0)
+	    return false;
+    }
+
+    return true;
+}
+
+GridAnim::GridMesh *
+GridAnim::findMesh (const GLTexture::MatrixList &matrix,
+		    const CompRegion            &region,
+		    const CompRegion            &clip,
+		    const CompRect              &outRect)
+{
+    foreach (GridMesh &mesh, mMeshes)
+	if (mesh.matches (matrix, region, clip, outRect))
+	    return &mesh;
+
+    return NULL;
+}
 
+void
+GridAnim::generateMesh (GridMesh                    &mesh,
+			const GLTexture::MatrixList &matrix,
+			const CompRegion            &region,
+			const CompRegion            &clip,
+			const CompRect              &outRect)
+{
     GLfloat *v, *vMax;
-    bool notUsing3dCoords = !using3D ();
 
-    CompRect outRect (mAWindow->savedRectsValid () ?
-		      mAWindow->savedOutRect () :
-		      mWindow->outputRect ());
     CompWindowExtents outExtents (mAWindow->savedRectsValid () ?
 				  mAWindow->savedOutExtents () :
 				  mWindow->output ());
@@ -251,140 +286,225 @@ GridAnim::addGeometry (const GLTexture::MatrixList &matrix,
     GLVertexBuffer *vertexBuffer = gWindow->vertexBuffer ();
     int vSize = vertexBuffer->getVertexStride ();
 
-    // Indentation kept to provide a clean diff with the old code, for now...
+    int y1 = outRect.y1 ();
+    int x2 = outRect.x2 ();
+    int y2 = outRect.y2 ();
+
+    float gridW = (float)owidth / (mGridWidth - 1);
+    float gridH;
+
+    if (mCurWindowEvent == WindowEventShade ||
+	mCurWindowEvent == WindowEventUnshade)
+    {
+	if (y1 < winContentsY)	// if at top part
+	    gridH = mDecorTopHeight;
+	else if (y2 > winContentsY + winContentsHeight)  // if at bottom
+	    gridH = mDecorBottomHeight;
+	else			// in window contents (only in Y coords)
+	{
+	    float winContentsHeight =
+		oheight - (mDecorTopHeight + mDecorBottomHeight);
+	    gridH = winContentsHeight / (mGridHeight - 3);
+	}
+    }
+    else
+	gridH = (float)oheight / (mGridHeight - 1);
+
+    int oldCount = vertexBuffer->countVertices ();
+    gWindow->glAddGeometry (matrix, region, clip, gridW, gridH);
+    int newCount = vertexBuffer->countVertices ();
+
+    if (newCount == oldCount)
+	return;
+
+    // Keep the texture coordinates, they are reused as is every frame
+    unsigned int nTextures = MIN (matrix.size (),
+				  (unsigned int) GridMesh::MAX_TEXTURES);
+
+    for (mesh.mNTextures = 0; mesh.mNTextures < nTextures; ++mesh.mNTextures)
+    {
+	GLfloat *t = vertexBuffer->getTexCoords (mesh.mNTextures);
+
+	if (!t)
+	    break;
+
+	mesh.mTexCoords[mesh.mNTextures].assign (t + oldCount * 2,
+						 t + newCount * 2);
+    }
+
+    mesh.mVertices.reserve (newCount - oldCount);
+
+    v = vertexBuffer->getVertices () + (oldCount * vSize);
+    vMax = vertexBuffer->getVertices () + (newCount * vSize);
+
+    float x, y, topiyFloat;
+    // For each vertex
+    for (; v < vMax; v += vSize)
     {
-	int y1 = outRect.y1 ();
-	int x2 = outRect.x2 ();
-	int y2 = outRect.y2 ();
+	x = v[0];
+	y = v[1];
 
-	float gridW = (float)owidth / (mGridWidth - 1);
-	float gridH;
+	if (y > y2)
+	    y = y2;
 
 	if (mCurWindowEvent == WindowEventShade ||
 	    mCurWindowEvent == WindowEventUnshade)
 	{
 	    if (y1 < winContentsY)	// if at top part
-		gridH = mDecorTopHeight;
-	    else if (y2 > winContentsY + winContentsHeight)  // if at bottom
-		gridH = mDecorBottomHeight;
-	    else			// in window contents (only in Y coords)
 	    {
-		float winContentsHeight =
-		    oheight - (mDecorTopHeight + mDecorBottomHeight);
-		gridH = winContentsHeight / (mGridHeight - 3);
+		topiyFloat = (y - oy) / mDecorTopHeight;
+		topiyFloat = MIN (topiyFloat, 0.999);	// avoid 1.0
 	    }
+	    else if (y2 > winContentsY + winContentsHeight)	// if at bottom
+		topiyFloat = (mGridHeight - 2) +
+		    (mDecorBottomHeight ? (y - winContentsY -
+					   winContentsHeight) /
+		     mDecorBottomHeight : 0);
+	    else		// in window contents (only in Y coords)
+		topiyFloat = (mGridHeight - 3) *
+		    (y - winContentsY) / winContentsHeight + 1;
 	}
 	else
-	    gridH = (float)oheight / (mGridHeight - 1);
+	    topiyFloat = (mGridHeight - 1) * (y - oy) / oheight;
 
-	int oldCount = vertexBuffer->countVertices ();
-	gWindow->glAddGeometry (matrix, region, clip, gridW, gridH);
-	int newCount = vertexBuffer->countVertices ();
-	v = vertexBuffer->getVertices () + (oldCount * vSize);
-	vMax = vertexBuffer->getVertices () + (newCount * vSize);
- 
-	float x, y, topiyFloat;
-	// For each vertex
-	for (; v < vMax; v += vSize)
-	{
-	    x = v[0];
-	    y = v[1];
+	// topiy should be at most (mGridHeight - 2)
+	int topiy = (int)(topiyFloat + 1e-4);
 
-	    if (y > y2)
-		y = y2;
+	if (topiy == mGridHeight - 1)
+	    --topiy;
 
-	    if (mCurWindowEvent == WindowEventShade ||
-		mCurWindowEvent == WindowEventUnshade)
-	    {
-		if (y1 < winContentsY)	// if at top part
-		{
-		    topiyFloat = (y - oy) / mDecorTopHeight;
-		    topiyFloat = MIN (topiyFloat, 0.999);	// avoid 1.0
-		}
-		else if (y2 > winContentsY + winContentsHeight)	// if at bottom
-		    topiyFloat = (mGridHeight - 2) +
-			(mDecorBottomHeight ? (y - winContentsY -
-					       winContentsHeight) /
-			 mDecorBottomHeight : 0);
-		else		// in window contents (only in Y coords)
-		    topiyFloat = (mGridHeight - 3) *
-			(y - winContentsY) / winContentsHeight + 1;
-	    }
-	    else
-		topiyFloat = (mGridHeight - 1) * (y - oy) / oheight;
+	if (x > x2)
+	    x = x2;
 
-	    // topiy should be at most (mGridHeight - 2)
-	    int topiy = (int)(topiyFloat + 1e-4);
+	// find containing grid cell (leftix rightix) x (topiy bottomiy)
+	float leftixFloat = (mGridWidth - 1) * (x - ox) / owidth;
+	int leftix = (int)(leftixFloat + 1e-4);
 
-	    if (topiy == mGridHeight - 1)
-		--topiy;
+	if (leftix == mGridWidth - 1)
+	    --leftix;
 
-	    int   bottomiy = topiy + 1;
-	    float iny      = topiyFloat - topiy;
-	    float inyRest  = 1 - iny;
+	// find position in cell by taking remainder of flooring
+	GridMesh::Vertex vertex;
 
-	    // End of calculations for y
+	vertex.topLeft = topiy * mGridWidth + leftix;
+	vertex.inx = leftixFloat - leftix;
+	vertex.iny = topiyFloat - topiy;
 
-	    // Indentation kept to provide a clean diff with the old code...
-	    {
-		if (x > x2)
-		    x = x2;
-
-		// find containing grid cell (leftix rightix) x (topiy bottomiy)
-		float leftixFloat = (mGridWidth - 1) * (x - ox) / owidth;
-		int leftix = (int)(leftixFloat + 1e-4);
-
-		if (leftix == mGridWidth - 1)
-		    --leftix;
-
-		int rightix = leftix + 1;
-
-		// GridModel::GridObjects that are at top, bottom, left, right corners of quad
-		GridModel::GridObject *objToTopLeft =
-		    &(mModel->mObjects[topiy * mGridWidth + leftix]);
-		GridModel::GridObject *objToTopRight =
-		    &(mModel->mObjects[topiy * mGridWidth + rightix]);
-		GridModel::GridObject *objToBottomLeft =
-		    &(mModel->mObjects[bottomiy * mGridWidth + leftix]);
-		GridModel::GridObject *objToBottomRight =
-		    &(mModel->mObjects[bottomiy * mGridWidth + rightix]);
-
-		Point3d &objToTopLeftPos = objToTopLeft->mPosition;
-		Point3d &objToTopRightPos = objToTopRight->mPosition;
-		Point3d &objToBottomLeftPos = objToBottomLeft->mPosition;
-		Point3d &objToBottomRightPos = objToBottomRight->mPosition;
-
-		// find position in cell by taking remainder of flooring
-		float inx = leftixFloat - leftix;
-		float inxRest = 1 - inx;
-
-		// Interpolate to find deformed coordinates
-
-		float hor1x = (inxRest * objToTopLeftPos.x () +
-			       inx * objToTopRightPos.x ());
-		float hor1y = (inxRest * objToTopLeftPos.y () +
-			       inx * objToTopRightPos.y ());
-		float hor1z = (notUsing3dCoords ? 0 :
-			       inxRest * objToTopLeftPos.z () +
-			       inx * objToTopRightPos.z ());
-		float hor2x = (inxRest * objToBottomLeftPos.x () +
-			       inx * objToBottomRightPos.x ());
-		float hor2y = (inxRest * objToBottomLeftPos.y () +
-			       inx * objToBottomRightPos.y ());
-		float hor2z = (notUsing3dCoords ? 0 :
-			       inxRest * objToBottomLeftPos.z () +
-			       inx * objToBottomRightPos.z ());
-
-		float deformedX = inyRest * hor1x + iny * hor2x;
-		float deformedY = inyRest * hor1y + iny * hor2y;
-		float deformedZ = inyRest * hor1z + iny * hor2z;
-
-		v[0] = deformedX;
-		v[1] = deformedY;
-		v[2] = deformedZ;
+	mesh.mVertices.push_back (vertex);
+    }
+}
 
-	    }
-	}
+void
+GridAnim::addGeometry (const GLTexture::MatrixList &matrix,
+		       const CompRegion            &region,
+		       const CompRegion            &clip,
+		       unsigned int                maxGridWidth,
+		       unsigned int                maxGridHeight)
+{
+    if (region.isEmpty ()) // nothing to do
+	return;
+
+    bool notUsing3dCoords = !using3D ();
+
+    CompRect outRect (mAWindow->savedRectsValid () ?
+		      mAWindow->savedOutRect () :
+		      mWindow->outputRect ());
+
+    GLWindow *gWindow = GLWindow::get (mWindow);
+    GLVertexBuffer *vertexBuffer = gWindow->vertexBuffer ();
+    int vSize = vertexBuffer->getVertexStride ();
+
+    GridMesh *mesh = findMesh (matrix, region, clip, outRect);
+    bool     retained = (mesh != NULL);
+    GLfloat  *v;
+
+    if (retained)
+    {
+	if (mesh->mVertices.empty ())
+	    return;
+
+	// Only the grid objects have moved since the mesh was generated,
+	// so just compute the new positions
+	mDeformed.resize (mesh->mVertices.size () * vSize);
+	v = &mDeformed[0];
+    }
+    else
+    {
+	// Painted regions normally stay the same for the whole animation,
+	// but don't keep every one of them if they don't
+	if (mMeshes.size () >= MAX_RETAINED_MESHES)
+	    mMeshes.clear ();
+
+	mMeshes.push_back (GridMesh ());
+	mesh = &mMeshes.back ();
+
+	mesh->mMatrix = matrix;
+	mesh->mRegion = region;
+	mesh->mClip = clip;
+	mesh->mOutRect = outRect;
+	mesh->mNTextures = 0;
+
+	int oldCount = vertexBuffer->countVertices ();
+
+	generateMesh (*mesh, matrix, region, clip, outRect);
+
+	if (mesh->mVertices.empty ())
+	    return;
+
+	// Deform the freshly generated vertices in place
+	v = vertexBuffer->getVertices () + (oldCount * vSize);
+    }
+
+    GridModel::GridObject *objects = mModel->mObjects;
+
+    for (std::vector<GridMesh::Vertex>::const_iterator it =
+	     mesh->mVertices.begin ();
+	 it != mesh->mVertices.end (); ++it, v += vSize)
+    {
+	// GridModel::GridObjects that are at top, bottom, left, right corners of quad
+	Point3d &objToTopLeftPos =
+	    objects[it->topLeft].mPosition;
+	Point3d &objToTopRightPos =
+	    objects[it->topLeft + 1].mPosition;
+	Point3d &objToBottomLeftPos =
+	    objects[it->topLeft + mGridWidth].mPosition;
+	Point3d &objToBottomRightPos =
+	    objects[it->topLeft + mGridWidth + 1].mPosition;
+
+	float inx = it->inx;
+	float inxRest = 1 - inx;
+	float iny = it->iny;
+	float inyRest = 1 - iny;
+
+	// Interpolate to find deformed coordinates
+
+	float hor1x = (inxRest * objToTopLeftPos.x () +
+		       inx * objToTopRightPos.x ());
+	float hor1y = (inxRest * objToTopLeftPos.y () +
+		       inx * objToTopRightPos.y ());
+	float hor1z = (notUsing3dCoords ? 0 :
+		       inxRest * objToTopLeftPos.z () +
+		       inx * objToTopRightPos.z ());
+	float hor2x = (inxRest * objToBottomLeftPos.x () +
+		       inx * objToBottomRightPos.x ());
+	float hor2y = (inxRest * objToBottomLeftPos.y () +
+		       inx * objToBottomRightPos.y ());
+	float hor2z = (notUsing3dCoords ? 0 :
+		       inxRest * objToBottomLeftPos.z () +
+		       inx * objToBottomRightPos.z ());
+
+	v[0] = inyRest * hor1x + iny * hor2x;
+	v[1] = inyRest * hor1y + iny * hor2y;
+	v[2] = inyRest * hor1z + iny * hor2z;
+    }
+
+    if (retained)
+    {
+	vertexBuffer->addVertices (mesh->mVertices.size (), &mDeformed[0]);
+
+	for (unsigned int i = 0; i < mesh->mNTextures; ++i)
+	    vertexBuffer->addTexCoords (i, mesh->mVertices.size (),
+					&mesh->mTexCoords[i][0]);
     }
 }
 
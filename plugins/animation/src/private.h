@@ -250,6 +250,16 @@ private:
     unsigned int          mLockedPaintListCnt;
     unsigned int          mGetWindowPaintListEnableCnt;
 
+    // Option changes not yet applied, see setOptions. The masks hold
+    // one bit per AnimEvent.
+    bool                  mDeferOptionUpdates;
+    bool                  mPendingAnimationList;
+    unsigned int          mPendingOptionSets;
+    unsigned int          mPendingEventEffects;
+    unsigned int          mPendingRandomEffects;
+
+    void updatePendingOptions ();
+
     void updateEventEffects (AnimEvent e,
 			     bool forRandom,
 			     bool callPost = true);
@@ -285,6 +295,8 @@ public:
     PrivateAnimScreen (CompScreen *s, AnimScreen *);
     ~PrivateAnimScreen ();
 
+    bool setOptions (CompOption::Vector &options);
+
     // In order to prevent other plugins from modifying
     // the paint lists as we use it we need to lock the
     // list
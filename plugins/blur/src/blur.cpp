@@ -2173,8 +2173,10 @@ BlurScreen::matchPropertyChanged (CompWindow *w)
     screen->matchPropertyChanged (w);
 }
 
+/* Sets one option and records in pendingOptionChanges what has to be
+ * redone for it */
 bool
-BlurScreen::setOption (const CompString &name, CompOption::Value &value)
+BlurScreen::applyOption (const CompString &name, CompOption::Value &value)
 {
     unsigned int index;
 
@@ -2189,15 +2191,12 @@ BlurScreen::setOption (const CompString &name, CompOption::Value &value)
 	    break;
 	case BlurOptions::FocusBlurMatch:
 	case BlurOptions::AlphaBlurMatch:
-	    foreach (CompWindow *w, screen->windows ())
-		BlurWindow::get (w)->updateMatch ();
-
+	    pendingOptionChanges |= UpdateMatches | DamageScreen;
 	    moreBlur = true;
-	    cScreen->damageScreen ();
 	    break;
 	case BlurOptions::FocusBlur:
 	    moreBlur = true;
-	    cScreen->damageScreen ();
+	    pendingOptionChanges |= DamageScreen;
 	    break;
 	case BlurOptions::AlphaBlur:
 	    if (GL::shaders && optionGetAlphaBlur ())
@@ -2205,36 +2204,27 @@ BlurScreen::setOption (const CompString &name, CompOption::Value &value)
 	    else
 		alphaBlur = false;
 
-	    cScreen->damageScreen ();
+	    pendingOptionChanges |= DamageScreen;
 	    break;
 	case BlurOptions::Filter:
-	    blurReset ();
-	    cScreen->damageScreen ();
+	    pendingOptionChanges |= ResetBlur | DamageScreen;
 	    break;
 	case BlurOptions::GaussianRadius:
 	case BlurOptions::GaussianStrength:
 	case BlurOptions::IndependentTex:
 	    if (optionGetFilter () == BlurOptions::FilterGaussian)
-	    {
-		blurReset ();
-		cScreen->damageScreen ();
-	    }
+		pendingOptionChanges |= ResetBlur | DamageScreen;
 	    break;
 	case BlurOptions::MipmapLod:
 	    if (optionGetFilter () == BlurOptions::FilterMipmap)
-	    {
-		blurReset ();
-		cScreen->damageScreen ();
-	    }
+		pendingOptionChanges |= ResetBlur | DamageScreen;
 	    break;
 	case BlurOptions::Saturation:
-	    blurReset ();
-	    cScreen->damageScreen ();
+	    pendingOptionChanges |= ResetBlur | DamageScreen;
 	    break;
 	case BlurOptions::Occlusion:
 	    blurOcclusion = optionGetOcclusion ();
-	    blurReset ();
-	    cScreen->damageScreen ();
+	    pendingOptionChanges |= ResetBlur | DamageScreen;
 	    break;
 	default:
 	    break;
@@ -2243,11 +2233,52 @@ BlurScreen::setOption (const CompString &name, CompOption::Value &value)
     return rv;
 }
 
+void
+BlurScreen::finishOptionChanges ()
+{
+    if (pendingOptionChanges & UpdateMatches)
+	foreach (CompWindow *w, screen->windows ())
+	    BlurWindow::get (w)->updateMatch ();
+
+    if (pendingOptionChanges & ResetBlur)
+	blurReset ();
+
+    if (pendingOptionChanges & DamageScreen)
+	cScreen->damageScreen ();
+
+    pendingOptionChanges = 0;
+}
+
+bool
+BlurScreen::setOption (const CompString &name, CompOption::Value &value)
+{
+    bool rv = applyOption (name, value);
+
+    finishOptionChanges ();
+
+    return rv;
+}
+
+bool
+BlurScreen::setOptions (CompOption::Vector &options)
+{
+    bool rv = false;
+
+    foreach (CompOption &o, options)
+	if (applyOption (o.name (), o.value ()))
+	    rv = true;
+
+    finishOptionChanges ();
+
+    return rv;
+}
+
 BlurScreen::BlurScreen (CompScreen *screen) :
     PluginClassHandler<BlurScreen,CompScreen> (screen),
     gScreen (GLScreen::get (screen)),
     cScreen (CompositeScreen::get (screen)),
     moreBlur (false),
+    pendingOptionChanges (0),
     filterRadius (0),
     srcBlurFunctions (0),
     dstBlurFunctions (0),
@@ -78,6 +78,10 @@ class BlurScreen :
 	~BlurScreen ();
 
 	bool setOption (const CompString &name, CompOption::Value &value);
+	bool setOptions (CompOption::Vector &options);
+
+	bool applyOption (const CompString &name, CompOption::Value &value);
+	void finishOptionChanges ();
 
 	void handleEvent (XEvent *);
 
@@ -134,6 +138,16 @@ class BlurScreen :
 	int  blurTime;
 	bool moreBlur;
 
+	/* Work left over from changed options */
+	enum
+	{
+	    UpdateMatches = (1 << 0),
+	    ResetBlur     = (1 << 1),
+	    DamageScreen  = (1 << 2)
+	};
+
+	unsigned int pendingOptionChanges;
+
 	bool blurOcclusion;
 
 	int filterRadius;
@@ -18,13 +18,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <poll.h>
+
 #include "ccp.h"
 
 COMPIZ_PLUGIN_20090315 (ccp, CcpPluginVTable)
 
-static const unsigned short CCP_UPDATE_MIN_TIMEOUT = 250;
-static const unsigned short CCP_UPDATE_MAX_TIMEOUT = 4000;
-
 #define CORE_VTABLE_NAME  "core"
 
 static void
@@ -396,30 +395,66 @@ ccpTypeCheck (CCSSetting *s, CompOption *o)
     return false;
 }
 
-void
-CcpScreen::setOptionFromContext (CompOption *o,
-				 const char *plugin)
+bool
+CcpScreen::getValueFromContext (CompOption        *o,
+				const char        *plugin,
+				CompOption::Value &value)
 {
     CCSPlugin *bsp = ccsFindPlugin (mContext, (plugin) ? plugin : CORE_VTABLE_NAME);
 
     if (!bsp)
-	return;
+	return false;
 
     CCSSetting *setting = ccsFindSetting (bsp, o->name ().c_str ());
 
     if (!setting ||
 	!ccpTypeCheck (setting, o))
-	return;
-
-    CompOption::Value value;
+	return false;
 
     ccpSettingToValue (setting, &value);
 
+    return true;
+}
+
+/* Hands all of the options to the plugin as one change set, so that
+ * it only has to react once to the whole of it */
+void
+CcpScreen::setOptionsFromContext (const OptionList &options,
+				  const char       *plugin)
+{
+    CompOption::Vector changes;
+
+    foreach (CompOption *o, options)
+    {
+	CompOption::Value value;
+
+	if (!getValueFromContext (o, plugin, value))
+	    continue;
+
+	changes.push_back (CompOption (o->name (), o->type ()));
+	changes.back ().value () = value;
+    }
+
+    if (changes.empty ())
+	return;
+
     mApplyingSettings = true;
-    screen->setOptionForPlugin (plugin, o->name ().c_str (), value);
+    screen->setOptionsForPlugin (plugin, changes);
     mApplyingSettings = false;
 }
 
+void
+CcpScreen::setOptionsFromContext (CompOption::Vector &options,
+				  const char         *plugin)
+{
+    OptionList list;
+
+    foreach (CompOption &o, options)
+	list.push_back (&o);
+
+    setOptionsFromContext (list, plugin);
+}
+
 void
 CcpScreen::setContextFromOption (CompOption *o, const char *plugin)
 {
@@ -442,26 +477,79 @@ bool
 CcpScreen::reload ()
 {
     foreach (CompPlugin *p, CompPlugin::getPlugins ())
-	foreach (CompOption &o, p->vTable->getOptions ())
-	    setOptionFromContext (&o, p->vTable->name ().c_str ());
+	setOptionsFromContext (p->vTable->getOptions (),
+			       p->vTable->name ().c_str ());
+
+    ccsSyncMetadataCache ();
 
     return false;
 }
 
 bool
-CcpScreen::timeout ()
+CcpScreen::syncMetadata ()
+{
+    ccsSyncMetadataCache ();
+
+    return false;
+}
+
+static void
+ccpChangedSettingsNotify (CCSContext *context,
+			  void       *closure)
+{
+    CcpScreen *cs = static_cast<CcpScreen *> (closure);
+
+    /* Everything the backend delivers during this main loop
+     * iteration is applied together on the next one */
+    if (!cs->mChangesTimer.active ())
+	cs->mChangesTimer.start (boost::bind (&CcpScreen::processChanges, cs), 0);
+}
+
+void
+CcpScreen::updateFileWatch ()
+{
+    int fd = ccsGetFileWatchFd ();
+
+    if (fd == mFileWatchFd)
+	return;
+
+    if (mFileWatchFd != -1)
+	screen->removeWatchFd (mFileWatchHandle);
+
+    mFileWatchFd = fd;
+
+    if (mFileWatchFd != -1)
+	mFileWatchHandle = screen->addWatchFd (mFileWatchFd,
+					       POLLIN | POLLPRI | POLLHUP | POLLERR,
+					       boost::bind (&CcpScreen::processFileWatches,
+							    this));
+}
+
+void
+CcpScreen::processFileWatches ()
 {
+    /* Backends reading from files pick up changes here, which then
+     * end up in the context's changed settings list */
     ccsProcessEvents (mContext, ProcessEventsNoGlibMainLoopMask);
+    updateFileWatch ();
+}
 
+bool
+CcpScreen::processChanges ()
+{
     CCSSettingList list = ccsContextStealChangedSettings (mContext);
 
     if (ccsSettingListLength (list))
     {
-	CCSSettingList l = list;	
+	/* Changed options grouped by plugin, in the order in which the
+	 * plugins first appear in the list */
+	std::vector<std::pair<CompString, OptionList> > batches;
+
+	CCSSettingList l = list;
 	CCSSetting     *s;
 	CompPlugin     *p;
 	CompOption     *o;
-	
+
 	while (l)
 	{
 	    s = l->data;
@@ -475,16 +563,34 @@ CcpScreen::timeout ()
 	    o = CompOption::findOption (p->vTable->getOptions (), ccsSettingGetName (s));
 
 	    if (o)
-		setOptionFromContext (o, ccsPluginGetName (ccsSettingGetParent (s)));
+	    {
+		CompString name (ccsPluginGetName (ccsSettingGetParent (s)));
+		unsigned int i;
+
+		for (i = 0; i < batches.size (); ++i)
+		    if (batches[i].first == name)
+			break;
+
+		if (i == batches.size ())
+		    batches.push_back (std::make_pair (name, OptionList ()));
+
+		batches[i].second.push_back (o);
+	    }
 
 	    ccsDebug ("Setting Update \"%s\"", ccsSettingGetName (s));
 	}
 
+	for (unsigned int i = 0; i < batches.size (); ++i)
+	    setOptionsFromContext (batches[i].second, batches[i].first.c_str ());
+
 	ccsSettingListFree (list, FALSE);
 	ccsContextClearChangedSettings (mContext);
     }
 
-    return true;
+    /* Re-reading a profile might have moved the file watches */
+    updateFileWatch ();
+
+    return false;
 }
 
 bool
@@ -518,23 +624,64 @@ CcpScreen::setOptionForPlugin (const char        *plugin,
     return status;
 }
 
+bool
+CcpScreen::setOptionsForPlugin (const char         *plugin,
+				CompOption::Vector &options)
+{
+    OptionList changed;
+    CompPlugin *p = NULL;
+
+    bool can_save = (!mApplyingSettings && !mReloadTimer.active ());
+
+    if (can_save)
+    {
+	p = CompPlugin::find (plugin);
+
+	if (p)
+	{
+	    foreach (CompOption &option, options)
+	    {
+		CompOption *o = CompOption::findOption (p->vTable->getOptions (),
+							option.name ());
+
+		if (o && !(o->value () == option.value ()))
+		    changed.push_back (o);
+	    }
+	}
+    }
+
+    bool status = screen->setOptionsForPlugin (plugin, options);
+
+    if (status && can_save)
+	foreach (CompOption *o, changed)
+	    setContextFromOption (o, p->vTable->name ().c_str ());
+
+    return status;
+}
+
 bool
 CcpScreen::initPluginForScreen (CompPlugin *p)
 {
     bool status = screen->initPluginForScreen (p);
 
     if (status)
-    {
-	foreach (CompOption &opt, p->vTable->getOptions ())
-	    setOptionFromContext (&opt, p->vTable->name ().c_str ());
-    }
+	setOptionsFromContext (p->vTable->getOptions (),
+			       p->vTable->name ().c_str ());
+
+    /* Plugins are usually loaded several at a time, cache what was
+     * read for all of them at once */
+    if (!mMetadataSyncTimer.active ())
+	mMetadataSyncTimer.start (boost::bind (&CcpScreen::syncMetadata,
+					       this), 0);
 
     return status;
 }
 
 CcpScreen::CcpScreen (CompScreen *screen) :
     PluginClassHandler<CcpScreen,CompScreen> (screen),
-    mApplyingSettings (false)
+    mApplyingSettings (false),
+    mFileWatchFd (-1),
+    mFileWatchHandle (0)
 {
     ccsSetBasicMetadata (TRUE);
 
@@ -543,15 +690,20 @@ CcpScreen::CcpScreen (CompScreen *screen) :
 
     ccsContextClearChangedSettings (mContext);
 
+    ccsSetChangedSettingsNotify (mContext, ccpChangedSettingsNotify, this);
+    updateFileWatch ();
+
     mReloadTimer.start (boost::bind (&CcpScreen::reload, this), 0);
-    mTimeoutTimer.start (boost::bind (&CcpScreen::timeout, this),
-			 CCP_UPDATE_MIN_TIMEOUT, CCP_UPDATE_MAX_TIMEOUT);
 
     ScreenInterface::setHandler (screen);
 }
 
 CcpScreen::~CcpScreen ()
 {
+    if (mFileWatchFd != -1)
+	screen->removeWatchFd (mFileWatchHandle);
+
+    ccsSetChangedSettingsNotify (mContext, NULL, NULL);
     ccsContextDestroy (mContext);
 }
 
@@ -43,15 +43,30 @@ class CcpScreen :
 
 	bool initPluginForScreen (CompPlugin *p);
 
+	typedef std::vector<CompOption *> OptionList;
+
 	bool setOptionForPlugin (const char        *plugin,
 				 const char        *name,
 				 CompOption::Value &v);
 
-	bool timeout ();
+	bool setOptionsForPlugin (const char         *plugin,
+				  CompOption::Vector &options);
+
+	bool processChanges ();
+	void processFileWatches ();
+	void updateFileWatch ();
 	bool reload ();
+	bool syncMetadata ();
 
-	void setOptionFromContext (CompOption *o,
-				   const char *plugin);
+	bool getValueFromContext (CompOption        *o,
+				  const char        *plugin,
+				  CompOption::Value &value);
+
+	void setOptionsFromContext (const OptionList &options,
+				    const char       *plugin);
+
+	void setOptionsFromContext (CompOption::Vector &options,
+				    const char         *plugin);
 
 	void setContextFromOption (CompOption *o,
 				   const char *plugin);
@@ -62,8 +77,12 @@ class CcpScreen :
 	CCSContext  *mContext;
 	bool        mApplyingSettings;
 
-	CompTimer   mTimeoutTimer;
+	CompTimer   mChangesTimer;
 	CompTimer   mReloadTimer;
+	CompTimer   mMetadataSyncTimer;
+
+	int               mFileWatchFd;
+	CompWatchFdHandle mFileWatchHandle;
 };
 
 class CcpPluginVTable :
@@ -40,7 +40,7 @@
 #include <sstream>
 #include <fstream>
 
-#define COMPIZ_COMPIZTOOLBOX_ABI 3
+#define COMPIZ_COMPIZTOOLBOX_ABI 4
 
 typedef enum
 {
@@ -65,11 +65,13 @@ typedef enum
     Group
 } SwitchWindowSelection;
 
+class WindowPreviews;
+
 class BaseSwitchScreen
 {
     public:
 	BaseSwitchScreen (CompScreen *screen);
-	virtual ~BaseSwitchScreen () {}
+	virtual ~BaseSwitchScreen ();
 
 	void handleEvent (XEvent *);
 	void setSelectedWindowHint (bool focus);
@@ -109,6 +111,8 @@ class BaseSwitchScreen
 	unsigned int fgColor[4];
 
 	bool ignoreSwitcher;
+
+	WindowPreviews *previews;
 };
 
 class BaseSwitchWindow
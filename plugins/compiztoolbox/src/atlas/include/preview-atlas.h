@@ -0,0 +1,98 @@
+/*
+ * Compiz, compiztoolbox, window preview atlas
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_TOOLBOX_PREVIEW_ATLAS_H
+#define _COMPIZ_TOOLBOX_PREVIEW_ATLAS_H
+
+#include <map>
+#include <vector>
+
+#include <core/rect.h>
+#include <core/size.h>
+
+namespace compiz
+{
+    namespace toolbox
+    {
+	/**
+	 * Packs window previews of varying sizes into one texture.
+	 *
+	 * Cells are laid out on shelves: rows as tall as the first
+	 * preview put on them, filled left to right. Cells given back
+	 * are reused for previews that fit in them. Neighbouring cells
+	 * are kept a pixel apart so that filtering does not bleed.
+	 */
+	class PreviewAtlas
+	{
+	    public:
+
+		PreviewAtlas (const CompSize &size);
+
+		/**
+		 * Returns the cell of the preview for id, or NULL if
+		 * there is none
+		 */
+		const CompRect * find (unsigned long id) const;
+
+		/**
+		 * Returns a cell of exactly size for id, which is the
+		 * current one if it already has that size. Returns NULL
+		 * if there is no room left.
+		 */
+		const CompRect * allocate (unsigned long  id,
+					   const CompSize &size);
+
+		void release (unsigned long id);
+		void clear ();
+
+		const CompSize & size () const;
+		unsigned int count () const;
+
+	    private:
+
+		struct Shelf
+		{
+		    int y;
+		    int height;
+		    int x;
+		};
+
+		/* A cell and all of the space it takes up, which
+		 * can be more if it was reused */
+		struct Cell
+		{
+		    CompRect rect;
+		    CompRect slot;
+		};
+
+		bool allocateOnShelf (int width, int height, CompRect &slot);
+		bool allocateFree (int width, int height, CompRect &slot);
+
+		CompSize                      mSize;
+		std::vector <Shelf>           mShelves;
+		std::vector <CompRect>        mFree;
+		std::map <unsigned long, Cell> mCells;
+	};
+    }
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Compiz, compiztoolbox, window preview atlas
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "preview-atlas.h"
+
+namespace ct = compiz::toolbox;
+
+namespace
+{
+    /* Space left between cells */
+    const int GUTTER = 1;
+}
+
+ct::PreviewAtlas::PreviewAtlas (const CompSize &size) :
+    mSize (size)
+{
+}
+
+const CompRect *
+ct::PreviewAtlas::find (unsigned long id) const
+{
+    std::map <unsigned long, Cell>::const_iterator it = mCells.find (id);
+
+    if (it == mCells.end ())
+	return NULL;
+
+    return &it->second.rect;
+}
+
+const CompRect *
+ct::PreviewAtlas::allocate (unsigned long  id,
+			    const CompSize &size)
+{
+    const CompRect *current = find (id);
+
+    if (current && current->width ()  == size.width () &&
+		   current->height () == size.height ())
+	return current;
+
+    release (id);
+
+    if (size.width () <= 0 || size.height () <= 0)
+	return NULL;
+
+    int      width  = size.width ()  + GUTTER;
+    int      height = size.height () + GUTTER;
+    CompRect slot;
+
+    if (!allocateOnShelf (width, height, slot) &&
+	!allocateFree (width, height, slot))
+	return NULL;
+
+    Cell &added = mCells[id];
+
+    added.slot = slot;
+    added.rect.setGeometry (slot.x (), slot.y (),
+			    size.width (), size.height ());
+
+    return &added.rect;
+}
+
+/* Use the shelf that wastes the least height, or start a new one */
+bool
+ct::PreviewAtlas::allocateOnShelf (int      width,
+				   int      height,
+				   CompRect &slot)
+{
+    Shelf *best = NULL;
+
+    for (std::vector <Shelf>::iterator it = mShelves.begin ();
+	 it != mShelves.end (); ++it)
+    {
+	if (it->height < height || it->x + width > mSize.width ())
+	    continue;
+
+	if (!best || it->height < best->height)
+	    best = &*it;
+    }
+
+    /* A shelf much taller than needed wastes less if a new one fits */
+    int top = mShelves.empty () ? 0 :
+	      mShelves.back ().y + mShelves.back ().height;
+
+    if ((!best || best->height > height * 2) &&
+	top + height <= mSize.height () && width <= mSize.width ())
+    {
+	Shelf shelf = { top, height, 0 };
+
+	mShelves.push_back (shelf);
+	best = &mShelves.back ();
+    }
+
+    if (!best)
+	return false;
+
+    slot.setGeometry (best->x, best->y, width, height);
+    best->x += width;
+
+    return true;
+}
+
+/* Reuse the smallest given back cell that is large enough */
+bool
+ct::PreviewAtlas::allocateFree (int      width,
+				int      height,
+				CompRect &slot)
+{
+    std::vector <CompRect>::iterator best = mFree.end ();
+
+    for (std::vector <CompRect>::iterator it = mFree.begin ();
+	 it != mFree.end (); ++it)
+    {
+	if (it->width () < width || it->height () < height)
+	    continue;
+
+	if (best == mFree.end () || it->area () < best->area ())
+	    best = it;
+    }
+
+    if (best == mFree.end ())
+	return false;
+
+    slot = *best;
+    mFree.erase (best);
+
+    return true;
+}
+
+void
+ct::PreviewAtlas::release (unsigned long id)
+{
+    std::map <unsigned long, Cell>::iterator it = mCells.find (id);
+
+    if (it == mCells.end ())
+	return;
+
+    mFree.push_back (it->second.slot);
+    mCells.erase (it);
+}
+
+void
+ct::PreviewAtlas::clear ()
+{
+    mShelves.clear ();
+    mFree.clear ();
+    mCells.clear ();
+}
+
+const CompSize &
+ct::PreviewAtlas::size () const
+{
+    return mSize;
+}
+
+unsigned int
+ct::PreviewAtlas::count () const
+{
+    return mCells.size ();
+}
@@ -0,0 +1,129 @@
+/*
+ * Compiz, compiztoolbox, window preview atlas tests
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <core/region.h>
+
+#include "preview-atlas.h"
+
+namespace ct = compiz::toolbox;
+
+class PreviewAtlasTest :
+    public ::testing::Test
+{
+    public:
+
+	PreviewAtlasTest () :
+	    atlas (CompSize (256, 256))
+	{
+	}
+
+	ct::PreviewAtlas atlas;
+};
+
+TEST_F (PreviewAtlasTest, Empty)
+{
+    EXPECT_EQ (NULL, atlas.find (1));
+    EXPECT_EQ (0, atlas.count ());
+}
+
+TEST_F (PreviewAtlasTest, AllocatesExactSize)
+{
+    const CompRect *cell = atlas.allocate (1, CompSize (100, 50));
+
+    ASSERT_TRUE (cell);
+    EXPECT_EQ (100, cell->width ());
+    EXPECT_EQ (50, cell->height ());
+    EXPECT_EQ (*cell, *atlas.find (1));
+}
+
+TEST_F (PreviewAtlasTest, SameSizeKeepsCell)
+{
+    CompRect first (*atlas.allocate (1, CompSize (100, 50)));
+
+    atlas.allocate (2, CompSize (60, 40));
+
+    EXPECT_EQ (first, *atlas.allocate (1, CompSize (100, 50)));
+    EXPECT_EQ (2, atlas.count ());
+}
+
+TEST_F (PreviewAtlasTest, CellsDoNotOverlap)
+{
+    CompRegion used;
+
+    for (unsigned long id = 1; id <= 12; ++id)
+    {
+	const CompRect *cell = atlas.allocate (id, CompSize (40 + id, 30 + id % 3));
+
+	ASSERT_TRUE (cell);
+	EXPECT_TRUE ((used & *cell).isEmpty ());
+	EXPECT_TRUE (CompRect (0, 0, 256, 256).contains (*cell));
+
+	used += *cell;
+    }
+}
+
+TEST_F (PreviewAtlasTest, FullReturnsNull)
+{
+    EXPECT_TRUE (atlas.allocate (1, CompSize (200, 200)));
+    EXPECT_EQ (NULL, atlas.allocate (2, CompSize (200, 200)));
+    EXPECT_EQ (NULL, atlas.allocate (3, CompSize (300, 10)));
+    EXPECT_EQ (1, atlas.count ());
+}
+
+TEST_F (PreviewAtlasTest, ReleasedCellIsReused)
+{
+    CompRect first (*atlas.allocate (1, CompSize (200, 200)));
+
+    atlas.release (1);
+    EXPECT_EQ (NULL, atlas.find (1));
+
+    const CompRect *cell = atlas.allocate (2, CompSize (150, 150));
+
+    ASSERT_TRUE (cell);
+    EXPECT_EQ (first.pos (), cell->pos ());
+
+    /* The whole of the first cell comes back when it is released again */
+    atlas.release (2);
+    EXPECT_TRUE (atlas.allocate (3, CompSize (200, 200)));
+}
+
+TEST_F (PreviewAtlasTest, ResizeMovesCell)
+{
+    atlas.allocate (1, CompSize (50, 50));
+
+    const CompRect *cell = atlas.allocate (1, CompSize (60, 50));
+
+    ASSERT_TRUE (cell);
+    EXPECT_EQ (60, cell->width ());
+    EXPECT_EQ (1, atlas.count ());
+}
+
+TEST_F (PreviewAtlasTest, Clear)
+{
+    atlas.allocate (1, CompSize (200, 200));
+    atlas.clear ();
+
+    EXPECT_EQ (0, atlas.count ());
+    EXPECT_TRUE (atlas.allocate (2, CompSize (200, 200)));
+}
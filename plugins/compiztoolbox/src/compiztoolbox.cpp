@@ -25,10 +25,14 @@
 
 #include <compiztoolbox/compiztoolbox.h>
 #include "compiztoolbox_options.h"
+#include "preview-atlas.h"
 
 #include <core/abiversion.h>
 #include <core/propertywriter.h>
 
+#include <map>
+#include <boost/scoped_ptr.hpp>
+
 const unsigned short ICON_SIZE     = 512;
 const unsigned short MAX_ICON_SIZE = 512;
 
@@ -52,6 +56,44 @@ class CompizToolboxPluginVTable :
 
 COMPIZ_PLUGIN_20090315 (compiztoolbox, CompizToolboxPluginVTable)
 
+/*
+ * Downscaled copies of the switcher windows, kept in one texture.
+ *
+ * A preview is rendered at the size the thumbnail is shown at and only
+ * again once the window is damaged, so painting a thumbnail is a single
+ * small textured quad rather than the whole window texture.
+ */
+class WindowPreviews
+{
+    public:
+
+	WindowPreviews ();
+
+	bool paint (CompWindow                *window,
+		    GLWindow                  *gWindow,
+		    const GLMatrix            &transform,
+		    const GLWindowPaintAttrib &attrib,
+		    const CompRect            &thumb,
+		    bool                      mipmap);
+
+	void damage (Window id);
+	void clear ();
+
+    private:
+
+	bool render (CompWindow                *window,
+		     GLWindow                  *gWindow,
+		     const CompRect            &cell,
+		     const GLWindowPaintAttrib &attrib,
+		     bool                      mipmap);
+
+	compiz::toolbox::PreviewAtlas          atlas;
+	boost::scoped_ptr <GLFramebufferObject> fbo;
+
+	/* saturation each up to date preview was rendered with */
+	std::map <Window, GLushort>            rendered;
+};
+
 CompString
 getXDGUserDir (XDGUserDir userDir)
 {
@@ -258,6 +300,10 @@ BaseSwitchScreen::activateEvent (bool activating)
     o[0].value ().set ((int) ::screen->root ());
     o[1].value ().set (activating);
 
+    /* Previews are not kept up to date while the switcher is hidden */
+    if (!activating)
+	previews->clear ();
+
     ::screen->handleCompizEvent ("switcher", "activate", o);
 }
 
@@ -413,6 +459,202 @@ BaseSwitchScreen::findArgbVisual (Display *dpy, int scr)
     return visual;
 }
 
+WindowPreviews::WindowPreviews () :
+    atlas (CompSize (MIN (2048, GL::maxTextureSize),
+		     MIN (2048, GL::maxTextureSize)))
+{
+}
+
+void
+WindowPreviews::damage (Window id)
+{
+    rendered.erase (id);
+}
+
+/* Forget all previews and give back the texture, which is as large
+ * as 2048x2048 and only needed while a switcher is shown */
+void
+WindowPreviews::clear ()
+{
+    atlas.clear ();
+    rendered.clear ();
+    fbo.reset ();
+}
+
+/* Draws the window scaled into cell of the atlas */
+bool
+WindowPreviews::render (CompWindow                *window,
+			GLWindow                  *gWindow,
+			const CompRect            &cell,
+			const GLWindowPaintAttrib &attrib,
+			bool                      mipmap)
+{
+    GLScreen   *gScreen = GLScreen::get (::screen);
+    CompOutput &output  = ::screen->fullscreenOutput ();
+    CompRect   border   = window->borderRect ();
+    GLint      viewport[4];
+    GLint      scissor[4];
+    GLfloat    clearColor[4];
+    GLMatrix   sTransform;
+
+    GLFramebufferObject *oldFbo = fbo->bind ();
+
+    if (!fbo->checkStatus ())
+    {
+	GLFramebufferObject::rebind (oldFbo);
+	return false;
+    }
+
+    glGetIntegerv (GL_VIEWPORT, viewport);
+    glGetIntegerv (GL_SCISSOR_BOX, scissor);
+    glGetFloatv (GL_COLOR_CLEAR_VALUE, clearColor);
+
+    GLboolean scissorEnabled = glIsEnabled (GL_SCISSOR_TEST);
+
+    if (!scissorEnabled)
+	glEnable (GL_SCISSOR_TEST);
+
+    glViewport (cell.x (), cell.y (), cell.width (), cell.height ());
+    glScissor (cell.x (), cell.y (), cell.width (), cell.height ());
+    glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+    glClear (GL_COLOR_BUFFER_BIT);
+
+    /* Stretch the window over the whole (viewport sized) output */
+    sTransform.toScreenSpace (&output, -DEFAULT_Z_CAMERA);
+    sTransform.scale ((float) output.width ()  / border.width (),
+		      (float) output.height () / border.height (), 1.0f);
+    sTransform.translate (-border.x (), -border.y (), 0.0f);
+
+    GLWindowPaintAttrib sAttrib = { OPAQUE, BRIGHT, attrib.saturation,
+				    1.0f, 1.0f, 0.0f, 0.0f };
+    unsigned int        mask    = PAINT_WINDOW_TRANSFORMED_MASK;
+    GLenum              filter  = gScreen->textureFilter ();
+    int addWindowGeometryIndex  = gWindow->glAddGeometryGetCurrentIndex ();
+
+    if (window->alpha ())
+	mask |= PAINT_WINDOW_TRANSLUCENT_MASK;
+
+    /* The preview is painted at the size it was rendered at, so this is
+     * the only place the window texture is sampled scaled down */
+    if (mipmap)
+	gScreen->setTextureFilter (GL_LINEAR_MIPMAP_LINEAR);
+
+    gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
+    gWindow->glDraw (sTransform, sAttrib, CompRegion::infinite (), mask);
+    gWindow->glAddGeometrySetCurrentIndex (addWindowGeometryIndex);
+
+    gScreen->setTextureFilter (filter);
+
+    glClearColor (clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    glScissor (scissor[0], scissor[1], scissor[2], scissor[3]);
+
+    if (!scissorEnabled)
+	glDisable (GL_SCISSOR_TEST);
+
+    glViewport (viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    GLFramebufferObject::rebind (oldFbo);
+
+    return true;
+}
+
+/* Paints the preview of window into thumb, rendering it first if it is
+ * missing or out of date. Returns false if it has to be painted the
+ * usual way. */
+bool
+WindowPreviews::paint (CompWindow                *window,
+		       GLWindow                  *gWindow,
+		       const GLMatrix            &transform,
+		       const GLWindowPaintAttrib &attrib,
+		       const CompRect            &thumb,
+		       bool                      mipmap)
+{
+    if (!GL::fboEnabled || thumb.isEmpty ())
+	return false;
+
+    if (!fbo)
+    {
+	fbo.reset (new GLFramebufferObject ());
+
+	if (!fbo->allocate (atlas.size ()))
+	{
+	    fbo.reset ();
+	    return false;
+	}
+    }
+
+    Window         id       = window->id ();
+    const CompRect *old     = atlas.find (id);
+    CompRect       previous = old ? *old : CompRect ();
+    const CompRect *cell    = atlas.allocate (id, thumb.size ());
+
+    if (!cell)
+	return false;
+
+    std::map <Window, GLushort>::iterator it = rendered.find (id);
+
+    if (*cell != previous || it == rendered.end () ||
+	it->second != attrib.saturation)
+    {
+	if (!render (window, gWindow, *cell, attrib, mipmap))
+	{
+	    atlas.release (id);
+	    return false;
+	}
+
+	rendered[id] = attrib.saturation;
+    }
+
+    GLTexture               *tex       = fbo->tex ();
+    const GLTexture::Matrix &texMatrix = tex->matrix ();
+    GLVertexBuffer          *streamingBuffer = GLVertexBuffer::streamingBuffer ();
+
+    /* The cell was rendered bottom up */
+    GLfloat tx1 = COMP_TEX_COORD_X (texMatrix, cell->x1 ());
+    GLfloat tx2 = COMP_TEX_COORD_X (texMatrix, cell->x2 ());
+    GLfloat ty1 = COMP_TEX_COORD_Y (texMatrix, cell->y2 ());
+    GLfloat ty2 = COMP_TEX_COORD_Y (texMatrix, cell->y1 ());
+
+    const GLfloat vertexData[] = {
+	(float) thumb.x1 (), (float) thumb.y1 (), 0.0f,
+	(float) thumb.x1 (), (float) thumb.y2 (), 0.0f,
+	(float) thumb.x2 (), (float) thumb.y1 (), 0.0f,
+	(float) thumb.x2 (), (float) thumb.y2 (), 0.0f
+    };
+
+    const GLfloat textureData[] = {
+	tx1, ty1,
+	tx1, ty2,
+	tx2, ty1,
+	tx2, ty2
+    };
+
+    /* Premultiplied, like the preview */
+    GLushort color = ((unsigned int) attrib.opacity * attrib.brightness) /
+		     0xffff;
+    GLushort colorData[4] = { color, color, color, attrib.opacity };
+
+    GLboolean glBlendEnabled = glIsEnabled (GL_BLEND);
+
+    if (!glBlendEnabled)
+	glEnable (GL_BLEND);
+
+    streamingBuffer->begin (GL_TRIANGLE_STRIP);
+    streamingBuffer->addVertices (4, &vertexData[0]);
+    streamingBuffer->addTexCoords (0, 4, &textureData[0]);
+    streamingBuffer->addColors (1, colorData);
+    streamingBuffer->end ();
+
+    tex->enable (GLTexture::Good);
+    streamingBuffer->render (transform);
+    tex->disable ();
+
+    if (!glBlendEnabled)
+	glDisable (GL_BLEND);
+
+    return true;
+}
+
 void
 BaseSwitchWindow::paintThumb (const GLWindowPaintAttrib &attrib,
 			      const GLMatrix            &transform,
@@ -495,19 +737,25 @@ BaseSwitchWindow::paintThumb (const GLWindowPaintAttrib &attrib,
 			      sAttrib.yTranslate / sAttrib.yScale - g.y (),
 			      0.0f);
 
-	filter = gScreen->textureFilter ();
+	CompRect thumb (wx, wy, ceilf (width), ceilf (height));
 
-	if (baseScreen->getMipmap ())
-	    gScreen->setTextureFilter (GL_LINEAR_MIPMAP_LINEAR);
+	if (!baseScreen->previews->paint (window, gWindow, transform, sAttrib,
+					  thumb, baseScreen->getMipmap ()))
+	{
+	    filter = gScreen->textureFilter ();
 
-	/* XXX: replacing the addWindowGeometry function like this is
-	   very ugly but necessary until the vertex stage has been made
-	   fully pluggable. */
-	gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
-	gWindow->glDraw (wTransform, sAttrib, CompRegion::infinite (), mask);
-	gWindow->glAddGeometrySetCurrentIndex (addWindowGeometryIndex);
+	    if (baseScreen->getMipmap ())
+		gScreen->setTextureFilter (GL_LINEAR_MIPMAP_LINEAR);
 
-	gScreen->setTextureFilter (filter);
+	    /* XXX: replacing the addWindowGeometry function like this is
+	       very ugly but necessary until the vertex stage has been made
+	       fully pluggable. */
+	    gWindow->glAddGeometrySetCurrentIndex (MAXSHORT);
+	    gWindow->glDraw (wTransform, sAttrib, CompRegion::infinite (), mask);
+	    gWindow->glAddGeometrySetCurrentIndex (addWindowGeometryIndex);
+
+	    gScreen->setTextureFilter (filter);
+	}
 
 	if (iconMode != HideIcon)
 	{
@@ -576,6 +824,8 @@ BaseSwitchWindow::damageRect (bool initial, const CompRect &rect)
     if (!openGLAvailable)
 	return true;
 
+    baseScreen->previews->damage (window->id ());
+
     if (baseScreen->grabIndex)
     {
 	CompWindow *popup;
@@ -684,7 +934,8 @@ BaseSwitchScreen::BaseSwitchScreen (CompScreen *screen) :
     grabIndex (NULL),
     moreAdjust (false),
     selection (CurrentViewport),
-    ignoreSwitcher (false)
+    ignoreSwitcher (false),
+    previews (new WindowPreviews ())
 {
     CompOption::Vector atomTemplate;
     CompOption::Value v;
@@ -712,6 +963,11 @@ BaseSwitchScreen::BaseSwitchScreen (CompScreen *screen) :
     fgColor[3] = 0xffff;
 }
 
+BaseSwitchScreen::~BaseSwitchScreen ()
+{
+    delete previews;
+}
+
 BaseSwitchWindow::BaseSwitchWindow (BaseSwitchScreen *ss, CompWindow *w) :
     baseScreen (ss),
     window (w)
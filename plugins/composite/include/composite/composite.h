@@ -289,6 +289,7 @@ class CompositeScreen :
 	WRAPABLE_HND (7, CompositeScreenInterface, void, damageCutoff);
 
 	friend class PrivateCompositeDisplay;
+	friend class PrivateCompositeWindow;
 
     private:
 	PrivateCompositeScreen *priv;
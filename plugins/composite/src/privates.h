@@ -64,6 +64,8 @@ class PrivateCompositeScreen :
 
 	void handleEvent (XEvent *event);
 
+	void addSupportedAtoms (std::vector<Atom> &atoms);
+
 	void makeOutputWindow ();
 
 	bool init ();
@@ -131,6 +133,9 @@ class PrivateCompositeScreen :
 
 	compiz::composite::buffertracking::AgeingDamageBuffers ageingBuffers;
 	compiz::composite::buffertracking::FrameRoster         roster;
+
+	/* Windows whose clients finished a frame since the last paint */
+	std::vector<Window> frameDrawnWindows;
 };
 
 class PrivateCompositeWindow :
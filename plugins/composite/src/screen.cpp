@@ -31,6 +31,8 @@
 
 #include <boost/make_shared.hpp>
 
+#include <algorithm>
+
 #include <sys/time.h>
 
 #include <X11/Xlib.h>
@@ -203,6 +205,52 @@ CompositeScreen::damageEvent ()
 
 template class PluginClassHandler<CompositeScreen, CompScreen, COMPIZ_COMPOSITE_ABI>;
 
+namespace
+{
+XID
+damageKey (const XEvent &event)
+{
+    return ((const XDamageNotifyEvent &) event).damage;
+}
+
+/* Repeated reports for the same damage object fold into one covering
+ * them, as long as they overlap or touch. A bounding box around damage
+ * far apart, like a clock in one corner and a cursor in another, would
+ * repaint everything in between. */
+bool
+mergeDamage (XEvent       &pendingEvent,
+	     const XEvent &nextEvent)
+{
+    XDamageNotifyEvent       &pending = (XDamageNotifyEvent &) pendingEvent;
+    const XDamageNotifyEvent &next    = (const XDamageNotifyEvent &) nextEvent;
+
+    if (pending.drawable != next.drawable)
+	return false;
+
+    if (next.area.x > pending.area.x + pending.area.width  ||
+	pending.area.x > next.area.x + next.area.width     ||
+	next.area.y > pending.area.y + pending.area.height ||
+	pending.area.y > next.area.y + next.area.height)
+	return false;
+
+    int x1 = std::min<int> (pending.area.x, next.area.x);
+    int y1 = std::min<int> (pending.area.y, next.area.y);
+    int x2 = std::max<int> (pending.area.x + pending.area.width,
+			    next.area.x + next.area.width);
+    int y2 = std::max<int> (pending.area.y + pending.area.height,
+			    next.area.y + next.area.height);
+
+    XRectangle area = { (short) x1, (short) y1,
+			(unsigned short) (x2 - x1),
+			(unsigned short) (y2 - y1) };
+
+    pending      = next;
+    pending.area = area;
+
+    return true;
+}
+}
+
 CompositeScreen::CompositeScreen (CompScreen *s) :
     PluginClassHandler<CompositeScreen, CompScreen, COMPIZ_COMPOSITE_ABI> (s),
     priv (new PrivateCompositeScreen (this))
@@ -238,6 +286,9 @@ CompositeScreen::CompositeScreen (CompScreen *s) :
 	return;
     }
 
+    screen->eventCoalescer ().addRule (priv->damageEvent + XDamageNotify,
+				       damageKey, mergeDamage);
+
     if (!XFixesQueryExtension (s->dpy (), &priv->fixesEvent, &priv->fixesError))
     {
 	compLogMessage ("core", CompLogLevelFatal,
@@ -259,6 +310,8 @@ CompositeScreen::CompositeScreen (CompScreen *s) :
 
     if (!priv->init ())
 	setFailed ();
+    else
+	screen->updateSupportedWmHints ();
 }
 
 CompositeScreen::~CompositeScreen ()
@@ -329,6 +382,12 @@ PrivateCompositeScreen::~PrivateCompositeScreen ()
 {
     Display *dpy = screen->dpy ();
 
+    screen->addSupportedAtomsSetEnabled (this, false);
+    screen->updateSupportedWmHints ();
+
+    if (damageEvent)
+	screen->eventCoalescer ().removeRule (damageEvent + XDamageNotify);
+
     if (cmSnAtom)
 	XSetSelectionOwner (dpy, cmSnAtom, None, CurrentTime);
 
@@ -336,6 +395,15 @@ PrivateCompositeScreen::~PrivateCompositeScreen ()
 	XDestroyWindow (dpy, newCmSnOwner);
 }
 
+void
+PrivateCompositeScreen::addSupportedAtoms (std::vector<Atom> &atoms)
+{
+    /* We get to say when a frame has been drawn */
+    atoms.push_back (Atoms::wmFrameDrawn);
+
+    screen->addSupportedAtoms (atoms);
+}
+
 bool
 PrivateCompositeScreen::init ()
 {
@@ -1004,6 +1072,18 @@ CompositeScreen::handlePaintTimeout ()
 	}
     }
 
+    /* Clients using the extended sync counter wait for this before
+     * they start on their next frame */
+    foreach (Window id, priv->frameDrawnWindows)
+    {
+	CompWindow *w = screen->findWindow (id);
+
+	if (w)
+	    w->frameDrawn ();
+    }
+
+    priv->frameDrawnWindows.clear ();
+
     priv->lastRedraw = tv;
     priv->painting = false;
     priv->scheduled = false;
@@ -542,6 +542,11 @@ PrivateCompositeWindow::windowNotify (CompWindowNotify n)
 		PrivateCompositeWindow::handleDamageRect (cWindow, rect);
 
 	    damageRects.clear();
+
+	    /* Let the client know once its frame made it to the screen,
+	     * even if there turns out to be nothing to paint for it */
+	    cScreen->priv->frameDrawnWindows.push_back (window->id ());
+	    cScreen->damagePending ();
 	    break;
 	}
 
@@ -1661,6 +1661,20 @@ PrivateCubeScreen::setOptionForPlugin (const char        *plugin,
     return status;
 }
 
+bool
+PrivateCubeScreen::setOptionsForPlugin (const char         *plugin,
+					CompOption::Vector &options)
+{
+    bool status = screen->setOptionsForPlugin (plugin, options);
+
+    if (status				&&
+	strcmp (plugin, "core") == 0	&&
+	CompOption::findOption (options, "hsize"))
+	updateGeometry (screen->vpSize ().width (), mInvert);
+
+    return status;
+}
+
 PrivateCubeScreen::PrivateCubeScreen (CompScreen *s) :
     cScreen (CompositeScreen::get (s)),
     gScreen (GLScreen::get (s)),
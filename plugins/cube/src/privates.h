@@ -76,6 +76,9 @@ class PrivateCubeScreen :
 				 const char        *name,
 				 CompOption::Value &v);
 
+	bool setOptionsForPlugin (const char         *plugin,
+				  CompOption::Vector &options);
+
 	void outputChangeNotify ();
 
 	const CompWindowList & getWindowPaintList ();
@@ -1675,29 +1675,59 @@ DbusScreen::setOptionForPlugin (const char        *plugin,
 {
     bool status = screen->setOptionForPlugin (plugin, name, value);
 
+    if (status)
+	optionsChanged (plugin, std::vector<CompString> (1, name));
+
+    return status;
+}
+
+bool
+DbusScreen::setOptionsForPlugin (const char         *plugin,
+				 CompOption::Vector &options)
+{
+    bool status = screen->setOptionsForPlugin (plugin, options);
+
     if (status)
     {
-	CompPlugin *p;
+	std::vector<CompString> names;
 
-	p = CompPlugin::find (plugin);
-	if (p && p->vTable)
-	{
-	    CompOption::Vector &options = p->vTable->getOptions ();
-	    sendChangeSignalForOption (CompOption::findOption (options, name),
-				       p->vTable->name ());
+	foreach (CompOption &o, options)
+	    names.push_back (o.name ());
 
-	    if (p->vTable->name () == "core" &&
-		strcmp (name, "active_plugins") == 0)
-	    {
-		unregisterPluginsForScreen (connection);
-		registerPluginsForScreen (connection);
-	    }
-	}
+	optionsChanged (plugin, names);
     }
 
     return status;
 }
 
+void
+DbusScreen::optionsChanged (const char                    *plugin,
+			    const std::vector<CompString> &names)
+{
+    CompPlugin *p = CompPlugin::find (plugin);
+
+    if (!p || !p->vTable)
+	return;
+
+    CompOption::Vector &options = p->vTable->getOptions ();
+    bool               pluginsChanged = false;
+
+    foreach (const CompString &name, names)
+    {
+	sendChangeSignalForOption (CompOption::findOption (options, name),
+				   p->vTable->name ());
+
+	if (p->vTable->name () == "core" && name == "active_plugins")
+	    pluginsChanged = true;
+    }
+
+    if (pluginsChanged)
+    {
+	unregisterPluginsForScreen (connection);
+	registerPluginsForScreen (connection);
+    }
+}
+
 void
 DbusScreen::sendPluginsChangedSignal (const char *name)
 {
@@ -108,6 +108,10 @@ class DbusScreen :
 			    const char *name,
 			    CompOption::Value &v);
 
+	bool
+	setOptionsForPlugin (const char         *plugin,
+			     CompOption::Vector &options);
+
 	bool
 	initPluginForScreen (CompPlugin *p);
 
@@ -195,6 +199,10 @@ class DbusScreen :
 	sendChangeSignalForOption (CompOption       *o,
 			           const CompString &plugin);
 
+	void
+	optionsChanged (const char                    *plugin,
+			const std::vector<CompString> &names);
+
 	bool
 	getPathDecomposed (const char              *data,
 			   std::vector<CompString> &path);
@@ -2767,9 +2767,11 @@ DecorScreen::updateDefaultShadowProperty ()
     free (colorString[1]);
 }
 
+/* Sets one option and records in pendingOptionChanges what has to be
+ * redone for it */
 bool
-DecorScreen::setOption (const CompString  &name,
-			CompOption::Value &value)
+DecorScreen::applyOption (const CompString  &name,
+			  CompOption::Value &value)
 {
     unsigned int index;
 
@@ -2808,8 +2810,7 @@ DecorScreen::setOption (const CompString  &name,
 	    }
 	    /* fall-through intended */
 	case DecorOptions::DecorationMatch:
-	    foreach (CompWindow *w, screen->windows ())
-		DecorWindow::get (w)->update (true);
+	    pendingOptionChanges |= UpdateDecorations;
 	    break;
 	case DecorOptions::ActiveShadowRadius:
 	case DecorOptions::ActiveShadowOpacity:
@@ -2821,7 +2822,7 @@ DecorScreen::setOption (const CompString  &name,
 	case DecorOptions::InactiveShadowColor:
 	case DecorOptions::InactiveShadowXOffset:
 	case DecorOptions::InactiveShadowYOffset:
-	    updateDefaultShadowProperty ();
+	    pendingOptionChanges |= UpdateShadowProperty;
 	    break;
 	default:
 	    break;
@@ -2830,6 +2831,51 @@ DecorScreen::setOption (const CompString  &name,
     return rv;
 }
 
+void
+DecorScreen::finishOptionChanges ()
+{
+    if (pendingOptionChanges & UpdateDecorations)
+	foreach (CompWindow *w, screen->windows ())
+	    DecorWindow::get (w)->update (true);
+
+    if (pendingOptionChanges & UpdateShadowProperty)
+	updateDefaultShadowProperty ();
+
+    pendingOptionChanges = 0;
+}
+
+bool
+DecorScreen::setOption (const CompString  &name,
+			CompOption::Value &value)
+{
+    bool rv = applyOption (name, value);
+
+    finishOptionChanges ();
+
+    return rv;
+}
+
+/*
+ * DecorScreen::setOptions
+ *
+ * Apply a batch of changed options, redecorating
+ * windows and updating the shadow property at most
+ * once for the whole batch
+ */
+bool
+DecorScreen::setOptions (CompOption::Vector &options)
+{
+    bool rv = false;
+
+    foreach (CompOption &o, options)
+	if (applyOption (o.name (), o.value ()))
+	    rv = true;
+
+    finishOptionChanges ();
+
+    return rv;
+}
+
 /*
  * DecorWindow::moveNotify
  *
@@ -3018,6 +3064,7 @@ DecorScreen::DecorScreen (CompScreen *s) :
     dmWin (None),
     dmSupports (0),
     cmActive (false),
+    pendingOptionChanges (0),
     windowDefault (new Decoration (WINDOW_DECORATION_TYPE_WINDOW,
 				   decor_extents_t (),
 				   decor_extents_t (),
@@ -212,6 +212,7 @@ class DecorScreen :
 	~DecorScreen ();
 
 	bool setOption (const CompString &name, CompOption::Value &value);
+	bool setOptions (CompOption::Vector &options);
 
 	void handleEvent (XEvent *event);
 	void matchPropertyChanged (CompWindow *);
@@ -230,6 +231,9 @@ class DecorScreen :
 
     private:
 
+	bool applyOption (const CompString &name, CompOption::Value &value);
+	void finishOptionChanges ();
+
 	DecorPixmapRequestorInterface * findWindowRequestor (Window);
 	DecorationListFindMatchingInterface * findWindowDecorations (Window);
 
@@ -259,6 +263,15 @@ class DecorScreen :
 
 	bool cmActive;
 
+	/* Work left over from changed options */
+	enum
+	{
+	    UpdateDecorations    = (1 << 0),
+	    UpdateShadowProperty = (1 << 1)
+	};
+
+	unsigned int pendingOptionChanges;
+
 	DecorationList decor[DECOR_NUM];
 	Decoration::Ptr     windowDefault;
 
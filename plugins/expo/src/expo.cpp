@@ -205,7 +205,7 @@ ExpoScreen::nextVp (CompAction         *action,
 
     moveFocusViewport (newX - selectedVp.x (),
 		       newY - selectedVp.y ());
-    cScreen->damageScreen ();
+    damageWall ();
 
     return true;
 }
@@ -236,7 +236,7 @@ ExpoScreen::prevVp (CompAction         *action,
 
     moveFocusViewport (newX - selectedVp.x (),
 		       newY - selectedVp.y ());
-    cScreen->damageScreen ();
+    damageWall ();
 
     return true;
 }
@@ -254,7 +254,7 @@ ExpoScreen::moveFocusViewport (int dx,
     newY = MAX (0, MIN (static_cast <int> (screen->vpSize ().height ()) - 1, newY));
 
     selectedVp.set (newX, newY);
-    cScreen->damageScreen ();
+    damageWall ();
 }
 
 void
@@ -359,7 +359,7 @@ ExpoScreen::handleEvent (XEvent *event)
 		    doubleClick = false;
 		}
 
-		cScreen->damageScreen ();
+		damageWall ();
 		prevClickPoint = CompPoint (event->xbutton.x, event->xbutton.y);
 	    }
 
@@ -476,6 +476,14 @@ ExpoScreen::updateWraps (bool enable)
     gScreen->glPaintOutputSetEnabled (this, enable);
     gScreen->glPaintTransformedOutputSetEnabled (this, enable);
 
+    /* Start with a clean slate every time and don't hold on to the
+     * viewport pictures outside of expo */
+    vpCache.clear ();
+
+    if (enable)
+	vpDamage.reset (screen->vpSize (), *screen,
+			screen->outputDevs ().size ());
+
     ExpoWindow *ew;
 
     foreach (CompWindow *w, screen->windows ())
@@ -494,6 +502,11 @@ void
 ExpoScreen::paint (CompOutput::ptrList &outputs,
 		   unsigned int        mask)
 {
+    /* Whoever damaged the whole screen, the damage of the windows
+     * that changed since did not make it to damageRect */
+    if ((mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK) && viewportCacheUsable ())
+	vpDamage.damageAll ();
+
     if (expoCam         > 0.0	&&
 	outputs.size () > 1	&&
 	optionGetMultioutputMode () == MultioutputModeOneBigWall)
@@ -542,7 +555,7 @@ ExpoScreen::donePaint ()
     {
 	foreach (float &vp, vpActivity)
 	    if (vp != 0.0 && vp != 1.0)
-		cScreen->damageScreen ();
+		damageWall ();
     }
 
     if (grabIndex && expoCam <= 0.0f && !expoMode)
@@ -772,6 +785,231 @@ ExpoScreen::invertTransformedVertex (const GLScreenPaintAttrib &attrib,
     vertex[1] = ceil (p1[1] + (alpha * v[1]));
 }
 
+/*
+ * Once the wall is fully zoomed out every viewport is painted from a
+ * picture taken of it earlier, as long as nothing on the viewport has
+ * changed. While zooming, dragging windows around or bending the wall
+ * windows are painted differently every frame, so the viewports are
+ * painted directly then.
+ */
+bool
+ExpoScreen::viewportCacheUsable ()
+{
+    return optionGetCacheViewports () &&
+	   GL::fboEnabled             &&
+	   expoCam >= 1.0f            &&
+	   dndState == DnDNone        &&
+	   optionGetDeform () != DeformCurve;
+}
+
+/*
+ * Repaints the wall without damaging the whole screen while the
+ * viewport pictures are in use. Once the whole screen is damaged,
+ * composite stops passing the damage of single windows on to
+ * damageRect, and the pictures could not tell which viewports
+ * changed.
+ *
+ * The wall is painted transformed, so any damage to an output
+ * repaints all of it.
+ */
+void
+ExpoScreen::damageWall ()
+{
+    if (viewportCacheUsable ())
+	cScreen->damageRegion (screen->region ());
+    else
+	cScreen->damageScreen ();
+}
+
+/* Everything on a viewport which can change without damaging a window */
+compiz::expo::ViewportDamage::Signature
+ExpoScreen::viewportSignature (const CompPoint &vp)
+{
+    compiz::expo::ViewportDamage::Signature signature;
+    CompRect vpRect (vpDamage.viewportRect (vp, screen->vp ()));
+
+    signature.push_back (vp == selectedVp);
+
+    foreach (CompWindow *w, screen->windows ())
+    {
+	const CompRect &rect = w->outputRect ();
+
+	if (!w->onAllViewports () && !vpRect.intersects (rect))
+	    continue;
+
+	const GLWindowPaintAttrib &attrib = GLWindow::get (w)->paintAttrib ();
+
+	signature.push_back (w->id ());
+	signature.push_back (rect.x ());
+	signature.push_back (rect.y ());
+	signature.push_back (rect.width ());
+	signature.push_back (rect.height ());
+	signature.push_back (w->isViewable ());
+	signature.push_back (w->shaded ());
+	signature.push_back (w->state ());
+	signature.push_back (attrib.opacity);
+	signature.push_back (attrib.brightness);
+	signature.push_back (attrib.saturation);
+	signature.push_back (ExpoWindow::get (w)->wallOpacity (vp));
+    }
+
+    return signature;
+}
+
+/* Paints paintingVp of output flat into fbo */
+bool
+ExpoScreen::renderViewport (GLFramebufferObject *fbo,
+			    CompOutput          *output,
+			    unsigned int        mask)
+{
+    /* The viewports are shown a lot smaller than the output, there is
+     * no point in keeping them at full size */
+    float    scale = MIN (1.0f, 2.0f / MAX (screen->vpSize ().width (),
+					    screen->vpSize ().height ()));
+    CompSize size (ceilf (output->width () * scale),
+		   ceilf (output->height () * scale));
+
+    if (!fbo->allocate (size))
+	return false;
+
+    GLFramebufferObject *oldFbo = fbo->bind ();
+
+    if (!fbo->checkStatus ())
+    {
+	GLFramebufferObject::rebind (oldFbo);
+	return false;
+    }
+
+    GLfloat clearColor[4];
+    glGetFloatv (GL_COLOR_CLEAR_VALUE, clearColor);
+
+    glViewport (0, 0, size.width (), size.height ());
+    glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+    glClear (GL_COLOR_BUFFER_BIT);
+    glClearColor (clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    /* Brightness and saturation are applied when painting the
+     * picture, they change without the viewport changing */
+    float    brightness = vpBrightness;
+    float    saturation = vpSaturation;
+    GLMatrix identity;
+
+    vpBrightness = 1.0f;
+    vpSaturation = 1.0f;
+
+    renderingViewport = true;
+    viewportVolatile  = false;
+
+    gScreen->glPaintTransformedOutput (defaultScreenPaintAttrib, identity,
+				       CompRegion (*output), output,
+				       mask & ~PAINT_SCREEN_CLEAR_MASK);
+
+    renderingViewport = false;
+
+    vpBrightness = brightness;
+    vpSaturation = saturation;
+
+    GLFramebufferObject::rebind (oldFbo);
+
+    glViewport (output->x1 (), screen->height () - output->y2 (),
+		output->width (), output->height ());
+
+    return true;
+}
+
+bool
+ExpoScreen::paintCachedViewport (const GLScreenPaintAttrib &attrib,
+				 const GLMatrix            &transform,
+				 CompOutput                *output,
+				 unsigned int              mask)
+{
+    /* Saturation needs the window shaders, leave it to them */
+    if (!viewportCacheUsable () || vpSaturation < 1.0f)
+	return false;
+
+    unsigned int nVps  = screen->vpSize ().width () * screen->vpSize ().height ();
+    unsigned int index = output->id () * nVps +
+			 paintingVp.y () * screen->vpSize ().width () +
+			 paintingVp.x ();
+
+    if (vpCache.size () <= index)
+	vpCache.resize (screen->outputDevs ().size () * nVps);
+
+    if (index >= vpCache.size ())
+	return false;
+
+    if (!vpCache[index])
+	vpCache[index].reset (new GLFramebufferObject ());
+
+    GLFramebufferObject *fbo       = vpCache[index].get ();
+    compiz::expo::ViewportDamage::Signature signature =
+	viewportSignature (paintingVp);
+
+    if (!fbo->tex () ||
+	vpDamage.needsUpdate (output->id (), paintingVp, signature))
+    {
+	if (!renderViewport (fbo, output, mask))
+	    return false;
+
+	vpDamage.updated (output->id (), paintingVp, signature);
+
+	/* What other plugins paint differently goes unnoticed by the
+	 * signature, take a new picture until they are done */
+	if (viewportVolatile)
+	    vpDamage.damageViewport (output->id (), paintingVp);
+    }
+
+    GLTexture               *tex       = fbo->tex ();
+    const GLTexture::Matrix &texMatrix = tex->matrix ();
+    GLVertexBuffer          *streamingBuffer = GLVertexBuffer::streamingBuffer ();
+    GLMatrix                sTransform (transform);
+
+    gScreen->glApplyTransform (attrib, output, &sTransform);
+    sTransform.toScreenSpace (output, -attrib.zTranslate);
+
+    GLfloat tx1 = COMP_TEX_COORD_X (texMatrix, 0.0f);
+    GLfloat tx2 = COMP_TEX_COORD_X (texMatrix, tex->width ());
+    GLfloat ty1 = 1.0 - COMP_TEX_COORD_Y (texMatrix, 0.0f);
+    GLfloat ty2 = 1.0 - COMP_TEX_COORD_Y (texMatrix, tex->height ());
+
+    const GLfloat vertexData[] = {
+	(float) output->x1 (), (float) output->y1 (), 0.0f,
+	(float) output->x1 (), (float) output->y2 (), 0.0f,
+	(float) output->x2 (), (float) output->y1 (), 0.0f,
+	(float) output->x2 (), (float) output->y2 (), 0.0f
+    };
+
+    const GLfloat textureData[] = {
+	tx1, ty1,
+	tx1, ty2,
+	tx2, ty1,
+	tx2, ty2
+    };
+
+    GLushort brightness = vpBrightness * 0xffff;
+    GLushort colorData[4] = { brightness, brightness, brightness, 0xffff };
+
+    GLboolean glBlendEnabled = glIsEnabled (GL_BLEND);
+
+    if (!glBlendEnabled)
+	glEnable (GL_BLEND);
+
+    streamingBuffer->begin (GL_TRIANGLE_STRIP);
+    streamingBuffer->addVertices (4, &vertexData[0]);
+    streamingBuffer->addTexCoords (0, 4, &textureData[0]);
+    streamingBuffer->addColors (1, colorData);
+    streamingBuffer->end ();
+
+    tex->enable (GLTexture::Good);
+    streamingBuffer->render (sTransform);
+    tex->disable ();
+
+    if (!glBlendEnabled)
+	glDisable (GL_BLEND);
+
+    return true;
+}
+
 void
 ExpoScreen::paintWall (const GLScreenPaintAttrib &attrib,
 		       const GLMatrix&           transform,
@@ -1017,9 +1255,10 @@ ExpoScreen::paintWall (const GLScreenPaintAttrib &attrib,
 				       DEFAULT_Z_CAMERA - curveDistance);
 	    }
 
-	    gScreen->glPaintTransformedOutput (attrib, sTransform3,
-					       screen->region (), output,
-					       mask);
+	    if (!paintCachedViewport (attrib, sTransform3, output, mask))
+		gScreen->glPaintTransformedOutput (attrib, sTransform3,
+						   screen->region (), output,
+						   mask);
 
 	    if (!reflection)
 	    {
@@ -1307,22 +1546,18 @@ ExpoWindow::glDraw (const GLMatrix            &transform,
     // Scaling factors to be applied to attrib later in glDrawTexture
     expoOpacity = 1.0f;
 
-    int expoAnimation = eScreen->optionGetExpoAnimation ();
-
     if (eScreen->expoActive)
+	expoOpacity = wallOpacity (eScreen->paintingVp);
+
+    if (eScreen->renderingViewport)
     {
-	if (expoAnimation != ExpoScreen::ExpoAnimationZoom)
-	    expoOpacity = eScreen->expoCam;
+	const GLWindowPaintAttrib &paintAttrib = gWindow->paintAttrib ();
 
-	if (window->wmType () & CompWindowTypeDockMask &&
-	    eScreen->optionGetHideDocks ())
-	{
-	    if (expoAnimation == ExpoScreen::ExpoAnimationZoom &&
-		eScreen->paintingVp == eScreen->selectedVp)
-		expoOpacity = (1.0f - sigmoidProgress (eScreen->expoCam));
-	    else
-		expoOpacity = 0.0f;
-	}
+	if ((mask & PAINT_WINDOW_TRANSFORMED_MASK)     ||
+	    attrib.opacity != paintAttrib.opacity       ||
+	    attrib.brightness != paintAttrib.brightness ||
+	    attrib.saturation != paintAttrib.saturation)
+	    eScreen->viewportVolatile = true;
     }
 
     bool status = gWindow->glDraw (transform, attrib, region, mask);
@@ -1342,6 +1577,29 @@ ExpoWindow::glDraw (const GLMatrix            &transform,
     return status;
 }
 
+/* How much of the window shows on vp of the wall */
+float
+ExpoWindow::wallOpacity (const CompPoint &vp)
+{
+    float opacity       = 1.0f;
+    int   expoAnimation = eScreen->optionGetExpoAnimation ();
+
+    if (expoAnimation != ExpoScreen::ExpoAnimationZoom)
+	opacity = eScreen->expoCam;
+
+    if (window->wmType () & CompWindowTypeDockMask &&
+	eScreen->optionGetHideDocks ())
+    {
+	if (expoAnimation == ExpoScreen::ExpoAnimationZoom &&
+	    vp == eScreen->selectedVp)
+	    opacity = (1.0f - sigmoidProgress (eScreen->expoCam));
+	else
+	    opacity = 0.0f;
+    }
+
+    return opacity;
+}
+
 static const unsigned short EXPO_GRID_SIZE = 100;
 
 void
@@ -1539,7 +1797,14 @@ ExpoWindow::damageRect (bool            initial,
 			const CompRect  &rect)
 {
     if (eScreen->expoCam > 0.0f)
-	eScreen->cScreen->damageScreen ();
+    {
+	if (window->onAllViewports ())
+	    eScreen->vpDamage.damageAll ();
+	else
+	    eScreen->vpDamage.damage (window->outputRect (), screen->vp ());
+
+	eScreen->damageWall ();
+    }
 
     return cWindow->damageRect (initial, rect);
 }
@@ -1590,7 +1855,9 @@ ExpoScreen::ExpoScreen (CompScreen *s) :
     doubleClick            (false),
     vpNormals              (360 * 3),
     grabIndex              (0),
-    mGlowTextureProperties (&glowTextureProperties)
+    mGlowTextureProperties (&glowTextureProperties),
+    renderingViewport      (false),
+    viewportVolatile       (false)
 {
     leftKey  = XKeysymToKeycode (s->dpy (), XStringToKeysym ("Left"));
     rightKey = XKeysymToKeycode (s->dpy (), XStringToKeysym ("Right"));
@@ -29,8 +29,11 @@
 #include <composite/composite.h>
 #include <opengl/opengl.h>
 
+#include <boost/shared_ptr.hpp>
+
 #include "expo_options.h"
 #include "glow.h"
+#include "viewport-damage.h"
 
 class ExpoScreen :
     public ScreenInterface,
@@ -72,6 +75,8 @@ class ExpoScreen :
 	bool nextVp (CompAction *, CompAction::State, CompOption::Vector&);
 	bool prevVp (CompAction *, CompAction::State, CompOption::Vector&);
 
+	void damageWall ();
+
 	typedef enum
 	{
 	    DnDNone,
@@ -130,6 +135,16 @@ class ExpoScreen :
 
 	const GlowTextureProperties *mGlowTextureProperties;
 
+	/* Pictures of the viewports, per output, used once the wall
+	 * is fully zoomed out */
+	std::vector<boost::shared_ptr<GLFramebufferObject> > vpCache;
+	compiz::expo::ViewportDamage                         vpDamage;
+
+	/* Set while a picture of a viewport is taken, and whether
+	 * other plugins changed how a window on it was painted */
+	bool                                                 renderingViewport;
+	bool                                                 viewportVolatile;
+
     private:
 
 	void moveFocusViewport (int, int);
@@ -148,6 +163,19 @@ class ExpoScreen :
 			unsigned int               ,
 			bool                        );
 
+	bool viewportCacheUsable ();
+	compiz::expo::ViewportDamage::Signature
+	viewportSignature (const CompPoint &);
+
+	bool paintCachedViewport (const GLScreenPaintAttrib &,
+				  const GLMatrix            &,
+				  CompOutput                *,
+				  unsigned int                );
+
+	bool renderViewport (GLFramebufferObject *,
+			     CompOutput          *,
+			     unsigned int          );
+
 	KeyCode leftKey;
 	KeyCode rightKey;
 	KeyCode upKey;
@@ -201,6 +229,8 @@ class ExpoWindow :
 	void
 	resizeNotify (int, int, int, int);
 
+	float wallOpacity (const CompPoint &vp);
+
 	CompWindow      *window;
 	CompositeWindow *cWindow;
 	GLWindow        *gWindow;
@@ -0,0 +1,113 @@
+/*
+ * Compiz, expo plugin, per viewport damage tracking
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_EXPO_VIEWPORT_DAMAGE_H
+#define _COMPIZ_EXPO_VIEWPORT_DAMAGE_H
+
+#include <vector>
+#include <cstddef>
+
+#include <core/point.h>
+#include <core/rect.h>
+#include <core/size.h>
+
+namespace compiz
+{
+    namespace expo
+    {
+	/**
+	 * Keeps track of which viewports have changed since they were
+	 * last rendered, separately for every output.
+	 *
+	 * Changes are either reported as damage, or noticed because
+	 * the signature of a viewport (everything on it which can
+	 * change without damage, like window geometry and stacking) is
+	 * different from the last time.
+	 */
+	class ViewportDamage
+	{
+	    public:
+
+		/**
+		 * What a viewport was rendered from, compared as a whole
+		 */
+		typedef std::vector <double> Signature;
+
+		ViewportDamage ();
+
+		/**
+		 * Starts over with everything damaged
+		 */
+		void reset (const CompSize &vpSize,
+			    const CompSize &screenSize,
+			    unsigned int   nOutputs);
+
+		/**
+		 * Damages every viewport rect touches. rect is relative
+		 * to currentVp, like window geometry.
+		 */
+		void damage (const CompRect  &rect,
+			     const CompPoint &currentVp);
+
+		void damageAll ();
+
+		/**
+		 * Damages only vp of output
+		 */
+		void damageViewport (unsigned int    output,
+				     const CompPoint &vp);
+
+		/**
+		 * Whether vp has to be rendered again for output
+		 */
+		bool needsUpdate (unsigned int    output,
+				  const CompPoint &vp,
+				  const Signature &signature) const;
+
+		/**
+		 * Records that vp was rendered for output
+		 */
+		void updated (unsigned int    output,
+			      const CompPoint &vp,
+			      const Signature &signature);
+
+		/**
+		 * The viewport rectangle of vp, relative to currentVp
+		 */
+		CompRect viewportRect (const CompPoint &vp,
+				       const CompPoint &currentVp) const;
+
+	    private:
+
+		unsigned int index (unsigned int    output,
+				    const CompPoint &vp) const;
+
+		CompSize                  mVpSize;
+		CompSize                  mScreenSize;
+		unsigned int              mNOutputs;
+
+		std::vector <bool>        mDamaged;
+		std::vector <Signature>   mSignatures;
+	};
+    }
+}
+
+#endif
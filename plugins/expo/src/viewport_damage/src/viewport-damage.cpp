@@ -0,0 +1,146 @@
+/*
+ * Compiz, expo plugin, per viewport damage tracking
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "viewport-damage.h"
+
+namespace ce = compiz::expo;
+
+namespace
+{
+    /* Division rounding towards negative infinity */
+    int floorDiv (int a, int b)
+    {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+}
+
+ce::ViewportDamage::ViewportDamage () :
+    mNOutputs (0)
+{
+}
+
+void
+ce::ViewportDamage::reset (const CompSize &vpSize,
+			   const CompSize &screenSize,
+			   unsigned int   nOutputs)
+{
+    unsigned int n = vpSize.width () * vpSize.height () * nOutputs;
+
+    mVpSize     = vpSize;
+    mScreenSize = screenSize;
+    mNOutputs   = nOutputs;
+
+    mDamaged.assign (n, true);
+    mSignatures.assign (n, Signature ());
+}
+
+void
+ce::ViewportDamage::damage (const CompRect  &rect,
+			    const CompPoint &currentVp)
+{
+    if (rect.isEmpty () ||
+	mScreenSize.width () <= 0 || mScreenSize.height () <= 0)
+	return;
+
+    int x1 = floorDiv (rect.x1 (), mScreenSize.width ()) + currentVp.x ();
+    int y1 = floorDiv (rect.y1 (), mScreenSize.height ()) + currentVp.y ();
+    int x2 = floorDiv (rect.x2 () - 1, mScreenSize.width ()) + currentVp.x ();
+    int y2 = floorDiv (rect.y2 () - 1, mScreenSize.height ()) + currentVp.y ();
+
+    x1 = std::max (x1, 0);
+    y1 = std::max (y1, 0);
+    x2 = std::min (x2, mVpSize.width () - 1);
+    y2 = std::min (y2, mVpSize.height () - 1);
+
+    for (unsigned int o = 0; o < mNOutputs; ++o)
+	for (int y = y1; y <= y2; ++y)
+	    for (int x = x1; x <= x2; ++x)
+		mDamaged[index (o, CompPoint (x, y))] = true;
+}
+
+void
+ce::ViewportDamage::damageAll ()
+{
+    std::fill (mDamaged.begin (), mDamaged.end (), true);
+}
+
+void
+ce::ViewportDamage::damageViewport (unsigned int    output,
+				    const CompPoint &vp)
+{
+    if (output >= mNOutputs ||
+	vp.x () < 0 || vp.x () >= mVpSize.width () ||
+	vp.y () < 0 || vp.y () >= mVpSize.height ())
+	return;
+
+    mDamaged[index (output, vp)] = true;
+}
+
+bool
+ce::ViewportDamage::needsUpdate (unsigned int    output,
+				 const CompPoint &vp,
+				 const Signature &signature) const
+{
+    if (output >= mNOutputs ||
+	vp.x () < 0 || vp.x () >= mVpSize.width () ||
+	vp.y () < 0 || vp.y () >= mVpSize.height ())
+	return true;
+
+    unsigned int i = index (output, vp);
+
+    return mDamaged[i] || mSignatures[i] != signature;
+}
+
+void
+ce::ViewportDamage::updated (unsigned int    output,
+			     const CompPoint &vp,
+			     const Signature &signature)
+{
+    if (output >= mNOutputs ||
+	vp.x () < 0 || vp.x () >= mVpSize.width () ||
+	vp.y () < 0 || vp.y () >= mVpSize.height ())
+	return;
+
+    unsigned int i = index (output, vp);
+
+    mDamaged[i]    = false;
+    mSignatures[i] = signature;
+}
+
+CompRect
+ce::ViewportDamage::viewportRect (const CompPoint &vp,
+				  const CompPoint &currentVp) const
+{
+    return CompRect ((vp.x () - currentVp.x ()) * mScreenSize.width (),
+		     (vp.y () - currentVp.y ()) * mScreenSize.height (),
+		     mScreenSize.width (),
+		     mScreenSize.height ());
+}
+
+unsigned int
+ce::ViewportDamage::index (unsigned int    output,
+			   const CompPoint &vp) const
+{
+    return (output * mVpSize.height () + vp.y ()) * mVpSize.width () + vp.x ();
+}
@@ -0,0 +1,178 @@
+/*
+ * Compiz, expo plugin, per viewport damage tracking tests
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "viewport-damage.h"
+
+namespace ce = compiz::expo;
+
+namespace
+{
+    ce::ViewportDamage::Signature signature (double value)
+    {
+	return ce::ViewportDamage::Signature (1, value);
+    }
+}
+
+class ExpoViewportDamageTest :
+    public ::testing::Test
+{
+    public:
+
+	ExpoViewportDamageTest ()
+	{
+	    damage.reset (CompSize (3, 2), CompSize (1000, 800), 2);
+
+	    for (unsigned int o = 0; o < 2; ++o)
+		for (int y = 0; y < 2; ++y)
+		    for (int x = 0; x < 3; ++x)
+			damage.updated (o, CompPoint (x, y), signature (1));
+	}
+
+	unsigned int countDamaged (unsigned int output) const
+	{
+	    unsigned int n = 0;
+
+	    for (int y = 0; y < 2; ++y)
+		for (int x = 0; x < 3; ++x)
+		    if (damage.needsUpdate (output, CompPoint (x, y), signature (1)))
+			++n;
+
+	    return n;
+	}
+
+	ce::ViewportDamage damage;
+};
+
+TEST (ExpoViewportDamage, EverythingDamagedAfterReset)
+{
+    ce::ViewportDamage damage;
+
+    damage.reset (CompSize (2, 2), CompSize (1000, 800), 1);
+
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (0, 0), signature (0)));
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (1, 1), signature (0)));
+}
+
+TEST_F (ExpoViewportDamageTest, UpdatedViewportsAreClean)
+{
+    EXPECT_EQ (0, countDamaged (0));
+    EXPECT_EQ (0, countDamaged (1));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageOnCurrentViewport)
+{
+    damage.damage (CompRect (10, 10, 100, 100), CompPoint (1, 0));
+
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (1, 0), signature (1)));
+    EXPECT_TRUE (damage.needsUpdate (1, CompPoint (1, 0), signature (1)));
+    EXPECT_EQ (1, countDamaged (0));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageOnOtherViewport)
+{
+    /* left of the current viewport is viewport 0 */
+    damage.damage (CompRect (-500, 900, 100, 100), CompPoint (1, 0));
+
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (0, 1), signature (1)));
+    EXPECT_EQ (1, countDamaged (0));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageAcrossViewports)
+{
+    damage.damage (CompRect (900, 700, 200, 200), CompPoint (0, 0));
+
+    EXPECT_EQ (4, countDamaged (0));
+    EXPECT_FALSE (damage.needsUpdate (0, CompPoint (2, 0), signature (1)));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageEndingOnBoundary)
+{
+    damage.damage (CompRect (0, 0, 1000, 800), CompPoint (0, 0));
+
+    EXPECT_EQ (1, countDamaged (0));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageOutsideTheWallIsIgnored)
+{
+    damage.damage (CompRect (-3000, -3000, 100, 100), CompPoint (0, 0));
+    damage.damage (CompRect (5000, 100, 100, 100), CompPoint (0, 0));
+    damage.damage (CompRect (), CompPoint (0, 0));
+
+    EXPECT_EQ (0, countDamaged (0));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageAll)
+{
+    damage.damageAll ();
+
+    EXPECT_EQ (6, countDamaged (0));
+    EXPECT_EQ (6, countDamaged (1));
+}
+
+TEST_F (ExpoViewportDamageTest, DamageOneViewport)
+{
+    damage.damageViewport (1, CompPoint (2, 1));
+    damage.damageViewport (2, CompPoint (0, 0));
+    damage.damageViewport (0, CompPoint (3, 0));
+
+    EXPECT_EQ (0, countDamaged (0));
+    EXPECT_EQ (1, countDamaged (1));
+    EXPECT_TRUE (damage.needsUpdate (1, CompPoint (2, 1), signature (1)));
+}
+
+TEST_F (ExpoViewportDamageTest, SignatureChange)
+{
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (2, 1), signature (2)));
+
+    damage.updated (0, CompPoint (2, 1), signature (2));
+
+    EXPECT_FALSE (damage.needsUpdate (0, CompPoint (2, 1), signature (2)));
+    EXPECT_TRUE (damage.needsUpdate (1, CompPoint (2, 1), signature (2)));
+}
+
+TEST_F (ExpoViewportDamageTest, SignaturesAreComparedInFull)
+{
+    ce::ViewportDamage::Signature s;
+
+    s.push_back (1);
+    s.push_back (2);
+    damage.updated (0, CompPoint (2, 1), s);
+
+    EXPECT_FALSE (damage.needsUpdate (0, CompPoint (2, 1), s));
+
+    std::swap (s[0], s[1]);
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (2, 1), s));
+
+    std::swap (s[0], s[1]);
+    s.push_back (0);
+    EXPECT_TRUE (damage.needsUpdate (0, CompPoint (2, 1), s));
+}
+
+TEST_F (ExpoViewportDamageTest, ViewportRect)
+{
+    EXPECT_EQ (CompRect (-1000, 800, 1000, 800),
+	       damage.viewportRect (CompPoint (0, 1), CompPoint (1, 0)));
+}
@@ -76,6 +76,9 @@
 
 COMPIZ_PLUGIN_20090315 (ezoom, ZoomPluginVTable)
 
+/* How many distinct cursor images to keep uploaded */
+#define MAX_CACHED_CURSORS 16
+
 
 /*
  * This toggles paint functions. We don't need to continually run code when we
@@ -394,20 +397,21 @@ EZoomScreen::donePaint ()
 {
     if (grabbed)
     {
+	CompRegion damage;
+
+	/* Only the zoomed outputs that are still moving change */
 	for (unsigned int out = 0; out < zooms.size (); ++out)
-	{
 	    if (isInMovement (out) && isActive (out))
-	    {
-		cScreen->damageScreen ();
-		break;
-	    }
-	}
+		damage += screen->outputDevs ().at (out);
+
+	if (!damage.isEmpty ())
+	    cScreen->damageRegion (damage);
     }
-    else if (grabIndex)
-	cScreen->damageScreen ();
-    else
+    else if (!grabIndex)
 	toggleFunctions (false);
 
+    cursorDamage = cursorRegion ();
+
     cScreen->donePaint ();
 }
 
@@ -1129,6 +1133,8 @@ EZoomScreen::cursorMoved ()
 void
 EZoomScreen::updateMousePosition (const CompPoint &p)
 {
+    std::vector <ZoomArea> previous (zooms);
+
     mouse.setX (p.x ());
     mouse.setY (p.y ());
 
@@ -1140,7 +1146,87 @@ EZoomScreen::updateMousePosition (const CompPoint &p)
 	setCenter (mouse.x (), mouse.y (), true);
 
     cursorMoved ();
-    cScreen->damageScreen ();
+    damageCursorMovement (previous);
+}
+
+/* The cursor moved. Outputs that panned or zoomed as a result need a full
+ * repaint, otherwise only the old and new faux-cursor rectangles do. */
+void
+EZoomScreen::damageCursorMovement (const std::vector <ZoomArea> &previous)
+{
+    CompRegion damage (cursorDamage);
+
+    for (unsigned int out = 0; out < zooms.size (); ++out)
+    {
+	if (out >= previous.size ()				||
+	    previous[out].xtrans      != zooms[out].xtrans	||
+	    previous[out].ytrans      != zooms[out].ytrans	||
+	    previous[out].currentZoom != zooms[out].currentZoom)
+	    damage += screen->outputDevs ().at (out);
+    }
+
+    damage += cursorRegion ();
+
+    cScreen->damageRegion (damage);
+}
+
+/* Where the faux-cursor is painted on the zoomed outputs, padded a little
+ * for texture filtering. */
+CompRegion
+EZoomScreen::cursorRegion ()
+{
+    CompRegion region;
+
+    if (!cursor.isSet)
+	return region;
+
+    for (unsigned int out = 0; out < zooms.size (); ++out)
+    {
+	if (!isActive (out))
+	    continue;
+
+	int   ax, ay;
+	float scaleFactor;
+
+	convertToZoomed (out, mouse.x (), mouse.y (), &ax, &ay);
+
+	if (optionGetScaleMouseDynamic ())
+	    scaleFactor = 1.0f / zooms.at (out).currentZoom;
+	else
+	    scaleFactor = 1.0f / optionGetScaleMouseStatic ();
+
+	int x1 = ax - ceilf (cursor.hotX * scaleFactor) - 1;
+	int y1 = ay - ceilf (cursor.hotY * scaleFactor) - 1;
+	int x2 = ax + ceilf ((cursor.width - cursor.hotX) * scaleFactor) + 1;
+	int y2 = ay + ceilf ((cursor.height - cursor.hotY) * scaleFactor) + 1;
+
+	region += CompRegion (x1, y1, x2 - x1, y2 - y1) &
+		  screen->outputDevs ().at (out);
+    }
+
+    return region;
+}
+
+/* Where the zoom box is drawn on each output */
+CompRegion
+EZoomScreen::zoomBoxRegion ()
+{
+    CompRegion region;
+
+    for (unsigned int out = 0; out < zooms.size (); ++out)
+    {
+	int x1, y1, x2, y2;
+
+	convertToZoomed (out, box.x1 (), box.y1 (), &x1, &y1);
+	convertToZoomed (out, box.x2 (), box.y2 (), &x2, &y2);
+
+	CompRect rect (MIN (x1, x2) - 2, MIN (y1, y2) - 2,
+		       abs (x2 - x1) + 4, abs (y2 - y1) + 4);
+
+	region += CompRegion (rect) & screen->outputDevs ().at (out);
+    }
+
+    return region;
 }
 
 /* Timeout handler to poll the mouse. Returns false (and thereby does not
@@ -1159,7 +1245,7 @@ EZoomScreen::updateMouseInterval (const CompPoint &p)
     }
 }
 
-/* Free a cursor */
+/* Stop using a cursor. The texture itself belongs to cursorCache. */
 void
 EZoomScreen::freeCursor (CursorTexture *cursor)
 {
@@ -1167,10 +1253,41 @@ EZoomScreen::freeCursor (CursorTexture *cursor)
 	return;
 
     cursor->isSet = false;
-    glDeleteTextures (1, &cursor->texture);
     cursor->texture = 0;
 }
 
+/* Free all the cached cursor textures */
+void
+EZoomScreen::freeCursorCache ()
+{
+    foreach (CursorTexture &cached, cursorCache)
+	glDeleteTextures (1, &cached.texture);
+
+    cursorCache.clear ();
+    freeCursor (&cursor);
+}
+
+/* Switch to an already uploaded image of the cursor with the given
+ * serial, if there is one. */
+bool
+EZoomScreen::useCachedCursor (unsigned long serial)
+{
+    for (std::list <CursorTexture>::iterator it = cursorCache.begin ();
+	 it != cursorCache.end (); ++it)
+    {
+	if (it->serial != serial)
+	    continue;
+
+	cursorCache.splice (cursorCache.begin (), cursorCache, it);
+	cursor = cursorCache.front ();
+	cursor.isSet = true;
+
+	return true;
+    }
+
+    return false;
+}
+
 /* Translate into place and draw the scaled cursor.  */
 void
 EZoomScreen::drawCursor (CompOutput    *output,
@@ -1259,40 +1376,35 @@ EZoomScreen::drawCursor (CompOutput    *output,
     }
 }
 
-/* Create (if necessary) a texture to store the cursor,
- * fetch the cursor with XFixes. Store it. */
+/* Fetch the cursor with XFixes and upload it to a texture, unless
+ * an image with the same serial is already cached. */
 void
 EZoomScreen::updateCursor (CursorTexture * cursor)
 {
-    int     i;
-    Display *dpy = screen->dpy ();
-
-    if (!cursor->isSet)
-    {
-	cursor->isSet = true;
-	cursor->screen = screen;
-
-	glGenTextures (1, &cursor->texture);
-	glBindTexture (GL_TEXTURE_2D, cursor->texture);
-
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
-			 gScreen->textureFilter ());
-	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-			 gScreen->textureFilter ());
-    }
+    int           i;
+    Display       *dpy = screen->dpy ();
+    CursorTexture entry;
 
     XFixesCursorImage *ci = XFixesGetCursorImage (dpy);
     unsigned char     *pixels;
     unsigned long     pix;
 
+    if (ci && useCachedCursor (ci->cursor_serial))
+    {
+	XFree (ci);
+	*cursor = this->cursor;
+	return;
+    }
+
+    entry.screen = screen;
+
     if (ci)
     {
-	cursor->width  = ci->width;
-	cursor->height = ci->height;
-	cursor->hotX = ci->xhot;
-	cursor->hotY = ci->yhot;
+	entry.width  = ci->width;
+	entry.height = ci->height;
+	entry.hotX   = ci->xhot;
+	entry.hotY   = ci->yhot;
+	entry.serial = ci->cursor_serial;
 	pixels = (unsigned char *) malloc (ci->width * ci->height * 4);
 
 	if (!pixels)
@@ -1317,16 +1429,16 @@ EZoomScreen::updateCursor (CursorTexture * cursor)
 	/* Fallback R: 255 G: 255 B: 255 A: 255
 	 * FIXME: Draw a cairo mouse cursor */
 
-	cursor->width  = 1;
-	cursor->height = 1;
-	cursor->hotX   = 0;
-	cursor->hotY   = 0;
-	pixels = (unsigned char *) malloc (cursor->width * cursor->height * 4);
+	entry.width  = 1;
+	entry.height = 1;
+	entry.hotX   = 0;
+	entry.hotY   = 0;
+	pixels = (unsigned char *) malloc (entry.width * entry.height * 4);
 
 	if (!pixels)
 	    return;
 
-	for (i = 0; i < cursor->width * cursor->height; ++i)
+	for (i = 0; i < entry.width * entry.height; ++i)
 	{
 	    pix                 = 0x00ffffff;
 	    pixels[i * 4]       = pix & 0xff;
@@ -1338,12 +1450,34 @@ EZoomScreen::updateCursor (CursorTexture * cursor)
 	compLogMessage ("ezoom", CompLogLevelWarn, "unable to get system cursor image!");
     }
 
-    glBindTexture (GL_TEXTURE_2D, cursor->texture);
-    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, cursor->width,
-		  cursor->height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
+    glGenTextures (1, &entry.texture);
+    glBindTexture (GL_TEXTURE_2D, entry.texture);
+
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+		     gScreen->textureFilter ());
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+		     gScreen->textureFilter ());
+
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, entry.width,
+		  entry.height, 0, GL_BGRA, GL_UNSIGNED_BYTE, pixels);
     glBindTexture (GL_TEXTURE_2D, 0);
 
     free (pixels);
+
+    /* Themes only have a handful of cursors, so a small cache covers
+     * everything an application switches between */
+    cursorCache.push_front (entry);
+
+    while (cursorCache.size () > MAX_CACHED_CURSORS)
+    {
+	glDeleteTextures (1, &cursorCache.back ().texture);
+	cursorCache.pop_back ();
+    }
+
+    *cursor = entry;
+    cursor->isSet = true;
 }
 
 /* We are no longer zooming the cursor, so display it.  */
@@ -1949,6 +2083,8 @@ EZoomScreen::handleEvent (XEvent *event)
 	case MotionNotify:
 	    if (grabIndex)
 	    {
+		CompRegion damage (zoomBoxRegion ());
+
 		if (pointerX < clickPos.x ())
 		{
 		    box.setX (pointerX);
@@ -1965,7 +2101,7 @@ EZoomScreen::handleEvent (XEvent *event)
 		else
 		    box.setHeight (pointerY - clickPos.y ());
 
-		cScreen->damageScreen ();
+		cScreen->damageRegion (damage + zoomBoxRegion ());
 	    }
 
 	    break;
@@ -1978,10 +2114,16 @@ EZoomScreen::handleEvent (XEvent *event)
 	default:
 	    if (event->type == fixesEventBase + XFixesCursorNotify)
 	    {
-		//XFixesCursorNotifyEvent *cev = (XFixesCursorNotifyEvent *)
-		//event;
+		XFixesCursorNotifyEvent *cev = (XFixesCursorNotifyEvent *)
+		event;
+
 		if (cursor.isSet)
-		    updateCursor (&cursor);
+		{
+		    if (!useCachedCursor (cev->cursor_serial))
+			updateCursor (&cursor);
+
+		    cScreen->damageRegion (cursorDamage + cursorRegion ());
+		}
 	    }
 
 	    break;
@@ -1998,7 +2140,8 @@ EZoomScreen::CursorTexture::CursorTexture () :
     width (0),
     height (0),
     hotX (0),
-    hotY (0)
+    hotY (0),
+    serial (0)
 {
 }
 
@@ -2144,6 +2287,7 @@ EZoomScreen::~EZoomScreen ()
 
     cScreen->damageScreen ();
     cursorZoomInactive ();
+    freeCursorCache ();
 }
 
 bool
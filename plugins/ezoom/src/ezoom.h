@@ -116,6 +116,7 @@ class EZoomScreen :
 		int        height;
 		int        hotX;
 		int        hotY;
+		unsigned long serial; // XFixes cursor serial of the image
 
 	    public:
 
@@ -173,6 +174,9 @@ class EZoomScreen :
 	CursorTexture          cursor;	// the texture for the faux-cursor
 					// we paint to do fake input
 					// handling
+	std::list <CursorTexture> cursorCache; // uploaded cursor images,
+					       // most recently used first
+	CompRegion             cursorDamage; // where the cursor was last painted
 	bool                   cursorInfoSelected;
 	bool                   cursorHidden;
 	CompRect               box;
@@ -306,6 +310,21 @@ class EZoomScreen :
 	void
 	updateCursor (CursorTexture * cursor);
 
+	bool
+	useCachedCursor (unsigned long serial);
+
+	void
+	freeCursorCache ();
+
+	CompRegion
+	cursorRegion ();
+
+	CompRegion
+	zoomBoxRegion ();
+
+	void
+	damageCursorMovement (const std::vector <ZoomArea> &previous);
+
 	void
 	cursorZoomInactive ();
 
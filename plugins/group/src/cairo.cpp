@@ -44,6 +44,10 @@ SelectionLayer::rebuild (SelectionLayer *layer,
     PaintState       stateBuf = layer->mState;
     GroupSelection   *gBuf   = layer->mGroup;
 
+    /* Nothing to rebuild, render () redraws it if needed */
+    if (layer->width () == size.width () && layer->height () == size.height ())
+	return layer;
+
     delete layer;
     layer = SelectionLayer::create (size, gBuf);
     if (!layer)
@@ -73,6 +77,9 @@ BackgroundLayer::rebuild (BackgroundLayer *layer,
     PaintState       stateBuf = layer->mState;
     GroupSelection   *gBuf = layer->mGroup;
 
+    if (layer->width () == size.width () && layer->height () == size.height ())
+	return layer;
+
     delete layer;
     layer = BackgroundLayer::create (size, gBuf);
     if (!layer)
@@ -101,6 +108,26 @@ CairoLayer::clear ()
     cairo_restore (cr);
 }
 
+/*
+ * TextureLayer::needsRender
+ *
+ * Rasterising and uploading a layer is expensive, and most of the
+ * calls to render () come from tab changes that do not change what
+ * the layer shows. Returns false if the texture was already made
+ * from the state described by key, otherwise remembers key.
+ *
+ */
+bool
+TextureLayer::needsRender (const RenderKey &key)
+{
+    /* An empty key is what invalidate () leaves */
+    if (!mTexture.empty () && !mRenderKey.empty () && key == mRenderKey)
+	return false;
+
+    mRenderKey = key;
+    return true;
+}
+
 /*
  * CairoLayer::~CairoLayer ()
  *
@@ -242,8 +269,22 @@ SelectionLayer::render ()
     if (!HAS_TOP_WIN (mGroup) || !mCairo)
 	return;
 
+    RenderKey key;
+
+    key.push_back (width ());
+    key.push_back (height ());
+
+    for (unsigned int i = 0; i < 4; ++i)
+	key.push_back (mGroup->mColor[i]);
+
+    if (!needsRender (key))
+	return;
+
     cr = mCairo;
 
+    /* The layer may be reused for a new color */
+    clear ();
+
     /* fill */
     cairo_set_line_width (cr, 2);
     cairo_set_source_rgba (cr,
@@ -294,6 +335,20 @@ BackgroundLayer::render ()
     theight = mGroup->mTabBar->mRegion.boundingRect ().height ();
     radius = gs->optionGetBorderRadius ();
 
+    /* The options this depends on invalidate () the layer */
+    RenderKey key;
+
+    key.push_back (twidth);
+    key.push_back (theight);
+    key.push_back (width ());
+    key.push_back (mBgAnimation);
+
+    if (mBgAnimation != AnimationNone)
+	key.push_back (mBgAnimationTime);
+
+    if (!needsRender (key))
+	return;
+
     /* Do not draw more than the tab bar width */
     if (twidth > width ())
 	twidth = width ();
@@ -807,6 +862,20 @@ TextLayer::render ()
     twidth = mGroup->mTabBar->mRegion.boundingRect ().width ();
     theight = mGroup->mTabBar->mRegion.boundingRect ().height ();
 
+    /* Title changes and font options rebuild () the layer */
+    RenderKey key;
+    Window    id = None;
+
+    if (mGroup->mTabBar->mTextSlot && mGroup->mTabBar->mTextSlot->mWindow)
+	id = mGroup->mTabBar->mTextSlot->mWindow->id ();
+
+    key.push_back (twidth);
+    key.push_back (theight);
+    key.push_back (id);
+
+    if (!needsRender (key))
+	return;
+
     if (mGroup->mTabBar->mTextSlot &&
         mGroup->mTabBar->mTextSlot->mWindow && gTextAvailable)
     {
@@ -866,6 +935,10 @@ TextLayer::render ()
     if (pixmap)
     {
 	mTexture.clear ();
+
+	if (mPixmap)
+	    XFreePixmap (screen->dpy (), mPixmap);
+
 	mPixmap = pixmap;
 	/* Text layer's texture is bound here, this can be re used
 	 * in TextureLayer::paint
@@ -843,8 +843,8 @@ GroupSelection::changeColor ()
 	const CompRect &bRect = mTabBar->mTopTab->mRegion.boundingRect ();
 	CompSize size (bRect.width (),
 		       bRect.height ());
-	SelectionLayer *sl = mTabBar->mSelectionLayer;
-	SelectionLayer::rebuild (sl, size);
+	mTabBar->mSelectionLayer =
+	    SelectionLayer::rebuild (mTabBar->mSelectionLayer, size);
 
 	if (mTabBar->mSelectionLayer)
 	    mTabBar->mSelectionLayer->render ();
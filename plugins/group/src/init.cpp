@@ -55,7 +55,10 @@ GroupScreen::optionChanged (CompOption *opt,
 	case GroupOptions::BorderWidth:
 	    foreach (group, mGroups)
 		if (group->mTabBar)
+		{
+		    group->mTabBar->mBgLayer->invalidate ();
 		    group->mTabBar->mBgLayer->render ();
+		}
 	    break;
 	case GroupOptions::TabbarFontSize:
 	case GroupOptions::TabbarFontColor:
@@ -84,6 +84,10 @@ class TextureLayer :
     public:
 
 	void setPaintWindow (CompWindow *);
+
+	/* Forces the next render () to draw, for changes render ()
+	 * can't see (like options) */
+	void invalidate () { mRenderKey.clear (); }
 	virtual void paint (const GLWindowPaintAttrib &attrib,
 			    const GLMatrix	      &transform,
 			    const CompRegion	      &paintRegion,
@@ -95,6 +99,15 @@ class TextureLayer :
 	CompWindow	*mPaintWindow; /* the window we are going to
 					* paint with geometry */
 
+    protected:
+
+	/* What a texture is rendered from, compared as a whole */
+	typedef std::vector <long> RenderKey;
+
+	bool needsRender (const RenderKey &key);
+
+	RenderKey       mRenderKey;
+
 };
 
 class CairoLayer :
@@ -1904,9 +1904,8 @@ GroupScreen::changeTab (GroupTabBarSlot             *topTab,
 	CompSize size (group->mTabBar->mTopTab->mRegion.boundingRect ().width (),
 		       group->mTabBar->mTopTab->mRegion.boundingRect ().height ());
 
-	/* Rebuild layers and render */
-	group->mTabBar->mTextLayer = TextLayer::rebuild (group->mTabBar->mTextLayer);
-
+	/* Rebuild layers and render, which only redraws them if what
+	 * they show changed */
 	if (group->mTabBar->mTextLayer)
 	    group->mTabBar->mTextLayer->render ();
 	group->mTabBar->mSelectionLayer =
@@ -49,25 +49,86 @@ MousepollScreen::getMousePosition ()
     return false;
 }
 
+/*
+ * Called once per poll interval at most. When raw motion events are
+ * available the timer is only started by pointer movement and runs
+ * once, so a still pointer costs nothing. Otherwise this is the old
+ * polling timer. Either way a poller only hears about a position it
+ * has not seen yet.
+ */
 bool
 MousepollScreen::updatePosition ()
 {
-    if (getMousePosition ())
+    /* pos may have been updated elsewhere already, the pollers
+     * themselves know what they have seen */
+    getMousePosition ();
+
+    for (std::list<MousePoller *>::iterator it = pollers.begin ();
+	 it != pollers.end ();)
     {
-	for (std::list<MousePoller *>::iterator it = pollers.begin ();
-	     it != pollers.end ();)
-	{
-	    MousePoller *poller = *it;
-
-	    ++it;
-	    poller->mPoint = pos;
-	    poller->mCallback (pos);
-	}
+	MousePoller *poller = *it;
+
+	++it;
+
+	if (poller->mPoint == pos)
+	    continue;
+
+	poller->mPoint = pos;
+	poller->mCallback (pos);
     }
 
+    return xiOpcode == -1;
+}
+
+void
+MousepollScreen::handleEvent (XEvent *event)
+{
+    /* The event data is not needed, only the fact that the pointer
+     * moved, so there is no need to fetch the cookie */
+    if (event->type == GenericEvent &&
+	event->xcookie.extension == xiOpcode &&
+	event->xcookie.evtype == XI_RawMotion &&
+	!timer.active ())
+	timer.start ();
+
+    screen->handleEvent (event);
+}
+
+bool
+MousepollScreen::initRawMotion ()
+{
+    int event, error;
+    int major = 2, minor = 2;
+
+    if (!XQueryExtension (screen->dpy (), "XInputExtension",
+			  &xiOpcode, &event, &error))
+	return false;
+
+    /* Raw events are only delivered during grabs since 2.1 */
+    if (XIQueryVersion (screen->dpy (), &major, &minor) != Success ||
+	(major == 2 && minor < 1))
+	return false;
+
     return true;
 }
 
+void
+MousepollScreen::selectRawMotion (bool enable)
+{
+    unsigned char  mask[XIMaskLen (XI_LASTEVENT)] = { 0 };
+    XIEventMask    eventMask;
+
+    if (enable)
+	XISetMask (mask, XI_RawMotion);
+
+    eventMask.deviceid = XIAllMasterDevices;
+    eventMask.mask_len = sizeof (mask);
+    eventMask.mask     = mask;
+
+    XISelectEvents (screen->dpy (), screen->root (), &eventMask, 1);
+    screen->handleEventSetEnabled (this, enable);
+}
+
 bool
 MousepollScreen::addTimer (MousePoller *poller)
 {
@@ -83,10 +144,19 @@ MousepollScreen::addTimer (MousePoller *poller)
 
     if (start)
     {
-	getMousePosition ();
-	timer.start ();
+	if (xiOpcode != -1)
+	    selectRawMotion (true);
+	else
+	    timer.start ();
     }
 
+    /* A still pointer sends no motion events, so hand the new poller
+     * where it is now instead of waiting for it to move */
+    getMousePosition ();
+
+    poller->mPoint = pos;
+    poller->mCallback (pos);
+
     return true;
 }
 
@@ -102,7 +172,12 @@ MousepollScreen::removeTimer (MousePoller *poller)
     pollers.erase (it);
 
     if (pollers.empty ())
+    {
 	timer.stop ();
+
+	if (xiOpcode != -1)
+	    selectRawMotion (false);
+    }
 }
 
 void
@@ -139,9 +214,11 @@ MousePoller::start ()
 	return;
     }
 
-    ms->addTimer (this);
-
+    /* Active before it is added, the first position is handed out
+     * right away and the callback may stop the poller again */
     mActive = true;
+
+    ms->addTimer (this);
 }
 
 void
@@ -222,14 +299,31 @@ MousepollScreen::updateTimer ()
 template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>;
 
 MousepollScreen::MousepollScreen (CompScreen *screen) :
-    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen)
+    PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI> (screen),
+    xiOpcode (-1)
 {
+    ScreenInterface::setHandler (screen, false);
+
+    if (!initRawMotion ())
+    {
+	xiOpcode = -1;
+	compLogMessage ("mousepoll", CompLogLevelInfo,
+			"XInput 2.1 not available, polling the pointer "
+			"position instead.");
+    }
+
     updateTimer ();
     timer.setCallback (boost::bind (&MousepollScreen::updatePosition, this));
 
     optionSetMousePollIntervalNotify (boost::bind (&MousepollScreen::updateTimer, this));
 }
 
+MousepollScreen::~MousepollScreen ()
+{
+    if (xiOpcode != -1 && !pollers.empty ())
+	selectRawMotion (false);
+}
+
 bool
 MousepollPluginVTable::init ()
 {
@@ -24,6 +24,8 @@
 #include <core/pluginclasshandler.h>
 #include <core/timer.h>
 
+#include <X11/extensions/XInput2.h>
+
 #include <mousepoll/mousepoll.h>
 
 #include "mousepoll_options.h"
@@ -39,17 +41,32 @@ extern template class PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MO
 
 class MousepollScreen :
     public PluginClassHandler <MousepollScreen, CompScreen, COMPIZ_MOUSEPOLL_ABI>,
+    public ScreenInterface,
     public MousepollOptions
 {
     public:
 
 	MousepollScreen (CompScreen *screen);
+	~MousepollScreen ();
 
 	std::list<MousePoller *> pollers;
 	CompTimer                timer;
 
 	CompPoint                pos;
 
+	/* XInput2 opcode, or -1 if raw motion events are not
+	 * available and we have to poll on the timer */
+	int                      xiOpcode;
+
+	void
+	handleEvent (XEvent *event);
+
+	bool
+	initRawMotion ();
+
+	void
+	selectRawMotion (bool enable);
+
 	bool
 	updatePosition ();
 
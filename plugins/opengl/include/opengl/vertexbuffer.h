@@ -89,6 +89,7 @@ class GLVertexBuffer
 	void addTexCoords (GLuint texture,
 	                   GLuint nTexcoords,
 	                   const GLfloat *texcoords);
+	GLfloat *getTexCoords (GLuint texture) const;
 	GLuint countTextures () const;
 
 	void addUniform (const char *name, GLfloat value);
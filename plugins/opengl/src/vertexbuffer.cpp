@@ -240,6 +240,14 @@ void GLVertexBuffer::addTexCoords (GLuint texture,
 	data.push_back (texcoords[i]);
 }
 
+GLfloat *GLVertexBuffer::getTexCoords (GLuint texture) const
+{
+    if (texture >= priv->nTextures || priv->textureData[texture].empty ())
+	return NULL;
+
+    return &priv->textureData[texture][0];
+}
+
 GLuint GLVertexBuffer::countTextures () const
 {
     return priv->nTextures;
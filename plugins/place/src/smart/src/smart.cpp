@@ -1,4 +1,5 @@
 #include "smart.h"
+#include <algorithm>
 #include <boost/foreach.hpp>
 
 #ifndef foreach
@@ -25,6 +26,140 @@ namespace compiz
 	{
 	}
 
+	namespace
+	{
+	    /* The frame rectangle of another window and how much
+	     * covering it counts for */
+	    struct Obstacle
+	    {
+		int xl, yt, xr, yb;
+		int weight;
+	    };
+
+	    bool byLeft (const Obstacle &a, const Obstacle &b)
+	    {
+		return a.xl < b.xl;
+	    }
+
+	    /* Smallest value in a sorted vector that is greater than
+	     * value, or fallback */
+	    int nextAbove (const std::vector <int> &sorted,
+			   int                     value,
+			   int                     fallback)
+	    {
+		std::vector <int>::const_iterator it =
+		    std::upper_bound (sorted.begin (), sorted.end (), value);
+
+		return it != sorted.end () ? std::min (*it, fallback) : fallback;
+	    }
+
+	    /*
+	     * All the obstacles overlapping one horizontal band of the
+	     * work area, that is one value of yTmp. Candidate positions
+	     * along a band are visited from left to right, so the
+	     * obstacles overlapping the candidate are kept in a sweep
+	     * set and the next x step is a binary search.
+	     */
+	    class Band
+	    {
+		public:
+
+		    Band (const std::vector <Obstacle> &obstacles,
+			  int                          y,
+			  int                          cw,
+			  int                          ch);
+
+		    int overlap (int x);
+		    int nextX (int x, int possible) const;
+
+		private:
+
+		    std::vector <Obstacle> mByLeft;
+		    std::vector <int>      mRights;
+		    std::vector <int>      mLefts;
+
+		    std::vector <Obstacle> mActive;
+		    unsigned int           mNext;
+		    int                    mLastX;
+		    int                    mCw;
+	    };
+
+	    Band::Band (const std::vector <Obstacle> &obstacles,
+			int                          y,
+			int                          cw,
+			int                          ch) :
+		mNext (0),
+		mLastX (0),
+		mCw (cw)
+	    {
+		foreach (Obstacle o, obstacles)
+		{
+		    if (y < o.yb && y + ch > o.yt)
+		    {
+			/* only the part inside the band counts */
+			o.yt = MAX (y, o.yt);
+			o.yb = MIN (y + ch, o.yb);
+
+			mByLeft.push_back (o);
+			mRights.push_back (o.xr);
+			mLefts.push_back (o.xl - cw);
+		    }
+		}
+
+		std::sort (mByLeft.begin (), mByLeft.end (), byLeft);
+		std::sort (mRights.begin (), mRights.end ());
+		std::sort (mLefts.begin (), mLefts.end ());
+	    }
+
+	    int
+	    Band::overlap (int x)
+	    {
+		int cxl = x;
+		int cxr = x + mCw;
+
+		/* The sweep only moves right, start over otherwise */
+		if (x < mLastX)
+		{
+		    mActive.clear ();
+		    mNext = 0;
+		}
+
+		mLastX = x;
+
+		while (mNext < mByLeft.size () && mByLeft[mNext].xl < cxr)
+		    mActive.push_back (mByLeft[mNext++]);
+
+		int overlap = 0;
+
+		for (unsigned int i = 0; i < mActive.size ();)
+		{
+		    const Obstacle &o = mActive[i];
+
+		    if (o.xr <= cxl)
+		    {
+			mActive[i] = mActive.back ();
+			mActive.pop_back ();
+			continue;
+		    }
+
+		    int xl = MAX (cxl, o.xl);
+		    int xr = MIN (cxr, o.xr);
+
+		    overlap += o.weight * (xr - xl) * (o.yb - o.yt);
+		    ++i;
+		}
+
+		return overlap;
+	    }
+
+	    int
+	    Band::nextX (int x, int possible) const
+	    {
+		possible = nextAbove (mRights, x, possible);
+		return nextAbove (mLefts, x, possible);
+	    }
+	}
+
 	void smart (Placeable                      *placeable,
 		    CompPoint			   &pos,
 		    const compiz::place::Placeable::Vector &placeables)
@@ -37,17 +172,23 @@ namespace compiz
 	     * Xinerama supported added by Balaji Ramani (balaji@yablibli.com)
 	     * with ideas from xfce.
 	     * adapted for Compiz by Bellegarde Cedric (gnumdk(at)gmail.com)
+	     *
+	     * The candidate positions and their order are the same as
+	     * in the original algorithm, but instead of going through
+	     * every window for every candidate the windows are sorted
+	     * once and each band of candidates only looks at the windows
+	     * it crosses.
 	     */
 	    int overlap = 0, minOverlap = 0;
 
-	    /* temp holder */
-	    int basket = 0;
 	    /* CT lame flag. Don't like it. What else would do? */
 	    bool firstPass = true;
 
+	    const CompRect &workArea = placeable->workArea ();
+
 	    /* get the maximum allowed windows space */
-	    int xTmp = placeable->workArea ().x ();
-	    int yTmp = placeable->workArea ().y ();
+	    int xTmp = workArea.x ();
+	    int yTmp = workArea.y ();
 
 	    /* client gabarit */
 	    int cw = placeable->geometry ().width () - 1;
@@ -56,50 +197,59 @@ namespace compiz
 	    int xOptimal = xTmp;
 	    int yOptimal = yTmp;
 
+	    std::vector <Obstacle> obstacles;
+	    std::vector <int>      bottoms;
+	    std::vector <int>      tops;
+
+	    obstacles.reserve (placeables.size ());
+	    bottoms.reserve (placeables.size ());
+	    tops.reserve (placeables.size ());
+
+	    foreach (Placeable *p, placeables)
+	    {
+		const compiz::window::Geometry &otherGeometry = p->geometry ();
+		const compiz::window::extents::Extents &otherExtents = p->extents ();
+		Obstacle o;
+
+		o.xl = otherGeometry.x () - otherExtents.left;
+		o.yt = otherGeometry.y () - otherExtents.top;
+		o.xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
+		o.yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+		if (p->state () & compiz::place::WindowAbove)
+		    o.weight = 16;
+		else if (p->state () & compiz::place::WindowBelow)
+		    o.weight = 0;
+		else
+		    o.weight = 1;
+
+		obstacles.push_back (o);
+		bottoms.push_back (o.yb);
+		tops.push_back (o.yt - ch);
+	    }
+
+	    std::sort (bottoms.begin (), bottoms.end ());
+	    std::sort (tops.begin (), tops.end ());
+
+	    Band band (obstacles, yTmp, cw, ch);
+	    int  bandY = yTmp;
+
 	    /* loop over possible positions */
 	    do
 	    {
+		if (bandY != yTmp)
+		{
+		    band  = Band (obstacles, yTmp, cw, ch);
+		    bandY = yTmp;
+		}
+
 		/* test if enough room in x and y directions */
-		if (yTmp + ch > placeable->workArea ().bottom () && ch < placeable->workArea ().height ())
+		if (yTmp + ch > workArea.bottom () && ch < workArea.height ())
 		    overlap = H_WRONG; /* this throws the algorithm to an exit */
-		else if (xTmp + cw > placeable->workArea ().right ())
+		else if (xTmp + cw > workArea.right ())
 		    overlap = W_WRONG;
 		else
-		{
-		    overlap = NONE; /* initialize */
-
-		    int cxl = xTmp;
-		    int cxr = xTmp + cw;
-		    int cyt = yTmp;
-		    int cyb = yTmp + ch;
-
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if windows overlap, calc the overall overlapping */
-			if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
-			{
-			    xl = MAX (cxl, xl);
-			    xr = MIN (cxr, xr);
-			    yt = MAX (cyt, yt);
-			    yb = MIN (cyb, yb);
-
-			    if (p->state () & compiz::place::WindowAbove)
-				overlap += 16 * (xr - xl) * (yb - yt);
-			    else if (p->state () & compiz::place::WindowBelow)
-				overlap += 0;
-			    else
-				overlap += (xr - xl) * (yb - yt);
-			}
-		    }
-		}
+		    overlap = band.overlap (xTmp);
 
 		/* CT first time we get no overlap we stop */
 		if (overlap == NONE)
@@ -125,72 +275,33 @@ namespace compiz
 		/* really need to loop? test if there's any overlap */
 		if (overlap > NONE)
 		{
-		    int possible = placeable->workArea ().right ();
+		    int possible = workArea.right ();
 
 		    if (possible - cw > xTmp)
 			possible -= cw;
 
-		    /* compare to the position of each client on the same desk */
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int xl = otherGeometry.x () - otherExtents.left;
-			int yt = otherGeometry.y () - otherExtents.top;
-			int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if not enough room above or under the current
-			 * client determine the first non-overlapped x position
-			 */
-			if (yTmp < yb && yt < ch + yTmp)
-			{
-			    if (xr > xTmp && possible > xr)
-				possible = xr;
-
-			    basket = xl - cw;
-			    if (basket > xTmp && possible > basket)
-				possible = basket;
-			}
-		    }
-		    xTmp = possible;
+		    /* first non-overlapped x position in this band */
+		    xTmp = band.nextX (xTmp, possible);
 		}
 		/* else ==> not enough x dimension (overlap was wrong on horizontal) */
 		else if (overlap == W_WRONG)
 		{
-		    xTmp     = placeable->workArea ().x ();
-		    int possible = placeable->workArea ().bottom ();
+		    xTmp     = workArea.x ();
+		    int possible = workArea.bottom ();
 
 		    if (possible - ch > yTmp)
 			possible -= ch;
 
-		    /* test the position of each window on the desk */
-		    foreach (Placeable *p, placeables)
-		    {
-			const compiz::window::Geometry &otherGeometry = p->geometry ();
-			const compiz::window::extents::Extents &otherExtents = p->extents ();
-
-			int yt = otherGeometry.y () - otherExtents.top;
-			int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
-
-			/* if not enough room to the left or right of the current
-			 * client determine the first non-overlapped y position
-			 */
-			if (yb > yTmp && possible > yb)
-			    possible = yb;
-
-			basket = yt - ch;
-			if (basket > yTmp && possible > basket)
-			    possible = basket;
-		    }
-		    yTmp = possible;
+		    /* first y position where some window starts or stops
+		     * being in the way */
+		    possible = nextAbove (bottoms, yTmp, possible);
+		    yTmp = nextAbove (tops, yTmp, possible);
 		}
 	    }
-	    while (overlap != NONE && overlap != H_WRONG && yTmp < placeable->workArea ().bottom ());
+	    while (overlap != NONE && overlap != H_WRONG && yTmp < workArea.bottom ());
 
-	    if (ch >= placeable->workArea ().height ())
-		yOptimal = placeable->workArea ().y ();
+	    if (ch >= workArea.height ())
+		yOptimal = workArea.y ();
 
 	    pos.setX (xOptimal + placeable->extents ().left);
 	    pos.setY (yOptimal + placeable->extents ().top);
@@ -0,0 +1,398 @@
+/*
+ * Compiz, place plugin, smart placement equivalence tests
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <smart.h>
+#include <boost/foreach.hpp>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <iostream>
+
+#ifndef foreach
+#define foreach BOOST_FOREACH
+#endif
+
+namespace cw = compiz::window;
+namespace cp = compiz::place;
+
+namespace
+{
+class MockPlaceable :
+    public cp::Placeable
+{
+    public:
+
+	MockPlaceable (const cw::Geometry           &geometry,
+		       const cw::extents::Extents   &extents,
+		       const CompRect               &workArea,
+		       unsigned int                 state = 0) :
+	    mGeometry (geometry),
+	    mExtents (extents),
+	    mWorkArea (workArea),
+	    mState (state)
+	{
+	}
+
+    protected:
+
+	const cw::Geometry & getGeometry () const { return mGeometry; }
+	const cw::extents::Extents & getExtents () const { return mExtents; }
+	const CompRect & getWorkarea () const { return mWorkArea; }
+	unsigned int getState () const { return mState; }
+
+    private:
+
+	cw::Geometry         mGeometry;
+	cw::extents::Extents mExtents;
+	CompRect             mWorkArea;
+	unsigned int         mState;
+};
+
+/* The algorithm as it was before the windows were indexed, kept to
+ * check that the indexed version picks the same spot */
+void referenceSmart (cp::Placeable                 *placeable,
+		     CompPoint                     &pos,
+		     const cp::Placeable::Vector   &placeables)
+{
+    const int NONE = 0;
+    const int H_WRONG = -1;
+    const int W_WRONG = -2;
+
+    int overlap = 0, minOverlap = 0;
+    int basket = 0;
+    bool firstPass = true;
+
+    int xTmp = placeable->workArea ().x ();
+    int yTmp = placeable->workArea ().y ();
+
+    int cw = placeable->geometry ().width () - 1;
+    int ch = placeable->geometry ().height () - 1;
+
+    int xOptimal = xTmp;
+    int yOptimal = yTmp;
+
+    do
+    {
+	if (yTmp + ch > placeable->workArea ().bottom () && ch < placeable->workArea ().height ())
+	    overlap = H_WRONG;
+	else if (xTmp + cw > placeable->workArea ().right ())
+	    overlap = W_WRONG;
+	else
+	{
+	    overlap = NONE;
+
+	    int cxl = xTmp;
+	    int cxr = xTmp + cw;
+	    int cyt = yTmp;
+	    int cyb = yTmp + ch;
+
+	    foreach (cp::Placeable *p, placeables)
+	    {
+		const cw::Geometry &otherGeometry = p->geometry ();
+		const cw::extents::Extents &otherExtents = p->extents ();
+
+		int xl = otherGeometry.x () - otherExtents.left;
+		int yt = otherGeometry.y () - otherExtents.top;
+		int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
+		int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+		if (cxl < xr && cxr > xl && cyt < yb && cyb > yt)
+		{
+		    xl = MAX (cxl, xl);
+		    xr = MIN (cxr, xr);
+		    yt = MAX (cyt, yt);
+		    yb = MIN (cyb, yb);
+
+		    if (p->state () & cp::WindowAbove)
+			overlap += 16 * (xr - xl) * (yb - yt);
+		    else if (p->state () & cp::WindowBelow)
+			overlap += 0;
+		    else
+			overlap += (xr - xl) * (yb - yt);
+		}
+	    }
+	}
+
+	if (overlap == NONE)
+	{
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	    break;
+	}
+
+	if (firstPass)
+	{
+	    firstPass  = false;
+	    minOverlap = overlap;
+	}
+	else if (overlap >= NONE && overlap < minOverlap)
+	{
+	    minOverlap = overlap;
+	    xOptimal = xTmp;
+	    yOptimal = yTmp;
+	}
+
+	if (overlap > NONE)
+	{
+	    int possible = placeable->workArea ().right ();
+
+	    if (possible - cw > xTmp)
+		possible -= cw;
+
+	    foreach (cp::Placeable *p, placeables)
+	    {
+		const cw::Geometry &otherGeometry = p->geometry ();
+		const cw::extents::Extents &otherExtents = p->extents ();
+
+		int xl = otherGeometry.x () - otherExtents.left;
+		int yt = otherGeometry.y () - otherExtents.top;
+		int xr = otherGeometry.x2 () + otherExtents.right + otherGeometry.border () * 2;
+		int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+		if (yTmp < yb && yt < ch + yTmp)
+		{
+		    if (xr > xTmp && possible > xr)
+			possible = xr;
+
+		    basket = xl - cw;
+		    if (basket > xTmp && possible > basket)
+			possible = basket;
+		}
+	    }
+	    xTmp = possible;
+	}
+	else if (overlap == W_WRONG)
+	{
+	    xTmp     = placeable->workArea ().x ();
+	    int possible = placeable->workArea ().bottom ();
+
+	    if (possible - ch > yTmp)
+		possible -= ch;
+
+	    foreach (cp::Placeable *p, placeables)
+	    {
+		const cw::Geometry &otherGeometry = p->geometry ();
+		const cw::extents::Extents &otherExtents = p->extents ();
+
+		int yt = otherGeometry.y () - otherExtents.top;
+		int yb = otherGeometry.y2 () + otherExtents.bottom + otherGeometry.border () * 2;
+
+		if (yb > yTmp && possible > yb)
+		    possible = yb;
+
+		basket = yt - ch;
+		if (basket > yTmp && possible > basket)
+		    possible = basket;
+	    }
+	    yTmp = possible;
+	}
+    }
+    while (overlap != NONE && overlap != H_WRONG && yTmp < placeable->workArea ().bottom ());
+
+    if (ch >= placeable->workArea ().height ())
+	yOptimal = placeable->workArea ().y ();
+
+    pos.setX (xOptimal + placeable->extents ().left);
+    pos.setY (yOptimal + placeable->extents ().top);
+}
+
+int randomBetween (int min, int max)
+{
+    return min + rand () % (max - min + 1);
+}
+
+cw::extents::Extents decoration ()
+{
+    cw::extents::Extents e;
+
+    e.left   = 1;
+    e.right  = 1;
+    e.top    = 24;
+    e.bottom = 1;
+
+    return e;
+}
+
+unsigned long long
+usecsSince (const struct timeval &start)
+{
+    struct timeval now;
+
+    gettimeofday (&now, NULL);
+
+    return (now.tv_sec - start.tv_sec) * 1000000ULL +
+	   (now.tv_usec - start.tv_usec);
+}
+}
+
+class CompPlaceSmartEquivalenceTest :
+    public ::testing::Test
+{
+    public:
+
+	CompPlaceSmartEquivalenceTest () :
+	    workArea (0, 24, 2560, 1416)
+	{
+	    srand (42);
+	}
+
+	~CompPlaceSmartEquivalenceTest ()
+	{
+	    foreach (cp::Placeable *p, placeables)
+		delete p;
+	}
+
+	void addRandomWindows (unsigned int n,
+			       int          minSize,
+			       int          maxSize)
+	{
+	    for (unsigned int i = 0; i < n; ++i)
+	    {
+		int w = randomBetween (minSize, maxSize);
+		int h = randomBetween (minSize, maxSize);
+		int x = randomBetween (workArea.x () - w / 4, workArea.x2 () - w / 2);
+		int y = randomBetween (workArea.y () - h / 4, workArea.y2 () - h / 2);
+		unsigned int state = 0;
+
+		switch (rand () % 8)
+		{
+		    case 0:
+			state = cp::WindowAbove;
+			break;
+		    case 1:
+			state = cp::WindowBelow;
+			break;
+		    default:
+			break;
+		}
+
+		placeables.push_back (new MockPlaceable (cw::Geometry (x, y, w, h, rand () % 2),
+							 decoration (),
+							 workArea,
+							 state));
+	    }
+	}
+
+	void expectSamePlacement (int w, int h)
+	{
+	    MockPlaceable placeable (cw::Geometry (0, 0, w, h, 0),
+				     decoration (),
+				     workArea);
+	    CompPoint expected, actual;
+
+	    referenceSmart (&placeable, expected, placeables);
+	    cp::smart (&placeable, actual, placeables);
+
+	    EXPECT_EQ (expected, actual) << "placing " << w << "x" << h
+					 << " among " << placeables.size ()
+					 << " windows";
+	}
+
+	CompRect              workArea;
+	cp::Placeable::Vector placeables;
+};
+
+TEST_F (CompPlaceSmartEquivalenceTest, EmptyWorkArea)
+{
+    expectSamePlacement (640, 480);
+}
+
+TEST_F (CompPlaceSmartEquivalenceTest, FitsBesideOneWindow)
+{
+    placeables.push_back (new MockPlaceable (cw::Geometry (1, 48, 800, 600, 0),
+					     decoration (),
+					     workArea));
+
+    expectSamePlacement (640, 480);
+}
+
+TEST_F (CompPlaceSmartEquivalenceTest, LargerThanWorkArea)
+{
+    addRandomWindows (10, 100, 800);
+
+    expectSamePlacement (3000, 2000);
+    expectSamePlacement (400, 2000);
+    expectSamePlacement (3000, 300);
+}
+
+TEST_F (CompPlaceSmartEquivalenceTest, RandomLayouts)
+{
+    for (unsigned int round = 0; round < 50; ++round)
+    {
+	addRandomWindows (4, 50, 1200);
+
+	expectSamePlacement (randomBetween (50, 1600),
+			     randomBetween (50, 1000));
+	expectSamePlacement (1, 1);
+    }
+}
+
+TEST_F (CompPlaceSmartEquivalenceTest, CrowdedWorkArea)
+{
+    addRandomWindows (200, 20, 400);
+
+    for (unsigned int i = 0; i < 20; ++i)
+	expectSamePlacement (randomBetween (50, 1200),
+			     randomBetween (50, 800));
+}
+
+TEST_F (CompPlaceSmartEquivalenceTest, Benchmark)
+{
+    const unsigned int nPlacements = 20;
+    int                sizes[nPlacements][2];
+
+    addRandomWindows (150, 50, 600);
+
+    for (unsigned int i = 0; i < nPlacements; ++i)
+    {
+	sizes[i][0] = randomBetween (200, 1000);
+	sizes[i][1] = randomBetween (150, 700);
+    }
+
+    struct timeval start;
+    CompPoint      pos;
+
+    gettimeofday (&start, NULL);
+    for (unsigned int i = 0; i < nPlacements; ++i)
+    {
+	MockPlaceable p (cw::Geometry (0, 0, sizes[i][0], sizes[i][1], 0),
+			 decoration (), workArea);
+	referenceSmart (&p, pos, placeables);
+    }
+    unsigned long long reference = usecsSince (start);
+
+    gettimeofday (&start, NULL);
+    for (unsigned int i = 0; i < nPlacements; ++i)
+    {
+	MockPlaceable p (cw::Geometry (0, 0, sizes[i][0], sizes[i][1], 0),
+			 decoration (), workArea);
+	cp::smart (&p, pos, placeables);
+    }
+    unsigned long long indexed = usecsSince (start);
+
+    std::cout << "placing " << nPlacements << " windows among "
+	      << placeables.size () << ": scanning " << reference
+	      << "us, indexed " << indexed << "us" << std::endl;
+
+    RecordProperty ("ScanningUsecs", reference);
+    RecordProperty ("IndexedUsecs", indexed);
+}
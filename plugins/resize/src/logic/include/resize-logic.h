@@ -134,6 +134,7 @@ class ResizeLogic
     private:
 	void handleKeyEvent (KeyCode keycode);
 	void handleMotionEvent (int xRoot, int yRoot);
+	void applyPointerMotion (int xRoot, int yRoot);
 
 	void sendResizeNotify ();
 	void updateWindowSize ();
@@ -169,6 +170,12 @@ class ResizeLogic
 
 	unsigned int lastMaskX;
 	unsigned int lastMaskY;
+
+	/* Pointer position not applied yet because the client was
+	 * still busy with the last size it was given */
+	bool motionPending;
+	int  pendingPointerX;
+	int  pendingPointerY;
 };
 
 #endif /* RESIZELOGIC_H */
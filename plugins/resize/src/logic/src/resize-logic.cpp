@@ -78,7 +78,10 @@ ResizeLogic::ResizeLogic() :
     cScreen (NULL),
     gScreen (NULL),
     lastMaskX (0),
-    lastMaskY (0)
+    lastMaskY (0),
+    motionPending (false),
+    pendingPointerX (0),
+    pendingPointerY (0)
 {
     rKeys[0].name	= "Left";
     rKeys[0].dx		= -1;
@@ -382,7 +385,13 @@ ResizeLogic::handleEvent (XEvent *event)
 	    sa = (XSyncAlarmNotifyEvent *) event;
 
 	    if (w->syncAlarm () == sa->alarm)
-		updateWindowSize ();
+	    {
+		/* Only the newest pointer position matters by now */
+		if (motionPending && !w->syncWait ())
+		    applyPointerMotion (pendingPointerX, pendingPointerY);
+		else
+		    updateWindowSize ();
+	    }
 	}
     }
 }
@@ -451,13 +460,6 @@ ResizeLogic::handleMotionEvent (int xRoot, int yRoot)
 {
     if (grabIndex)
     {
-	BoxRec box;
-	int    wi, he, cwi, che;        /* size of window contents (c prefix for constrained)*/
-	int    wX, wY, wWidth, wHeight; /* rect. for window contents+borders */
-
-	wi = savedGeometry.width;
-	he = savedGeometry.height;
-
 	if (!mask)
 	{
 	    setUpMask (xRoot, yRoot);
@@ -467,90 +469,116 @@ ResizeLogic::handleMotionEvent (int xRoot, int yRoot)
 	    accumulatePointerMotion (xRoot, yRoot);
 	}
 
-	if (mask & ResizeLeftMask || lastMaskX & ResizeLeftMask)
-	    wi -= pointerDx;
-	else if (mask & ResizeRightMask || lastMaskX & ResizeRightMask)
-	    wi += pointerDx;
+	/* The client can't take another size before it is done drawing
+	 * the last one, so there is no point in working out sizes for
+	 * every position the pointer passes through until then */
+	if (mode == ResizeOptions::ModeNormal && w->syncWait ())
+	{
+	    motionPending   = true;
+	    pendingPointerX = xRoot;
+	    pendingPointerY = yRoot;
+	    return;
+	}
 
-	if (mask & ResizeUpMask || lastMaskY & ResizeUpMask)
-	    he -= pointerDy;
-	else if (mask & ResizeDownMask || lastMaskY & ResizeDownMask)
-	    he += pointerDy;
+	applyPointerMotion (xRoot, yRoot);
+    }
+}
 
-	if (w->state () & CompWindowStateMaximizedVertMask)
-	    he = w->serverGeometry ().height ();
+void
+ResizeLogic::applyPointerMotion (int xRoot, int yRoot)
+{
+    BoxRec box;
+    int    wi, he, cwi, che;        /* size of window contents (c prefix for constrained)*/
+    int    wX, wY, wWidth, wHeight; /* rect. for window contents+borders */
 
-	if (w->state () & CompWindowStateMaximizedHorzMask)
-	    wi = w->serverGeometry ().width ();
+    motionPending = false;
 
-	cwi = wi;
-	che = he;
+    wi = savedGeometry.width;
+    he = savedGeometry.height;
 
-	if (w->constrainNewWindowSize (wi, he, &cwi, &che) &&
-	    mode != ResizeOptions::ModeNormal &&
-	    mode != ResizeOptions::ModeOutline)
-	{
-	    Box box;
+    if (mask & ResizeLeftMask || lastMaskX & ResizeLeftMask)
+	wi -= pointerDx;
+    else if (mask & ResizeRightMask || lastMaskX & ResizeRightMask)
+	wi += pointerDx;
 
-	    /* Also, damage relevant paint rectangles */
-	    if (mode == ResizeOptions::ModeRectangle)
-		getPaintRectangle (&box);
-	    else if (mode == ResizeOptions::ModeStretch)
-		getStretchRectangle (&box);
+    if (mask & ResizeUpMask || lastMaskY & ResizeUpMask)
+	he -= pointerDy;
+    else if (mask & ResizeDownMask || lastMaskY & ResizeDownMask)
+	he += pointerDy;
 
-	    damageRectangle (&box);
-	}
+    if (w->state () & CompWindowStateMaximizedVertMask)
+	he = w->serverGeometry ().height ();
 
-	if (offWorkAreaConstrained)
-	    constrainToWorkArea (che, cwi);
+    if (w->state () & CompWindowStateMaximizedHorzMask)
+	wi = w->serverGeometry ().width ();
 
-	wi = cwi;
-	he = che;
+    cwi = wi;
+    che = he;
 
-	/* compute rect. for window + borders */
-	computeWindowPlusBordersRect (wX, wY, wWidth, wHeight, /*out*/
-				      wi, he); /*in*/
+    if (w->constrainNewWindowSize (wi, he, &cwi, &che) &&
+	mode != ResizeOptions::ModeNormal &&
+	mode != ResizeOptions::ModeOutline)
+    {
+	Box box;
 
-	snapWindowToWorkAreaBoundaries (wi, he, wX, wY, wWidth, wHeight);
+	/* Also, damage relevant paint rectangles */
+	if (mode == ResizeOptions::ModeRectangle)
+	    getPaintRectangle (&box);
+	else if (mode == ResizeOptions::ModeStretch)
+	    getStretchRectangle (&box);
 
-	if (isConstrained)
-	    limitMovementToConstraintRegion (wi, he, /*in/out*/
-					     xRoot, yRoot,
-					     wX, wY, wWidth, wHeight); /*in*/
+	damageRectangle (&box);
+    }
 
-	if (mode != ResizeOptions::ModeNormal &&
-	    mode != ResizeOptions::ModeOutline)
-	{
-	    if (mode == ResizeOptions::ModeStretch)
-		getStretchRectangle (&box);
-	    else
-		getPaintRectangle (&box);
+    if (offWorkAreaConstrained)
+	constrainToWorkArea (che, cwi);
 
-	    damageRectangle (&box);
-	}
+    wi = cwi;
+    he = che;
 
-	enableOrDisableVerticalMaximization (yRoot);
+    /* compute rect. for window + borders */
+    computeWindowPlusBordersRect (wX, wY, wWidth, wHeight, /*out*/
+				  wi, he); /*in*/
 
-	computeGeometry (wi, he);
+    snapWindowToWorkAreaBoundaries (wi, he, wX, wY, wWidth, wHeight);
 
-	if (mode != ResizeOptions::ModeNormal &&
-	    mode != ResizeOptions::ModeOutline)
-	{
-	    if (mode == ResizeOptions::ModeStretch)
-		getStretchRectangle (&box);
-	    else
-		getPaintRectangle (&box);
+    if (isConstrained)
+	limitMovementToConstraintRegion (wi, he, /*in/out*/
+					 xRoot, yRoot,
+					 wX, wY, wWidth, wHeight); /*in*/
 
-	    damageRectangle (&box);
-	}
-	else if (mode == ResizeOptions::ModeNormal)
-	{
-	    updateWindowSize ();
-	}
+    if (mode != ResizeOptions::ModeNormal &&
+	mode != ResizeOptions::ModeOutline)
+    {
+	if (mode == ResizeOptions::ModeStretch)
+	    getStretchRectangle (&box);
+	else
+	    getPaintRectangle (&box);
+
+	damageRectangle (&box);
+    }
+
+    enableOrDisableVerticalMaximization (yRoot);
+
+    computeGeometry (wi, he);
+
+    if (mode != ResizeOptions::ModeNormal &&
+	mode != ResizeOptions::ModeOutline)
+    {
+	if (mode == ResizeOptions::ModeStretch)
+	    getStretchRectangle (&box);
+	else
+	    getPaintRectangle (&box);
 
-	updateWindowProperty ();
-	sendResizeNotify ();
+	damageRectangle (&box);
     }
+    else if (mode == ResizeOptions::ModeNormal)
+    {
+	updateWindowSize ();
+    }
+
+    updateWindowProperty ();
+    sendResizeNotify ();
 }
 
 void
@@ -1463,6 +1491,17 @@ ResizeLogic::terminateResize (CompAction        *action,
     {
 	XWindowChanges xwc = XWINDOWCHANGES_INIT;
 	unsigned int   mask = 0;
+	bool           lastMotion = false;
+
+	/* The client was still busy when the resize ended, so work out
+	 * where the pointer ended up or the last size would be lost */
+	if (motionPending && !(state & CompAction::StateCancel))
+	{
+	    applyPointerMotion (pendingPointerX, pendingPointerY);
+	    lastMotion = true;
+	}
+
+	motionPending = false;
 
 	if (mode == ResizeOptions::ModeNormal)
 	{
@@ -1494,6 +1533,15 @@ ResizeLogic::terminateResize (CompAction        *action,
 
 		w->saveMask () = CWY | CWHeight;
 	    }
+	    else if (lastMotion)
+	    {
+		xwc.x      = geometry.x;
+		xwc.y      = geometry.y;
+		xwc.width  = geometry.width;
+		xwc.height = geometry.height;
+
+		mask = CWX | CWY | CWWidth | CWHeight;
+	    }
 	}
 	else
 	{
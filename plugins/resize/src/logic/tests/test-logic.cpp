@@ -363,3 +363,76 @@ TEST_F (ResizeLogicTest, DontCrashIfSourceNotExternalApp)
 
     logic.terminateResize(&action, state, options);
 }
+
+/* While the client is still drawing the last size it was given, pointer
+ * motion must not turn into configure requests. Once it is done, only
+ * the newest pointer position is applied. */
+TEST_F (ResizeLogicTest, CoalesceMotionWhileClientIsBusy)
+{
+    CompAction		action;
+    CompAction::State	state = 0;
+    CompOption::Vector	options;
+    bool		busy = false;
+
+    options.push_back (CompOption ("window", CompOption::TypeInt));
+    options[0].value ().set ((int) 123);
+
+    options.push_back (CompOption ("external", CompOption::TypeBool));
+    options[1].value ().set (true);
+
+    EXPECT_CALL (mockScreen, otherGrabExist (StrEq ("resize"), _))
+	.WillOnce (Return (false));
+
+    EXPECT_CALL (mockScreen, pushGrab (_, StrEq ("resize")))
+	.WillOnce (Return ((CompScreen::GrabHandle)1));
+
+    EXPECT_CALL (mockScreen, handleEvent (_))
+	.Times (AnyNumber ());
+
+    EXPECT_CALL (mockWindow, syncWait ())
+	.WillRepeatedly (ReturnPointee (&busy));
+
+    EXPECT_CALL (mockWindow, syncAlarm ())
+	.WillRepeatedly (Return ((XSyncAlarm) 1));
+
+    /* hit the middle of the top edge of the window  */
+    pointerX = mockWindowServerGeometry.centerX ();
+    pointerY = mockWindowServerGeometry.top();
+
+    logic.initiateResizeDefaultMode(&action, state, options);
+
+    XEvent event;
+    event.type = MotionNotify;
+    event.xmotion.root = 345;
+
+    EXPECT_CALL (mockScreen, root ())
+	.WillRepeatedly (Return (event.xmotion.root));
+
+    busy = true;
+
+    EXPECT_CALL (mockWindow, configureXWindow (_, _))
+	.Times (0);
+
+    for (int i = 1; i <= 5; i++)
+    {
+	pointerY = mockWindowServerGeometry.top () - i * 10;
+	logic.handleEvent (&event);
+    }
+
+    busy = false;
+
+    EXPECT_CALL (mockWindow, configureXWindow (_, _))
+	.Times (1);
+
+    XEvent alarm;
+    XSyncAlarmNotifyEvent *sa = (XSyncAlarmNotifyEvent *) &alarm;
+
+    sa->type  = 0; /* syncEvent () + XSyncAlarmNotify */
+    sa->alarm = 1;
+
+    logic.handleEvent (&alarm);
+
+    EXPECT_CALL (mockScreen, removeGrab (_, _));
+
+    logic.terminateResize(&action, state, options);
+}
@@ -0,0 +1,124 @@
+/*
+ * Compiz, scale plugin, slot layout and window assignment
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_SCALE_LAYOUT_H
+#define _COMPIZ_SCALE_LAYOUT_H
+
+#include <map>
+#include <vector>
+
+#include <core/point.h>
+#include <core/rect.h>
+
+namespace compiz
+{
+    namespace scale
+    {
+	namespace layout
+	{
+	    /**
+	     * Space around and between the slots of a grid
+	     */
+	    struct GridOptions
+	    {
+		int spacing;
+		int xOffset;
+		int yOffset;
+		int yBottomOffset;
+	    };
+
+	    /**
+	     * Appends nWindows slots to slots, laid out in rows over
+	     * workArea. There are sqrt (nWindows + 1) rows, all but the
+	     * last one holding the same number of slots.
+	     */
+	    void grid (const CompRect          &workArea,
+		       unsigned int            nWindows,
+		       const GridOptions       &options,
+		       std::vector <CompRect>  &slots);
+
+	    /**
+	     * Pairs up points in from with points in to so that the sum
+	     * of the distances between pairs is as small as possible.
+	     *
+	     * Returns the index in to for each point in from, or -1 for
+	     * points left over when to is smaller than from.
+	     */
+	    std::vector <int>
+	    minimumDistanceMatching (const std::vector <CompPoint> &from,
+				     const std::vector <CompPoint> &to);
+
+	    /**
+	     * Assigns windows to slots, remembering the assignment so
+	     * that a later layout of a slightly different set of windows
+	     * (one appearing or disappearing while scaled) only moves
+	     * the windows whose slot changed.
+	     */
+	    class SlotAssignment
+	    {
+		public:
+
+		    typedef unsigned long Id;
+
+		    struct Window
+		    {
+			Id        id;
+			CompPoint centre;
+		    };
+
+		    SlotAssignment ();
+
+		    /**
+		     * Returns the slot index for each window, or -1 for
+		     * windows that did not get one.
+		     *
+		     * A window keeps the slot it had in an earlier call
+		     * if a slot with exactly the same geometry is still
+		     * there. All other windows are matched to the
+		     * remaining slots by minimumDistanceMatching, from
+		     * the slot they had if they had one and from their
+		     * centre otherwise.
+		     */
+		    std::vector <int>
+		    assign (const std::vector <Window>   &windows,
+			    const std::vector <CompRect> &slots);
+
+		    /**
+		     * Forgets all earlier assignments
+		     */
+		    void clear ();
+
+		    /**
+		     * How many windows kept their slot in the last call
+		     * to assign ()
+		     */
+		    unsigned int kept () const;
+
+		private:
+
+		    std::map <Id, CompRect> mLast;
+		    unsigned int            mKept;
+	    };
+	}
+    }
+}
+
+#endif
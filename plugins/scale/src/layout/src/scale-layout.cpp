@@ -0,0 +1,298 @@
+/*
+ * Compiz, scale plugin, slot layout and window assignment
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "scale-layout.h"
+
+namespace csl = compiz::scale::layout;
+
+namespace
+{
+    CompPoint centre (const CompRect &rect)
+    {
+	return CompPoint ((rect.x1 () + rect.x2 ()) / 2,
+			  (rect.y1 () + rect.y2 ()) / 2);
+    }
+
+    double distance (const CompPoint &a,
+		     const CompPoint &b)
+    {
+	double dx = a.x () - b.x ();
+	double dy = a.y () - b.y ();
+
+	return sqrt (dx * dx + dy * dy);
+    }
+
+    /*
+     * Hungarian method for a rows x columns cost matrix with
+     * rows <= columns, O (rows^2 * columns). Returns the column
+     * for each row.
+     */
+    std::vector <int>
+    hungarian (const std::vector <double> &cost,
+	       unsigned int               rows,
+	       unsigned int               columns)
+    {
+	const double INF = std::numeric_limits <double>::max ();
+
+	/* 1-based, row and column 0 are the virtual start */
+	std::vector <double>       u (rows + 1, 0.0), v (columns + 1, 0.0);
+	std::vector <double>       minv (columns + 1);
+	std::vector <unsigned int> p (columns + 1, 0), way (columns + 1, 0);
+	std::vector <bool>         used (columns + 1);
+
+	for (unsigned int i = 1; i <= rows; ++i)
+	{
+	    unsigned int j0 = 0;
+
+	    p[0] = i;
+	    std::fill (minv.begin (), minv.end (), INF);
+	    std::fill (used.begin (), used.end (), false);
+
+	    do
+	    {
+		unsigned int i0 = p[j0], j1 = 0;
+		double       delta = INF;
+
+		used[j0] = true;
+
+		for (unsigned int j = 1; j <= columns; ++j)
+		{
+		    if (used[j])
+			continue;
+
+		    double cur = cost[(i0 - 1) * columns + j - 1] - u[i0] - v[j];
+
+		    if (cur < minv[j])
+		    {
+			minv[j] = cur;
+			way[j]  = j0;
+		    }
+
+		    if (minv[j] < delta)
+		    {
+			delta = minv[j];
+			j1    = j;
+		    }
+		}
+
+		for (unsigned int j = 0; j <= columns; ++j)
+		{
+		    if (used[j])
+		    {
+			u[p[j]] += delta;
+			v[j]    -= delta;
+		    }
+		    else
+			minv[j] -= delta;
+		}
+
+		j0 = j1;
+	    }
+	    while (p[j0]);
+
+	    do
+	    {
+		unsigned int j1 = way[j0];
+
+		p[j0] = p[j1];
+		j0    = j1;
+	    }
+	    while (j0);
+	}
+
+	std::vector <int> result (rows, -1);
+
+	for (unsigned int j = 1; j <= columns; ++j)
+	    if (p[j])
+		result[p[j] - 1] = j - 1;
+
+	return result;
+    }
+}
+
+void
+csl::grid (const CompRect          &workArea,
+	   unsigned int            nWindows,
+	   const GridOptions       &options,
+	   std::vector <CompRect>  &slots)
+{
+    if (!nWindows)
+	return;
+
+    int lines   = sqrt (nWindows + 1);
+    int spacing = options.spacing;
+    int nSlots  = 0;
+
+    int y      = options.yOffset + workArea.y () + spacing;
+    int height = (workArea.height () - options.yOffset -
+		  options.yBottomOffset - (lines + 1) * spacing) / lines;
+
+    for (int i = 0; i < lines; ++i)
+    {
+	int n = MIN (nWindows - nSlots, ceilf ((float) nWindows / lines));
+
+	int x     = options.xOffset + workArea.x () + spacing;
+	int width = (workArea.width () - options.xOffset -
+		     (n + 1) * spacing) / n;
+
+	for (int j = 0; j < n; ++j)
+	{
+	    slots.push_back (CompRect (x, y, width, height));
+
+	    x += width + spacing;
+	    ++nSlots;
+	}
+
+	y += height + spacing;
+    }
+}
+
+std::vector <int>
+csl::minimumDistanceMatching (const std::vector <CompPoint> &from,
+			      const std::vector <CompPoint> &to)
+{
+    /* The matching wants fewer rows than columns, so swap the two
+     * sides if there are more points to match than targets */
+    bool                           swap    = from.size () > to.size ();
+    const std::vector <CompPoint> &rows    = swap ? to : from;
+    const std::vector <CompPoint> &columns = swap ? from : to;
+
+    std::vector <double> cost (rows.size () * columns.size ());
+
+    for (unsigned int i = 0; i < rows.size (); ++i)
+	for (unsigned int j = 0; j < columns.size (); ++j)
+	    cost[i * columns.size () + j] = distance (rows[i], columns[j]);
+
+    std::vector <int> match = hungarian (cost, rows.size (), columns.size ());
+
+    if (!swap)
+	return match;
+
+    std::vector <int> result (from.size (), -1);
+
+    for (unsigned int i = 0; i < match.size (); ++i)
+	result[match[i]] = i;
+
+    return result;
+}
+
+csl::SlotAssignment::SlotAssignment () :
+    mKept (0)
+{
+}
+
+std::vector <int>
+csl::SlotAssignment::assign (const std::vector <Window>   &windows,
+			     const std::vector <CompRect> &slots)
+{
+    std::vector <int>  result (windows.size (), -1);
+    std::vector <bool> taken (slots.size (), false);
+
+    mKept = 0;
+
+    /* Windows whose slot is still there stay where they are */
+    for (unsigned int i = 0; i < windows.size (); ++i)
+    {
+	std::map <Id, CompRect>::const_iterator last =
+	    mLast.find (windows[i].id);
+
+	if (last == mLast.end ())
+	    continue;
+
+	for (unsigned int j = 0; j < slots.size (); ++j)
+	{
+	    if (!taken[j] && slots[j] == last->second)
+	    {
+		result[i] = j;
+		taken[j]  = true;
+		++mKept;
+		break;
+	    }
+	}
+    }
+
+    /* Match up everything else. Windows which had a slot go to the
+     * nearest one to it, so that when the number of rows changes
+     * they keep their place in the grid relative to each other */
+    std::vector <CompPoint>    from, to;
+    std::vector <unsigned int> fromIndex, toIndex;
+
+    for (unsigned int i = 0; i < windows.size (); ++i)
+    {
+	if (result[i] == -1)
+	{
+	    std::map <Id, CompRect>::const_iterator last =
+		mLast.find (windows[i].id);
+
+	    if (last != mLast.end ())
+		from.push_back (centre (last->second));
+	    else
+		from.push_back (windows[i].centre);
+
+	    fromIndex.push_back (i);
+	}
+    }
+
+    for (unsigned int j = 0; j < slots.size (); ++j)
+    {
+	if (!taken[j])
+	{
+	    to.push_back (centre (slots[j]));
+	    toIndex.push_back (j);
+	}
+    }
+
+    if (!from.empty () && !to.empty ())
+    {
+	std::vector <int> match = minimumDistanceMatching (from, to);
+
+	for (unsigned int i = 0; i < match.size (); ++i)
+	    if (match[i] != -1)
+		result[fromIndex[i]] = toIndex[match[i]];
+    }
+
+    for (unsigned int i = 0; i < windows.size (); ++i)
+    {
+	if (result[i] != -1)
+	    mLast[windows[i].id] = slots[result[i]];
+	else
+	    mLast.erase (windows[i].id);
+    }
+
+    return result;
+}
+
+void
+csl::SlotAssignment::clear ()
+{
+    mLast.clear ();
+    mKept = 0;
+}
+
+unsigned int
+csl::SlotAssignment::kept () const
+{
+    return mKept;
+}
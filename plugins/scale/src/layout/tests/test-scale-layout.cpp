@@ -0,0 +1,329 @@
+/*
+ * Compiz, scale plugin, slot layout and window assignment tests
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "scale-layout.h"
+
+namespace csl = compiz::scale::layout;
+
+namespace
+{
+    const csl::GridOptions options = { 10, 0, 0, 0 };
+
+    double totalDistance (const std::vector <CompPoint> &from,
+			  const std::vector <CompPoint> &to,
+			  const std::vector <int>       &match)
+    {
+	double total = 0.0;
+
+	for (unsigned int i = 0; i < from.size (); ++i)
+	{
+	    if (match[i] == -1)
+		continue;
+
+	    double dx = from[i].x () - to[match[i]].x ();
+	    double dy = from[i].y () - to[match[i]].y ();
+
+	    total += sqrt (dx * dx + dy * dy);
+	}
+
+	return total;
+    }
+
+    std::vector <CompPoint> randomPoints (unsigned int n)
+    {
+	std::vector <CompPoint> points;
+
+	for (unsigned int i = 0; i < n; ++i)
+	    points.push_back (CompPoint (rand () % 1920, rand () % 1080));
+
+	return points;
+    }
+
+    std::vector <csl::SlotAssignment::Window>
+    windowsAt (const std::vector <CompPoint> &centres)
+    {
+	std::vector <csl::SlotAssignment::Window> windows;
+
+	for (unsigned int i = 0; i < centres.size (); ++i)
+	{
+	    csl::SlotAssignment::Window w = { i + 1, centres[i] };
+	    windows.push_back (w);
+	}
+
+	return windows;
+    }
+}
+
+class ScaleLayoutTest :
+    public ::testing::Test
+{
+    public:
+
+	ScaleLayoutTest () :
+	    workArea (0, 0, 1920, 1080)
+	{
+	    srand (7);
+	}
+
+	CompRect workArea;
+};
+
+TEST_F (ScaleLayoutTest, GridHasOneSlotPerWindow)
+{
+    for (unsigned int n = 0; n < 50; ++n)
+    {
+	std::vector <CompRect> slots;
+
+	csl::grid (workArea, n, options, slots);
+	EXPECT_EQ (n, slots.size ());
+    }
+}
+
+TEST_F (ScaleLayoutTest, GridRows)
+{
+    std::vector <CompRect> slots;
+
+    /* sqrt (6) rounds down to 2 rows of 3 */
+    csl::grid (workArea, 5, options, slots);
+
+    ASSERT_EQ (5, slots.size ());
+    EXPECT_EQ (CompRect (10, 10, 626, 525), slots[0]);
+    EXPECT_EQ (CompRect (646, 10, 626, 525), slots[1]);
+    EXPECT_EQ (CompRect (1282, 10, 626, 525), slots[2]);
+    EXPECT_EQ (CompRect (10, 545, 945, 525), slots[3]);
+    EXPECT_EQ (CompRect (965, 545, 945, 525), slots[4]);
+}
+
+TEST_F (ScaleLayoutTest, MatchingIsOptimal)
+{
+    for (unsigned int round = 0; round < 20; ++round)
+    {
+	std::vector <CompPoint> from = randomPoints (6);
+	std::vector <CompPoint> to = randomPoints (6);
+	std::vector <int>       match = csl::minimumDistanceMatching (from, to);
+	std::vector <int>       permutation;
+
+	for (unsigned int i = 0; i < to.size (); ++i)
+	    permutation.push_back (i);
+
+	double best = totalDistance (from, to, permutation);
+
+	while (std::next_permutation (permutation.begin (), permutation.end ()))
+	    best = std::min (best, totalDistance (from, to, permutation));
+
+	EXPECT_NEAR (best, totalDistance (from, to, match), 1e-6);
+    }
+}
+
+TEST_F (ScaleLayoutTest, MatchingBeatsGreedy)
+{
+    /* Greedy takes the closest pair first and leaves the other point
+     * to go all the way round */
+    std::vector <CompPoint> from, to;
+
+    from.push_back (CompPoint (100, 0));
+    from.push_back (CompPoint (0, 0));
+    to.push_back (CompPoint (90, 0));
+    to.push_back (CompPoint (190, 0));
+
+    std::vector <int> match = csl::minimumDistanceMatching (from, to);
+
+    EXPECT_EQ (1, match[0]);
+    EXPECT_EQ (0, match[1]);
+}
+
+TEST_F (ScaleLayoutTest, MatchingMorePointsThanTargets)
+{
+    std::vector <CompPoint> from, to;
+
+    from.push_back (CompPoint (0, 0));
+    from.push_back (CompPoint (500, 500));
+    from.push_back (CompPoint (1000, 1000));
+    to.push_back (CompPoint (990, 990));
+    to.push_back (CompPoint (10, 10));
+
+    std::vector <int> match = csl::minimumDistanceMatching (from, to);
+
+    ASSERT_EQ (3, match.size ());
+    EXPECT_EQ (1, match[0]);
+    EXPECT_EQ (-1, match[1]);
+    EXPECT_EQ (0, match[2]);
+}
+
+TEST_F (ScaleLayoutTest, EveryWindowGetsADifferentSlot)
+{
+    std::vector <CompRect> slots;
+
+    csl::grid (workArea, 30, options, slots);
+
+    csl::SlotAssignment assignment;
+    std::vector <int>   result = assignment.assign (windowsAt (randomPoints (30)),
+						    slots);
+    std::vector <int>   sorted (result);
+
+    std::sort (sorted.begin (), sorted.end ());
+
+    for (unsigned int i = 0; i < sorted.size (); ++i)
+	EXPECT_EQ ((int) i, sorted[i]);
+
+    EXPECT_EQ (0, assignment.kept ());
+}
+
+TEST_F (ScaleLayoutTest, RemovingAWindowKeepsTheSlotsThatDidNotChange)
+{
+    /* 11 windows are 3 rows of 4, 4 and 3, 10 windows keep the rows
+     * and only the last one loses a slot */
+    std::vector <CompPoint> centres = randomPoints (11);
+    std::vector <CompRect>  slots;
+
+    csl::grid (workArea, centres.size (), options, slots);
+
+    csl::SlotAssignment assignment;
+    std::vector <csl::SlotAssignment::Window> windows = windowsAt (centres);
+    std::vector <int> before = assignment.assign (windows, slots);
+
+    /* drop the window in the last slot of the first row */
+    unsigned int gone = std::find (before.begin (), before.end (), 3) -
+			before.begin ();
+
+    windows.erase (windows.begin () + gone);
+    before.erase (before.begin () + gone);
+
+    std::vector <CompRect> newSlots;
+    csl::grid (workArea, windows.size (), options, newSlots);
+
+    std::vector <int> after = assignment.assign (windows, newSlots);
+
+    unsigned int moved = 0;
+
+    for (unsigned int i = 0; i < windows.size (); ++i)
+    {
+	if (before[i] < 8)
+	    EXPECT_EQ (slots[before[i]], newSlots[after[i]]);
+	else if (slots[before[i]] != newSlots[after[i]])
+	    ++moved;
+    }
+
+    EXPECT_EQ (windows.size () - moved, assignment.kept ());
+    EXPECT_LE (moved, 3);
+}
+
+TEST_F (ScaleLayoutTest, RemovingAWindowMovesTheOthersToNearbySlotsWhenRowsChange)
+{
+    /* 15 windows are 4 rows of 4, 4, 4 and 3, 14 windows are 3 rows
+     * of 5, 5 and 4, so every slot changes */
+    std::vector <CompPoint> centres = randomPoints (15);
+    std::vector <CompRect>  slots;
+
+    csl::grid (workArea, centres.size (), options, slots);
+
+    csl::SlotAssignment assignment;
+    std::vector <csl::SlotAssignment::Window> windows = windowsAt (centres);
+    std::vector <int> before = assignment.assign (windows, slots);
+
+    /* drop the window in the first slot */
+    unsigned int gone = std::find (before.begin (), before.end (), 0) -
+			before.begin ();
+
+    windows.erase (windows.begin () + gone);
+    before.erase (before.begin () + gone);
+
+    std::vector <CompRect> newSlots;
+    csl::grid (workArea, windows.size (), options, newSlots);
+
+    std::vector <int> after = assignment.assign (windows, newSlots);
+
+    EXPECT_EQ (0, assignment.kept ());
+
+    /* Every window goes to a slot around where it was rather than
+     * to wherever is closest to the window itself */
+    std::vector <CompPoint> from, to;
+    std::vector <int>       match;
+
+    for (unsigned int i = 0; i < windows.size (); ++i)
+    {
+	const CompRect &old = slots[before[i]];
+	const CompRect &now = newSlots[after[i]];
+
+	from.clear ();
+	to.clear ();
+	from.push_back (CompPoint (old.centerX (), old.centerY ()));
+	to.push_back (CompPoint (now.centerX (), now.centerY ()));
+	match.assign (1, 0);
+
+	EXPECT_LT (totalDistance (from, to, match), old.width ());
+    }
+}
+
+TEST_F (ScaleLayoutTest, ClearForgetsAssignments)
+{
+    std::vector <CompRect> slots;
+
+    csl::grid (workArea, 4, options, slots);
+
+    csl::SlotAssignment assignment;
+    std::vector <csl::SlotAssignment::Window> windows = windowsAt (randomPoints (4));
+
+    assignment.assign (windows, slots);
+    assignment.assign (windows, slots);
+    EXPECT_EQ (4, assignment.kept ());
+
+    assignment.clear ();
+    assignment.assign (windows, slots);
+    EXPECT_EQ (0, assignment.kept ());
+}
+
+TEST_F (ScaleLayoutTest, Benchmark200Windows)
+{
+    const unsigned int nWindows = 200;
+
+    std::vector <csl::SlotAssignment::Window> windows = windowsAt (randomPoints (nWindows));
+    std::vector <CompRect> slots;
+    csl::SlotAssignment    assignment;
+    struct timeval         start, end;
+
+    gettimeofday (&start, NULL);
+
+    csl::grid (workArea, nWindows, options, slots);
+    std::vector <int> result = assignment.assign (windows, slots);
+
+    gettimeofday (&end, NULL);
+
+    unsigned long long usecs = (end.tv_sec - start.tv_sec) * 1000000ULL +
+			       (end.tv_usec - start.tv_usec);
+
+    std::cout << "laying out " << nWindows << " windows took " << usecs
+	      << "us (one frame at 60Hz is 16667us)" << std::endl;
+
+    RecordProperty ("LayoutUsecs", usecs);
+
+    EXPECT_EQ (nWindows, result.size ());
+    EXPECT_EQ (result.end (), std::find (result.begin (), result.end (), -1));
+}
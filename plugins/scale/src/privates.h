@@ -28,6 +28,7 @@
 
 #include <scale/scale.h>
 #include "scale_options.h"
+#include "scale-layout.h"
 
 class SlotArea {
     public:
@@ -61,7 +62,7 @@ class PrivateScaleScreen :
 	void layoutSlotsForArea (const CompRect&, int);
 	void layoutSlots ();
 	void findBestSlots ();
-	bool fillInWindows ();
+	void fillInWindows ();
 	bool layoutThumbs ();
 	bool layoutThumbsAll ();
 	bool layoutThumbsSingle ();
@@ -138,6 +139,10 @@ class PrivateScaleScreen :
 	std::vector<ScaleSlot> slots;
 	int                  nSlots;
 
+	/* the slots as laid out, before they are fitted to windows */
+	std::vector<CompRect>                  slotGrid;
+	compiz::scale::layout::SlotAssignment slotAssignment;
+
 	ScaleScreen::WindowList windows;
 
 	GLushort opacity;
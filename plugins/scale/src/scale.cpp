@@ -498,39 +498,23 @@ void
 PrivateScaleScreen::layoutSlotsForArea (const CompRect& workArea,
 					int             nWindows)
 {
-    if (!nWindows)
-	return;
-
-    int x, y, width, height;
-    int n;
+    compiz::scale::layout::GridOptions options;
 
-    int lines   = sqrt (nWindows + 1);
-    int spacing = optionGetSpacing ();
-    int nSlots  = 0;
+    options.spacing       = optionGetSpacing ();
+    options.xOffset       = optionGetXOffset ();
+    options.yOffset       = optionGetYOffset ();
+    options.yBottomOffset = optionGetYBottomOffset ();
 
-    y      = optionGetYOffset() + workArea.y () + spacing;
-    height = (workArea.height () - optionGetYOffset () - optionGetYBottomOffset () - (lines + 1) * spacing) / lines;
+    compiz::scale::layout::grid (workArea, nWindows, options, slotGrid);
 
-    for (int i = 0; i < lines; i++)
+    for (; nSlots < (int) slotGrid.size (); nSlots++)
     {
-	n = MIN (nWindows - nSlots, ceilf ((float) nWindows / lines));
-
-	x     = optionGetXOffset() + workArea.x () + spacing;
-	width = (workArea.width () - optionGetXOffset() - (n + 1) * spacing) / n;
-
-	for (int j = 0; j < n; j++)
-	{
-	    slots[this->nSlots].setGeometry (x, y, width, height);
-
-	    slots[this->nSlots].filled = false;
-
-	    x += width + spacing;
-
-	    this->nSlots++;
-	    nSlots++;
-	}
+	slots[nSlots].setGeometry (slotGrid[nSlots].x (),
+				   slotGrid[nSlots].y (),
+				   slotGrid[nSlots].width (),
+				   slotGrid[nSlots].height ());
 
-	y += height + spacing;
+	slots[nSlots].filled = false;
     }
 }
 
@@ -571,6 +555,7 @@ PrivateScaleScreen::layoutSlots ()
 	moMode = ScaleOptions::MultioutputModeOnCurrentOutputDevice;
 
     nSlots = 0;
+    slotGrid.clear ();
 
     switch (moMode)
     {
@@ -594,50 +579,55 @@ PrivateScaleScreen::layoutSlots ()
     }
 }
 
+/* Assigns windows to slots so that the windows travel as little as
+ * possible in total, keeping windows in slots that did not change since
+ * the last layout where they are */
 void
 PrivateScaleScreen::findBestSlots ()
 {
-    CompWindow *w;
-    int        i, d, d0 = 0;
-    float      sx, sy, cx, cy;
+    std::vector<compiz::scale::layout::SlotAssignment::Window> centres;
+    std::vector<ScaleWindow *>                                  unplaced;
 
     foreach (ScaleWindow *sw, windows)
     {
-	w = sw->priv->window;
+	CompWindow *w = sw->priv->window;
 
 	if (sw->priv->slot)
 	    continue;
 
-	sw->priv->sid      = 0;
+	compiz::scale::layout::SlotAssignment::Window c;
+
+	c.id = w->id ();
+	c.centre.set ((w->serverX () - (w->defaultViewport ().x () - screen->vp ().x ()) * screen->width ()) + w->width () / 2,
+		      (w->serverY () - (w->defaultViewport ().y () - screen->vp ().y ()) * screen->height ()) + w->height () / 2);
+
+	centres.push_back (c);
+	unplaced.push_back (sw);
+    }
+
+    std::vector<int> sids = slotAssignment.assign (centres, slotGrid);
+
+    for (unsigned int i = 0; i < unplaced.size (); i++)
+    {
+	ScaleWindow *sw = unplaced[i];
+
+	sw->priv->sid      = sids[i];
 	sw->priv->distance = MAXSHORT;
 
-	for (i = 0; i < nSlots; i++)
+	if (sids[i] != -1)
 	{
-	    if (!slots[i].filled)
-	    {
-		sx = (slots[i].x2 () + slots[i].x1 ()) / 2;
-		sy = (slots[i].y2 () + slots[i].y1 ()) / 2;
-
-		cx = (w->serverX () - (w->defaultViewport ().x () - screen->vp ().x ()) * screen->width ()) + w->width () / 2;
-		cy = (w->serverY () - (w->defaultViewport ().y () - screen->vp ().y ()) * screen->height ()) + w->height () / 2;
+	    const CompRect &slot = slotGrid[sids[i]];
+	    float          cx, cy;
 
-		cx -= sx;
-		cy -= sy;
+	    cx = centres[i].centre.x () - (slot.x1 () + slot.x2 ()) / 2;
+	    cy = centres[i].centre.y () - (slot.y1 () + slot.y2 ()) / 2;
 
-		d = sqrt (cx * cx + cy * cy);
-		if (d0 + d < sw->priv->distance)
-		{
-		    sw->priv->sid      = i;
-		    sw->priv->distance = d0 + d;
-		}
-	    }
+	    sw->priv->distance = sqrt (cx * cx + cy * cy);
 	}
-
-	d0 += sw->priv->distance;
     }
 }
 
-bool
+void
 PrivateScaleScreen::fillInWindows ()
 {
     CompWindow *w;
@@ -648,11 +638,8 @@ PrivateScaleScreen::fillInWindows ()
     {
 	w = sw->priv->window;
 
-	if (!sw->priv->slot)
+	if (!sw->priv->slot && sw->priv->sid != -1)
 	{
-	    if (slots[sw->priv->sid].filled)
-		return true;
-
 	    sw->priv->slot = &slots[sw->priv->sid];
 
 	    /* Auxilary items reparented into windows are clickable so we want to care about
@@ -683,8 +670,6 @@ PrivateScaleScreen::fillInWindows ()
 	    sw->priv->adjust = true;
 	}
     }
-
-    return false;
 }
 
 bool
@@ -699,14 +684,13 @@ ScaleScreen::layoutSlotsAndAssignWindows ()
     /* create a grid of slots */
     priv->layoutSlots ();
 
-    do
-    {
-	/* find most appropriate slots for windows */
-	priv->findBestSlots ();
+    /* find most appropriate slots for windows */
+    priv->findBestSlots ();
 
-	/* sort windows, window with closest distance to a slot first */
-	priv->windows.sort (PrivateScaleWindow::compareWindowsDistance);
-    } while (priv->fillInWindows ());
+    /* sort windows, window with closest distance to a slot first */
+    priv->windows.sort (PrivateScaleWindow::compareWindowsDistance);
+
+    priv->fillInWindows ();
 
     return true;
 }
@@ -821,7 +805,8 @@ PrivateScaleScreen::layoutThumbsSingle ()
 		ret |= sScreen->layoutSlotsAndAssignWindows ();
 
 		foreach (ScaleWindow *sw, windows)
-		    slotWindows[sw] = *sw->priv->slot;
+		    if (sw->priv->slot)
+			slotWindows[sw] = *sw->priv->slot;
 	    }
 	}
     }
@@ -1303,6 +1288,9 @@ PrivateScaleScreen::scaleInitiateCommon (CompAction         *action,
 
     currentMatch = match;
 
+    /* a new scale, nobody has a slot to keep yet */
+    slotAssignment.clear ();
+
     if (!layoutThumbs ())
 	return false;
 
@@ -0,0 +1,129 @@
+/*
+ * Compiz, snap plugin, edge index
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_SNAP_EDGE_INDEX_H
+#define _COMPIZ_SNAP_EDGE_INDEX_H
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <X11/Xlib.h>
+
+typedef enum
+{
+    LeftEdge = 0,
+    RightEdge,
+    TopEdge,
+    BottomEdge
+} EdgeType;
+
+/* Custom Edge struct
+ * Position, start, end meanings are specific to type :
+ *  - LeftEdge/RightEdge : position : x, start/end : y1/y2
+ *  - TopEdge/BottomEdge : position : y, start/end : x1/x2
+ * id/passed are used during visibility detection when adding edges
+ * snapped is straight forward
+ */
+typedef struct
+{
+    int position;
+    int start;
+    int end;
+    EdgeType type;
+    bool screenEdge;
+
+    Window id;
+    bool passed;
+
+    bool snapped;
+} Edge;
+
+namespace compiz
+{
+    namespace snap
+    {
+	/**
+	 * The visible edges, sorted by position for each edge type, so
+	 * that finding the nearest edge to a side of the grabbed window
+	 * does not need to look at every edge.
+	 */
+	class EdgeIndex
+	{
+	    public:
+
+		EdgeIndex ();
+
+		void clear ();
+		void add (const Edge &edge);
+
+		/**
+		 * Replaces all edges with edges. Edges that were snapped
+		 * stay snapped if they are still there, that is if an
+		 * edge of the same window and type is at the same
+		 * position and overlaps the old one.
+		 */
+		void update (const std::list <Edge> &edges);
+
+		/**
+		 * Finds the nearest edge of type whose span overlaps
+		 * start to end, at or before position if before is set,
+		 * at or after position otherwise. Returns NULL if there
+		 * is none, otherwise distance is set to how far away
+		 * it is.
+		 */
+		Edge * nearest (EdgeType type,
+				int      position,
+				int      start,
+				int      end,
+				bool     before,
+				int      &distance);
+
+		/**
+		 * Marks edge (returned by nearest ()) as snapped
+		 */
+		void snap (Edge *edge);
+
+		/**
+		 * Unsnaps the snapped edges of type overlapping start to
+		 * end which are further than distance away from position
+		 * on the side given by before
+		 */
+		void unsnap (EdgeType type,
+			     int      position,
+			     int      start,
+			     int      end,
+			     bool     before,
+			     int      distance);
+
+		unsigned int size () const;
+
+	    private:
+
+		typedef std::multimap <int, Edge> EdgeMap;
+
+		EdgeMap               mEdges[4];
+		std::vector <Edge *>  mSnapped;
+	};
+    }
+}
+
+#endif
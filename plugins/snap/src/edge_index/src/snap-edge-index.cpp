@@ -0,0 +1,183 @@
+/*
+ * Compiz, snap plugin, edge index
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "snap-edge-index.h"
+
+namespace cs = compiz::snap;
+
+namespace
+{
+    bool overlaps (const Edge &edge,
+		   int        start,
+		   int        end)
+    {
+	return edge.end >= start && edge.start <= end;
+    }
+}
+
+cs::EdgeIndex::EdgeIndex ()
+{
+}
+
+void
+cs::EdgeIndex::clear ()
+{
+    for (unsigned int i = 0; i < 4; ++i)
+	mEdges[i].clear ();
+
+    mSnapped.clear ();
+}
+
+void
+cs::EdgeIndex::add (const Edge &edge)
+{
+    Edge *added = &mEdges[edge.type].insert (std::make_pair (edge.position,
+							     edge))->second;
+
+    if (added->snapped)
+	mSnapped.push_back (added);
+}
+
+void
+cs::EdgeIndex::update (const std::list <Edge> &edges)
+{
+    std::vector <Edge> snapped;
+
+    for (std::vector <Edge *>::iterator it = mSnapped.begin ();
+	 it != mSnapped.end (); ++it)
+	snapped.push_back (**it);
+
+    clear ();
+
+    for (std::list <Edge>::const_iterator it = edges.begin ();
+	 it != edges.end (); ++it)
+    {
+	Edge edge (*it);
+
+	edge.snapped = false;
+
+	for (std::vector <Edge>::iterator s = snapped.begin ();
+	     s != snapped.end (); ++s)
+	{
+	    if (s->id == edge.id                 &&
+		s->type == edge.type             &&
+		s->screenEdge == edge.screenEdge &&
+		s->position == edge.position     &&
+		overlaps (*s, edge.start, edge.end))
+	    {
+		edge.snapped = true;
+		break;
+	    }
+	}
+
+	add (edge);
+    }
+}
+
+Edge *
+cs::EdgeIndex::nearest (EdgeType type,
+			int      position,
+			int      start,
+			int      end,
+			bool     before,
+			int      &distance)
+{
+    EdgeMap &edges = mEdges[type];
+
+    /* Edges are sorted by position, so walk away from position and
+     * stop at the first one that is in the way */
+    if (before)
+    {
+	EdgeMap::iterator it = edges.upper_bound (position);
+
+	while (it != edges.begin ())
+	{
+	    --it;
+
+	    if (overlaps (it->second, start, end))
+	    {
+		distance = position - it->first;
+		return &it->second;
+	    }
+	}
+    }
+    else
+    {
+	for (EdgeMap::iterator it = edges.lower_bound (position);
+	     it != edges.end (); ++it)
+	{
+	    if (overlaps (it->second, start, end))
+	    {
+		distance = it->first - position;
+		return &it->second;
+	    }
+	}
+    }
+
+    return NULL;
+}
+
+void
+cs::EdgeIndex::snap (Edge *edge)
+{
+    if (edge->snapped)
+	return;
+
+    edge->snapped = true;
+    mSnapped.push_back (edge);
+}
+
+void
+cs::EdgeIndex::unsnap (EdgeType type,
+		       int      position,
+		       int      start,
+		       int      end,
+		       bool     before,
+		       int      distance)
+{
+    for (std::vector <Edge *>::iterator it = mSnapped.begin ();
+	 it != mSnapped.end ();)
+    {
+	Edge *edge = *it;
+	int  d     = before ? position - edge->position :
+			      edge->position - position;
+
+	if (edge->type == type && overlaps (*edge, start, end) && d > distance)
+	{
+	    edge->snapped = false;
+	    it = mSnapped.erase (it);
+	}
+	else
+	    ++it;
+    }
+}
+
+unsigned int
+cs::EdgeIndex::size () const
+{
+    unsigned int n = 0;
+
+    for (unsigned int i = 0; i < 4; ++i)
+	n += mEdges[i].size ();
+
+    return n;
+}
@@ -0,0 +1,269 @@
+/*
+ * Compiz, snap plugin, edge index tests
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include "snap-edge-index.h"
+
+namespace cs = compiz::snap;
+
+namespace
+{
+    Edge makeEdge (EdgeType type,
+		   int      position,
+		   int      start,
+		   int      end,
+		   Window   id = 1)
+    {
+	Edge edge;
+
+	edge.position   = position;
+	edge.start      = start;
+	edge.end        = end;
+	edge.type       = type;
+	edge.screenEdge = false;
+	edge.id         = id;
+	edge.passed     = false;
+	edge.snapped    = false;
+
+	return edge;
+    }
+
+    /* What the plugin used to do, a scan over all edges */
+    Edge * scanNearest (std::vector <Edge> &edges,
+			EdgeType           type,
+			int                position,
+			int                start,
+			int                end,
+			bool               before,
+			int                &distance)
+    {
+	Edge *best = NULL;
+	int  min   = 65535;
+
+	for (unsigned int i = 0; i < edges.size (); ++i)
+	{
+	    Edge &e = edges[i];
+
+	    if (e.type != type || e.end < start || e.start > end)
+		continue;
+
+	    int d = before ? position - e.position : e.position - position;
+
+	    if (d < min && d >= 0)
+	    {
+		min  = d;
+		best = &e;
+	    }
+	}
+
+	distance = min;
+	return best;
+    }
+}
+
+class SnapEdgeIndexTest :
+    public ::testing::Test
+{
+    public:
+
+	cs::EdgeIndex index;
+};
+
+TEST_F (SnapEdgeIndexTest, Empty)
+{
+    int distance = -1;
+
+    EXPECT_EQ (NULL, index.nearest (LeftEdge, 100, 0, 100, false, distance));
+    EXPECT_EQ (0, index.size ());
+}
+
+TEST_F (SnapEdgeIndexTest, NearestAfter)
+{
+    index.add (makeEdge (LeftEdge, 300, 0, 100));
+    index.add (makeEdge (LeftEdge, 200, 0, 100));
+    index.add (makeEdge (LeftEdge, 50, 0, 100));
+
+    int  distance = -1;
+    Edge *e = index.nearest (LeftEdge, 150, 0, 100, false, distance);
+
+    ASSERT_TRUE (e);
+    EXPECT_EQ (200, e->position);
+    EXPECT_EQ (50, distance);
+}
+
+TEST_F (SnapEdgeIndexTest, NearestBefore)
+{
+    index.add (makeEdge (RightEdge, 300, 0, 100));
+    index.add (makeEdge (RightEdge, 200, 0, 100));
+    index.add (makeEdge (RightEdge, 50, 0, 100));
+
+    int  distance = -1;
+    Edge *e = index.nearest (RightEdge, 250, 0, 100, true, distance);
+
+    ASSERT_TRUE (e);
+    EXPECT_EQ (200, e->position);
+    EXPECT_EQ (50, distance);
+}
+
+TEST_F (SnapEdgeIndexTest, EdgeAtPosition)
+{
+    index.add (makeEdge (TopEdge, 100, 0, 100));
+
+    int distance = -1;
+
+    ASSERT_TRUE (index.nearest (TopEdge, 100, 0, 100, true, distance));
+    EXPECT_EQ (0, distance);
+    ASSERT_TRUE (index.nearest (TopEdge, 100, 0, 100, false, distance));
+    EXPECT_EQ (0, distance);
+}
+
+TEST_F (SnapEdgeIndexTest, SkipsEdgesOutsideSpan)
+{
+    index.add (makeEdge (LeftEdge, 200, 500, 600));
+    index.add (makeEdge (LeftEdge, 400, 50, 60));
+
+    int  distance = -1;
+    Edge *e = index.nearest (LeftEdge, 150, 0, 100, false, distance);
+
+    ASSERT_TRUE (e);
+    EXPECT_EQ (400, e->position);
+}
+
+TEST_F (SnapEdgeIndexTest, SkipsOtherTypes)
+{
+    index.add (makeEdge (RightEdge, 200, 0, 100));
+
+    int distance = -1;
+
+    EXPECT_EQ (NULL, index.nearest (LeftEdge, 150, 0, 100, false, distance));
+}
+
+TEST_F (SnapEdgeIndexTest, SnapAndUnsnap)
+{
+    index.add (makeEdge (LeftEdge, 200, 0, 100));
+
+    int  distance = -1;
+    Edge *e = index.nearest (LeftEdge, 190, 0, 100, false, distance);
+
+    index.snap (e);
+    EXPECT_TRUE (e->snapped);
+
+    /* still within resistance */
+    index.unsnap (LeftEdge, 180, 0, 100, false, 30);
+    EXPECT_TRUE (e->snapped);
+
+    /* wrong span */
+    index.unsnap (LeftEdge, 100, 500, 600, false, 30);
+    EXPECT_TRUE (e->snapped);
+
+    index.unsnap (LeftEdge, 100, 0, 100, false, 30);
+    EXPECT_FALSE (e->snapped);
+}
+
+TEST_F (SnapEdgeIndexTest, UpdateKeepsEdgesSnapped)
+{
+    index.add (makeEdge (LeftEdge, 200, 0, 100, 1));
+    index.add (makeEdge (LeftEdge, 300, 0, 100, 2));
+
+    int  distance = -1;
+    Edge *e = index.nearest (LeftEdge, 190, 0, 100, false, distance);
+
+    index.snap (e);
+
+    /* Another window moved, the snapped edge is now split in two by
+     * a third window */
+    std::list <Edge> edges;
+
+    edges.push_back (makeEdge (LeftEdge, 200, 0, 40, 1));
+    edges.push_back (makeEdge (LeftEdge, 200, 60, 100, 1));
+    edges.push_back (makeEdge (LeftEdge, 250, 0, 100, 2));
+    edges.push_back (makeEdge (TopEdge, 200, 0, 100, 1));
+    index.update (edges);
+
+    EXPECT_EQ (4, index.size ());
+
+    e = index.nearest (LeftEdge, 190, 0, 30, false, distance);
+    ASSERT_TRUE (e != NULL);
+    EXPECT_TRUE (e->snapped);
+
+    e = index.nearest (LeftEdge, 190, 70, 90, false, distance);
+    ASSERT_TRUE (e != NULL);
+    EXPECT_TRUE (e->snapped);
+
+    e = index.nearest (LeftEdge, 240, 0, 100, false, distance);
+    ASSERT_TRUE (e != NULL);
+    EXPECT_FALSE (e->snapped);
+
+    e = index.nearest (TopEdge, 190, 0, 100, false, distance);
+    ASSERT_TRUE (e != NULL);
+    EXPECT_FALSE (e->snapped);
+
+    /* The edges carried over can still be unsnapped */
+    index.unsnap (LeftEdge, 100, 0, 100, false, 30);
+
+    e = index.nearest (LeftEdge, 190, 0, 30, false, distance);
+    EXPECT_FALSE (e->snapped);
+}
+
+TEST_F (SnapEdgeIndexTest, SameDistanceAsScan)
+{
+    std::vector <Edge> edges;
+
+    srand (3);
+
+    for (unsigned int i = 0; i < 500; ++i)
+    {
+	int start = rand () % 2000;
+	Edge e = makeEdge ((EdgeType) (rand () % 4), rand () % 2000,
+			   start, start + rand () % 400, i);
+
+	edges.push_back (e);
+	index.add (e);
+    }
+
+    EXPECT_EQ (500, index.size ());
+
+    for (unsigned int i = 0; i < 2000; ++i)
+    {
+	EdgeType type     = (EdgeType) (rand () % 4);
+	int      position = rand () % 2000;
+	int      start    = rand () % 2000;
+	int      end      = start + rand () % 600;
+	bool     before   = rand () % 2;
+	int      expected, actual = 65535;
+
+	Edge *scanned = scanNearest (edges, type, position, start, end,
+				     before, expected);
+	Edge *found   = index.nearest (type, position, start, end,
+				       before, actual);
+
+	EXPECT_EQ (scanned == NULL, found == NULL);
+
+	if (scanned && found)
+	{
+	    EXPECT_EQ (expected, actual);
+	}
+    }
+}
@@ -347,6 +347,13 @@ SnapWindow::updateEdges ()
 
     if (ss->optionGetEdgesCategoriesMask () & EdgesCategoriesScreenEdgesMask)
 	updateScreenEdges ();
+
+    /* Edges may be rebuilt in the middle of a grab, when other
+     * windows move, keep the ones the window is snapped to snapped */
+    edgeIndex.update (edges);
+
+    edges.clear ();
+    edgesDirty = false;
 }
 
 // Edges checking functions (move) ---------------------------------------------
@@ -367,30 +374,16 @@ SnapWindow::moveCheckNearestEdge (int position,
 {
     SNAP_SCREEN (screen);
 
-    Edge *edge = &edges.front ();
-    int dist, min = 65535;
+    int min;
+    Edge *edge = edgeIndex.nearest (type, position, start, end, before, min);
 
-    foreach (Edge &current, edges)
-    {
-	// Skip wrong type or outbound edges
-	if (current.type != type || current.end < start || current.start > end)
-	    continue;
+    // Unsnap edges that aren't snapped anymore
+    edgeIndex.unsnap (type, position, start, end, before,
+		      ss->optionGetResistanceDistance ());
+
+    if (!edge)
+	return;
 
-	// Compute distance
-	dist = before ? position - current.position : current.position - position;
-	// Update minimum distance if needed
-	if (dist < min && dist >= 0)
-	{
-	    min = dist;
-	    edge = &current;
-	}
-	// 0-dist edge, just break
-	if (dist == 0)
-	    break;
-	// Unsnap edges that aren't snapped anymore
-	if (current.snapped && dist > ss->optionGetResistanceDistance ())
-	    current.snapped = false;
-    }
     // We found a 0-dist edge, or we have a snapping candidate
     if (min == 0 || (min <= ss->optionGetAttractionDistance ()
 	&& ss->optionGetSnapTypeMask () & SnapTypeEdgeAttractionMask))
@@ -404,7 +397,7 @@ SnapWindow::moveCheckNearestEdge (int position,
 	// Attract the window if needed, moving it of the correct dist
 	if (min != 0 && !edge->snapped)
 	{
-	    edge->snapped = true;
+	    edgeIndex.snap (edge);
 	    switch (type)
 	    {
 	    case LeftEdge:
@@ -433,6 +426,10 @@ void
 SnapWindow::moveCheckEdges (int snapDirection)
 {
     CompRect input (window->serverBorderRect ());
+
+    if (edgesDirty)
+	updateEdges ();
+
     moveCheckNearestEdge (input.left (), input.top (), input.bottom (),
 			  true, RightEdge, HorizontalSnap & snapDirection);
     moveCheckNearestEdge (input.right (), input.top (), input.bottom (),
@@ -458,30 +455,16 @@ SnapWindow::resizeCheckNearestEdge (int position,
 {
     SNAP_SCREEN (screen);
 
-    Edge *edge = &edges.front ();
-    int dist, min = 65535;
+    int min;
+    Edge *edge = edgeIndex.nearest (type, position, start, end, before, min);
 
-    foreach (Edge &current, edges)
-    {
-	// Skip wrong type or outbound edges
-	if (current.type != type || current.end < start || current.start > end)
-	    continue;
+    // Unsnap edges that aren't snapped anymore
+    edgeIndex.unsnap (type, position, start, end, before,
+		      ss->optionGetResistanceDistance ());
+
+    if (!edge)
+	return;
 
-	// Compute distance
-	dist = before ? position - current.position : current.position - position;
-	// Update minimum distance if needed
-	if (dist < min && dist >= 0)
-	{
-	    min = dist;
-	    edge = &current;
-	}
-	// 0-dist edge, just break
-	if (dist == 0)
-	    break;
-	// Unsnap edges that aren't snapped anymore
-	if (current.snapped && dist > ss->optionGetResistanceDistance ())
-	    current.snapped = false;
-    }
     // We found a 0-dist edge, or we have a snapping candidate
     if (min == 0 || (min <= ss->optionGetAttractionDistance ()
 	&& ss->optionGetSnapTypeMask () & SnapTypeEdgeAttractionMask))
@@ -496,7 +479,7 @@ SnapWindow::resizeCheckNearestEdge (int position,
 	// Attract the window if needed, moving it of the correct dist
 	if (min != 0 && !edge->snapped)
 	{
-	    edge->snapped = true;
+	    edgeIndex.snap (edge);
 	    switch (type)
 	    {
 	    case LeftEdge:
@@ -526,6 +509,9 @@ SnapWindow::resizeCheckEdges (int dx, int dy, int dwidth, int dheight)
 {
     CompRect input (window->serverBorderRect ());
 
+    if (edgesDirty)
+	updateEdges ();
+
     resizeCheckNearestEdge (input.left (), input.top (), input.bottom (),
 			    true, RightEdge, HorizontalSnap);
     resizeCheckNearestEdge (input.right (), input.top (), input.bottom (),
@@ -571,6 +557,10 @@ SnapWindow::resizeNotify (int dx, int dy, int dwidth, int dheight)
 
     window->resizeNotify (dx, dy, dwidth, dheight);
 
+    // another window changed while one is grabbed, its edges are stale
+    if (ss->grabWindow && ss->grabWindow != this)
+	ss->grabWindow->edgesDirty = true;
+
     // avoid-infinite-notify-loop mode/not grabbed
     if (skipNotify || !(grabbed & ResizeGrab))
 	return;
@@ -621,6 +611,9 @@ SnapWindow::moveNotify (int dx, int dy, bool immediate)
 
     window->moveNotify (dx, dy, immediate);
 
+    if (ss->grabWindow && ss->grabWindow != this)
+	ss->grabWindow->edgesDirty = true;
+
     // avoid-infinite-notify-loop mode/not grabbed
     if (skipNotify || !(grabbed & MoveGrab))
 	return;
@@ -706,7 +699,10 @@ SnapWindow::moveNotify (int dx, int dy, bool immediate)
 void
 SnapWindow::grabNotify (int x, int y, unsigned int state, unsigned int mask)
 {
+    SNAP_SCREEN (screen);
+
     grabbed = (mask & CompWindowGrabResizeMask) ? ResizeGrab : MoveGrab;
+    ss->grabWindow = this;
     updateEdges ();
 
     window->grabNotify (x, y, state, mask);
@@ -719,7 +715,13 @@ SnapWindow::grabNotify (int x, int y, unsigned int state, unsigned int mask)
 void
 SnapWindow::ungrabNotify ()
 {
-    edges.clear ();
+    SNAP_SCREEN (screen);
+
+    edgeIndex.clear ();
+    edgesDirty = false;
+
+    if (ss->grabWindow == this)
+	ss->grabWindow = NULL;
 
     snapGeometry = CompWindow::Geometry ();
     snapDirection = 0;
@@ -729,6 +731,32 @@ SnapWindow::ungrabNotify ()
     window->ungrabNotify ();
 }
 
+/*
+ * Windows appearing, disappearing or restacking change which edges
+ * of the others are visible
+ */
+void
+SnapWindow::windowNotify (CompWindowNotify n)
+{
+    SNAP_SCREEN (screen);
+
+    switch (n)
+    {
+	case CompWindowNotifyMap:
+	case CompWindowNotifyUnmap:
+	case CompWindowNotifyRestack:
+	case CompWindowNotifyHide:
+	case CompWindowNotifyShow:
+	    if (ss->grabWindow && ss->grabWindow != this)
+		ss->grabWindow->edgesDirty = true;
+	    break;
+	default:
+	    break;
+    }
+
+    window->windowNotify (n);
+}
+
 // Internal stuff --------------------------------------------------------------
 
 void
@@ -759,6 +787,7 @@ SnapScreen::SnapScreen (CompScreen *screen) :
     PluginClassHandler <SnapScreen, CompScreen> (screen),
     SnapOptions (),
     snapping (true),
+    grabWindow (NULL),
     avoidSnapMask (0)
 {
     ScreenInterface::setHandler (screen);
@@ -771,6 +800,7 @@ SnapScreen::SnapScreen (CompScreen *screen) :
 
 SnapWindow::SnapWindow (CompWindow *window) :
     PluginClassHandler <SnapWindow, CompWindow> (window),
+    edgesDirty (false),
     window (window),
     snapDirection (0),
     m_dx (0),
@@ -786,6 +816,10 @@ SnapWindow::SnapWindow (CompWindow *window) :
 
 SnapWindow::~SnapWindow ()
 {
+    SNAP_SCREEN (screen);
+
+    if (ss->grabWindow == this)
+	ss->grabWindow = NULL;
 }
 
 bool
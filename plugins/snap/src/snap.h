@@ -32,6 +32,7 @@
 #include <core/pluginclasshandler.h>
 
 #include "snap_options.h"
+#include "snap-edge-index.h"
 
 /*
  * The window we should snap too if snapping to windows
@@ -47,34 +48,7 @@
 #define MoveGrab		(1L << 0)
 #define ResizeGrab		(1L << 1)
 
-typedef enum
-{
-    LeftEdge = 0,
-    RightEdge,
-    TopEdge,
-    BottomEdge
-} EdgeType;
-
-/* Custom Edge struct
- * Position, start, end meanings are specific to type :
- *  - LeftEdge/RightEdge : position : x, start/end : y1/y2
- *  - TopEdge/BottomEdge : position : y, start/end : x1/x2
- * id/passed are used during visibility detection when adding edges
- * snapped is straight forward
- */
-typedef struct
-{
-    int position;
-    int start;
-    int end;
-    EdgeType type;
-    bool screenEdge;
-
-    Window id;
-    bool passed;
-
-    bool snapped;
-} Edge;
+class SnapWindow;
 
 class SnapScreen :
     public ScreenInterface,
@@ -93,6 +67,9 @@ class SnapScreen :
 			      CompOption::Vector &options);
 	void optionChanged (CompOption *opt, SnapOptions::Options num);
 
+	// the window being moved or resized, if any
+	SnapWindow *grabWindow;
+
     private:
 	// used to allow moving windows without snapping
 	int avoidSnapMask;
@@ -111,12 +88,17 @@ class SnapWindow :
 	void grabNotify (int x, int y, unsigned int state, unsigned int mask);
 	void stateChangeNotify (unsigned int lastState);
 	void ungrabNotify ();
+	void windowNotify (CompWindowNotify n);
+
+	// set when the edges need recalculating before the next check
+	bool edgesDirty;
 
     private:
 	CompWindow *window;
 
-	// linked lists
+	// scratch list the edges are built in before being indexed
 	std::list<Edge> edges;
+	compiz::snap::EdgeIndex edgeIndex;
 
 	// bitfield
 	int snapDirection;
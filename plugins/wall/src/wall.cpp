@@ -1610,6 +1610,24 @@ WallScreen::setOptionForPlugin (const char        *plugin,
     return status;
 }
 
+bool
+WallScreen::setOptionsForPlugin (const char         *plugin,
+				 CompOption::Vector &options)
+{
+    bool status = screen->setOptionsForPlugin (plugin, options);
+
+    if (strcmp (plugin, "core") == 0)
+    {
+        if (CompOption::findOption (options, "hsize") ||
+            CompOption::findOption (options, "vsize"))
+        {
+            createCairoContexts (false);
+        }
+    }
+
+    return status;
+}
+
 void
 WallScreen::matchExpHandlerChanged ()
 {
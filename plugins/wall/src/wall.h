@@ -96,6 +96,7 @@ class WallScreen :
 
 	bool setOptionForPlugin (const char *, const char *,
 				 CompOption::Value&);
+	bool setOptionsForPlugin (const char *, CompOption::Vector &);
 	void matchExpHandlerChanged ();
 	void matchPropertyChanged (CompWindow *);
 
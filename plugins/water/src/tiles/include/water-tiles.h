@@ -0,0 +1,97 @@
+/*
+ * Compiz, water plugin, active tile tracking
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#ifndef _COMPIZ_WATER_TILES_H
+#define _COMPIZ_WATER_TILES_H
+
+#include <vector>
+
+#include <core/size.h>
+#include <core/rect.h>
+#include <core/region.h>
+
+namespace compiz
+{
+    namespace water
+    {
+	/**
+	 * Conservative tracking of the parts of the height field which
+	 * may be non-zero.
+	 *
+	 * The area is split into square tiles. Disturbing a rectangle
+	 * activates every tile it touches plus one tile of margin, and
+	 * every time the wave has travelled the width of a tile the set
+	 * of active tiles grows by its eight-connected neighbours. Tiles
+	 * outside of region () are therefore known to be flat and need
+	 * neither simulating nor repainting.
+	 */
+	class TileGrid
+	{
+	    public:
+
+		TileGrid (const CompSize &area,
+			  unsigned int   tileSize);
+
+		/**
+		 * Marks the tiles covering rect (and their neighbours)
+		 * as active
+		 */
+		void disturb (const CompRect &rect);
+
+		/**
+		 * Advances the wave front by distance pixels, growing
+		 * the active set once a full tile has been covered
+		 */
+		void propagate (float distance);
+
+		/**
+		 * Marks every tile as flat again
+		 */
+		void clear ();
+
+		bool empty () const;
+		unsigned int activeTiles () const;
+		unsigned int totalTiles () const;
+
+		/**
+		 * Returns the union of all active tiles, clipped to
+		 * the area
+		 */
+		const CompRegion & region () const;
+
+	    private:
+
+		void activate (int column, int row);
+		void dilate ();
+
+		CompSize          mArea;
+		int               mTileSize;
+		int               mColumns;
+		int               mRows;
+		std::vector<bool> mActive;
+		unsigned int      mNActive;
+		float             mTravelled;
+		CompRegion        mRegion;
+	};
+    }
+}
+
+#endif
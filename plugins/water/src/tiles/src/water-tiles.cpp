@@ -0,0 +1,146 @@
+/*
+ * Compiz, water plugin, active tile tracking
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "water-tiles.h"
+
+namespace cw = compiz::water;
+
+cw::TileGrid::TileGrid (const CompSize &area,
+			unsigned int   tileSize) :
+    mArea (area),
+    mTileSize (tileSize ? tileSize : 1),
+    mColumns ((area.width ()  + mTileSize - 1) / mTileSize),
+    mRows    ((area.height () + mTileSize - 1) / mTileSize),
+    mActive (mColumns * mRows, false),
+    mNActive (0),
+    mTravelled (0.0f)
+{
+}
+
+void
+cw::TileGrid::activate (int column,
+			int row)
+{
+    if (column < 0 || column >= mColumns ||
+	row    < 0 || row    >= mRows)
+	return;
+
+    std::vector<bool>::reference active = mActive[row * mColumns + column];
+
+    if (active)
+	return;
+
+    active = true;
+    ++mNActive;
+
+    CompRect tile (column * mTileSize, row * mTileSize,
+		   mTileSize, mTileSize);
+
+    mRegion += tile & CompRect (0, 0, mArea.width (), mArea.height ());
+}
+
+void
+cw::TileGrid::disturb (const CompRect &rect)
+{
+    /* Floor division so that rectangles hanging off the top-left
+     * edge still map onto the first row and column */
+    int x1 = rect.x1 () >= 0 ? rect.x1 () / mTileSize :
+			       (rect.x1 () - mTileSize + 1) / mTileSize;
+    int y1 = rect.y1 () >= 0 ? rect.y1 () / mTileSize :
+			       (rect.y1 () - mTileSize + 1) / mTileSize;
+    int x2 = rect.x2 () >= 0 ? rect.x2 () / mTileSize :
+			       (rect.x2 () - mTileSize + 1) / mTileSize;
+    int y2 = rect.y2 () >= 0 ? rect.y2 () / mTileSize :
+			       (rect.y2 () - mTileSize + 1) / mTileSize;
+
+    for (int row = y1 - 1; row <= y2 + 1; ++row)
+	for (int column = x1 - 1; column <= x2 + 1; ++column)
+	    activate (column, row);
+}
+
+void
+cw::TileGrid::dilate ()
+{
+    std::vector<bool> previous (mActive);
+
+    for (int row = 0; row < mRows; ++row)
+    {
+	for (int column = 0; column < mColumns; ++column)
+	{
+	    if (!previous[row * mColumns + column])
+		continue;
+
+	    for (int dy = -1; dy <= 1; ++dy)
+		for (int dx = -1; dx <= 1; ++dx)
+		    activate (column + dx, row + dy);
+	}
+    }
+}
+
+void
+cw::TileGrid::propagate (float distance)
+{
+    if (!mNActive)
+	return;
+
+    mTravelled += distance;
+
+    while (mTravelled >= mTileSize)
+    {
+	mTravelled -= mTileSize;
+
+	if (mNActive < mActive.size ())
+	    dilate ();
+    }
+}
+
+void
+cw::TileGrid::clear ()
+{
+    mActive.assign (mActive.size (), false);
+    mNActive = 0;
+    mTravelled = 0.0f;
+    mRegion = CompRegion ();
+}
+
+bool
+cw::TileGrid::empty () const
+{
+    return mNActive == 0;
+}
+
+unsigned int
+cw::TileGrid::activeTiles () const
+{
+    return mNActive;
+}
+
+unsigned int
+cw::TileGrid::totalTiles () const
+{
+    return mActive.size ();
+}
+
+const CompRegion &
+cw::TileGrid::region () const
+{
+    return mRegion;
+}
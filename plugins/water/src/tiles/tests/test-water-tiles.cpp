@@ -0,0 +1,138 @@
+/*
+ * Compiz, water plugin, active tile tracking
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "water-tiles.h"
+
+namespace cw = compiz::water;
+
+namespace
+{
+    const CompSize     screenSize (1000, 600);
+    const unsigned int tileSize = 100;
+}
+
+class WaterTileGridTest :
+    public ::testing::Test
+{
+    public:
+
+	WaterTileGridTest () :
+	    grid (screenSize, tileSize)
+	{
+	}
+
+    protected:
+
+	cw::TileGrid grid;
+};
+
+TEST_F (WaterTileGridTest, InitiallyEmpty)
+{
+    EXPECT_TRUE (grid.empty ());
+    EXPECT_TRUE (grid.region ().isEmpty ());
+    EXPECT_EQ (60, grid.totalTiles ());
+}
+
+TEST_F (WaterTileGridTest, DisturbActivatesTileAndNeighbours)
+{
+    grid.disturb (CompRect (450, 250, 1, 1));
+
+    EXPECT_EQ (9, grid.activeTiles ());
+    EXPECT_EQ (CompRegion (300, 100, 300, 300), grid.region ());
+}
+
+TEST_F (WaterTileGridTest, DisturbInCornerIsClippedToArea)
+{
+    grid.disturb (CompRect (0, 0, 1, 1));
+
+    EXPECT_EQ (4, grid.activeTiles ());
+    EXPECT_EQ (CompRegion (0, 0, 200, 200), grid.region ());
+}
+
+TEST_F (WaterTileGridTest, DisturbOutsideAreaTouchesEdgeOnly)
+{
+    grid.disturb (CompRect (-50, -50, 10, 10));
+
+    EXPECT_EQ (1, grid.activeTiles ());
+    EXPECT_EQ (CompRegion (0, 0, 100, 100), grid.region ());
+}
+
+TEST_F (WaterTileGridTest, PartialTileDistanceDoesNotGrow)
+{
+    grid.disturb (CompRect (450, 250, 1, 1));
+    grid.propagate (tileSize / 2.0f);
+
+    EXPECT_EQ (9, grid.activeTiles ());
+}
+
+TEST_F (WaterTileGridTest, FullTileDistanceGrowsByOneRing)
+{
+    grid.disturb (CompRect (450, 250, 1, 1));
+    grid.propagate (tileSize / 2.0f);
+    grid.propagate (tileSize / 2.0f);
+
+    EXPECT_EQ (25, grid.activeTiles ());
+    EXPECT_EQ (CompRegion (200, 0, 500, 500), grid.region ());
+}
+
+TEST_F (WaterTileGridTest, PropagateOnEmptyGridDoesNothing)
+{
+    grid.propagate (tileSize * 10.0f);
+    EXPECT_TRUE (grid.empty ());
+
+    /* Distance travelled while flat must not leak into the next ripple */
+    grid.disturb (CompRect (450, 250, 1, 1));
+    EXPECT_EQ (9, grid.activeTiles ());
+}
+
+TEST_F (WaterTileGridTest, SaturatesAtFullArea)
+{
+    grid.disturb (CompRect (0, 0, 1, 1));
+    grid.propagate (tileSize * 20.0f);
+
+    EXPECT_EQ (grid.totalTiles (), grid.activeTiles ());
+    EXPECT_EQ (CompRegion (0, 0, 1000, 600), grid.region ());
+}
+
+TEST_F (WaterTileGridTest, ClearResetsEverything)
+{
+    grid.disturb (CompRect (450, 250, 1, 1));
+    grid.propagate (tileSize * 0.75f);
+    grid.clear ();
+
+    EXPECT_TRUE (grid.empty ());
+    EXPECT_TRUE (grid.region ().isEmpty ());
+
+    grid.disturb (CompRect (450, 250, 1, 1));
+    grid.propagate (tileSize * 0.5f);
+    EXPECT_EQ (9, grid.activeTiles ());
+}
+
+TEST (WaterTileGridUnevenTest, LastTilesAreClipped)
+{
+    cw::TileGrid grid (CompSize (250, 150), tileSize);
+
+    EXPECT_EQ (6, grid.totalTiles ());
+
+    grid.disturb (CompRect (240, 140, 1, 1));
+    EXPECT_EQ (CompRegion (100, 0, 150, 150), grid.region ());
+}
@@ -35,27 +35,13 @@ const unsigned int TEXTURE_SIZE = 256;
 
 const float K = 0.1964f;
 
+/* Edge length of the squares used to track which parts of the
+ * height field are non-zero, in screen pixels */
+const unsigned int TILE_SIZE = 64;
+
 static int waterLastPointerX = 0;
 static int waterLastPointerY = 0;
 
-GLfloat WaterScreen::vertexData [18] = {
-    -1.0f, -1.0f, 0.0f,
-     1.0f, -1.0f, 0.0f,
-    -1.0f,  1.0f, 0.0f,
-    -1.0f,  1.0f, 0.0f,
-     1.0f, -1.0f, 0.0f,
-     1.0f,  1.0f, 0.0f,
-};
-
-GLfloat WaterScreen::textureData [12] = {
-    0.0f, 0.0f,
-    1.0f, 0.0f,
-    0.0f, 1.0f,
-    0.0f, 1.0f,
-    1.0f, 0.0f,
-    1.0f, 1.0f,
-};
-
 bool
 WaterScreen::fboPrologue (int fIndex)
 {
@@ -89,14 +75,23 @@ WaterScreen::waterUpdate (float dt)
 	    fade = 0.0f;
     }
 
+    /* The wave travels at most one texel per step, grow the set of
+     * active tiles before simulating so that it covers the new front */
+    tiles.propagate (MAX ((float) screen->width ()  / texWidth,
+			  (float) screen->height () / texHeight));
+
+    if (tiles.empty ())
+	return;
+
     if (!fboPrologue (INDEX (this, 1)))
 	return;
 
     glEnable (GL_TEXTURE_2D);
 
+    /* Only step the tiles which may be non-zero, everything outside
+     * of them is flat in all three buffers and stays flat */
     vertexBuffer[UPDATE]->begin ();
-    vertexBuffer[UPDATE]->addVertices  (6, &vertexData[0]);
-    vertexBuffer[UPDATE]->addTexCoords (0, 6, &textureData[0]);
+    waterTileVertices (vertexBuffer[UPDATE]);
     vertexBuffer[UPDATE]->end ();
 
     /*
@@ -138,15 +133,101 @@ WaterScreen::waterUpdate (float dt)
     fboIndex = INDEX (this, 1);
 }
 
+void
+WaterScreen::waterTileVertices (GLVertexBuffer *vb)
+{
+    const float width  = screen->width ();
+    const float height = screen->height ();
+
+    foreach (const CompRect &r, tiles.region ().rects ())
+    {
+	GLfloat s1 = r.x1 () / width;
+	GLfloat s2 = r.x2 () / width;
+	GLfloat t1 = (height - r.y1 ()) / height;
+	GLfloat t2 = (height - r.y2 ()) / height;
+
+	const GLfloat vertices[] = {
+	    s1 * 2.0f - 1.0f, t2 * 2.0f - 1.0f, 0.0f,
+	    s2 * 2.0f - 1.0f, t2 * 2.0f - 1.0f, 0.0f,
+	    s1 * 2.0f - 1.0f, t1 * 2.0f - 1.0f, 0.0f,
+	    s1 * 2.0f - 1.0f, t1 * 2.0f - 1.0f, 0.0f,
+	    s2 * 2.0f - 1.0f, t2 * 2.0f - 1.0f, 0.0f,
+	    s2 * 2.0f - 1.0f, t1 * 2.0f - 1.0f, 0.0f,
+	};
+
+	const GLfloat texCoords[] = {
+	    s1, t2,
+	    s2, t2,
+	    s1, t1,
+	    s1, t1,
+	    s2, t2,
+	    s2, t1,
+	};
+
+	vb->addVertices  (6, &vertices[0]);
+	vb->addTexCoords (0, 6, &texCoords[0]);
+    }
+}
+
+void
+WaterScreen::waterClear ()
+{
+    GLfloat clearColor[4];
+
+    glGetFloatv (GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+
+    for (int i = 0; i < TEXTURE_NUM; i++)
+    {
+	if (!fboPrologue (i))
+	    break;
+
+	glClear (GL_COLOR_BUFFER_BIT);
+
+	fboEpilogue ();
+    }
+
+    glClearColor (clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+
+    tiles.clear ();
+}
+
+void
+WaterScreen::waterDamage ()
+{
+    cScreen->damageRegion (tiles.region ());
+}
+
 void
 WaterScreen::waterVertices (GLenum type,
 			  XPoint *p,
 			  int    n,
 			  float  v)
 {
+    /* Whatever is left over from the last ripple is outside of the
+     * tracked tiles, so start again from a flat surface */
+    if (count <= 0)
+	waterClear ();
+
     if (!fboPrologue (INDEX (this, 0)))
 	return;
 
+    /* Setting a flat height (eg, the wiper) can't create new waves */
+    if (v != 0.0f && n > 0)
+    {
+	int x1 = p[0].x, y1 = p[0].y, x2 = x1, y2 = y1;
+
+	for (int i = 1; i < n; i++)
+	{
+	    x1 = MIN (x1, p[i].x);
+	    y1 = MIN (y1, p[i].y);
+	    x2 = MAX (x2, p[i].x);
+	    y2 = MAX (y2, p[i].y);
+	}
+
+	tiles.disturb (CompRect (x1, y1, x2 - x1 + 1, y2 - y1 + 1));
+    }
+
     glColorMask (GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
     glLineWidth (1.0f);
 
@@ -183,6 +264,7 @@ WaterScreen::waterVertices (GLenum type,
 	cScreen->preparePaintSetEnabled (this, true);
 	gScreen->glPaintOutputSetEnabled (this, true);
 	gScreen->glPaintCompositedOutputSetEnabled (this, true);
+	gScreen->glPaintCompositedOutputRequiredSetEnabled (this, true);
 	cScreen->donePaintSetEnabled (this, true);
     }
 
@@ -200,7 +282,7 @@ WaterScreen::rainTimeout ()
 
     waterVertices (GL_POINTS, &p, 1, 0.8f * (rand () / (float) RAND_MAX));
 
-    cScreen->damageScreen ();
+    waterDamage ();
 
     return true;
 }
@@ -328,48 +410,56 @@ WaterScreen::glPaintCompositedOutput (const CompRegion    &region,
                                       GLFramebufferObject *fbo,
                                       unsigned int         mask)
 {
-    if (count)
+    if (!count || tiles.empty () || !GL::vboEnabled || !GL::shaders)
     {
-	if (GL::vboEnabled && GL::shaders)
-	{
-	    GLFramebufferObject::rebind (oldFbo);
-	    glViewport (oldViewport[0], oldViewport[1],
-			oldViewport[2], oldViewport[3]);
-
-	    vertexBuffer[PAINT]->begin ();
-	    vertexBuffer[PAINT]->addVertices (6, &vertexData[0]);
-	    vertexBuffer[PAINT]->addTexCoords (0, 6, &textureData[0]);
-	    vertexBuffer[PAINT]->end ();
-
-	    glEnable (GL_TEXTURE_2D);
-
-	    glActiveTexture (GL_TEXTURE0);
-	    fbo->tex ()->setFilter (GL_LINEAR);
-	    glBindTexture (GL_TEXTURE_2D, fbo->tex ()->name ());
-	    vertexBuffer[PAINT]->addUniform ("baseTex", 0);
-
-	    glActiveTexture (GL_TEXTURE1);
-	    waterFbo[INDEX (this, 0)]->tex ()->setFilter (GL_LINEAR);
-	    glBindTexture (GL_TEXTURE_2D,
-			waterFbo[INDEX (this, 0)]->tex ()->name ());
-	    vertexBuffer[PAINT]->addUniform ("waveTex", 1);
-
-	    vertexBuffer[PAINT]->addUniform3f ("lightVec",
-					lightVec[0],
-					lightVec[1],
-					lightVec[2]);
-	    vertexBuffer[PAINT]->addUniform ("offsetScale", offsetScale);
-	    GLboolean isBlendingEnabled;
-	    glGetBooleanv (GL_BLEND, &isBlendingEnabled);
-	    glDisable (GL_BLEND);
-	    vertexBuffer[PAINT]->render ();
-	    if (isBlendingEnabled)
-		glEnable (GL_BLEND);
-
-	    glBindTexture (GL_TEXTURE_2D, 0);
-	    glDisable (GL_TEXTURE_2D);
-	}
+	gScreen->glPaintCompositedOutput (region, fbo, mask);
+	return;
     }
+
+    CompRegion unaffected ((mask & COMPOSITE_SCREEN_DAMAGE_ALL_MASK) ?
+			   screen->region () : region);
+
+    /* Let the rest of the chain blit whatever the ripples don't cover */
+    unaffected -= tiles.region ();
+    if (!unaffected.isEmpty ())
+	gScreen->glPaintCompositedOutput (unaffected, fbo,
+					  mask & ~COMPOSITE_SCREEN_DAMAGE_ALL_MASK);
+
+    GLFramebufferObject::rebind (oldFbo);
+    glViewport (oldViewport[0], oldViewport[1],
+		oldViewport[2], oldViewport[3]);
+
+    vertexBuffer[PAINT]->begin ();
+    waterTileVertices (vertexBuffer[PAINT]);
+    vertexBuffer[PAINT]->end ();
+
+    glEnable (GL_TEXTURE_2D);
+
+    glActiveTexture (GL_TEXTURE0);
+    fbo->tex ()->setFilter (GL_LINEAR);
+    glBindTexture (GL_TEXTURE_2D, fbo->tex ()->name ());
+    vertexBuffer[PAINT]->addUniform ("baseTex", 0);
+
+    glActiveTexture (GL_TEXTURE1);
+    waterFbo[INDEX (this, 0)]->tex ()->setFilter (GL_LINEAR);
+    glBindTexture (GL_TEXTURE_2D,
+		   waterFbo[INDEX (this, 0)]->tex ()->name ());
+    vertexBuffer[PAINT]->addUniform ("waveTex", 1);
+
+    vertexBuffer[PAINT]->addUniform3f ("lightVec",
+				       lightVec[0],
+				       lightVec[1],
+				       lightVec[2]);
+    vertexBuffer[PAINT]->addUniform ("offsetScale", offsetScale);
+    GLboolean isBlendingEnabled;
+    glGetBooleanv (GL_BLEND, &isBlendingEnabled);
+    glDisable (GL_BLEND);
+    vertexBuffer[PAINT]->render ();
+    if (isBlendingEnabled)
+	glEnable (GL_BLEND);
+
+    glBindTexture (GL_TEXTURE_2D, 0);
+    glDisable (GL_TEXTURE_2D);
 }
 
 /* TODO: a way to control the speed */
@@ -467,7 +557,7 @@ void
 WaterScreen::donePaint ()
 {
     if (count)
-	cScreen->damageScreen ();
+	waterDamage ();
     else
     {
 	cScreen->preparePaintSetEnabled (this, false);
@@ -475,6 +565,10 @@ WaterScreen::donePaint ()
 	gScreen->glPaintCompositedOutputSetEnabled (this, false);
 	gScreen->glPaintCompositedOutputRequiredSetEnabled (this, false);
 	cScreen->donePaintSetEnabled (this, false);
+
+	/* Repaint the last rippled area without the effect */
+	waterDamage ();
+	tiles.clear ();
     }
 
     cScreen->donePaint ();
@@ -495,7 +589,7 @@ WaterScreen::handleMotionEvent ()
 
 	waterVertices (GL_LINES, p, 2, 0.2f);
 
-	cScreen->damageScreen ();
+	waterDamage ();
     }
 
 }
@@ -529,7 +623,7 @@ waterInitiate (CompAction         *action,
 
  	    ws->waterVertices (GL_POINTS, &p, 1, 1.0f);
 
-	    ws->cScreen->damageScreen ();
+	    ws->waterDamage ();
 	}
     }
 
@@ -635,7 +729,7 @@ waterTitleWave (CompAction         *action,
 
 	ws->waterVertices (GL_LINES, p, 2, 0.15f);
 
-	ws->cScreen->damageScreen ();
+	ws->waterDamage ();
     }
 
     return false;
@@ -660,7 +754,7 @@ waterPoint (CompAction         *action,
 
     ws->waterVertices (GL_POINTS, &p, 1, amp);
 
-    ws->cScreen->damageScreen ();
+    ws->waterDamage ();
 
     return false;
 }
@@ -690,7 +784,7 @@ waterLine (CompAction         *action,
 
     ws->waterVertices (GL_LINES, p, 2, amp);
 
-    ws->cScreen->damageScreen ();
+    ws->waterDamage ();
 
     return false;
 }
@@ -708,7 +802,7 @@ WaterScreen::handleEvent (XEvent *event)
 		p.y = pointerY;
 
 		waterVertices (GL_POINTS, &p, 1, 0.8f);
-		cScreen->damageScreen ();
+		waterDamage ();
 	    }
 	    break;
 	case EnterNotify:
@@ -773,6 +867,8 @@ WaterScreen::WaterScreen (CompScreen *screen) :
 
     count (0),
 
+    tiles (CompSize (screen->width (), screen->height ()), TILE_SIZE),
+
     data (NULL),
     d0 (NULL),
     d1 (NULL),
@@ -25,6 +25,7 @@
  */
 
 #include "water_options.h"
+#include <core/core.h>
 #include <core/screen.h>
 #include <core/pluginclasshandler.h>
 
@@ -32,6 +33,7 @@
 #include <opengl/opengl.h>
 #include <opengl/framebufferobject.h>
 #include "shaders.h"
+#include "water-tiles.h"
 
 
 #define WATER_SCREEN(s) \
@@ -41,6 +43,8 @@ extern const unsigned int TEXTURE_SIZE;
 
 extern const float K;
 
+extern const unsigned int TILE_SIZE;
+
 #define TEXTURE_NUM 3
 #define PROG_NUM 3
 
@@ -77,6 +81,9 @@ class WaterScreen :
 
 	void waterUpdate (float dt);
 	void waterVertices (GLenum type, XPoint *p, int n, float v);
+	void waterClear ();
+	void waterDamage ();
+	void waterTileVertices (GLVertexBuffer *vb);
 
 	bool rainTimeout ();
 	bool wiperTimeout ();
@@ -95,10 +102,6 @@ class WaterScreen :
 	GLProgram      *program[PROG_NUM];
 	GLVertexBuffer *vertexBuffer[PROG_NUM];
 
-	static GLfloat vertexData[18];
-
-	static GLfloat textureData[12];
-
 	GLFramebufferObject *waterFbo[TEXTURE_NUM];
 
 	GLFramebufferObject *oldFbo;
@@ -112,6 +115,8 @@ class WaterScreen :
 
 	int count;
 
+	compiz::water::TileGrid tiles;
+
 	void          *data;
 	float         *d0;
 	float         *d1;
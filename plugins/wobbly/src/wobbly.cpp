@@ -27,6 +27,8 @@
 
 #include "wobbly.h"
 
+#include <core/threadpool.h>
+
 COMPIZ_PLUGIN_20090315 (wobbly, WobblyPluginVTable)
 
 
@@ -1288,6 +1290,36 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
 	friction = optionGetFriction ();
 	springK  = optionGetSpringK ();
 
+	/* Stepping a model only touches that window's model, so do all
+	 * of them at once and handle the results below */
+	pendingSteps.clear ();
+	foreach (CompWindow *w, ::screen->windows ())
+	{
+	    WobblyWindow *ww = WobblyWindow::get (w);
+
+	    if (ww->wobblingMask & (WobblyInitialMask | WobblyVelocityMask))
+	    {
+		PendingStep step;
+
+		step.ww           = ww;
+		step.topLeft      = ww->model->topLeft;
+		step.bottomRight  = ww->model->bottomRight;
+		step.time         = (ww->wobblingMask &
+				     (unsigned) WobblyVelocityMask) ?
+				    msSinceLastPaint :
+				    cScreen->redrawTime ();
+		step.wobblingMask = 0;
+
+		pendingSteps.push_back (step);
+	    }
+	}
+
+	compiz::core::parallelFor (pendingSteps.size (),
+				   boost::bind (&WobblyScreen::stepModel, this,
+						_1, friction, springK));
+
+	std::vector<PendingStep>::iterator step = pendingSteps.begin ();
+
 	wobblingWindowsMask = false;
 	foreach (CompWindow *w, ::screen->windows ())
 	{
@@ -1299,15 +1331,28 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
 		{
 		    model = ww->model;
 
-		    topLeft     = model->topLeft;
-		    bottomRight = model->bottomRight;
+		    /* Windows that only started wobbling while the results
+		     * were being handled are stepped here */
+		    if (step != pendingSteps.end () && step->ww == ww)
+		    {
+			topLeft     = step->topLeft;
+			bottomRight = step->bottomRight;
 
-		    ww->wobblingMask =
-			ww->modelStep (friction, springK,
-				       (ww->wobblingMask &
-				        (unsigned) WobblyVelocityMask) ?
-				       msSinceLastPaint :
-				       cScreen->redrawTime ());
+			ww->wobblingMask = step->wobblingMask;
+			++step;
+		    }
+		    else
+		    {
+			topLeft     = model->topLeft;
+			bottomRight = model->bottomRight;
+
+			ww->wobblingMask =
+			    ww->modelStep (friction, springK,
+					   (ww->wobblingMask &
+					    (unsigned) WobblyVelocityMask) ?
+					   msSinceLastPaint :
+					   cScreen->redrawTime ());
+		    }
 
 		    if ((ww->state & MAXIMIZE_STATE) && ww->grabbed)
 			ww->wobblingMask |= WobblyForceMask;
@@ -1432,6 +1477,18 @@ WobblyScreen::preparePaint (int msSinceLastPaint)
     cScreen->preparePaint (msSinceLastPaint);
 }
 
+/* Runs on a worker thread, see compiz::core::ThreadPool for what is
+ * allowed in here */
+void
+WobblyScreen::stepModel (unsigned int i,
+			 float        friction,
+			 float        springK)
+{
+    PendingStep &step = pendingSteps[i];
+
+    step.wobblingMask = step.ww->modelStep (friction, springK, step.time);
+}
+
 void
 WobblyScreen::donePaint ()
 {
@@ -31,6 +31,8 @@
 #include <string.h>
 #include <math.h>
 
+#include <vector>
+
 #include <composite/composite.h>
 #include <opengl/opengl.h>
 
@@ -240,6 +242,20 @@ public:
 
     bool           yConstrained;
     const CompRect *constraintBox;
+
+    /// A model step to be run off the main thread, see preparePaint
+    struct PendingStep
+    {
+	WobblyWindow *ww;
+	Point        topLeft;
+	Point        bottomRight;
+	float        time;
+	unsigned int wobblingMask;
+    };
+
+    std::vector<PendingStep> pendingSteps;
+
+    void stepModel (unsigned int i, float friction, float springK);
 };
 
 class WobblyWindow :
@@ -560,20 +560,14 @@ WorkaroundsWindow::updateUrgencyState ()
 }
 
 /* Use this function to forcibly refresh java window properties when they
- * have been unmarked as transient. This is just a copy of
- * PrivateScreen::setWindowState. I would use CompWindow::changeState, but
- * it checks whether oldstate==newstate
+ * have been unmarked as transient. I would use CompWindow::changeState, but
+ * it checks whether oldstate==newstate. Goes through core so that the write
+ * is ordered with the ones core batches up for the same window.
  */
 void
 WorkaroundsScreen::setWindowState (unsigned int state, Window id)
 {
-    int i = 0;
-    Atom data[32];
-
-    i = compiz::window::fillStateData (state, data);
-    XChangeProperty (screen->dpy (), id, Atoms::winState,
-	             XA_ATOM, 32, PropModeReplace,
-	             (unsigned char *) data, i);
+    screen->setWindowState (state, id);
 }
 
 void
@@ -121,6 +121,7 @@ namespace Atoms {
     Atom wmSyncRequest;
 
     Atom wmSyncRequestCounter;
+    Atom wmFrameDrawn;
 
     Atom wmFullscreenMonitors;
 
@@ -289,6 +290,7 @@ namespace Atoms {
 
 	wmSyncRequestCounter =
 	    XInternAtom (dpy, "_NET_WM_SYNC_REQUEST_COUNTER", 0);
+	wmFrameDrawn = XInternAtom (dpy, "_NET_WM_FRAME_DRAWN", 0);
 
 	wmFullscreenMonitors =
 	    XInternAtom (dpy, "_NET_WM_FULLSCREEN_MONITORS", 0);
@@ -58,25 +58,76 @@ Window CompWindowToWindow (CompWindow *window)
 bool
 PrivateWindow::handleSyncAlarm ()
 {
-    if (priv->syncWait)
-    {
-	priv->syncWait = false;
+    /* Also how a client that never finishes its frame is given up on */
+    priv->syncFrozen = false;
 
-	if (window->resize (priv->syncGeometry))
-	{
-	    window->windowNotify (CompWindowNotifySyncAlarm);
-	}
-	else
-	{
-	    /* resizeWindow failing means that there is another pending
-	       resize and we must send a new sync request to the client */
-	    window->sendSyncRequest ();
-	}
+    endSyncWait ();
+
+    return false;
+}
+
+bool
+PrivateWindow::endSyncWait ()
+{
+    if (!syncWait)
+	return false;
+
+    syncWait = false;
+
+    if (window->resize (syncGeometry))
+    {
+	window->windowNotify (CompWindowNotifySyncAlarm);
+	return true;
     }
 
+    /* resizeWindow failing means that there is another pending
+       resize and we must send a new sync request to the client */
+    window->sendSyncRequest ();
+
     return false;
 }
 
+void
+PrivateWindow::handleSyncCounter (const XSyncValue &value)
+{
+    if (!syncExtended)
+    {
+	handleSyncAlarm ();
+	return;
+    }
+
+    syncValue = value;
+
+    /* The client started drawing a frame, hold on to what it draws
+     * until it is done */
+    if (XSyncValueLow32 (value) & 1)
+    {
+	syncFrozen = true;
+
+	if (!syncWaitTimer.active ())
+	    syncWaitTimer.start ();
+
+	return;
+    }
+
+    syncFrozen     = false;
+    syncFrameDrawn = true;
+
+    if (syncWait)
+    {
+	/* Only the frame for the size that was asked for ends the wait */
+	if (!XSyncValueLessThan (value, syncWaitValue) && endSyncWait ())
+	    return;
+    }
+    else
+    {
+	syncWaitTimer.stop ();
+    }
+
+    /* Every finished frame is reported as drawn, the client doesn't
+     * start on the next one before that */
+    window->windowNotify (CompWindowNotifySyncAlarm);
+}
 
 static bool
 autoRaiseTimeout (CompScreen *screen)
@@ -972,11 +1023,11 @@ PrivateScreen::handleActionEvent (XEvent *event)
 	bool handled = false;
 
 	nextKeyPressIsRepeated_ = false;
-	if (XEventsQueued (dpy, QueuedAfterReading))
-	{
-	    XEvent nev;
-	    XPeekEvent (dpy, &nev);
 
+	XEvent nev;
+
+	if (peekNextEvent (nev))
+	{
 	    if (nev.type == KeyPress && nev.xkey.time == event->xkey.time &&
 		nev.xkey.keycode == event->xkey.keycode)
 	    {
@@ -1305,6 +1356,12 @@ CompScreenImpl::alwaysHandleEvent (XEvent *event)
     }
 }
 
+compiz::core::EventCoalescer &
+CompScreenImpl::eventCoalescer ()
+{
+    return privateScreen.eventCoalescer;
+}
+
 ServerGrabInterface *
 CompScreenImpl::serverGrabInterface ()
 {
@@ -1813,7 +1870,16 @@ CompScreenImpl::_handleEvent (XEvent *event)
 	{
 	    w = findWindow (event->xproperty.window);
 	    if (w)
+	    {
+		/* only fetch the new icon early if the old one was used */
+		bool used = !w->priv->iconImages.empty () ||
+			    w->priv->icons.size ();
+
 		w->priv->freeIcons ();
+
+		if (used)
+		    w->priv->prefetchIcons ();
+	    }
 	}
 	else if (event->xproperty.atom == Atoms::startupId)
 	{
@@ -2464,7 +2530,7 @@ static const unsigned short _NET_WM_STATE_TOGGLE = 2;
 		CompWindow* const w(*i);
 		if (w->priv->syncAlarm == sa->alarm)
 		{
-		    w->priv->handleSyncAlarm ();
+		    w->priv->handleSyncCounter (sa->counter_value);
 		    break;
 		}
 	    }
@@ -0,0 +1,186 @@
+/*
+ * Compiz, coalescing of redundant events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_EVENTCOALESCER_H
+#define _COMPIZ_EVENTCOALESCER_H
+
+#include <X11/Xlib.h>
+
+#include <boost/function.hpp>
+
+namespace compiz
+{
+namespace core
+{
+
+class PrivateEventCoalescer;
+
+/**
+ * Drains the events already queued and collapses the redundant ones
+ * before they are handled.
+ *
+ * Only event types with a rule are collapsed. A rule gives the key
+ * of an event (the window, drawable or damage object it is about) and
+ * folds a newer event into an older one with the same key. The folded
+ * event is handled in place of the newer one, the older one is not
+ * handled at all.
+ *
+ * Events are never collapsed across an event without a rule, so the
+ * order of everything else (input, mapping, properties ...) relative
+ * to them is kept. Rules for events whose order matters across keys
+ * as well (restacking) keep them from being collapsed across an event
+ * of the same type with another key.
+ */
+class EventCoalescer
+{
+    public:
+
+	/**
+	 * Fetches the next queued event, false once there are none
+	 */
+	typedef boost::function <bool (XEvent &)> Source;
+
+	/**
+	 * Sees an event before it is thrown away
+	 */
+	typedef boost::function <void (const XEvent &)> Discarded;
+
+	/**
+	 * What an event is about. Only events of the same type and key
+	 * are offered to the merge function.
+	 */
+	typedef boost::function <XID (const XEvent &)> Key;
+
+	/**
+	 * Folds next into pending. Returns false, leaving pending alone,
+	 * if the two can't be collapsed.
+	 */
+	typedef boost::function <bool (XEvent &, const XEvent &)> Merge;
+
+	/**
+	 * Whether events of a type with different keys may be reordered
+	 * relative to each other by collapsing them
+	 */
+	enum Ordering
+	{
+	    IndependentKeys,
+	    OrderedAcrossKeys
+	};
+
+	struct Counters
+	{
+	    Counters ();
+
+	    unsigned int received;
+	    unsigned int coalesced;
+	};
+
+	EventCoalescer ();
+	~EventCoalescer ();
+
+	/**
+	 * Collapses events of type with key and merge, replacing any
+	 * previous rule for it
+	 */
+	void addRule (int          type,
+		      const Key   &key,
+		      const Merge &merge,
+		      Ordering     ordering = IndependentKeys);
+	void removeRule (int type);
+
+	/**
+	 * Keeps events of type from being collapsed, for plugins which
+	 * need every one of them. Counted, each inhibit () needs a
+	 * matching uninhibit ().
+	 */
+	void inhibit (int type);
+	void uninhibit (int type);
+	bool inhibited (int type) const;
+
+	/**
+	 * Drains source, collapsing as it goes
+	 */
+	void fill (const Source &source);
+
+	/**
+	 * Takes the next event to handle, false once none are left
+	 */
+	bool next (XEvent &event);
+
+	/**
+	 * The event next () would return, without taking it
+	 */
+	bool peek (XEvent &event) const;
+
+	/**
+	 * Throws away the events not handled yet which eventMask
+	 * selects, like XCheckMaskEvent does for the events still
+	 * queued in Xlib, passing each to discarded first. Only input,
+	 * crossing, focus, exposure and property events can be selected.
+	 */
+	void discard (long eventMask, const Discarded &discarded);
+
+	bool empty () const;
+
+	/**
+	 * Events drained and events collapsed into others, in total and
+	 * for one type
+	 */
+	const Counters & counters () const;
+	unsigned int coalesced (int type) const;
+	void resetCounters ();
+
+    private:
+
+	EventCoalescer (const EventCoalescer &);
+	EventCoalescer & operator= (const EventCoalescer &);
+
+	PrivateEventCoalescer *priv;
+};
+
+/**
+ * Rules for core events
+ */
+namespace coalesce
+{
+/**
+ * MotionNotify: the window, collapsed if nothing but the pointer
+ * position changed, the newest position wins
+ */
+XID motionKey (const XEvent &event);
+bool mergeMotion (XEvent &pending, const XEvent &next);
+
+/**
+ * ConfigureNotify: the window, collapsed if reported to the same
+ * window, the newest geometry and stacking wins. The sibling a
+ * window is stacked above depends on the ConfigureNotify events
+ * for other windows before it, so add this rule with
+ * OrderedAcrossKeys.
+ */
+XID configureKey (const XEvent &event);
+bool mergeConfigure (XEvent &pending, const XEvent &next);
+}
+
+}
+}
+
+#endif
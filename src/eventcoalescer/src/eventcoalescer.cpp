@@ -0,0 +1,372 @@
+/*
+ * Compiz, coalescing of redundant events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "privateeventcoalescer.h"
+
+namespace cc = compiz::core;
+
+namespace
+{
+    /* Whether eventMask selects events of type */
+    bool
+    selects (long eventMask,
+	     int  type)
+    {
+	switch (type)
+	{
+	    case KeyPress:
+		return eventMask & KeyPressMask;
+	    case KeyRelease:
+		return eventMask & KeyReleaseMask;
+	    case ButtonPress:
+		return eventMask & ButtonPressMask;
+	    case ButtonRelease:
+		return eventMask & ButtonReleaseMask;
+	    case MotionNotify:
+		return eventMask & (PointerMotionMask |
+				    PointerMotionHintMask |
+				    ButtonMotionMask |
+				    Button1MotionMask |
+				    Button2MotionMask |
+				    Button3MotionMask |
+				    Button4MotionMask |
+				    Button5MotionMask);
+	    case EnterNotify:
+		return eventMask & EnterWindowMask;
+	    case LeaveNotify:
+		return eventMask & LeaveWindowMask;
+	    case FocusIn:
+	    case FocusOut:
+		return eventMask & FocusChangeMask;
+	    case Expose:
+		return eventMask & ExposureMask;
+	    case PropertyNotify:
+		return eventMask & PropertyChangeMask;
+	    default:
+		return false;
+	}
+    }
+}
+
+cc::EventCoalescer::Counters::Counters () :
+    received (0),
+    coalesced (0)
+{
+}
+
+cc::CoalescingRule::CoalescingRule () :
+    ordered (false),
+    inhibitions (0),
+    coalesced (0)
+{
+}
+
+cc::PrivateEventCoalescer::PrivateEventCoalescer () :
+    read (0)
+{
+}
+
+cc::CoalescingRule *
+cc::PrivateEventCoalescer::activeRule (int type)
+{
+    RuleMap::iterator it = rules.find (type);
+
+    if (it == rules.end () ||
+	it->second.inhibitions ||
+	!it->second.key ||
+	!it->second.merge)
+	return NULL;
+
+    return &it->second;
+}
+
+void
+cc::PrivateEventCoalescer::orderAfter (int type,
+				       XID key)
+{
+    LatestMap::iterator it = latest.lower_bound (Key (type, 0));
+
+    while (it != latest.end () && it->first.first == type)
+    {
+	if (it->first.second != key)
+	    latest.erase (it++);
+	else
+	    ++it;
+    }
+}
+
+size_t
+cc::PrivateEventCoalescer::skipDead () const
+{
+    size_t i = read;
+
+    while (i < queue.size () && !queue[i].live)
+	++i;
+
+    return i;
+}
+
+cc::EventCoalescer::EventCoalescer () :
+    priv (new PrivateEventCoalescer ())
+{
+}
+
+cc::EventCoalescer::~EventCoalescer ()
+{
+    delete priv;
+}
+
+void
+cc::EventCoalescer::addRule (int          type,
+			     const Key   &key,
+			     const Merge &merge,
+			     Ordering     ordering)
+{
+    CoalescingRule &rule = priv->rules[type];
+
+    rule.key     = key;
+    rule.merge   = merge;
+    rule.ordered = ordering == OrderedAcrossKeys;
+}
+
+void
+cc::EventCoalescer::removeRule (int type)
+{
+    PrivateEventCoalescer::RuleMap::iterator it = priv->rules.find (type);
+
+    if (it == priv->rules.end ())
+	return;
+
+    /* Keep the inhibitions and the counter around, the rule may
+     * come back */
+    it->second.key.clear ();
+    it->second.merge.clear ();
+}
+
+void
+cc::EventCoalescer::inhibit (int type)
+{
+    priv->rules[type].inhibitions++;
+}
+
+void
+cc::EventCoalescer::uninhibit (int type)
+{
+    PrivateEventCoalescer::RuleMap::iterator it = priv->rules.find (type);
+
+    if (it != priv->rules.end () && it->second.inhibitions)
+	it->second.inhibitions--;
+}
+
+bool
+cc::EventCoalescer::inhibited (int type) const
+{
+    PrivateEventCoalescer::RuleMap::const_iterator it = priv->rules.find (type);
+
+    return it != priv->rules.end () && it->second.inhibitions;
+}
+
+void
+cc::EventCoalescer::fill (const Source &source)
+{
+    if (priv->skipDead () == priv->queue.size ())
+    {
+	priv->queue.clear ();
+	priv->read = 0;
+    }
+
+    /* Events left over from the last fill were already ordered
+     * against what came before them, leave them be */
+    priv->latest.clear ();
+
+    QueuedEvent queued;
+
+    queued.live = true;
+
+    while (source (queued.event))
+    {
+	priv->counters.received++;
+
+	CoalescingRule *rule = priv->activeRule (queued.event.type);
+
+	if (!rule)
+	{
+	    /* Nothing may be moved past this one */
+	    priv->latest.clear ();
+	    priv->queue.push_back (queued);
+	    continue;
+	}
+
+	PrivateEventCoalescer::Key key (queued.event.type,
+					rule->key (queued.event));
+
+	if (rule->ordered)
+	    priv->orderAfter (key.first, key.second);
+
+	PrivateEventCoalescer::LatestMap::iterator it = priv->latest.find (key);
+
+	if (it != priv->latest.end ())
+	{
+	    QueuedEvent &older  = priv->queue[it->second];
+	    XEvent      merged  = older.event;
+
+	    if (rule->merge (merged, queued.event))
+	    {
+		/* Handle the folded event where the newest one was */
+		older.live   = false;
+		queued.event = merged;
+
+		priv->counters.coalesced++;
+		rule->coalesced++;
+	    }
+	}
+
+	priv->latest[key] = priv->queue.size ();
+	priv->queue.push_back (queued);
+    }
+}
+
+bool
+cc::EventCoalescer::next (XEvent &event)
+{
+    size_t i = priv->skipDead ();
+
+    if (i == priv->queue.size ())
+    {
+	priv->queue.clear ();
+	priv->latest.clear ();
+	priv->read = 0;
+	return false;
+    }
+
+    event      = priv->queue[i].event;
+    priv->read = i + 1;
+
+    return true;
+}
+
+bool
+cc::EventCoalescer::peek (XEvent &event) const
+{
+    size_t i = priv->skipDead ();
+
+    if (i == priv->queue.size ())
+	return false;
+
+    event = priv->queue[i].event;
+
+    return true;
+}
+
+void
+cc::EventCoalescer::discard (long             eventMask,
+			     const Discarded &discarded)
+{
+    for (size_t i = priv->skipDead (); i < priv->queue.size (); ++i)
+    {
+	QueuedEvent &queued = priv->queue[i];
+
+	if (!queued.live || !selects (eventMask, queued.event.type))
+	    continue;
+
+	if (discarded)
+	    discarded (queued.event);
+
+	queued.live = false;
+    }
+}
+
+bool
+cc::EventCoalescer::empty () const
+{
+    return priv->skipDead () == priv->queue.size ();
+}
+
+const cc::EventCoalescer::Counters &
+cc::EventCoalescer::counters () const
+{
+    return priv->counters;
+}
+
+unsigned int
+cc::EventCoalescer::coalesced (int type) const
+{
+    PrivateEventCoalescer::RuleMap::const_iterator it = priv->rules.find (type);
+
+    return it != priv->rules.end () ? it->second.coalesced : 0;
+}
+
+void
+cc::EventCoalescer::resetCounters ()
+{
+    priv->counters = Counters ();
+
+    for (PrivateEventCoalescer::RuleMap::iterator it = priv->rules.begin ();
+	 it != priv->rules.end (); ++it)
+	it->second.coalesced = 0;
+}
+
+XID
+cc::coalesce::motionKey (const XEvent &event)
+{
+    return event.xmotion.window;
+}
+
+bool
+cc::coalesce::mergeMotion (XEvent       &pending,
+			   const XEvent &next)
+{
+    const XMotionEvent &p = pending.xmotion;
+    const XMotionEvent &n = next.xmotion;
+
+    /* Button and modifier changes, or the pointer moving to another
+     * child or screen, are not just motion */
+    if (p.root != n.root               ||
+	p.subwindow != n.subwindow     ||
+	p.state != n.state             ||
+	p.is_hint != n.is_hint         ||
+	p.same_screen != n.same_screen)
+	return false;
+
+    pending = next;
+
+    return true;
+}
+
+XID
+cc::coalesce::configureKey (const XEvent &event)
+{
+    return event.xconfigure.window;
+}
+
+bool
+cc::coalesce::mergeConfigure (XEvent       &pending,
+			      const XEvent &next)
+{
+    /* The same window may be reported to itself and to its parent */
+    if (pending.xconfigure.event != next.xconfigure.event)
+	return false;
+
+    pending = next;
+
+    return true;
+}
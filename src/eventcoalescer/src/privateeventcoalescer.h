@@ -0,0 +1,88 @@
+/*
+ * Compiz, coalescing of redundant events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PRIVATEEVENTCOALESCER_H
+#define _COMPIZ_PRIVATEEVENTCOALESCER_H
+
+#include <map>
+#include <vector>
+#include <utility>
+
+#include "core/eventcoalescer.h"
+
+namespace compiz
+{
+namespace core
+{
+
+struct CoalescingRule
+{
+    CoalescingRule ();
+
+    EventCoalescer::Key   key;
+    EventCoalescer::Merge merge;
+    bool                  ordered;
+    unsigned int          inhibitions;
+    unsigned int          coalesced;
+};
+
+struct QueuedEvent
+{
+    XEvent event;
+    bool   live;
+};
+
+class PrivateEventCoalescer
+{
+    public:
+
+	typedef std::map<int, CoalescingRule> RuleMap;
+	typedef std::pair<int, XID> Key;
+	typedef std::map<Key, size_t> LatestMap;
+
+	PrivateEventCoalescer ();
+
+	/* Rule for type, if events of it may be collapsed right now */
+	CoalescingRule * activeRule (int type);
+
+	/* Forget the newest events of type for keys other than key,
+	 * nothing may be moved past the event with key */
+	void orderAfter (int type, XID key);
+
+	/* Index of the next live event at or after read */
+	size_t skipDead () const;
+
+	RuleMap                  rules;
+	std::vector<QueuedEvent> queue;
+	size_t                   read;
+
+	/* Newest event of a type and key since the last event that
+	 * can't be collapsed */
+	LatestMap                latest;
+
+	EventCoalescer::Counters counters;
+};
+
+}
+}
+
+#endif
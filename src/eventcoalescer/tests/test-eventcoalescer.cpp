@@ -0,0 +1,416 @@
+/*
+ * Compiz, coalescing of redundant events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <core/eventcoalescer.h>
+
+namespace cc = compiz::core;
+
+namespace
+{
+const Window ROOT = 1;
+const Window CLIENT = 2;
+const Window OTHER = 3;
+
+/* An extension event, like DamageNotify */
+const int    AreaNotify = LASTEvent + 1;
+
+class FakeQueue
+{
+    public:
+
+	bool
+	next (XEvent &event)
+	{
+	    if (events.empty ())
+		return false;
+
+	    event = events.front ();
+	    events.pop_front ();
+
+	    return true;
+	}
+
+	void
+	motion (Window window, int x, int y, unsigned int state = 0)
+	{
+	    XEvent event = XEvent ();
+
+	    event.type             = MotionNotify;
+	    event.xmotion.window   = window;
+	    event.xmotion.root     = ROOT;
+	    event.xmotion.x_root   = x;
+	    event.xmotion.y_root   = y;
+	    event.xmotion.state    = state;
+	    events.push_back (event);
+	}
+
+	void
+	configure (Window event, Window window, int width, Window above = None)
+	{
+	    XEvent e = XEvent ();
+
+	    e.type               = ConfigureNotify;
+	    e.xconfigure.event   = event;
+	    e.xconfigure.window  = window;
+	    e.xconfigure.width   = width;
+	    e.xconfigure.above   = above;
+	    events.push_back (e);
+	}
+
+	void
+	area (Window window, int x, int width)
+	{
+	    XEvent event = XEvent ();
+
+	    event.type                 = AreaNotify;
+	    event.xexpose.window       = window;
+	    event.xexpose.x            = x;
+	    event.xexpose.width        = width;
+	    events.push_back (event);
+	}
+
+	void
+	other (int type, Window window)
+	{
+	    XEvent event = XEvent ();
+
+	    event.type        = type;
+	    event.xany.window = window;
+	    events.push_back (event);
+	}
+
+	std::deque<XEvent> events;
+};
+
+XID
+areaKey (const XEvent &event)
+{
+    return event.xexpose.window;
+}
+
+/* Grows pending to cover both areas */
+bool
+mergeArea (XEvent &pending, const XEvent &next)
+{
+    int x1 = std::min (pending.xexpose.x, next.xexpose.x);
+    int x2 = std::max (pending.xexpose.x + pending.xexpose.width,
+		       next.xexpose.x + next.xexpose.width);
+
+    pending.xexpose.x     = x1;
+    pending.xexpose.width = x2 - x1;
+
+    return true;
+}
+}
+
+class EventCoalescer :
+    public ::testing::Test
+{
+    public:
+
+	EventCoalescer ()
+	{
+	    coalescer.addRule (MotionNotify,
+			       cc::coalesce::motionKey,
+			       cc::coalesce::mergeMotion);
+	    coalescer.addRule (ConfigureNotify,
+			       cc::coalesce::configureKey,
+			       cc::coalesce::mergeConfigure,
+			       cc::EventCoalescer::OrderedAcrossKeys);
+	}
+
+	void
+	fill ()
+	{
+	    coalescer.fill (boost::bind (&FakeQueue::next, &queue, _1));
+	}
+
+	std::vector<XEvent>
+	drain ()
+	{
+	    std::vector<XEvent> events;
+	    XEvent              event;
+
+	    while (coalescer.next (event))
+		events.push_back (event);
+
+	    return events;
+	}
+
+	FakeQueue         queue;
+	cc::EventCoalescer coalescer;
+};
+
+TEST_F (EventCoalescer, HandsBackEventsWithoutRulesInOrder)
+{
+    queue.other (PropertyNotify, CLIENT);
+    queue.other (MapNotify, CLIENT);
+    queue.other (PropertyNotify, OTHER);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (3, events.size ());
+    EXPECT_EQ (PropertyNotify, events[0].type);
+    EXPECT_EQ (MapNotify, events[1].type);
+    EXPECT_EQ (OTHER, events[2].xany.window);
+    EXPECT_EQ (0, coalescer.counters ().coalesced);
+    EXPECT_EQ (3, coalescer.counters ().received);
+}
+
+TEST_F (EventCoalescer, KeepsOnlyTheNewestMotion)
+{
+    queue.motion (CLIENT, 1, 1);
+    queue.motion (CLIENT, 2, 2);
+    queue.motion (CLIENT, 3, 3);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (1, events.size ());
+    EXPECT_EQ (3, events[0].xmotion.x_root);
+    EXPECT_EQ (2, coalescer.counters ().coalesced);
+    EXPECT_EQ (2, coalescer.coalesced (MotionNotify));
+}
+
+TEST_F (EventCoalescer, KeepsMotionOnOtherWindowsAndWithOtherButtons)
+{
+    queue.motion (CLIENT, 1, 1);
+    queue.motion (OTHER, 2, 2);
+    queue.motion (CLIENT, 3, 3, Button1Mask);
+    fill ();
+
+    EXPECT_EQ (3, drain ().size ());
+    EXPECT_EQ (0, coalescer.counters ().coalesced);
+}
+
+TEST_F (EventCoalescer, CollapsesInterleavedEventsWithRules)
+{
+    queue.motion (CLIENT, 1, 1);
+    queue.configure (ROOT, CLIENT, 10);
+    queue.motion (CLIENT, 2, 2);
+    queue.configure (ROOT, CLIENT, 20);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (2, events.size ());
+    EXPECT_EQ (2, events[0].xmotion.x_root);
+    EXPECT_EQ (20, events[1].xconfigure.width);
+}
+
+TEST_F (EventCoalescer, NeverMovesEventsPastOnesWithoutRules)
+{
+    queue.configure (ROOT, CLIENT, 10);
+    queue.other (MapNotify, CLIENT);
+    queue.configure (ROOT, CLIENT, 20);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (3, events.size ());
+    EXPECT_EQ (10, events[0].xconfigure.width);
+    EXPECT_EQ (MapNotify, events[1].type);
+    EXPECT_EQ (20, events[2].xconfigure.width);
+}
+
+TEST_F (EventCoalescer, KeepsConfiguresReportedToDifferentWindows)
+{
+    queue.configure (CLIENT, CLIENT, 10);
+    queue.configure (ROOT, CLIENT, 10);
+    fill ();
+
+    EXPECT_EQ (2, drain ().size ());
+}
+
+TEST_F (EventCoalescer, KeepsConfiguresInOrderAcrossWindows)
+{
+    /* Restacking CLIENT above ROOT, OTHER above CLIENT and CLIENT
+     * above OTHER again only ends up with CLIENT on top if all three
+     * are handled in order */
+    queue.configure (ROOT, CLIENT, 10, ROOT);
+    queue.configure (ROOT, OTHER, 10, CLIENT);
+    queue.configure (ROOT, CLIENT, 10, OTHER);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (3, events.size ());
+    EXPECT_EQ (CLIENT, events[0].xconfigure.window);
+    EXPECT_EQ (ROOT, events[0].xconfigure.above);
+    EXPECT_EQ (OTHER, events[1].xconfigure.window);
+    EXPECT_EQ (CLIENT, events[2].xconfigure.window);
+    EXPECT_EQ (OTHER, events[2].xconfigure.above);
+    EXPECT_EQ (0, coalescer.counters ().coalesced);
+}
+
+TEST_F (EventCoalescer, CollapsesConfiguresForOneWindowBetweenOthers)
+{
+    queue.configure (ROOT, CLIENT, 10);
+    queue.configure (ROOT, OTHER, 10);
+    queue.configure (ROOT, OTHER, 20);
+    queue.configure (ROOT, CLIENT, 30);
+    queue.configure (ROOT, CLIENT, 40);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (3, events.size ());
+    EXPECT_EQ (10, events[0].xconfigure.width);
+    EXPECT_EQ (20, events[1].xconfigure.width);
+    EXPECT_EQ (40, events[2].xconfigure.width);
+    EXPECT_EQ (2, coalescer.counters ().coalesced);
+}
+
+TEST_F (EventCoalescer, InhibitedTypesAreNotCollapsed)
+{
+    coalescer.inhibit (MotionNotify);
+    coalescer.inhibit (MotionNotify);
+    coalescer.uninhibit (MotionNotify);
+
+    queue.motion (CLIENT, 1, 1);
+    queue.motion (CLIENT, 2, 2);
+    fill ();
+
+    EXPECT_TRUE (coalescer.inhibited (MotionNotify));
+    EXPECT_EQ (2, drain ().size ());
+
+    coalescer.uninhibit (MotionNotify);
+
+    queue.motion (CLIENT, 1, 1);
+    queue.motion (CLIENT, 2, 2);
+    fill ();
+
+    EXPECT_FALSE (coalescer.inhibited (MotionNotify));
+    EXPECT_EQ (1, drain ().size ());
+}
+
+TEST_F (EventCoalescer, RulesForExtensionEventsCanMergeThem)
+{
+    coalescer.addRule (AreaNotify, areaKey, mergeArea);
+
+    queue.area (CLIENT, 10, 10);
+    queue.area (CLIENT, 40, 10);
+    queue.area (OTHER, 0, 5);
+    fill ();
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (2, events.size ());
+    EXPECT_EQ (CLIENT, events[0].xexpose.window);
+    EXPECT_EQ (10, events[0].xexpose.x);
+    EXPECT_EQ (40, events[0].xexpose.width);
+
+    coalescer.removeRule (AreaNotify);
+
+    queue.area (CLIENT, 10, 10);
+    queue.area (CLIENT, 40, 10);
+    fill ();
+
+    EXPECT_EQ (2, drain ().size ());
+    EXPECT_EQ (1, coalescer.coalesced (AreaNotify));
+}
+
+TEST_F (EventCoalescer, PeekShowsTheNextEventWithoutTakingIt)
+{
+    XEvent event;
+
+    EXPECT_TRUE (coalescer.empty ());
+    EXPECT_FALSE (coalescer.peek (event));
+
+    queue.other (KeyPress, CLIENT);
+    queue.other (KeyRelease, CLIENT);
+    fill ();
+
+    ASSERT_TRUE (coalescer.next (event));
+    ASSERT_TRUE (coalescer.peek (event));
+    EXPECT_EQ (KeyRelease, event.type);
+    EXPECT_FALSE (coalescer.empty ());
+
+    ASSERT_TRUE (coalescer.next (event));
+    EXPECT_EQ (KeyRelease, event.type);
+    EXPECT_TRUE (coalescer.empty ());
+}
+
+namespace
+{
+void
+collect (const XEvent &event, std::vector<XEvent> &events)
+{
+    events.push_back (event);
+}
+}
+
+TEST_F (EventCoalescer, DiscardDropsSelectedEventsNotHandledYet)
+{
+    XEvent              event;
+    std::vector<XEvent> discarded;
+
+    queue.motion (CLIENT, 1, 1);
+    queue.other (EnterNotify, OTHER);
+    queue.other (MapNotify, CLIENT);
+    queue.motion (CLIENT, 2, 2);
+    queue.other (LeaveNotify, OTHER);
+    queue.other (KeyPress, CLIENT);
+    fill ();
+
+    /* Already handled, not discarded again */
+    ASSERT_TRUE (coalescer.next (event));
+
+    coalescer.discard (EnterWindowMask | LeaveWindowMask | PointerMotionMask,
+		       boost::bind (collect, _1, boost::ref (discarded)));
+
+    ASSERT_EQ (3, discarded.size ());
+    EXPECT_EQ (EnterNotify, discarded[0].type);
+    EXPECT_EQ (OTHER, discarded[0].xany.window);
+    EXPECT_EQ (MotionNotify, discarded[1].type);
+    EXPECT_EQ (LeaveNotify, discarded[2].type);
+
+    std::vector<XEvent> events = drain ();
+
+    ASSERT_EQ (2, events.size ());
+    EXPECT_EQ (MapNotify, events[0].type);
+    EXPECT_EQ (KeyPress, events[1].type);
+}
+
+TEST_F (EventCoalescer, ResetCountersStartsOver)
+{
+    queue.motion (CLIENT, 1, 1);
+    queue.motion (CLIENT, 2, 2);
+    fill ();
+    drain ();
+
+    coalescer.resetCounters ();
+
+    EXPECT_EQ (0, coalescer.counters ().received);
+    EXPECT_EQ (0, coalescer.counters ().coalesced);
+    EXPECT_EQ (0, coalescer.coalesced (MotionNotify));
+}
@@ -376,6 +376,18 @@ CompOption::Class::getOption (const CompString &name)
     return o;
 }
 
+bool
+CompOption::Class::setOptions (CompOption::Vector &options)
+{
+    bool changed = false;
+
+    foreach (CompOption &o, options)
+	if (setOption (o.name (), o.value ()))
+	    changed = true;
+
+    return changed;
+}
+
 CompOption *
 CompOption::findOption (CompOption::Vector &options,
 			CompString         name,
@@ -64,6 +64,8 @@ class CorePluginVTable : public CompPlugin::VTable
 
 	bool setOption (const CompString  &name,
 			CompOption::Value &value);
+
+	bool setOptions (CompOption::Vector &options);
 };
 
 COMPIZ_PLUGIN_20090315 (core, CorePluginVTable)
@@ -107,6 +109,12 @@ CorePluginVTable::setOption (const CompString  &name,
     return screen->setOption (name, value);
 }
 
+bool
+CorePluginVTable::setOptions (CompOption::Vector &options)
+{
+    return screen->setOptions (options);
+}
+
 static bool
 cloaderLoadPlugin (CompPlugin *p,
 		   const char *path,
@@ -646,6 +654,18 @@ CompPlugin::VTable::setOption (const CompString  &name,
     return false;
 }
 
+bool
+CompPlugin::VTable::setOptions (CompOption::Vector &options)
+{
+    bool changed = false;
+
+    foreach (CompOption &o, options)
+	if (setOption (o.name (), o.value ()))
+	    changed = true;
+
+    return changed;
+}
+
 CompAction::Vector &
 CompPlugin::VTable::getActions ()
 {
@@ -29,6 +29,7 @@
 #define _PLUGINCLASSES_H
 
 #include <vector>
+#include <cstddef>
 
 /**
  * Represents the index of a plugin's object classes
@@ -67,4 +68,65 @@ class PluginClassStorage {
 	static void freePluginClassIndex (Indices& iList, unsigned int idx);
 };
 
+/**
+ * Hands out storage for the instances of one plugin class. Instances
+ * are carved out of blocks which grow as more base objects take the
+ * plugin class, so the instances attached to many windows sit next
+ * to each other in memory and only each block is a trip to the heap.
+ * A block is given back as a whole once nothing lives in it.
+ */
+class PluginClassAllocator {
+
+    public:
+
+	class Counters {
+	    public:
+		Counters () : allocations (0), deallocations (0),
+			      blockAllocations (0), blockDeallocations (0) {}
+
+		unsigned long allocations;
+		unsigned long deallocations;
+		unsigned long blockAllocations;
+		unsigned long blockDeallocations;
+	};
+
+    public:
+	PluginClassAllocator ();
+	~PluginClassAllocator ();
+
+	/**
+	 * Returns storage for an object of size bytes, or NULL. All
+	 * objects handed out by one allocator must be the same size
+	 */
+	void * allocate (size_t size);
+
+	/**
+	 * Frees ptr, which may have come from another allocator for
+	 * the same plugin class. It is given back to that one.
+	 */
+	void deallocate (void *ptr);
+
+	const Counters & counters () const { return mCounters; }
+
+	/**
+	 * Counters summed up over every plugin class allocator
+	 */
+	static const Counters & totalCounters ();
+
+    private:
+	struct Block;
+
+	Block * newBlock ();
+	void link (Block *&list, Block *block);
+	void unlink (Block *&list, Block *block);
+
+	size_t       mSlotSize;
+	unsigned int mMaxSlotsPerBlock;
+	unsigned int mNBlocks;
+	Block        *mAvailable;
+	Block        *mFull;
+	Block        *mSpare;
+	Counters     mCounters;
+};
+
 #endif
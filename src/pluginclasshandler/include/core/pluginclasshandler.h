@@ -27,6 +27,7 @@
 #define _COMPPLUGINCLASSHANDLER_H
 
 #include <typeinfo>
+#include <new>
 #include <boost/preprocessor/cat.hpp>
 
 #include <core/string.h>
@@ -112,6 +113,13 @@ class PluginClassHandler
 	static Tp * get (Tb *);
 	static const Tp * get (const Tb *);
 
+	/**
+	 * Instances of the plugin class come out of a slab shared
+	 * by all base objects, see PluginClassAllocator
+	 */
+	static void * operator new (size_t size);
+	static void operator delete (void *ptr, size_t size);
+
     private:
 	/**
 	 * Returns the unique string identifying this plugin type with it's
@@ -141,8 +149,9 @@ class PluginClassHandler
 	bool mFailed;
 	Tb   *mBase;
 
-	static PluginClassIndex mIndex;
-	static bool             mPluginLoaded;
+	static PluginClassIndex     mIndex;
+	static bool                 mPluginLoaded;
+	static PluginClassAllocator mAllocator;
 };
 
 namespace compiz
@@ -174,6 +183,9 @@ PluginClassIndex PluginClassHandler<Tp,Tb,ABI>::mIndex;
 template<class Tp, class Tb, int ABI>
 bool PluginClassHandler<Tp,Tb,ABI>::mPluginLoaded = false;
 
+template<class Tp, class Tb, int ABI>
+PluginClassAllocator PluginClassHandler<Tp,Tb,ABI>::mAllocator;
+
 /**
  * Attaches a unique instance of the specified plugin class to a
  * unique instance of a specified base class
@@ -316,6 +328,33 @@ PluginClassHandler<Tp,Tb,ABI>::getInstance (Tb *base)
     }
 }
 
+template<class Tp, class Tb, int ABI>
+void *
+PluginClassHandler<Tp,Tb,ABI>::operator new (size_t size)
+{
+    /* Anything derived from the plugin class doesn't fit in
+     * its slots and comes from the heap as usual */
+    if (size != sizeof (Tp))
+	return ::operator new (size);
+
+    void *ptr = mAllocator.allocate (size);
+
+    if (!ptr)
+	throw std::bad_alloc ();
+
+    return ptr;
+}
+
+template<class Tp, class Tb, int ABI>
+void
+PluginClassHandler<Tp,Tb,ABI>::operator delete (void *ptr, size_t size)
+{
+    if (size != sizeof (Tp))
+	::operator delete (ptr);
+    else
+	mAllocator.deallocate (ptr);
+}
+
 template<class Tp, class Tb, int ABI>
 const Tp *
 PluginClassHandler<Tp,Tb,ABI>::get (const Tb *base)
@@ -25,8 +25,50 @@
  *          David Reveman <davidr@novell.com>
  */
 
+#include <cstdlib>
+
 #include <core/pluginclasses.h>
 
+namespace
+{
+    /* Enough for anything malloc would have to align for */
+    const size_t Alignment = 2 * sizeof (void *);
+    const size_t MaxBlockSize = 32 * 1024;
+
+    PluginClassAllocator::Counters totals;
+
+    inline size_t
+    alignedSize (size_t size)
+    {
+	return (size + Alignment - 1) & ~(Alignment - 1);
+    }
+}
+
+/* Each slot starts with a pointer back to its block, followed by the
+ * object. Free slots keep the next free slot of their block where the
+ * object would be.
+ *
+ * Every plugin which uses a plugin class may end up with its own copy
+ * of the allocator, so an object can be freed through another copy
+ * than the one it came from. Blocks know which allocator they belong
+ * to and are always given back to that one. */
+struct PluginClassAllocator::Block
+{
+    PluginClassAllocator *owner;
+    Block        *prev;
+    Block        *next;
+    char         *freeSlots;
+    unsigned int nSlots;
+    unsigned int nUsed;
+    unsigned int nCarved;
+
+    char * slot (unsigned int i, size_t slotSize)
+    {
+	return reinterpret_cast<char *> (this) +
+	       alignedSize (sizeof (Block)) + i * slotSize;
+    }
+};
+
 PluginClassStorage::PluginClassStorage (PluginClassStorage::Indices& iList) :
     pluginClasses (0)
 {
@@ -72,3 +114,221 @@ PluginClassStorage::freePluginClassIndex (PluginClassStorage::Indices& iList,
 
     iList.resize (size - 1);
 }
+
+PluginClassAllocator::PluginClassAllocator () :
+    mSlotSize (0),
+    mMaxSlotsPerBlock (0),
+    mNBlocks (0),
+    mAvailable (NULL),
+    mFull (NULL),
+    mSpare (NULL)
+{
+}
+
+PluginClassAllocator::~PluginClassAllocator ()
+{
+    /* Blocks that still have objects in them are left alone, whoever
+     * owns those objects still expects them to be there. They go
+     * back to the heap once the last of them is freed */
+    Block *lists[] = { mAvailable, mFull };
+
+    for (unsigned int i = 0; i < 2; ++i)
+	for (Block *block = lists[i]; block; block = block->next)
+	    block->owner = NULL;
+
+    if (mSpare)
+    {
+	free (mSpare);
+	mSpare = NULL;
+
+	++mCounters.blockDeallocations;
+	++totals.blockDeallocations;
+    }
+}
+
+const PluginClassAllocator::Counters &
+PluginClassAllocator::totalCounters ()
+{
+    return totals;
+}
+
+PluginClassAllocator::Block *
+PluginClassAllocator::newBlock ()
+{
+    if (mSpare)
+    {
+	Block *block = mSpare;
+
+	mSpare = NULL;
+	return block;
+    }
+
+    /* Most plugin classes only ever have one instance, the one on the
+     * screen, so start out with a single slot and double the size of
+     * every block after that */
+    unsigned int nSlots = mMaxSlotsPerBlock;
+
+    if (mNBlocks < 16 && (1u << mNBlocks) < nSlots)
+	nSlots = 1u << mNBlocks;
+
+    Block *block = static_cast<Block *> (malloc (alignedSize (sizeof (Block)) +
+						 nSlots * mSlotSize));
+
+    if (!block)
+	return NULL;
+
+    block->owner = this;
+    block->prev = NULL;
+    block->next = NULL;
+    block->freeSlots = NULL;
+    block->nSlots = nSlots;
+    block->nUsed = 0;
+    block->nCarved = 0;
+
+    ++mNBlocks;
+    ++mCounters.blockAllocations;
+    ++totals.blockAllocations;
+
+    return block;
+}
+
+void
+PluginClassAllocator::link (Block *&list,
+			    Block  *block)
+{
+    block->prev = NULL;
+    block->next = list;
+
+    if (list)
+	list->prev = block;
+
+    list = block;
+}
+
+void
+PluginClassAllocator::unlink (Block *&list,
+			      Block  *block)
+{
+    if (block->prev)
+	block->prev->next = block->next;
+    else
+	list = block->next;
+
+    if (block->next)
+	block->next->prev = block->prev;
+
+    block->prev = NULL;
+    block->next = NULL;
+}
+
+void *
+PluginClassAllocator::allocate (size_t size)
+{
+    if (!mSlotSize)
+    {
+	mSlotSize = alignedSize (Alignment + size);
+	mMaxSlotsPerBlock = MaxBlockSize / mSlotSize;
+
+	if (!mMaxSlotsPerBlock)
+	    mMaxSlotsPerBlock = 1;
+    }
+
+    if (!mAvailable)
+    {
+	Block *block = newBlock ();
+
+	if (!block)
+	    return NULL;
+
+	link (mAvailable, block);
+    }
+
+    Block *block = mAvailable;
+    char  *slot;
+
+    if (block->freeSlots)
+    {
+	slot = block->freeSlots;
+	block->freeSlots = *reinterpret_cast<char **> (slot + Alignment);
+    }
+    else
+	slot = block->slot (block->nCarved++, mSlotSize);
+
+    *reinterpret_cast<Block **> (slot) = block;
+
+    if (++block->nUsed == block->nSlots)
+    {
+	unlink (mAvailable, block);
+	link (mFull, block);
+    }
+
+    ++mCounters.allocations;
+    ++totals.allocations;
+
+    return slot + Alignment;
+}
+
+void
+PluginClassAllocator::deallocate (void *ptr)
+{
+    if (!ptr)
+	return;
+
+    char  *slot = static_cast<char *> (ptr) - Alignment;
+    Block *block = *reinterpret_cast<Block **> (slot);
+
+    if (block->owner != this)
+    {
+	if (block->owner)
+	{
+	    block->owner->deallocate (ptr);
+	    return;
+	}
+
+	/* The allocator is gone, its blocks just have to go once
+	 * they are empty */
+	++totals.deallocations;
+
+	if (!--block->nUsed)
+	{
+	    free (block);
+	    ++totals.blockDeallocations;
+	}
+
+	return;
+    }
+
+    if (block->nUsed == block->nSlots)
+    {
+	unlink (mFull, block);
+	link (mAvailable, block);
+    }
+
+    *reinterpret_cast<char **> (ptr) = block->freeSlots;
+    block->freeSlots = slot;
+
+    ++mCounters.deallocations;
+    ++totals.deallocations;
+
+    if (--block->nUsed)
+	return;
+
+    /* Keep one empty block around so that a window being mapped
+     * and unmapped over and over doesn't go back to the heap */
+    unlink (mAvailable, block);
+
+    if (!mSpare)
+    {
+	block->freeSlots = NULL;
+	block->nCarved = 0;
+	mSpare = block;
+    }
+    else
+    {
+	free (block);
+
+	--mNBlocks;
+	++mCounters.blockDeallocations;
+	++totals.blockDeallocations;
+    }
+}
@@ -0,0 +1,280 @@
+#include <test-pluginclasshandler.h>
+
+#include <sys/time.h>
+
+#include <cstring>
+#include <vector>
+
+namespace cpi = compiz::plugin::internal;
+
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Lt;
+using ::testing::Ne;
+
+/* Stands in for the plugin classes which usually attach to a
+ * window, each one a different size */
+template <int Size>
+class AllocatePlugin :
+    public Plugin,
+    public PluginClassHandler <AllocatePlugin <Size>, Base>
+{
+    public:
+	AllocatePlugin (Base *base) :
+	    Plugin (base),
+	    PluginClassHandler <AllocatePlugin <Size>, Base> (base)
+	{
+	    memset (data, 0, sizeof (data));
+	}
+
+	char data[Size];
+};
+
+typedef AllocatePlugin <16>   CompositeLikePlugin;
+typedef AllocatePlugin <200>  OpenGLLikePlugin;
+typedef AllocatePlugin <120>  DecorLikePlugin;
+typedef AllocatePlugin <360>  AnimationLikePlugin;
+typedef AllocatePlugin <40>   MoveLikePlugin;
+typedef AllocatePlugin <2000> LargePlugin;
+
+class DerivedPlugin :
+    public CompositeLikePlugin
+{
+    public:
+	DerivedPlugin (Base *base) :
+	    CompositeLikePlugin (base)
+	{
+	}
+
+	char moreData[64];
+};
+
+class PluginClassHandlerAllocate :
+    public CompizPCHTest
+{
+    public:
+
+	PluginClassHandlerAllocate ();
+	~PluginClassHandlerAllocate ();
+
+	/* Brings up all of the plugin classes on a new base object,
+	 * like mapping a window does */
+	Base * map ();
+
+	/* And tears them down again in reverse, like unmapping */
+	void unmap (Base *base);
+};
+
+PluginClassHandlerAllocate::PluginClassHandlerAllocate ()
+{
+    cpi::LoadedPluginClassBridge <CompositeLikePlugin, Base>::allowInstantiations (key);
+    cpi::LoadedPluginClassBridge <OpenGLLikePlugin, Base>::allowInstantiations (key);
+    cpi::LoadedPluginClassBridge <DecorLikePlugin, Base>::allowInstantiations (key);
+    cpi::LoadedPluginClassBridge <AnimationLikePlugin, Base>::allowInstantiations (key);
+    cpi::LoadedPluginClassBridge <MoveLikePlugin, Base>::allowInstantiations (key);
+    cpi::LoadedPluginClassBridge <LargePlugin, Base>::allowInstantiations (key);
+}
+
+PluginClassHandlerAllocate::~PluginClassHandlerAllocate ()
+{
+    cpi::LoadedPluginClassBridge <CompositeLikePlugin, Base>::disallowInstantiations (key);
+    cpi::LoadedPluginClassBridge <OpenGLLikePlugin, Base>::disallowInstantiations (key);
+    cpi::LoadedPluginClassBridge <DecorLikePlugin, Base>::disallowInstantiations (key);
+    cpi::LoadedPluginClassBridge <AnimationLikePlugin, Base>::disallowInstantiations (key);
+    cpi::LoadedPluginClassBridge <MoveLikePlugin, Base>::disallowInstantiations (key);
+    cpi::LoadedPluginClassBridge <LargePlugin, Base>::disallowInstantiations (key);
+}
+
+Base *
+PluginClassHandlerAllocate::map ()
+{
+    Base *base = new Base ();
+
+    CompositeLikePlugin::get (base);
+    OpenGLLikePlugin::get (base);
+    DecorLikePlugin::get (base);
+    AnimationLikePlugin::get (base);
+    MoveLikePlugin::get (base);
+    LargePlugin::get (base);
+
+    return base;
+}
+
+void
+PluginClassHandlerAllocate::unmap (Base *base)
+{
+    delete LargePlugin::get (base);
+    delete MoveLikePlugin::get (base);
+    delete AnimationLikePlugin::get (base);
+    delete DecorLikePlugin::get (base);
+    delete OpenGLLikePlugin::get (base);
+    delete CompositeLikePlugin::get (base);
+
+    delete base;
+}
+
+TEST_F (PluginClassHandlerAllocate, TestInstancesAreAdjacent)
+{
+    std::vector <Base *> windows;
+
+    for (unsigned int i = 0; i < 100; ++i)
+	windows.push_back (map ());
+
+    /* Count the instances which directly follow the one for the
+     * previous window, that is which are no more than one object
+     * and its bookkeeping away */
+    unsigned int adjacent = 0;
+
+    for (unsigned int i = 1; i < windows.size (); ++i)
+    {
+	char *previous = reinterpret_cast <char *> (OpenGLLikePlugin::get (windows[i - 1]));
+	char *current = reinterpret_cast <char *> (OpenGLLikePlugin::get (windows[i]));
+
+	if (current > previous &&
+	    current - previous < static_cast <long> (sizeof (OpenGLLikePlugin) + 32))
+	    ++adjacent;
+    }
+
+    EXPECT_THAT (adjacent, Lt (windows.size ()));
+    EXPECT_THAT (adjacent, Ge (90u));
+
+    for (unsigned int i = 0; i < windows.size (); ++i)
+	unmap (windows[i]);
+}
+
+TEST_F (PluginClassHandlerAllocate, TestFreedInstanceIsReused)
+{
+    Base   *base = new Base ();
+    Plugin *p = DecorLikePlugin::get (base);
+
+    delete p;
+    delete base;
+
+    base = new Base ();
+
+    EXPECT_THAT (static_cast <Plugin *> (DecorLikePlugin::get (base)), Eq (p));
+
+    delete DecorLikePlugin::get (base);
+    delete base;
+}
+
+TEST_F (PluginClassHandlerAllocate, TestDerivedClassesComeFromHeap)
+{
+    PluginClassAllocator::Counters before = PluginClassAllocator::totalCounters ();
+
+    Base   *base = new Base ();
+    Plugin *p = new DerivedPlugin (base);
+
+    EXPECT_THAT (static_cast <Plugin *> (CompositeLikePlugin::get (base)), Eq (p));
+    delete p;
+    delete base;
+
+    const PluginClassAllocator::Counters &after = PluginClassAllocator::totalCounters ();
+
+    EXPECT_THAT (after.allocations, Eq (before.allocations));
+    EXPECT_THAT (after.deallocations, Eq (before.deallocations));
+}
+
+TEST_F (PluginClassHandlerAllocate, TestFreeingThroughAnotherAllocator)
+{
+    /* Like the copies of a plugin class's allocator which each plugin
+     * using the class may have */
+    PluginClassAllocator mine, theirs;
+
+    void *a = mine.allocate (64);
+    void *b = mine.allocate (64);
+    void *c = theirs.allocate (64);
+
+    theirs.deallocate (a);
+
+    EXPECT_THAT (mine.counters ().deallocations, Eq (1u));
+    EXPECT_THAT (theirs.counters ().deallocations, Eq (0u));
+
+    /* Neither allocator lost track of its blocks, so neither hands
+     * out anything still in use */
+    void *d = mine.allocate (64);
+    void *e = theirs.allocate (64);
+
+    EXPECT_THAT (d, Ne (b));
+    EXPECT_THAT (d, Ne (c));
+    EXPECT_THAT (e, Ne (b));
+    EXPECT_THAT (e, Ne (c));
+    EXPECT_THAT (e, Ne (d));
+
+    theirs.deallocate (b);
+    theirs.deallocate (d);
+    mine.deallocate (c);
+    mine.deallocate (e);
+
+    EXPECT_THAT (mine.counters ().deallocations, Eq (mine.counters ().allocations));
+    EXPECT_THAT (theirs.counters ().deallocations, Eq (theirs.counters ().allocations));
+}
+
+TEST_F (PluginClassHandlerAllocate, TestFreeingAfterTheAllocatorIsGone)
+{
+    PluginClassAllocator::Counters before = PluginClassAllocator::totalCounters ();
+    PluginClassAllocator           *gone = new PluginClassAllocator ();
+    PluginClassAllocator           theirs;
+
+    void *a = gone->allocate (64);
+    void *b = gone->allocate (64);
+
+    delete gone;
+
+    theirs.deallocate (a);
+    theirs.deallocate (b);
+
+    const PluginClassAllocator::Counters &after = PluginClassAllocator::totalCounters ();
+
+    EXPECT_THAT (after.deallocations - before.deallocations, Eq (2u));
+    EXPECT_THAT (after.blockDeallocations - before.blockDeallocations,
+		 Eq (after.blockAllocations - before.blockAllocations));
+}
+
+TEST_F (PluginClassHandlerAllocate, TestMapAndUnmapThousandWindows)
+{
+    const unsigned int nWindows = 1000;
+    const unsigned int nCycles = 10;
+    const unsigned int nPluginClasses = 6;
+
+    std::vector <Base *>           windows (nWindows);
+    PluginClassAllocator::Counters before = PluginClassAllocator::totalCounters ();
+    struct timeval                 start, end;
+
+    gettimeofday (&start, NULL);
+
+    for (unsigned int cycle = 0; cycle < nCycles; ++cycle)
+    {
+	for (unsigned int i = 0; i < nWindows; ++i)
+	    windows[i] = map ();
+
+	for (unsigned int i = 0; i < nWindows; ++i)
+	    unmap (windows[i]);
+    }
+
+    gettimeofday (&end, NULL);
+
+    const PluginClassAllocator::Counters &after = PluginClassAllocator::totalCounters ();
+
+    unsigned long allocations = after.allocations - before.allocations;
+    unsigned long deallocations = after.deallocations - before.deallocations;
+    unsigned long blockAllocations = after.blockAllocations - before.blockAllocations;
+    unsigned long blockDeallocations = after.blockDeallocations - before.blockDeallocations;
+
+    RecordProperty ("plugin_class_allocations", allocations);
+    RecordProperty ("heap_allocations", blockAllocations);
+    RecordProperty ("heap_deallocations", blockDeallocations);
+    RecordProperty ("usec", (end.tv_sec - start.tv_sec) * 1000000 +
+			    (end.tv_usec - start.tv_usec));
+
+    EXPECT_THAT (allocations, Eq (nWindows * nCycles * nPluginClasses));
+    EXPECT_THAT (deallocations, Eq (allocations));
+
+    /* Each plugin class keeps one empty block around at most */
+    EXPECT_THAT (blockAllocations - blockDeallocations, Le (nPluginClasses));
+
+    /* Previously every plugin class instance was a heap allocation
+     * of its own */
+    EXPECT_THAT (blockAllocations * 20, Lt (allocations));
+}
@@ -34,6 +34,8 @@
 #include <core/timer.h>
 #include <core/plugin.h>
 #include <core/servergrab.h>
+#include <core/propertybatch.h>
+#include <core/eventcoalescer.h>
 #include <time.h>
 #include <boost/shared_ptr.hpp>
 
@@ -194,12 +196,19 @@ class WindowManager : boost::noncopyable
 	}
 
     private:
+	/* Keeps the server stack position and ids of w, so that
+	 * unhooking and finding siblings doesn't walk the stack */
+	void indexServerWindow (CompWindow *w, CompWindowList::iterator it);
+	void unindexServerWindow (CompWindow *w);
+	CompWindowList::iterator findServerWindow (Window id);
+
 	CompWindowList windows;
 	CompWindowList serverWindows;
 	CompWindowList destroyedWindows;
 	bool           stackIsFresh;
 
 	CompWindow::Map windowsMap;
+	CompWindow::Map serverWindowIds;      /* client and frame ids */
 	std::list<CompGroup *> groups;
 
 	CompWindowVector clientList;            /* clients in mapping order */
@@ -624,6 +633,9 @@ class PrivateScreen :
 
 	bool getNextEvent (XEvent &);
 	bool getNextXEvent (XEvent &);
+	bool getQueuedXEvent (XEvent &);
+	bool peekNextEvent (XEvent &);
+	bool coalesceConfigure (XEvent &, const XEvent &);
 	void processEvents ();
 
 	bool triggerButtonPressBindings (CompOption::Vector &options,
@@ -673,13 +685,15 @@ class PrivateScreen :
 
 	void handleSelectionClear (XEvent *event);
 
-	bool desktopHintEqual (unsigned long *data,
-			       int           size,
-			       int           offset,
-			       int           hintSize);
-
 	void setDesktopHints ();
 
+	void writeProperty (Window              id,
+			    Atom                property,
+			    Atom                type,
+			    int                 format,
+			    const unsigned char *data,
+			    int                 nElements);
+
 	void setVirtualScreenSize (int hsize, int vsize);
 
 	void updateScreenEdges ();
@@ -749,6 +763,7 @@ class PrivateScreen :
     }
 
     void identifyEdgeWindow(Window id);
+    void handleWarpCrossing(const XEvent &event);
     void setPlugins(const CompOption::Value::Vector& vList);
     void initPlugins();
 
@@ -793,6 +808,14 @@ public:
 
     bool initialized;
 
+    /* EWMH hints are staged here while events are processed and
+     * written once processEvents () is done */
+    compiz::core::PropertyBatch propertyBatch;
+
+    /* Events already queued are drained and collapsed here before
+     * they are handled, see getNextEvent () */
+    compiz::core::EventCoalescer eventCoalescer;
+
 private:
     CompScreen* screen;
     compiz::private_screen::Extension xkbEvent;
@@ -815,9 +838,6 @@ private:
     Atom wmSnAtom;
     Time wmSnTimestamp;
 
-    unsigned long *desktopHintData;
-    int desktopHintSize;
-
     Window edgeWindow;
     CompTimer pingTimer;
     CompTimer edgeDelayTimer;
@@ -1083,6 +1103,7 @@ class CompScreenImpl : public CompScreen,
 	virtual void addToDestroyedWindows(CompWindow * cw);
 	virtual void processEvents ();
 	virtual void alwaysHandleEvent (XEvent *event);
+	virtual compiz::core::EventCoalescer & eventCoalescer ();
 
 	virtual ServerGrabInterface * serverGrabInterface ();
 
@@ -1193,6 +1214,7 @@ class CompScreenImpl : public CompScreen,
         virtual void _outputChangeNotify();
         virtual void _cursorChangeNotify(const CompString&, int);
         virtual void _averageColorChangeNotify(const unsigned short*);
+        virtual bool _setOptionsForPlugin(const char *, CompOption::Vector &);
 
 	void grabServer ();
 	void ungrabServer ();
@@ -83,6 +83,7 @@ public:
     MOCK_METHOD0(_outputChangeNotify, void ());
     MOCK_METHOD2(_cursorChangeNotify, void (const CompString&, int));
     MOCK_METHOD1(_averageColorChangeNotify, void (const unsigned short*));
+    MOCK_METHOD2(_setOptionsForPlugin, bool (const char *, CompOption::Vector &));
 
     MOCK_METHOD0(outputDevs, CompOutput::vector & ());
     MOCK_METHOD2(setWindowState, void (unsigned int state, Window id));
@@ -176,6 +177,7 @@ public:
     MOCK_METHOD0(syncEvent, int ());
     MOCK_METHOD0(autoRaiseWindow, Window  ());
     MOCK_METHOD0(processEvents, void ());
+    MOCK_METHOD0(eventCoalescer, compiz::core::EventCoalescer & ());
     MOCK_METHOD1(alwaysHandleEvent, void (XEvent *event));
     MOCK_METHOD0(displayString, const char * ());
     MOCK_METHOD0(getCurrentOutputExtents, CompRect ());
@@ -36,78 +36,14 @@
 #include <boost/shared_ptr.hpp>
 
 #include <core/configurerequestbuffer.h>
+#include <core/windowicon.h>
+#include <core/windowbuttongrab.h>
+#include <core/pendingevents.h>
+#include <core/windowtransients.h>
 
 #include "syncserverwindow.h"
 #include "asyncserverwindow.h"
 
-#define XWINDOWCHANGES_INIT {0, 0, 0, 0, 0, None, 0}
-
-namespace compiz {namespace X11
-{
-class PendingEvent {
-public:
-    PendingEvent (Display *, Window);
-    virtual ~PendingEvent ();
-
-    virtual bool match (XEvent *);
-    unsigned int serial () { return mSerial; } // HACK: will be removed
-    virtual void dump ();
-
-    typedef boost::shared_ptr<PendingEvent> Ptr;
-
-protected:
-
-    virtual Window getEventWindow (XEvent *);
-
-    unsigned int mSerial;
-    Window       mWindow;
-};
-
-class PendingConfigureEvent :
-    public PendingEvent
-{
-public:
-    PendingConfigureEvent (Display *, Window, unsigned int, XWindowChanges *);
-    virtual ~PendingConfigureEvent ();
-
-    virtual bool match (XEvent *);
-    bool matchVM (unsigned int valueMask);
-    bool matchRequest (XWindowChanges &xwc, unsigned int);
-    virtual void dump ();
-
-    typedef boost::shared_ptr<PendingConfigureEvent> Ptr;
-
-protected:
-
-    virtual Window getEventWindow (XEvent *);
-
-private:
-    unsigned int mValueMask;
-    XWindowChanges mXwc;
-};
-
-class PendingEventQueue
-{
-public:
-
-    PendingEventQueue (Display *);
-    virtual ~PendingEventQueue ();
-
-    void add (PendingEvent::Ptr p);
-    bool match (XEvent *);
-    bool pending ();
-    bool forEachIf (boost::function <bool (compiz::X11::PendingEvent::Ptr)>);
-    void clear () { mEvents.clear (); } // HACK will be removed
-    void dump ();
-
-protected:
-    bool removeIfMatching (const PendingEvent::Ptr &p, XEvent *);
-
-private:
-    std::list <PendingEvent::Ptr> mEvents;
-};
-
-}}
 struct CompGroup;
 
 typedef CompWindowExtents CompFullscreenMonitorSet;
@@ -198,16 +134,28 @@ class PrivateWindow :
 				unsigned int     *mask,
 				const ServerLock &lock);
 
-	static bool stackTransients (CompWindow       *w,
-				     CompWindow       *avoid,
-				     XWindowChanges   *xwc,
-				     CompWindowList   &updateList,
-				     const ServerLock &lock);
-
-	static void stackAncestors (CompWindow       *w,
-				    XWindowChanges   *xwc,
-				    CompWindowList   &updateList,
-				    const ServerLock &lock);
+	/* The server stack top-down and who is transient for whom in it,
+	 * taken once for all the lookups of one restack */
+	struct TransientStack
+	{
+	    explicit TransientStack (const CompWindowList &serverWindows);
+
+	    CompWindowVector                  windows;
+	    compiz::window::transients::Index index;
+	};
+
+	static bool stackTransients (CompWindow           *w,
+				     CompWindow           *avoid,
+				     XWindowChanges       *xwc,
+				     CompWindowList       &updateList,
+				     const TransientStack &stack,
+				     const ServerLock     &lock);
+
+	static void stackAncestors (CompWindow           *w,
+				    XWindowChanges       *xwc,
+				    CompWindowList       &updateList,
+				    const TransientStack &stack,
+				    const ServerLock     &lock);
 
 	static bool isAncestorTo (CompWindow *transient,
 				  CompWindow *ancestor);
@@ -288,6 +236,8 @@ class PrivateWindow :
 	void updateRegion ();
 
 	bool handleSyncAlarm ();
+	bool endSyncWait ();
+	void handleSyncCounter (const XSyncValue &value);
 
 	void move (int dx, int dy, bool sync);
 	bool resize (int dx, int dy, int dwidth, int dheight, int dborder);
@@ -315,6 +265,16 @@ class PrivateWindow :
 
 	void freeIcons ();
 
+	void requestIcons ();
+	bool prefetchIcons ();
+	void releaseIconReservation ();
+	void receiveIcons ();
+	void dropIconData ();
+	CompIcon * decodeIcon (int image);
+
+	static void useIconData (Window id, size_t bytes);
+	static void dropEvictedIconData (const std::vector<Window> &evicted);
+
 	void updateMwmHints ();
 
 	void updateStartupId ();
@@ -438,6 +398,24 @@ class PrivateWindow :
 	std::vector<CompIcon *> icons;
 	bool noIcons;
 
+	/* _NET_WM_ICON as sent by the server, only decoded size by size
+	 * as the sizes are asked for, see getIcon () */
+	xcb_get_property_cookie_t iconCookie;
+	bool                      iconPending;
+	bool                      iconReserved;
+	xcb_get_property_reply_t  *iconData;
+
+	std::vector<compiz::window::icon::Image> iconImages;
+	std::vector<CompIcon *>                  iconDecoded;
+
+	compiz::window::buttongrab::State buttonGrabState;
+
+	/* Where this window is in the server stack and the ids it can be
+	 * found by there, see cps::WindowManager::insertServerWindow */
+	CompWindowList::iterator serverStackEntry;
+	bool                     inServerStack;
+	std::vector<Window>      serverStackKeys;
+
 	CompRect   iconGeometry;
 
 	XWindowChanges saveWc;
@@ -451,6 +429,14 @@ class PrivateWindow :
 	bool                 syncWait;
 	CompWindow::Geometry syncGeometry;
 
+	/* syncValue is the last value the client reported on an
+	 * extended counter, syncWaitValue the one a sync request
+	 * waits for */
+	XSyncValue syncWaitValue;
+	bool       syncExtended;
+	bool       syncFrozen;
+	bool       syncFrameDrawn;
+
 	int closeRequests;
 	Time lastCloseRequestTime;
 
@@ -0,0 +1,112 @@
+/*
+ * Compiz, coalesced window property writes
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PROPERTYBATCH_H
+#define _COMPIZ_PROPERTYBATCH_H
+
+#include <X11/Xlib.h>
+
+#include <boost/function.hpp>
+
+namespace compiz
+{
+namespace core
+{
+
+class PrivatePropertyBatch;
+
+/**
+ * Collects window property writes and sends them in one go.
+ *
+ * Every write replaces the whole property (PropModeReplace). Writes
+ * staged between begin () and the matching end () are held back, so
+ * when the same property is written several times only the last
+ * value is sent, once, when the outermost end () is reached. Outside
+ * of begin () / end () writes are sent straight away.
+ *
+ * For windows registered with own (), whose properties nobody else
+ * writes (eg, the root window's EWMH hints), the last value sent is
+ * remembered and a write which would not change it is dropped
+ * instead of being sent again. Writes to any other window are always
+ * sent, since a client may have changed the property in the meantime.
+ */
+class PropertyBatch
+{
+    public:
+
+	/**
+	 * Sends one property to the server: window, property, type,
+	 * format, data and number of elements, as for XChangeProperty
+	 */
+	typedef boost::function <void (Window, Atom, Atom, int,
+				       const unsigned char *, int)> Writer;
+
+	explicit PropertyBatch (const Writer &writer);
+	~PropertyBatch ();
+
+	/**
+	 * Only this process writes to the properties of id
+	 */
+	void own (Window id);
+
+	/**
+	 * Stages a write. Data is laid out as for XChangeProperty, that
+	 * is, an array of longs for format 32, and is copied.
+	 */
+	void stage (Window              id,
+		    Atom                property,
+		    Atom                type,
+		    int                 format,
+		    const unsigned char *data,
+		    int                 nElements);
+
+	/**
+	 * Holds writes back until the matching end (). May be nested.
+	 */
+	void begin ();
+	void end ();
+
+	/**
+	 * Sends everything staged so far, even inside begin () / end ()
+	 */
+	void flush ();
+
+	/**
+	 * Number of writes sent to the server, and the number dropped
+	 * because they were overwritten in the same batch or would not
+	 * have changed an owned property
+	 */
+	unsigned int sent () const;
+	unsigned int dropped () const;
+
+    private:
+
+	PropertyBatch (const PropertyBatch &);
+	PropertyBatch & operator= (const PropertyBatch &);
+
+	PrivatePropertyBatch *priv;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Compiz, coalesced window property writes
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PRIVATEPROPERTYBATCH_H
+#define _COMPIZ_PRIVATEPROPERTYBATCH_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+
+#include "core/propertybatch.h"
+
+namespace compiz
+{
+namespace core
+{
+
+struct PropertyValue
+{
+    PropertyValue ();
+
+    bool operator== (const PropertyValue &other) const;
+
+    Atom                       type;
+    int                        format;
+    int                        nElements;
+    std::vector<unsigned char> data;
+};
+
+struct StagedProperty
+{
+    StagedProperty ();
+
+    PropertyValue staged;
+    PropertyValue sent;
+    bool          hasSent;
+    bool          dirty;
+};
+
+class PrivatePropertyBatch
+{
+    public:
+
+	typedef std::pair<Window, Atom> Key;
+	typedef std::map<Key, StagedProperty> PropertyMap;
+
+	PrivatePropertyBatch (const PropertyBatch::Writer &writer);
+
+	PropertyBatch::Writer writer;
+
+	PropertyMap       properties;
+	std::vector<Key>  order;
+	std::set<Window>  owned;
+
+	unsigned int depth;
+	unsigned int sent;
+	unsigned int dropped;
+};
+
+}
+}
+
+#endif
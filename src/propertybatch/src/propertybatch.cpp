@@ -0,0 +1,189 @@
+/*
+ * Compiz, coalesced window property writes
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "privatepropertybatch.h"
+
+namespace cc = compiz::core;
+
+namespace
+{
+size_t
+dataSize (int format,
+	  int nElements)
+{
+    switch (format)
+    {
+	case 16:
+	    return nElements * sizeof (short);
+	case 32:
+	    return nElements * sizeof (long);
+	default:
+	    return nElements;
+    }
+}
+}
+
+cc::PropertyValue::PropertyValue () :
+    type (None),
+    format (0),
+    nElements (0)
+{
+}
+
+bool
+cc::PropertyValue::operator== (const PropertyValue &other) const
+{
+    return type == other.type &&
+	   format == other.format &&
+	   nElements == other.nElements &&
+	   data == other.data;
+}
+
+cc::StagedProperty::StagedProperty () :
+    hasSent (false),
+    dirty (false)
+{
+}
+
+cc::PrivatePropertyBatch::PrivatePropertyBatch (const PropertyBatch::Writer &writer) :
+    writer (writer),
+    depth (0),
+    sent (0),
+    dropped (0)
+{
+}
+
+cc::PropertyBatch::PropertyBatch (const Writer &writer) :
+    priv (new PrivatePropertyBatch (writer))
+{
+}
+
+cc::PropertyBatch::~PropertyBatch ()
+{
+    delete priv;
+}
+
+void
+cc::PropertyBatch::own (Window id)
+{
+    priv->owned.insert (id);
+}
+
+void
+cc::PropertyBatch::stage (Window              id,
+			  Atom                property,
+			  Atom                type,
+			  int                 format,
+			  const unsigned char *data,
+			  int                 nElements)
+{
+    PrivatePropertyBatch::Key key (id, property);
+    StagedProperty            &entry = priv->properties[key];
+
+    if (entry.dirty)
+	priv->dropped++;
+    else
+    {
+	entry.dirty = true;
+	priv->order.push_back (key);
+    }
+
+    entry.staged.type      = type;
+    entry.staged.format    = format;
+    entry.staged.nElements = nElements;
+    entry.staged.data.assign (data, data + dataSize (format, nElements));
+
+    if (!priv->depth)
+	flush ();
+}
+
+void
+cc::PropertyBatch::begin ()
+{
+    priv->depth++;
+}
+
+void
+cc::PropertyBatch::end ()
+{
+    if (priv->depth && !--priv->depth)
+	flush ();
+}
+
+void
+cc::PropertyBatch::flush ()
+{
+    std::vector<PrivatePropertyBatch::Key> order;
+
+    /* The writer might end up staging something itself */
+    order.swap (priv->order);
+
+    for (std::vector<PrivatePropertyBatch::Key>::iterator it = order.begin ();
+	 it != order.end (); ++it)
+    {
+	PrivatePropertyBatch::PropertyMap::iterator entry =
+	    priv->properties.find (*it);
+
+	if (entry == priv->properties.end ())
+	    continue;
+
+	StagedProperty &property = entry->second;
+	bool           owned     = priv->owned.count (it->first);
+
+	property.dirty = false;
+
+	if (owned && property.hasSent && property.sent == property.staged)
+	    priv->dropped++;
+	else
+	{
+	    const PropertyValue &value = property.staged;
+
+	    priv->writer (it->first, it->second, value.type, value.format,
+			  value.data.empty () ? NULL : &value.data[0],
+			  value.nElements);
+	    priv->sent++;
+	}
+
+	if (owned)
+	{
+	    property.sent.type      = property.staged.type;
+	    property.sent.format    = property.staged.format;
+	    property.sent.nElements = property.staged.nElements;
+	    property.sent.data.swap (property.staged.data);
+	    property.hasSent        = true;
+	}
+	else
+	    priv->properties.erase (entry);
+    }
+}
+
+unsigned int
+cc::PropertyBatch::sent () const
+{
+    return priv->sent;
+}
+
+unsigned int
+cc::PropertyBatch::dropped () const
+{
+    return priv->dropped;
+}
@@ -0,0 +1,249 @@
+/*
+ * Compiz, coalesced window property writes
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <core/propertybatch.h>
+
+namespace cc = compiz::core;
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::InSequence;
+
+namespace
+{
+const Window ROOT = 1;
+const Window CLIENT = 2;
+const Atom   CLIENT_LIST = 10;
+const Atom   WORKAREA = 11;
+const Atom   WM_STATE = 12;
+const Atom   CARDINAL = 6;
+
+class MockWriter
+{
+    public:
+
+	MOCK_METHOD6 (write, void (Window, Atom, Atom, int,
+				   const unsigned char *, int));
+
+	/* Captures the values written to the last property */
+	void
+	record (Window              id,
+		Atom                property,
+		Atom                type,
+		int                 format,
+		const unsigned char *data,
+		int                 nElements)
+	{
+	    const long *values = (const long *) data;
+
+	    written.assign (values, values + nElements);
+	    write (id, property, type, format, data, nElements);
+	}
+
+	std::vector<long> written;
+};
+}
+
+class PropertyBatch :
+    public ::testing::Test
+{
+    public:
+
+	PropertyBatch () :
+	    batch (boost::bind (&MockWriter::record, &writer,
+				_1, _2, _3, _4, _5, _6))
+	{
+	    batch.own (ROOT);
+	}
+
+	void stage (Window id, Atom property, long value)
+	{
+	    batch.stage (id, property, CARDINAL, 32,
+			 (const unsigned char *) &value, 1);
+	}
+
+	MockWriter        writer;
+	cc::PropertyBatch batch;
+};
+
+TEST_F (PropertyBatch, WritesImmediatelyOutsideBatch)
+{
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, CARDINAL, 32, _, 1));
+
+    stage (ROOT, WORKAREA, 1);
+
+    EXPECT_EQ (1u, batch.sent ());
+}
+
+TEST_F (PropertyBatch, HoldsWritesUntilEnd)
+{
+    batch.begin ();
+
+    EXPECT_CALL (writer, write (_, _, _, _, _, _)).Times (0);
+    stage (ROOT, WORKAREA, 1);
+
+    ::testing::Mock::VerifyAndClearExpectations (&writer);
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, CARDINAL, 32, _, 1));
+    batch.end ();
+}
+
+TEST_F (PropertyBatch, NestedBatchesFlushAtOutermostEnd)
+{
+    batch.begin ();
+    batch.begin ();
+
+    EXPECT_CALL (writer, write (_, _, _, _, _, _)).Times (0);
+    stage (ROOT, WORKAREA, 1);
+    batch.end ();
+
+    ::testing::Mock::VerifyAndClearExpectations (&writer);
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, CARDINAL, 32, _, 1));
+    batch.end ();
+}
+
+TEST_F (PropertyBatch, LastWriteInBatchWins)
+{
+    batch.begin ();
+
+    stage (ROOT, WORKAREA, 1);
+    stage (ROOT, WORKAREA, 2);
+    stage (ROOT, WORKAREA, 3);
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, CARDINAL, 32, _, 1));
+    batch.end ();
+
+    EXPECT_THAT (writer.written, ElementsAre (3));
+    EXPECT_EQ (1u, batch.sent ());
+    EXPECT_EQ (2u, batch.dropped ());
+}
+
+TEST_F (PropertyBatch, WritesInFirstStagedOrder)
+{
+    InSequence s;
+
+    batch.begin ();
+
+    stage (ROOT, WORKAREA, 1);
+    stage (ROOT, CLIENT_LIST, 1);
+    stage (ROOT, WORKAREA, 2);
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _));
+    EXPECT_CALL (writer, write (ROOT, CLIENT_LIST, _, _, _, _));
+    batch.end ();
+}
+
+TEST_F (PropertyBatch, DropsUnchangedOwnedProperty)
+{
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _)).Times (1);
+
+    stage (ROOT, WORKAREA, 1);
+    stage (ROOT, WORKAREA, 1);
+
+    batch.begin ();
+    stage (ROOT, WORKAREA, 1);
+    batch.end ();
+
+    EXPECT_EQ (1u, batch.sent ());
+    EXPECT_EQ (2u, batch.dropped ());
+}
+
+TEST_F (PropertyBatch, DropsOwnedPropertyChangedBackWithinBatch)
+{
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _)).Times (1);
+
+    stage (ROOT, WORKAREA, 1);
+
+    batch.begin ();
+    stage (ROOT, WORKAREA, 2);
+    stage (ROOT, WORKAREA, 1);
+    batch.end ();
+}
+
+TEST_F (PropertyBatch, SendsChangedOwnedProperty)
+{
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _)).Times (2);
+
+    stage (ROOT, WORKAREA, 1);
+    stage (ROOT, WORKAREA, 2);
+
+    EXPECT_THAT (writer.written, ElementsAre (2));
+}
+
+TEST_F (PropertyBatch, ComparesTypeAndLength)
+{
+    long values[] = { 1, 2 };
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _)).Times (3);
+
+    batch.stage (ROOT, WORKAREA, CARDINAL, 32, (const unsigned char *) values, 1);
+    batch.stage (ROOT, WORKAREA, CARDINAL, 32, (const unsigned char *) values, 2);
+    batch.stage (ROOT, WORKAREA, CARDINAL + 1, 32, (const unsigned char *) values, 2);
+}
+
+TEST_F (PropertyBatch, AlwaysSendsToWindowsNotOwned)
+{
+    EXPECT_CALL (writer, write (CLIENT, WM_STATE, _, _, _, _)).Times (2);
+
+    stage (CLIENT, WM_STATE, 1);
+    stage (CLIENT, WM_STATE, 1);
+}
+
+TEST_F (PropertyBatch, CoalescesWritesToWindowsNotOwned)
+{
+    batch.begin ();
+
+    stage (CLIENT, WM_STATE, 1);
+    stage (CLIENT, WM_STATE, 2);
+
+    EXPECT_CALL (writer, write (CLIENT, WM_STATE, _, _, _, _)).Times (1);
+    batch.end ();
+
+    EXPECT_THAT (writer.written, ElementsAre (2));
+}
+
+TEST_F (PropertyBatch, FlushSendsInsideBatch)
+{
+    batch.begin ();
+
+    stage (ROOT, WORKAREA, 1);
+
+    EXPECT_CALL (writer, write (ROOT, WORKAREA, _, _, _, _)).Times (1);
+    batch.flush ();
+    batch.end ();
+}
+
+TEST_F (PropertyBatch, EmptyProperty)
+{
+    EXPECT_CALL (writer, write (ROOT, CLIENT_LIST, CARDINAL, 32, NULL, 0)).Times (1);
+
+    batch.stage (ROOT, CLIENT_LIST, CARDINAL, 32, NULL, 0);
+    batch.stage (ROOT, CLIENT_LIST, CARDINAL, 32, NULL, 0);
+}
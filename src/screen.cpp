@@ -60,6 +60,7 @@
 #include <core/screen.h>
 #include <core/icon.h>
 #include <core/atoms.h>
+#include "core/windowprefetch.h"
 #include "privatescreen.h"
 #include "privatewindow.h"
 #include "privateaction.h"
@@ -473,6 +474,56 @@ CompScreenImpl::_setOptionForPlugin (const char        *plugin,
     return false;
 }
 
+bool
+CompScreen::setOptionsForPlugin (const char         *plugin,
+				 CompOption::Vector &options)
+{
+    WRAPABLE_HND_FUNCTN_RETURN (bool, setOptionsForPlugin, plugin, options)
+
+    return _setOptionsForPlugin (plugin, options);
+}
+
+bool
+CompScreenImpl::_setOptionsForPlugin (const char         *plugin,
+				      CompOption::Vector &options)
+{
+    CompPlugin *p = CompPlugin::find (plugin);
+    if (!p)
+	return false;
+
+    /* Batches often carry every option of a plugin, as on a reload,
+     * only hand over and report back the ones that change */
+    CompOption::Vector             &current = p->vTable->getOptions ();
+    std::vector<CompOption::Value> before;
+    CompOption::Vector             changing;
+
+    foreach (CompOption &o, options)
+    {
+	CompOption *c = CompOption::findOption (current, o.name ());
+
+	if (c && c->value () == o.value ())
+	    continue;
+
+	changing.push_back (o);
+	before.push_back (c ? c->value () : CompOption::Value ());
+    }
+
+    options.clear ();
+
+    if (changing.empty () || !p->vTable->setOptions (changing))
+	return false;
+
+    for (unsigned int i = 0; i < changing.size (); ++i)
+    {
+	CompOption *c = CompOption::findOption (current, changing[i].name ());
+
+	if (!c || c->value () != before[i])
+	    options.push_back (changing[i]);
+    }
+
+    return !options.empty ();
+}
+
 void
 CompScreen::sessionEvent (CompSession::Event event,
 			  CompOption::Vector &arguments)
@@ -509,6 +560,11 @@ ScreenInterface::setOptionForPlugin (const char        *plugin,
 				     CompOption::Value &value)
     WRAPABLE_DEF (setOptionForPlugin, plugin, name, value)
 
+bool
+ScreenInterface::setOptionsForPlugin (const char         *plugin,
+				      CompOption::Vector &options)
+    WRAPABLE_DEF (setOptionsForPlugin, plugin, options)
+
 void
 ScreenInterface::sessionEvent (CompSession::Event event,
 			       CompOption::Vector &arguments)
@@ -793,6 +849,17 @@ PrivateScreen::getNextXEvent (XEvent &ev)
     return true;
 }
 
+bool
+PrivateScreen::getQueuedXEvent (XEvent &ev)
+{
+    if (!XEventsQueued (dpy, QueuedAlready))
+	return false;
+
+    XNextEvent (dpy, &ev);
+
+    return true;
+}
+
 bool
 PrivateScreen::getNextEvent (XEvent &ev)
 {
@@ -802,10 +869,52 @@ PrivateScreen::getNextEvent (XEvent &ev)
     {
 	return dbg->getNextEvent (ev);
     }
+
+    /* Whatever was drained already goes first, even if coalescing
+     * was turned off in the meantime */
+    if (eventCoalescer.next (ev))
+	return true;
+
+    if (optionGetCoalesceEvents ())
+    {
+	eventCoalescer.fill (boost::bind (&PrivateScreen::getQueuedXEvent,
+					  this, _1));
+	return eventCoalescer.next (ev);
+    }
     else
 	return getNextXEvent (ev);
 }
 
+bool
+PrivateScreen::peekNextEvent (XEvent &ev)
+{
+    if (eventCoalescer.peek (ev))
+	return true;
+
+    if (!XEventsQueued (dpy, QueuedAfterReading))
+	return false;
+
+    XPeekEvent (dpy, &ev);
+
+    return true;
+}
+
+bool
+PrivateScreen::coalesceConfigure (XEvent       &pending,
+				  const XEvent &next)
+{
+    /* Every ConfigureNotify on a frame answers a request of ours
+     * and has to be matched against it */
+    CompWindow *w = screen->findTopLevelWindow (next.xconfigure.window, true);
+
+    if (w &&
+	w->priv->frame == next.xconfigure.window &&
+	w->priv->pendingConfigures.pending ())
+	return false;
+
+    return compiz::core::coalesce::mergeConfigure (pending, next);
+}
+
 void
 PrivateScreen::processEvents ()
 {
@@ -828,6 +937,10 @@ PrivateScreen::processEvents ()
 
     windowManager.invalidateServerWindows();
 
+    /* Property writes made while handling this batch of events are
+     * only sent once it has been handled, see PropertyBatch */
+    propertyBatch.begin ();
+
     XEvent event;
 
     while (getNextEvent (event))
@@ -898,6 +1011,9 @@ PrivateScreen::processEvents ()
 	lastPointerMods = pointerMods;
     }
 
+    propertyBatch.end ();
+    XFlush (dpy);
+
     /* remove destroyed windows */
     windowManager.removeDestroyed ();
 
@@ -924,15 +1040,90 @@ cps::WindowManager::validateServerWindows()
      * the server */
     if (stackIsFresh)
     {
+	foreach (CompWindow *sw, serverWindows)
+	    unindexServerWindow (sw);
+
 	serverWindows.clear ();
 
 	foreach (CompWindow *sw, windows)
 	{
 	    sw->serverPrev = sw->prev;
 	    sw->serverNext = sw->next;
-	    serverWindows.push_back (sw);
+	    indexServerWindow (sw, serverWindows.insert (serverWindows.end (), sw));
+	}
+    }
+}
+
+void
+cps::WindowManager::indexServerWindow (CompWindow               *w,
+				       CompWindowList::iterator it)
+{
+    PrivateWindow *p = w->priv;
+
+    p->serverStackEntry = it;
+    p->inServerStack    = true;
+
+    serverWindowIds[p->serverId] = w;
+    p->serverStackKeys.push_back (p->serverId);
+
+    if (p->serverFrame)
+    {
+	serverWindowIds[p->serverFrame] = w;
+	p->serverStackKeys.push_back (p->serverFrame);
+    }
+}
+
+void
+cps::WindowManager::unindexServerWindow (CompWindow *w)
+{
+    PrivateWindow *p = w->priv;
+
+    foreach (Window id, p->serverStackKeys)
+    {
+	CompWindow::Map::iterator it = serverWindowIds.find (id);
+
+	/* Another window may have been given the same id since */
+	if (it != serverWindowIds.end () && it->second == w)
+	    serverWindowIds.erase (it);
+    }
+
+    p->serverStackKeys.clear ();
+    p->inServerStack = false;
+}
+
+CompWindowList::iterator
+cps::WindowManager::findServerWindow (Window id)
+{
+    CompWindow::Map::iterator found = serverWindowIds.find (id);
+
+    if (found != serverWindowIds.end ())
+    {
+	PrivateWindow *p = found->second->priv;
+
+	if (p->inServerStack &&
+	    (p->serverId == id || (p->serverFrame && p->serverFrame == id)))
+	    return p->serverStackEntry;
+
+	/* The frame this was stacked with is gone */
+	serverWindowIds.erase (found);
+    }
+
+    /* Frames created after their window was stacked are only
+     * indexed once they are looked up */
+    for (CompWindowList::iterator it = serverWindows.begin ();
+	 it != serverWindows.end (); ++it)
+    {
+	PrivateWindow *p = (*it)->priv;
+
+	if (p->serverId == id || (p->serverFrame && p->serverFrame == id))
+	{
+	    serverWindowIds[id] = *it;
+	    p->serverStackKeys.push_back (id);
+	    return it;
 	}
     }
+
+    return serverWindows.end ();
 }
 
 void
@@ -1602,10 +1793,10 @@ cps::XWindowInfo::getWmState (Window id)
     unsigned char *data;
     unsigned long state = NormalState;
 
-    result = XGetWindowProperty (dpy, id,
-				 Atoms::wmState, 0L, 2L, false,
-				 Atoms::wmState, &actual, &format,
-				 &n, &left, &data);
+    result = compiz::window::getWindowProperty (dpy, id,
+						Atoms::wmState, 0L, 2L, false,
+						Atoms::wmState, &actual, &format,
+						&n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1703,10 +1894,10 @@ cps::XWindowInfo::getWindowState (Window id)
     unsigned char *data;
     unsigned int  state = 0;
 
-    result = XGetWindowProperty (dpy, id,
-				 Atoms::winState,
-				 0L, 1024L, false, XA_ATOM, &actual, &format,
-				 &n, &left, &data);
+    result = compiz::window::getWindowProperty (dpy, id,
+						Atoms::winState,
+						0L, 1024L, false, XA_ATOM, &actual, &format,
+						&n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1765,9 +1956,8 @@ PrivateScreen::setWindowState (unsigned int state, Window id)
     Atom data[32];
 
     i = compiz::window::fillStateData (state, data);
-    XChangeProperty (dpy, id, Atoms::winState,
-		     XA_ATOM, 32, PropModeReplace,
-		     (unsigned char *) data, i);
+    propertyBatch.stage (id, Atoms::winState, XA_ATOM, 32,
+			 (unsigned char *) data, i);
 }
 
 unsigned int
@@ -1778,10 +1968,10 @@ cps::XWindowInfo::getWindowType (Window id)
     unsigned long n, left;
     unsigned char *data;
 
-    result = XGetWindowProperty (dpy , id,
-				 Atoms::winType,
-				 0L, 1L, false, XA_ATOM, &actual, &format,
-				 &n, &left, &data);
+    result = compiz::window::getWindowProperty (dpy , id,
+						Atoms::winType,
+						0L, 1L, false, XA_ATOM, &actual, &format,
+						&n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1838,10 +2028,10 @@ cps::XWindowInfo::getMwmHints (Window       id,
     *func  = MwmFuncAll;
     *decor = MwmDecorAll;
 
-    result = XGetWindowProperty (dpy, id,
-				 Atoms::mwmHints,
-				 0L, 20L, false, AnyPropertyType,
-				 &actual, &format, &n, &left, &data);
+    result = compiz::window::getWindowProperty (dpy, id,
+						Atoms::mwmHints,
+						0L, 20L, false, AnyPropertyType,
+						&actual, &format, &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1867,7 +2057,7 @@ cps::XWindowInfo::getProtocols (Window id)
     int          count;
     unsigned int protocols = 0;
 
-    if (XGetWMProtocols (dpy, id, &protocol, &count))
+    if (compiz::window::getWMProtocols (dpy, id, &protocol, &count))
     {
 	for (int i = 0; i < count; i++)
 	{
@@ -1898,9 +2088,9 @@ CompScreenImpl::getWindowProp (Window       id,
     unsigned char *data;
     unsigned int  retval = defaultValue;
 
-    result = XGetWindowProperty (privateScreen.dpy, id, property,
-				 0L, 1L, false, XA_CARDINAL, &actual, &format,
-				 &n, &left, &data);
+    result = compiz::window::getWindowProperty (privateScreen.dpy, id, property,
+						0L, 1L, false, XA_CARDINAL, &actual, &format,
+						&n, &left, &data);
 
     if (result == Success && data)
     {
@@ -2032,21 +2222,16 @@ ScreenInterface::logMessage (const char   *componentName,
     WRAPABLE_DEF (logMessage, componentName, level, message)
 
 
-bool
-PrivateScreen::desktopHintEqual (unsigned long *data,
-				 int           size,
-				 int           offset,
-				 int           hintSize)
+void
+PrivateScreen::writeProperty (Window              id,
+			      Atom                property,
+			      Atom                type,
+			      int                 format,
+			      const unsigned char *data,
+			      int                 nElements)
 {
-    if (size != desktopHintSize)
-	return false;
-
-    if (memcmp (data + offset,
-		desktopHintData + offset,
-		hintSize * sizeof (unsigned long)) == 0)
-	return true;
-
-    return false;
+    XChangeProperty (dpy, id, property, type, format, PropModeReplace,
+		     data, nElements);
 }
 
 void
@@ -2070,10 +2255,8 @@ PrivateScreen::setDesktopHints ()
 	data[offset + i * 2 + 1] = viewPort.vp.y () * screen->height ();
     }
 
-    if (!desktopHintEqual (data, dSize, offset, hintSize))
-	XChangeProperty (dpy, rootWindow(),
-			 Atoms::desktopViewport,
-			 XA_CARDINAL, 32, PropModeReplace,
+    propertyBatch.stage (rootWindow (), Atoms::desktopViewport,
+			 XA_CARDINAL, 32,
 			 (unsigned char *) &data[offset], hintSize);
 
     offset += hintSize;
@@ -2084,10 +2267,8 @@ PrivateScreen::setDesktopHints ()
 	data[offset + i * 2 + 1] = screen->height () * viewPort.vpSize.height ();
     }
 
-    if (!desktopHintEqual (data, dSize, offset, hintSize))
-	XChangeProperty (dpy, rootWindow(),
-			 Atoms::desktopGeometry,
-			 XA_CARDINAL, 32, PropModeReplace,
+    propertyBatch.stage (rootWindow (), Atoms::desktopGeometry,
+			 XA_CARDINAL, 32,
 			 (unsigned char *) &data[offset], hintSize);
 
     offset += hintSize;
@@ -2101,10 +2282,8 @@ PrivateScreen::setDesktopHints ()
 	data[offset + i * 4 + 3] = workArea.height ();
     }
 
-    if (!desktopHintEqual (data, dSize, offset, hintSize))
-	XChangeProperty (dpy, rootWindow(),
-			 Atoms::workarea,
-			 XA_CARDINAL, 32, PropModeReplace,
+    propertyBatch.stage (rootWindow (), Atoms::workarea,
+			 XA_CARDINAL, 32,
 			 (unsigned char *) &data[offset], hintSize);
 
     offset += hintSize;
@@ -2112,17 +2291,11 @@ PrivateScreen::setDesktopHints ()
     data[offset] = nDesktop;
     hintSize = 1;
 
-    if (!desktopHintEqual (data, dSize, offset, hintSize))
-	XChangeProperty (dpy, rootWindow(),
-			 Atoms::numberOfDesktops,
-			 XA_CARDINAL, 32, PropModeReplace,
+    propertyBatch.stage (rootWindow (), Atoms::numberOfDesktops,
+			 XA_CARDINAL, 32,
 			 (unsigned char *) &data[offset], hintSize);
 
-    if (desktopHintData)
-	free (desktopHintData);
-
-    desktopHintData = data;
-    desktopHintSize = dSize;
+    free (data);
 }
 
 void
@@ -2696,15 +2869,13 @@ PrivateScreen::getDesktopHints (unsigned int showingDesktopMask)
 
     data[0] = currentDesktop;
 
-    XChangeProperty (dpy, rootWindow(), Atoms::currentDesktop,
-		     XA_CARDINAL, 32, PropModeReplace,
-		     (unsigned char *) data, 1);
+    propertyBatch.stage (rootWindow (), Atoms::currentDesktop,
+			 XA_CARDINAL, 32, (unsigned char *) data, 1);
 
     data[0] = showingDesktopMask ? true : false;
 
-    XChangeProperty (dpy, rootWindow(), Atoms::showingDesktop,
-		     XA_CARDINAL, 32, PropModeReplace,
-		     (unsigned char *) data, 1);
+    propertyBatch.stage (rootWindow (), Atoms::showingDesktop,
+			 XA_CARDINAL, 32, (unsigned char *) data, 1);
 }
 
 void
@@ -2759,10 +2930,10 @@ CompScreenImpl::_enterShowDesktopMode ()
 	data = 0;
     }
 
-    XChangeProperty (privateScreen.dpy, privateScreen.rootWindow(),
-		     Atoms::showingDesktop,
-		     XA_CARDINAL, 32, PropModeReplace,
-		     (unsigned char *) &data, 1);
+    privateScreen.propertyBatch.stage (privateScreen.rootWindow (),
+				       Atoms::showingDesktop,
+				       XA_CARDINAL, 32,
+				       (unsigned char *) &data, 1);
 }
 
 void
@@ -2815,10 +2986,10 @@ CompScreenImpl::_leaveShowDesktopMode (CompWindow *window)
 	focusDefaultWindow ();
     }
 
-    XChangeProperty (privateScreen.dpy, privateScreen.rootWindow(),
-		     Atoms::showingDesktop,
-		     XA_CARDINAL, 32, PropModeReplace,
-		     (unsigned char *) &data, 1);
+    privateScreen.propertyBatch.stage (privateScreen.rootWindow (),
+				       Atoms::showingDesktop,
+				       XA_CARDINAL, 32,
+				       (unsigned char *) &data, 1);
 }
 
 void
@@ -3060,21 +3231,12 @@ cps::WindowManager::insertServerWindow(CompWindow* w, Window aboveId)
 	    w->serverNext = serverWindows.front ();
 	}
 	serverWindows.push_front (w);
+	indexServerWindow (w, serverWindows.begin ());
 
 	return;
     }
 
-    CompWindowList::iterator it = serverWindows.begin ();
-
-    while (it != serverWindows.end ())
-    {
-	if ((*it)->priv->serverId == aboveId ||
-	    ((*it)->priv->serverFrame && (*it)->priv->serverFrame == aboveId))
-	{
-	    break;
-	}
-	++it;
-    }
+    CompWindowList::iterator it = findServerWindow (aboveId);
 
     if (it == serverWindows.end ())
     {
@@ -3095,7 +3257,7 @@ cps::WindowManager::insertServerWindow(CompWindow* w, Window aboveId)
 	w->serverNext->serverPrev = w;
     }
 
-    serverWindows.insert (++it, w);
+    indexServerWindow (w, serverWindows.insert (++it, w));
 }
 
 void
@@ -3157,16 +3319,14 @@ cps::WindowManager::unhookServerWindow (CompWindow *w)
     if (dbg)
 	dbg->serverWindowsChanged (true);
 
-    CompWindowList::iterator it =
-	std::find (serverWindows.begin (), serverWindows.end (), w);
-
-    if (it == serverWindows.end ())
+    if (!w->priv->inServerStack)
     {
 	compLogMessage ("core", CompLogLevelWarn, "a broken plugin tried to remove a window twice, we won't allow that!");
 	return;
     }
 
-    serverWindows.erase (it);
+    serverWindows.erase (w->priv->serverStackEntry);
+    unindexServerWindow (w);
 
     if (w->serverNext)
 	w->serverNext->serverPrev = w->serverPrev;
@@ -3687,6 +3847,8 @@ void cps::GrabManager::updatePassiveButtonGrabs(Window serverFrame)
 	}
     }
 
+    compiz::window::buttongrab::Grabs grabs;
+
     /* Grab only we have bindings on */
     foreach (ButtonGrab &bind, buttonGrabs)
     {
@@ -3709,19 +3871,22 @@ void cps::GrabManager::updatePassiveButtonGrabs(Window serverFrame)
 		!mods)
 		continue;
 
-	    XGrabButton (screen->dpy(),
-			 bind.button,
-			 mods | ignore,
-			 serverFrame,
-			 false,
-			 ButtonPressMask | ButtonReleaseMask |
-			    ButtonMotionMask,
-			 GrabModeSync,
-			 GrabModeAsync,
-			 None,
-			 None);
+	    grabs.insert (compiz::window::buttongrab::Grab (bind.button,
+							    mods | ignore));
 	}
     }
+
+    compiz::window::buttongrab::XInterface x (screen->dpy ());
+
+    /* Only send what changed since the last time */
+    if (window)
+	window->priv->buttonGrabState.grabOnly (x, serverFrame, grabs);
+    else
+    {
+	compiz::window::buttongrab::State state;
+
+	state.grabOnly (x, serverFrame, grabs);
+    }
 }
 
 void
@@ -3904,14 +4069,14 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
 	    clientIdList.clear ();
 	    clientIdListStacking.clear ();
 
-	    XChangeProperty (ps.dpy, ps.rootWindow(),
-			     Atoms::clientList,
-			     XA_WINDOW, 32, PropModeReplace,
-			     (unsigned char *) &ps.eventManager.getGrabWindow(), 1);
-	    XChangeProperty (ps.dpy, ps.rootWindow(),
-			     Atoms::clientListStacking,
-			     XA_WINDOW, 32, PropModeReplace,
-			     (unsigned char *) &ps.eventManager.getGrabWindow(), 1);
+	    ps.propertyBatch.stage (ps.rootWindow (),
+				    Atoms::clientList,
+				    XA_WINDOW, 32,
+				    (unsigned char *) &ps.eventManager.getGrabWindow(), 1);
+	    ps.propertyBatch.stage (ps.rootWindow (),
+				    Atoms::clientListStacking,
+				    XA_WINDOW, 32,
+				    (unsigned char *) &ps.eventManager.getGrabWindow(), 1);
 	}
 
 	return;
@@ -3964,17 +4129,17 @@ cps::WindowManager::updateClientList (PrivateScreen& ps)
     }
 
     if (updateClientList)
-	XChangeProperty (ps.dpy, ps.rootWindow(),
-			 Atoms::clientList,
-			 XA_WINDOW, 32, PropModeReplace,
-			 (unsigned char *) &clientIdList.at (0), n);
+	ps.propertyBatch.stage (ps.rootWindow (),
+				Atoms::clientList,
+				XA_WINDOW, 32,
+				(unsigned char *) &clientIdList.at (0), n);
 
     if (updateClientListStacking)
-	XChangeProperty (ps.dpy, ps.rootWindow(),
-			 Atoms::clientListStacking,
-			 XA_WINDOW, 32, PropModeReplace,
-			 (unsigned char *) &clientIdListStacking.at (0),
-			 n);
+	ps.propertyBatch.stage (ps.rootWindow (),
+				Atoms::clientListStacking,
+				XA_WINDOW, 32,
+				(unsigned char *) &clientIdListStacking.at (0),
+				n);
 }
 
 const CompWindowVector &
@@ -4285,9 +4450,8 @@ PrivateScreen::setCurrentDesktop (unsigned int desktop)
 
     unsigned long data = desktop;
 
-    XChangeProperty (dpy, rootWindow(), Atoms::currentDesktop,
-		     XA_CARDINAL, 32, PropModeReplace,
-		     (unsigned char *) &data, 1);
+    propertyBatch.stage (rootWindow (), Atoms::currentDesktop,
+			 XA_CARDINAL, 32, (unsigned char *) &data, 1);
 }
 
 const CompRect&
@@ -4546,6 +4710,20 @@ PrivateScreen::identifyEdgeWindow(Window id)
     }
 }
 
+void
+PrivateScreen::handleWarpCrossing(const XEvent &event)
+{
+    if (event.type == EnterNotify)
+    {
+	if (event.xcrossing.mode != NotifyGrab ||
+	    event.xcrossing.mode != NotifyUngrab ||
+	    event.xcrossing.mode != NotifyInferior)
+	{
+	    identifyEdgeWindow(event.xcrossing.window);
+	}
+    }
+}
+
 void
 CompScreenImpl::warpPointer (int dx,
 			 int dy)
@@ -4584,23 +4762,18 @@ CompScreenImpl::warpPointer (int dx,
      *
      * FIXME: Probably don't need to process *all* the crossing
      * events here ... maybe there is a way to check only the last
-     * event in the output buffer without roundtripping a lot */
-    while (XCheckMaskEvent (privateScreen.dpy,
-			    LeaveWindowMask |
-			    EnterWindowMask |
-			    PointerMotionMask,
-			    &event))
-    {
-	if (event.type == EnterNotify)
-	{
-	    if (event.xcrossing.mode != NotifyGrab ||
-		event.xcrossing.mode != NotifyUngrab ||
-		event.xcrossing.mode != NotifyInferior)
-	    {
-		privateScreen.identifyEdgeWindow(event.xcrossing.window);
-	    }
-	}
-    }
+     * event in the output buffer without roundtripping a lot
+     *
+     * Events which were already taken off the Xlib queue are
+     * waiting in the event coalescer, so drop them there too */
+    long warpMask = LeaveWindowMask | EnterWindowMask | PointerMotionMask;
+
+    privateScreen.eventCoalescer.discard (warpMask,
+					  boost::bind (&PrivateScreen::handleWarpCrossing,
+						       &privateScreen, _1));
+
+    while (XCheckMaskEvent (privateScreen.dpy, warpMask, &event))
+	privateScreen.handleWarpCrossing (event);
 
     if (!inHandleEvent)
     {
@@ -5199,6 +5372,7 @@ PrivateScreen::initDisplay (const char *name, cps::History& history, unsigned in
     screenNum = DefaultScreen (dpy);
     colormap  = DefaultColormap (dpy, screenNum);
     root = root_tmp;
+    propertyBatch.own (root);
 
     snContext = sn_monitor_context_new (snDisplay, screenNum,
 					      compScreenSnEvent, this, NULL);
@@ -5433,6 +5607,53 @@ PrivateScreen::initDisplay (const char *name, cps::History& history, unsigned in
 		&rootReturn, &parentReturn,
 		&children, &nchildren);
 
+    /* Everything the CompWindow constructor reads from the server is
+     * requested for all windows up front and collected in one go,
+     * rather than waiting on a round trip for every attribute and
+     * property of every window. This happens while the server is still
+     * grabbed so the snapshot is consistent, and input is selected
+     * before the grab is released so no property change in between
+     * is missed */
+    const Atom adoptionProperties[] =
+    {
+	Atoms::winState,
+	Atoms::winType,
+	Atoms::winDesktop,
+	Atoms::wmState,
+	Atoms::wmProtocols,
+	Atoms::wmStrutPartial,
+	Atoms::wmStrut,
+	Atoms::wmClientLeader,
+	Atoms::wmIconGeometry,
+	Atoms::startupId,
+	Atoms::mwmHints,
+	Atoms::frameGtkExtents,
+	XA_WM_CLASS,
+	XA_WM_HINTS,
+	XA_WM_NORMAL_HINTS,
+	XA_WM_TRANSIENT_FOR
+    };
+
+    compiz::window::PropertyPrefetch prefetch (dpy);
+
+    prefetch.request (children, nchildren,
+		      std::vector<Atom> (adoptionProperties,
+					 adoptionProperties +
+					 sizeof (adoptionProperties) / sizeof (Atom)));
+    prefetch.collect ();
+
+    for (unsigned int i = 0; i < nchildren; i++)
+    {
+	XWindowAttributes attrib;
+
+	if (prefetch.attributes (children[i], &attrib))
+	    XSelectInput (dpy, children[i],
+			  attrib.your_event_mask |
+			  PropertyChangeMask     |
+			  EnterWindowMask        |
+			  FocusChangeMask);
+    }
+
     XUngrabServer (dpy);
     XSync (dpy, FALSE);
 
@@ -5447,11 +5668,13 @@ PrivateScreen::initDisplay (const char *name, cps::History& history, unsigned in
 	 * for it
 	 */
 
-	if (!XGetWindowAttributes (screen->dpy (), children[i], &attrib))
+	if (!prefetch.attributes (children[i], &attrib))
 	    setDefaultWindowAttributes(&attrib);
 
 	Window topWindowInTree = i ? children[i - 1] : None;
 
+	compiz::window::PropertyPrefetch::Scope scope (prefetch, children[i]);
+
 	PrivateWindow::createCompWindow (topWindowInTree, topWindowInTree, attrib, children[i]);
     }
 
@@ -5578,14 +5801,14 @@ PrivateScreen::PrivateScreen (CompScreen *screen, cps::WindowManager& windowMana
     clientPointerDeviceId (None),
     invisibleCursor (None),
     initialized (false),
+    propertyBatch (boost::bind (&PrivateScreen::writeProperty, this,
+				_1, _2, _3, _4, _5, _6)),
     screen(screen),
     screenInfo (),
     snDisplay(0),
     root(None),
     snContext (0),
     wmSnAtom (None),
-    desktopHintData (0),
-    desktopHintSize (0),
     edgeWindow (None),
     edgeDelayTimer (),
     xdndWindow (None),
@@ -5598,6 +5821,14 @@ PrivateScreen::PrivateScreen (CompScreen *screen, cps::WindowManager& windowMana
 	screenEdge[i].count = 0;
     }
 
+    eventCoalescer.addRule (MotionNotify,
+			    compiz::core::coalesce::motionKey,
+			    compiz::core::coalesce::mergeMotion);
+    eventCoalescer.addRule (ConfigureNotify,
+			    compiz::core::coalesce::configureKey,
+			    boost::bind (&PrivateScreen::coalesceConfigure,
+					 this, _1, _2),
+			    compiz::core::EventCoalescer::OrderedAcrossKeys);
 }
 
 cps::History::History() :
@@ -5725,9 +5956,6 @@ PrivateScreen::~PrivateScreen ()
 	XCloseDisplay (dpy);
     }
 
-    if (desktopHintData)
-	free (desktopHintData);
-
     if (snDisplay)
 	sn_display_unref (snDisplay);
 }
@@ -0,0 +1,114 @@
+/*
+ * Compiz, parallel for over a shared pool of worker threads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_THREADPOOL_H
+#define _COMPIZ_THREADPOOL_H
+
+#include <boost/function.hpp>
+
+namespace compiz
+{
+namespace core
+{
+
+class PrivateThreadPool;
+
+/**
+ * A fixed set of worker threads for spreading independent, CPU bound
+ * work across cores.
+ *
+ * Work is only ever handed out through parallelFor (), which splits
+ * an index range into chunks and blocks until every chunk has run.
+ * Each participating thread owns a queue of chunks and steals from
+ * the others once its own queue is empty, so uneven chunks (eg, one
+ * window with a much larger model) don't leave cores idle.
+ *
+ * The function passed to parallelFor () runs concurrently on several
+ * threads and therefore:
+ *  - must only touch state belonging to the index it was called
+ *    with, and only read shared state
+ *  - must not make any X or GL calls, including indirectly through
+ *    CompWindow / CompScreen / GLScreen methods which talk to the
+ *    server or the GL context, or which wrap into plugins
+ *  - must not damage, create timers, or otherwise call back into
+ *    the main loop
+ *  - must not throw
+ * Anything which needs one of those has to happen after parallelFor ()
+ * returns, back on the main thread.
+ */
+class ThreadPool
+{
+    public:
+
+	typedef boost::function <void (unsigned int)> Function;
+
+	/**
+	 * Creates a pool with nWorkers threads in addition to the
+	 * calling thread, which always takes part in the work.
+	 */
+	explicit ThreadPool (unsigned int nWorkers);
+	~ThreadPool ();
+
+	/**
+	 * Number of threads that take part in a parallelFor (), including
+	 * the calling one
+	 */
+	unsigned int concurrency () const;
+
+	/**
+	 * Calls function (i) for every i in [0, count) and returns once
+	 * all calls have completed. Indices are handed out in chunks of
+	 * grain; a grain of zero picks one based on count and the number
+	 * of threads. Called from inside one of its own functions it
+	 * degrades to a plain loop.
+	 */
+	void parallelFor (unsigned int   count,
+			  const Function &function,
+			  unsigned int   grain = 0);
+
+	/**
+	 * The pool shared by core and plugins, sized to the number of
+	 * processors. Created on first use.
+	 */
+	static ThreadPool & shared ();
+
+    private:
+
+	ThreadPool (const ThreadPool &);
+	ThreadPool & operator= (const ThreadPool &);
+
+	PrivateThreadPool *priv;
+};
+
+/**
+ * Shorthand for ThreadPool::shared ().parallelFor (). Intended for
+ * pure, window local updates in preparePaint, see ThreadPool for the
+ * rules the function has to follow.
+ */
+void parallelFor (unsigned int             count,
+		  const ThreadPool::Function &function,
+		  unsigned int             grain = 0);
+
+}
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Compiz, parallel for over a shared pool of worker threads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PRIVATETHREADPOOL_H
+#define _COMPIZ_PRIVATETHREADPOOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <core/threadpool.h>
+
+namespace compiz
+{
+namespace core
+{
+
+class PrivateThreadPool
+{
+    public:
+
+	/* A contiguous run of indices, carrying the function it has
+	 * to be run with so that a late waking worker can never mix
+	 * up two consecutive parallelFor () calls */
+	struct Chunk
+	{
+	    unsigned int               begin;
+	    unsigned int               end;
+	    const ThreadPool::Function *function;
+	};
+
+	struct Queue
+	{
+	    std::mutex        lock;
+	    std::deque<Chunk> chunks;
+	};
+
+	PrivateThreadPool (unsigned int nWorkers);
+	~PrivateThreadPool ();
+
+	void workerMain (unsigned int id);
+
+	bool takeChunk (unsigned int id, Chunk &chunk);
+	void runChunks (unsigned int id);
+
+	std::vector<std::thread> workers;
+
+	/* One queue per participant, queues[0] belongs to the thread
+	 * calling parallelFor () */
+	std::vector<Queue *>     queues;
+
+	std::mutex               lock;
+	std::condition_variable  wake;
+	std::condition_variable  done;
+	unsigned long            generation;
+	unsigned int             pending;
+	bool                     quit;
+
+	/* Serialises parallelFor () callers */
+	std::mutex               running;
+};
+
+}
+}
+
+#endif
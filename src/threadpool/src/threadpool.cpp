@@ -0,0 +1,235 @@
+/*
+ * Compiz, parallel for over a shared pool of worker threads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include "privatethreadpool.h"
+
+namespace cc = compiz::core;
+
+namespace
+{
+    /* Set on pool threads and while the calling thread runs chunks,
+     * nested parallelFor () calls just run inline */
+    thread_local bool insideParallelFor = false;
+
+    /* Chunks per participating thread when no grain is given, a few
+     * so that stealing can even out uneven work */
+    const unsigned int chunksPerThread = 4;
+}
+
+cc::PrivateThreadPool::PrivateThreadPool (unsigned int nWorkers) :
+    generation (0),
+    pending (0),
+    quit (false)
+{
+    for (unsigned int i = 0; i <= nWorkers; ++i)
+	queues.push_back (new Queue ());
+
+    for (unsigned int i = 1; i <= nWorkers; ++i)
+	workers.push_back (std::thread (&PrivateThreadPool::workerMain, this, i));
+}
+
+cc::PrivateThreadPool::~PrivateThreadPool ()
+{
+    {
+	std::lock_guard<std::mutex> l (lock);
+	quit = true;
+    }
+
+    wake.notify_all ();
+
+    for (std::vector<std::thread>::iterator it = workers.begin ();
+	 it != workers.end (); ++it)
+	it->join ();
+
+    for (std::vector<Queue *>::iterator it = queues.begin ();
+	 it != queues.end (); ++it)
+	delete *it;
+}
+
+bool
+cc::PrivateThreadPool::takeChunk (unsigned int id,
+				  Chunk        &chunk)
+{
+    /* Own queue first, from the front */
+    {
+	Queue &own = *queues[id];
+	std::lock_guard<std::mutex> l (own.lock);
+
+	if (!own.chunks.empty ())
+	{
+	    chunk = own.chunks.front ();
+	    own.chunks.pop_front ();
+	    return true;
+	}
+    }
+
+    /* Then steal from the back of everyone else's */
+    for (unsigned int i = 1; i < queues.size (); ++i)
+    {
+	Queue &victim = *queues[(id + i) % queues.size ()];
+	std::lock_guard<std::mutex> l (victim.lock);
+
+	if (!victim.chunks.empty ())
+	{
+	    chunk = victim.chunks.back ();
+	    victim.chunks.pop_back ();
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+void
+cc::PrivateThreadPool::runChunks (unsigned int id)
+{
+    Chunk chunk;
+
+    while (takeChunk (id, chunk))
+    {
+	for (unsigned int i = chunk.begin; i < chunk.end; ++i)
+	    (*chunk.function) (i);
+
+	std::lock_guard<std::mutex> l (lock);
+
+	if (--pending == 0)
+	    done.notify_all ();
+    }
+}
+
+void
+cc::PrivateThreadPool::workerMain (unsigned int id)
+{
+    unsigned long seen = 0;
+
+    insideParallelFor = true;
+
+    for (;;)
+    {
+	{
+	    std::unique_lock<std::mutex> l (lock);
+
+	    while (!quit && seen == generation)
+		wake.wait (l);
+
+	    if (quit)
+		return;
+
+	    seen = generation;
+	}
+
+	runChunks (id);
+    }
+}
+
+cc::ThreadPool::ThreadPool (unsigned int nWorkers) :
+    priv (new PrivateThreadPool (nWorkers))
+{
+}
+
+cc::ThreadPool::~ThreadPool ()
+{
+    delete priv;
+}
+
+unsigned int
+cc::ThreadPool::concurrency () const
+{
+    return priv->queues.size ();
+}
+
+void
+cc::ThreadPool::parallelFor (unsigned int   count,
+			     const Function &function,
+			     unsigned int   grain)
+{
+    unsigned int nThreads = priv->queues.size ();
+
+    if (!grain)
+	grain = std::max (1u, count / (nThreads * chunksPerThread));
+
+    if (insideParallelFor || nThreads == 1 || count <= grain)
+    {
+	for (unsigned int i = 0; i < count; ++i)
+	    function (i);
+
+	return;
+    }
+
+    std::lock_guard<std::mutex> running (priv->running);
+
+    /* Workers still draining the previous call may pick up new chunks
+     * as soon as they are queued, so account for them first */
+    {
+	std::lock_guard<std::mutex> l (priv->lock);
+	priv->pending = (count + grain - 1) / grain;
+    }
+
+    unsigned int n = 0;
+
+    for (unsigned int begin = 0; begin < count; begin += grain, ++n)
+    {
+	PrivateThreadPool::Chunk chunk;
+	PrivateThreadPool::Queue &queue = *priv->queues[n % nThreads];
+
+	chunk.begin    = begin;
+	chunk.end      = std::min (count, begin + grain);
+	chunk.function = &function;
+
+	std::lock_guard<std::mutex> l (queue.lock);
+	queue.chunks.push_back (chunk);
+    }
+
+    {
+	std::lock_guard<std::mutex> l (priv->lock);
+	++priv->generation;
+    }
+
+    priv->wake.notify_all ();
+
+    insideParallelFor = true;
+    priv->runChunks (0);
+    insideParallelFor = false;
+
+    std::unique_lock<std::mutex> l (priv->lock);
+
+    while (priv->pending)
+	priv->done.wait (l);
+}
+
+cc::ThreadPool &
+cc::ThreadPool::shared ()
+{
+    static ThreadPool pool (std::max (1u, std::thread::hardware_concurrency ()) - 1);
+
+    return pool;
+}
+
+void
+cc::parallelFor (unsigned int             count,
+		 const ThreadPool::Function &function,
+		 unsigned int             grain)
+{
+    ThreadPool::shared ().parallelFor (count, function, grain);
+}
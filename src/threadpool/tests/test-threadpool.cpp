@@ -0,0 +1,177 @@
+/*
+ * Compiz, parallel for over a shared pool of worker threads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+#include <core/threadpool.h>
+
+namespace cc = compiz::core;
+
+namespace
+{
+    void
+    increment (std::vector<int> *visits,
+	       unsigned int     i)
+    {
+	++(*visits)[i];
+    }
+
+    void
+    recordThread (std::mutex                  *lock,
+		  std::set<std::thread::id>   *threads,
+		  unsigned int)
+    {
+	/* Give the other threads a chance to take part */
+	std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+	std::lock_guard<std::mutex> l (*lock);
+	threads->insert (std::this_thread::get_id ());
+    }
+
+    void
+    nested (cc::ThreadPool   *pool,
+	    std::vector<int> *visits,
+	    unsigned int     outer)
+    {
+	std::vector<int> inner (10, 0);
+
+	pool->parallelFor (inner.size (),
+			   boost::bind (increment, &inner, _1));
+
+	for (unsigned int i = 0; i < inner.size (); ++i)
+	    if (inner[i] == 1)
+		++(*visits)[outer];
+    }
+}
+
+class ThreadPoolTest :
+    public ::testing::TestWithParam <unsigned int>
+{
+    public:
+
+	ThreadPoolTest () :
+	    pool (GetParam ())
+	{
+	}
+
+    protected:
+
+	cc::ThreadPool pool;
+};
+
+TEST_P (ThreadPoolTest, Concurrency)
+{
+    EXPECT_EQ (GetParam () + 1, pool.concurrency ());
+}
+
+TEST_P (ThreadPoolTest, EmptyRangeDoesNothing)
+{
+    std::vector<int> visits;
+
+    pool.parallelFor (0, boost::bind (increment, &visits, _1));
+}
+
+TEST_P (ThreadPoolTest, VisitsEveryIndexOnce)
+{
+    std::vector<int> visits (1000, 0);
+
+    pool.parallelFor (visits.size (), boost::bind (increment, &visits, _1));
+
+    for (unsigned int i = 0; i < visits.size (); ++i)
+	EXPECT_EQ (1, visits[i]) << "index " << i;
+}
+
+TEST_P (ThreadPoolTest, VisitsEveryIndexOnceWithUnevenGrain)
+{
+    std::vector<int> visits (997, 0);
+
+    pool.parallelFor (visits.size (), boost::bind (increment, &visits, _1), 13);
+
+    for (unsigned int i = 0; i < visits.size (); ++i)
+	EXPECT_EQ (1, visits[i]) << "index " << i;
+}
+
+TEST_P (ThreadPoolTest, GrainLargerThanCount)
+{
+    std::vector<int> visits (5, 0);
+
+    pool.parallelFor (visits.size (), boost::bind (increment, &visits, _1), 64);
+
+    for (unsigned int i = 0; i < visits.size (); ++i)
+	EXPECT_EQ (1, visits[i]);
+}
+
+TEST_P (ThreadPoolTest, RepeatedCallsDontInterfere)
+{
+    for (unsigned int run = 0; run < 200; ++run)
+    {
+	std::vector<int> visits (64 + run, 0);
+
+	pool.parallelFor (visits.size (), boost::bind (increment, &visits, _1), 1);
+
+	for (unsigned int i = 0; i < visits.size (); ++i)
+	    ASSERT_EQ (1, visits[i]) << "run " << run << " index " << i;
+    }
+}
+
+TEST_P (ThreadPoolTest, NestedCallsRunInline)
+{
+    std::vector<int> visits (32, 0);
+
+    pool.parallelFor (visits.size (), boost::bind (nested, &pool, &visits, _1), 1);
+
+    for (unsigned int i = 0; i < visits.size (); ++i)
+	EXPECT_EQ (10, visits[i]);
+}
+
+TEST_P (ThreadPoolTest, UsesNoMoreThreadsThanConcurrency)
+{
+    std::mutex                lock;
+    std::set<std::thread::id> threads;
+
+    pool.parallelFor (64, boost::bind (recordThread, &lock, &threads, _1), 1);
+
+    EXPECT_GE (pool.concurrency (), threads.size ());
+    EXPECT_LE (1u, threads.size ());
+}
+
+INSTANTIATE_TEST_CASE_P (Workers, ThreadPoolTest,
+			 ::testing::Values (0u, 1u, 3u, 8u));
+
+TEST (SharedThreadPoolTest, VisitsEveryIndexOnce)
+{
+    std::vector<int> visits (256, 0);
+
+    cc::parallelFor (visits.size (), boost::bind (increment, &visits, _1));
+
+    for (unsigned int i = 0; i < visits.size (); ++i)
+	EXPECT_EQ (1, visits[i]);
+
+    EXPECT_EQ (&cc::ThreadPool::shared (), &cc::ThreadPool::shared ());
+    EXPECT_LE (1u, cc::ThreadPool::shared ().concurrency ());
+}
@@ -35,6 +35,7 @@
 #include <stdint.h>
 #include <assert.h>
 #include <math.h>
+#include <time.h>
 
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
@@ -43,6 +44,7 @@
 #include <core/icon.h>
 #include <core/atoms.h>
 #include "core/windowconstrainment.h"
+#include "core/windowprefetch.h"
 #include "privatewindow.h"
 #include "privatescreen.h"
 #include "privatestackdebugger.h"
@@ -230,8 +232,8 @@ void
 PrivateWindow::updateNormalHints ()
 {
     long   supplied;
-    Status status = XGetWMNormalHints (screen->dpy (), priv->id,
-				       &priv->sizeHints, &supplied);
+    Status status = compiz::window::getWMNormalHints (screen->dpy (), priv->id,
+						      &priv->sizeHints, &supplied);
 
     if (!status)
 	priv->sizeHints.flags = 0;
@@ -250,7 +252,7 @@ PrivateWindow::updateWmHints ()
 
     inputHint = true;
 
-    XWMHints *newHints = XGetWMHints (screen->dpy (), id);
+    XWMHints *newHints = compiz::window::getWMHints (screen->dpy (), id);
 
     if (newHints)
     {
@@ -297,8 +299,8 @@ PrivateWindow::updateClassHints ()
     }
 
     XClassHint classHint;
-    int        status = XGetClassHint (screen->dpy (),
-				       priv->id, &classHint);
+    int        status = compiz::window::getClassHint (screen->dpy (),
+						      priv->id, &classHint);
 
     if (status)
     {
@@ -323,8 +325,8 @@ PrivateWindow::updateTransientHint ()
 
     priv->transientFor = None;
 
-    Status status = XGetTransientForHint (screen->dpy (),
-					  priv->id, &transientFor);
+    Status status = compiz::window::getTransientForHint (screen->dpy (),
+							 priv->id, &transientFor);
 
     if (status)
     {
@@ -352,10 +354,10 @@ PrivateWindow::updateIconGeometry ()
 
     priv->iconGeometry.setGeometry (0, 0, 0, 0);
 
-    int result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::wmIconGeometry,
-				     0L, 1024L, False, XA_CARDINAL,
-				     &actual, &format, &n, &left, &data);
+    int result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::wmIconGeometry,
+						    0L, 1024L, False, XA_CARDINAL,
+						    &actual, &format, &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -381,10 +383,10 @@ PrivateWindow::updateClientFrame ()
     unsigned long n, left;
     unsigned char *data;
 
-    int result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::frameGtkExtents,
-				     0L, 65536, False, XA_CARDINAL,
-				     &actual, &format, &n, &left, &data);
+    int result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::frameGtkExtents,
+						    0L, 65536, False, XA_CARDINAL,
+						    &actual, &format, &n, &left, &data);
 
     if (result == Success && actual == XA_CARDINAL && data)
     {
@@ -432,10 +434,10 @@ PrivateWindow::getClientLeader ()
     unsigned long n, left;
     unsigned char *data;
 
-    int result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::wmClientLeader,
-				     0L, 1L, False, XA_WINDOW, &actual, &format,
-				     &n, &left, &data);
+    int result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::wmClientLeader,
+						    0L, 1L, False, XA_WINDOW, &actual, &format,
+						    &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -461,12 +463,12 @@ PrivateWindow::getStartupId ()
     unsigned long n, left;
     unsigned char *data;
 
-    int result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::startupId,
-				     0L, 1024L, False,
-				     Atoms::utf8String,
-				     &actual, &format,
-				     &n, &left, &data);
+    int result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::startupId,
+						    0L, 1024L, False,
+						    Atoms::utf8String,
+						    &actual, &format,
+						    &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1040,10 +1042,10 @@ CompWindow::updateStruts ()
     newStrut.bottom.width  = screen->width ();
     newStrut.bottom.height = 0;
 
-    int result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::wmStrutPartial,
-				     0L, 12L, false, XA_CARDINAL, &actual, &format,
-				     &n, &left, &data);
+    int result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::wmStrutPartial,
+						    0L, 12L, false, XA_CARDINAL, &actual, &format,
+						    &n, &left, &data);
 
     if (result == Success && data)
     {
@@ -1077,10 +1079,10 @@ CompWindow::updateStruts ()
 
     if (!hasNew)
     {
-	result = XGetWindowProperty (screen->dpy (), priv->id,
-				     Atoms::wmStrut,
-				     0L, 4L, false, XA_CARDINAL,
-				     &actual, &format, &n, &left, &data);
+	result = compiz::window::getWindowProperty (screen->dpy (), priv->id,
+						    Atoms::wmStrut,
+						    0L, 4L, false, XA_CARDINAL,
+						    &actual, &format, &n, &left, &data);
 
 	if (result == Success && data)
 	{
@@ -1657,21 +1659,31 @@ PrivateWindow::initializeSyncCounter ()
 
     int result = XGetWindowProperty (screen->dpy (), id,
 				     Atoms::wmSyncRequestCounter,
-				     0L, 1L, false, XA_CARDINAL, &actual, &format,
+				     0L, 2L, false, XA_CARDINAL, &actual, &format,
 				     &n, &left, &data);
 
     if (result == Success && n && data)
     {
 	unsigned long *counter = (unsigned long *) data;
 
-	syncCounter = *counter;
+	/* A second counter is the extended one, which the client makes
+	 * odd while it draws a frame and even again once it is done */
+	syncExtended = n > 1 &&
+		       XSyncQueryCounter (screen->dpy (), counter[1], &syncValue);
+
+	syncCounter = syncExtended ? counter[1] : counter[0];
 
 	XFree (data);
 
-	XSyncIntsToValue (&syncValue, (unsigned int) rand (), 0);
-	XSyncSetCounter (screen->dpy (),
-			 syncCounter,
-			 syncValue);
+	/* The client owns the extended counter, only the basic one is
+	 * ours to set */
+	if (!syncExtended)
+	{
+	    XSyncIntsToValue (&syncValue, (unsigned int) rand (), 0);
+	    XSyncSetCounter (screen->dpy (),
+			     syncCounter,
+			     syncValue);
+	}
 
 	syncValueIncrement (&syncValue);
 
@@ -1729,13 +1741,31 @@ CompWindow::sendSyncRequest ()
     xev.window       = priv->id;
     xev.message_type = Atoms::wmProtocols;
     xev.format       = 32;
+    /* With the extended counter the client decides what the counter is
+     * until it gets here, so ask for a value far enough ahead of the last
+     * one it reported and keep it even, as odd means a frame in progress */
+    if (priv->syncExtended)
+    {
+	XSyncValue ahead;
+	int        overflow;
+
+	XSyncIntToValue (&ahead, 240);
+	XSyncValueAdd (&priv->syncWaitValue, priv->syncValue, ahead, &overflow);
+
+	if (XSyncValueLow32 (priv->syncWaitValue) & 1)
+	    syncValueIncrement (&priv->syncWaitValue);
+    }
+    else
+	priv->syncWaitValue = priv->syncValue;
+
     xev.data.l[0]    = Atoms::wmSyncRequest;
     xev.data.l[1]    = CurrentTime;
-    xev.data.l[2]    = XSyncValueLow32 (priv->syncValue);
-    xev.data.l[3]    = XSyncValueHigh32 (priv->syncValue);
-    xev.data.l[4]    = 0;
+    xev.data.l[2]    = XSyncValueLow32 (priv->syncWaitValue);
+    xev.data.l[3]    = XSyncValueHigh32 (priv->syncWaitValue);
+    xev.data.l[4]    = priv->syncExtended ? 1 : 0;
 
-    syncValueIncrement (&priv->syncValue);
+    if (!priv->syncExtended)
+	syncValueIncrement (&priv->syncValue);
 
     XSendEvent (screen->dpy (), priv->id, false, 0, (XEvent *) &xev);
 
@@ -1746,6 +1776,34 @@ CompWindow::sendSyncRequest ()
 	priv->syncWaitTimer.start ();
 }
 
+void
+CompWindow::frameDrawn ()
+{
+    if (!priv->syncFrameDrawn)
+	return;
+
+    priv->syncFrameDrawn = false;
+
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    uint64_t usec = (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+
+    XClientMessageEvent xev;
+
+    xev.type         = ClientMessage;
+    xev.window       = priv->id;
+    xev.message_type = Atoms::wmFrameDrawn;
+    xev.format       = 32;
+    xev.data.l[0]    = XSyncValueLow32 (priv->syncValue);
+    xev.data.l[1]    = XSyncValueHigh32 (priv->syncValue);
+    xev.data.l[2]    = usec & 0xffffffff;
+    xev.data.l[3]    = usec >> 32;
+    xev.data.l[4]    = 0;
+
+    XSendEvent (screen->dpy (), priv->id, false, 0, (XEvent *) &xev);
+}
+
 void
 PrivateWindow::configure (XConfigureEvent *ce)
 {
@@ -1941,227 +1999,6 @@ PrivateWindow::move (int dx,
     }
 }
 
-bool
-compiz::X11::PendingEventQueue::pending ()
-{
-    return !mEvents.empty ();
-}
-
-void
-compiz::X11::PendingEventQueue::add (PendingEvent::Ptr p)
-{
-    compLogMessage ("core", CompLogLevelDebug, "pending request:");
-    p->dump ();
-
-    mEvents.push_back (p);
-}
-
-bool
-compiz::X11::PendingEventQueue::removeIfMatching (const PendingEvent::Ptr &p, XEvent *event)
-{
-    if (p->match (event))
-    {
-	compLogMessage ("core", CompLogLevelDebug, "received event:");
-	p->dump ();
-	return true;
-    }
-
-    return false;
-}
-
-void
-compiz::X11::PendingEvent::dump ()
-{
-    compLogMessage ("core", CompLogLevelDebug, "- event serial: %i", mSerial);
-    compLogMessage ("core", CompLogLevelDebug,  "- event window 0x%x", mWindow);
-}
-
-void
-compiz::X11::PendingConfigureEvent::dump ()
-{
-    compiz::X11::PendingEvent::dump ();
-
-    compLogMessage ("core", CompLogLevelDebug,  "- x: %i y: %i width: %i height: %i "\
-						 "border: %i, sibling: 0x%x",
-						 mXwc.x, mXwc.y, mXwc.width, mXwc.height, mXwc.border_width, mXwc.sibling);
-}
-
-bool
-compiz::X11::PendingEventQueue::match (XEvent *event)
-{
-    unsigned int lastSize = mEvents.size ();
-
-    mEvents.erase (std::remove_if (mEvents.begin (), mEvents.end (),
-				   boost::bind (&compiz::X11::PendingEventQueue::removeIfMatching, this, _1, event)), mEvents.end ());
-
-    return lastSize != mEvents.size ();
-}
-
-bool
-compiz::X11::PendingEventQueue::forEachIf (boost::function<bool (compiz::X11::PendingEvent::Ptr)> f)
-{
-    foreach (compiz::X11::PendingEvent::Ptr p, mEvents)
-	if (f (p))
-	    return true;
-
-    return false;
-}
-
-void
-compiz::X11::PendingEventQueue::dump ()
-{
-    foreach (compiz::X11::PendingEvent::Ptr p, mEvents)
-	p->dump ();
-}
-
-compiz::X11::PendingEventQueue::PendingEventQueue (Display *d)
-{
-    /* mClearCheckTimeout.setTimes (0, 0)
-     *
-     * XXX: For whatever reason, calling setTimes (0, 0) here causes
-     * the destructor of the timer object to be called twice later on
-     * in execution and the stack gets smashed. This could be a
-     * compiler bug, but requires further investigation */
-}
-
-compiz::X11::PendingEventQueue::~PendingEventQueue ()
-{
-}
-
-Window
-compiz::X11::PendingEvent::getEventWindow (XEvent *event)
-{
-    return event->xany.window;
-}
-
-bool
-compiz::X11::PendingEvent::match (XEvent *event)
-{
-    if (event->xany.serial != mSerial ||
-	getEventWindow (event)!= mWindow)
-	return false;
-
-    return true;
-}
-
-compiz::X11::PendingEvent::PendingEvent (Display *d, Window w) :
-    mSerial (XNextRequest (d)),
-    mWindow (w)
-{
-}
-
-compiz::X11::PendingEvent::~PendingEvent ()
-{
-}
-
-Window
-compiz::X11::PendingConfigureEvent::getEventWindow (XEvent *event)
-{
-    return event->xconfigure.window;
-}
-
-bool
-compiz::X11::PendingConfigureEvent::matchVM (unsigned int valueMask)
-{
-    unsigned int result = mValueMask != 0 ? valueMask & mValueMask : 1;
-
-    return result != 0;
-}
-
-bool
-compiz::X11::PendingConfigureEvent::matchRequest (XWindowChanges &xwc,
-						  unsigned int   valueMask)
-{
-    if (matchVM (valueMask))
-    {
-	if ((valueMask & CWX                       && xwc.x            != mXwc.x)		||
-	    (valueMask & CWY                       && xwc.y            != mXwc.y)		||
-	    (valueMask & CWWidth                   && xwc.width        != mXwc.width)		||
-	    (valueMask & CWHeight                  && xwc.height       != mXwc.height)		||
-	    (valueMask & CWBorderWidth             && xwc.border_width != mXwc.border_width)	||
-	    (valueMask & (CWStackMode | CWSibling) && xwc.sibling      != mXwc.sibling))
-	    return false;
-
-	return true;
-    }
-
-    return false;
-}
-
-bool
-compiz::X11::PendingConfigureEvent::match (XEvent *event)
-{
-    XConfigureEvent *ce     = (XConfigureEvent *) event;
-    bool            matched = true;
-
-    if (!compiz::X11::PendingEvent::match (event))
-	return false;
-
-    XWindowChanges xwc = XWINDOWCHANGES_INIT;
-
-    xwc.x            = ce->x;
-    xwc.y            = ce->y;
-    xwc.width        = ce->width;
-    xwc.height       = ce->height;
-    xwc.border_width = ce->border_width;
-    xwc.sibling      = ce->above;
-
-    matched = matchRequest (xwc, mValueMask);
-
-    /* Remove events from the queue
-     * even if they didn't match what
-     * we expected them to be, but still
-     * complain about it */
-    if (!matched)
-    {
-	compLogMessage ("core", CompLogLevelWarn, "no exact match for ConfigureNotify on 0x%x!", mWindow);
-	compLogMessage ("core", CompLogLevelWarn, "expected the following changes:");
-
-	if (mValueMask & CWX)
-	    compLogMessage ("core", CompLogLevelWarn, "x: %i", mXwc.x);
-
-	if (mValueMask & CWY)
-	    compLogMessage ("core", CompLogLevelWarn, "y: %i", mXwc.y);
-
-	if (mValueMask & CWWidth)
-	    compLogMessage ("core", CompLogLevelWarn, "width: %i", mXwc.width);
-
-	if (mValueMask & CWHeight)
-	    compLogMessage ("core", CompLogLevelWarn, "height: %i", mXwc.height);
-
-	if (mValueMask & CWBorderWidth)
-	    compLogMessage ("core", CompLogLevelWarn, "border: %i", mXwc.border_width);
-
-	if (mValueMask & (CWStackMode | CWSibling))
-	    compLogMessage ("core", CompLogLevelWarn, "sibling: 0x%x", mXwc.sibling);
-
-	compLogMessage ("core", CompLogLevelWarn, "instead got:");
-	compLogMessage ("core", CompLogLevelWarn, "x: %i", ce->x);
-	compLogMessage ("core", CompLogLevelWarn, "y: %i", ce->y);
-	compLogMessage ("core", CompLogLevelWarn, "width: %i", ce->width);
-	compLogMessage ("core", CompLogLevelWarn, "height: %i", ce->height);
-	compLogMessage ("core", CompLogLevelWarn, "above: %i", ce->above);
-	compLogMessage ("core", CompLogLevelWarn, "this should never happen. you should "\
-						  "probably file a bug about this.");
-    }
-
-    return true;
-}
-
-compiz::X11::PendingConfigureEvent::PendingConfigureEvent (Display        *d,
-							   Window         w,
-							   unsigned int   valueMask,
-							   XWindowChanges *xwc) :
-    compiz::X11::PendingEvent::PendingEvent (d, w),
-    mValueMask (valueMask),
-    mXwc (*xwc)
-{
-}
-
-compiz::X11::PendingConfigureEvent::~PendingConfigureEvent ()
-{
-}
-
 bool
 CompWindow::focus ()
 {
@@ -3420,45 +3257,64 @@ PrivateWindow::stackDocks (CompWindow       *w,
     return false;
 }
 
+PrivateWindow::TransientStack::TransientStack (const CompWindowList &serverWindows)
+{
+    windows.reserve (serverWindows.size ());
+
+    for (CompWindowList::const_reverse_iterator it = serverWindows.rbegin ();
+	 it != serverWindows.rend (); ++it)
+    {
+	PrivateWindow *p = (*it)->priv;
+
+	windows.push_back (*it);
+	index.add (p->id, p->transientFor, p->clientLeader,
+		   p->isGroupTransient (p->clientLeader));
+    }
+}
+
 bool
-PrivateWindow::stackTransients (CompWindow       *w,
-				CompWindow       *avoid,
-				XWindowChanges   *xwc,
-				CompWindowList   &updateList,
-				const ServerLock &lock)
+PrivateWindow::stackTransients (CompWindow           *w,
+				CompWindow           *avoid,
+				XWindowChanges       *xwc,
+				CompWindowList       &updateList,
+				const TransientStack &stack,
+				const ServerLock     &lock)
 {
     Window clientLeader = w->priv->clientLeader;
 
     if (w->priv->transientFor || w->priv->isGroupTransient (clientLeader))
 	clientLeader = None;
 
-    for (CompWindow *t = screen->serverWindows ().back (); t; t = t->serverPrev)
+    compiz::window::transients::Index::Positions transients;
+
+    stack.index.transients (w->priv->id, clientLeader, transients);
+
+    foreach (unsigned int position, transients)
     {
+	CompWindow *t = stack.windows[position];
+
 	if (t == w || t == avoid)
 	    continue;
 
-	if (t->priv->transientFor == w->priv->id ||
-	    t->priv->isGroupTransient (clientLeader))
-	{
-	    if (!stackTransients (t, avoid, xwc, updateList, lock)  ||
-		xwc->sibling == t->priv->id			    ||
-		(t->priv->serverFrame && xwc->sibling == t->priv->serverFrame))
-		return false;
-
-	    if ((t->priv->mapNum || t->priv->pendingMaps) &&
-		existsOnServer (t, lock))
-		updateList.push_back (t);
-	}
+	if (!stackTransients (t, avoid, xwc, updateList, stack, lock)	||
+	    xwc->sibling == t->priv->id					||
+	    (t->priv->serverFrame && xwc->sibling == t->priv->serverFrame))
+	    return false;
+
+	if ((t->priv->mapNum || t->priv->pendingMaps) &&
+	    existsOnServer (t, lock))
+	    updateList.push_back (t);
     }
 
     return true;
 }
 
 void
-PrivateWindow::stackAncestors (CompWindow       *w,
-			       XWindowChanges   *xwc,
-			       CompWindowList   &updateList,
-			       const ServerLock &lock)
+PrivateWindow::stackAncestors (CompWindow           *w,
+			       XWindowChanges       *xwc,
+			       CompWindowList       &updateList,
+			       const TransientStack &stack,
+			       const ServerLock     &lock)
 {
     CompWindow *transient = NULL;
 
@@ -3473,7 +3329,7 @@ PrivateWindow::stackAncestors (CompWindow       *w,
 
 	if (ancestor)
 	{
-	    if (!stackTransients (ancestor, w, xwc, updateList, lock)	||
+	    if (!stackTransients (ancestor, w, xwc, updateList, stack, lock) ||
 		ancestor->priv->type & CompWindowTypeDesktopMask	||
 		(ancestor->priv->type & CompWindowTypeDockMask && !(w->priv->type & CompWindowTypeDockMask)))
 		return;
@@ -3482,33 +3338,31 @@ PrivateWindow::stackAncestors (CompWindow       *w,
 		existsOnServer (ancestor, lock))
 		updateList.push_back (ancestor);
 
-	    stackAncestors (ancestor, xwc, updateList, lock);
+	    stackAncestors (ancestor, xwc, updateList, stack, lock);
 	}
     }
     else if (w->priv->isGroupTransient (w->priv->clientLeader))
     {
-	for (CompWindow *a = screen->serverWindows ().back (); a; a = a->serverPrev)
+	foreach (unsigned int position,
+		 stack.index.groupMembers (w->priv->clientLeader))
 	{
-	    if (a->priv->clientLeader == w->priv->clientLeader &&
-		a->priv->transientFor == None		       &&
-		!a->priv->isGroupTransient (w->priv->clientLeader))
-	    {
-		if (xwc->sibling == a->priv->id ||
-		    (a->priv->serverFrame && xwc->sibling == a->priv->serverFrame) ||
-		    !stackTransients (a, w, xwc, updateList, lock))
-		    break;
+	    CompWindow *a = stack.windows[position];
 
-		if (a->priv->type & CompWindowTypeDesktopMask)
-		    continue;
+	    if (xwc->sibling == a->priv->id ||
+		(a->priv->serverFrame && xwc->sibling == a->priv->serverFrame) ||
+		!stackTransients (a, w, xwc, updateList, stack, lock))
+		break;
 
-		if (a->priv->type & CompWindowTypeDockMask &&
-		    !(w->priv->type & CompWindowTypeDockMask))
-		    break;
+	    if (a->priv->type & CompWindowTypeDesktopMask)
+		continue;
 
-		if ((a->priv->mapNum || a->priv->pendingMaps) &&
-		    existsOnServer (a, lock))
-		    updateList.push_back (a);
-	    }
+	    if (a->priv->type & CompWindowTypeDockMask &&
+		!(w->priv->type & CompWindowTypeDockMask))
+		break;
+
+	    if ((a->priv->mapNum || a->priv->pendingMaps) &&
+		existsOnServer (a, lock))
+		updateList.push_back (a);
 	}
     }
 }
@@ -3548,11 +3402,15 @@ CompWindow::restackAndConfigureXWindow (unsigned int     valueMask,
 	   so that when compiz gets the ConfigureNotify event it doesn't
 	   have to restack all the windows again. */
 
+	/* Nothing is restacked until both lists are complete, so one
+	 * snapshot of the stack serves all the lookups */
+	PrivateWindow::TransientStack stack (screen->serverWindows ());
+
 	/* transient children above */
-	if (PrivateWindow::stackTransients (this, NULL, xwc, transients, lock))
+	if (PrivateWindow::stackTransients (this, NULL, xwc, transients, stack, lock))
 	{
 	    /* ancestors, siblings and sibling transients below */
-	    PrivateWindow::stackAncestors (this, xwc, ancestors, lock);
+	    PrivateWindow::stackAncestors (this, xwc, ancestors, stack, lock);
 
 	    for (CompWindowList::reverse_iterator w = ancestors.rbegin ();
 		 w != ancestors.rend (); ++w)
@@ -5039,6 +4897,193 @@ PrivateWindow::readIconHint ()
     icons.push_back (icon);
 }
 
+namespace
+{
+    /* Raw _NET_WM_ICON data is only kept around for the most recently
+     * used windows, the sizes that were actually asked for are decoded
+     * and stay in icons until the property changes. */
+    compiz::window::icon::DataBudget iconDataBudget (4 * 1024 * 1024);
+
+    /* _NET_WM_ICON is fetched in one go, this is the most a reply can
+     * hold. Replies not collected yet sit in xcb, prefetched ones are
+     * counted against the budget as that large. */
+    const long   MaxIconLength = 65536;
+    const size_t MaxIconReply = MaxIconLength * 4;
+}
+
+void
+PrivateWindow::dropEvictedIconData (const std::vector<Window> &evicted)
+{
+    foreach (Window e, evicted)
+    {
+	CompWindow *w = screen->findWindow (e);
+
+	if (w)
+	    w->priv->dropIconData ();
+	else
+	    iconDataBudget.remove (e);
+    }
+}
+
+void
+PrivateWindow::useIconData (Window id,
+			    size_t bytes)
+{
+    std::vector<Window> evicted;
+
+    iconDataBudget.use (id, bytes, evicted);
+    dropEvictedIconData (evicted);
+}
+
+/* sends the request for _NET_WM_ICON without waiting for the reply, which
+   is collected by receiveIcons () right after */
+void
+PrivateWindow::requestIcons ()
+{
+    if (iconPending || iconData || noIcons)
+	return;
+
+    iconCookie  = xcb_get_property (XGetXCBConnection (screen->dpy ()), 0, id,
+				    Atoms::wmIcon, XA_CARDINAL, 0, MaxIconLength);
+    iconPending = true;
+}
+
+/* like requestIcons (), for a reply which may not be collected until
+   an icon of the window is actually asked for. Returns false without
+   sending anything once the replies on their way fill the budget. */
+bool
+PrivateWindow::prefetchIcons ()
+{
+    if (iconPending || iconData || noIcons)
+	return true;
+
+    std::vector<Window> evicted;
+
+    if (!iconDataBudget.reserve (MaxIconReply, evicted))
+	return false;
+
+    dropEvictedIconData (evicted);
+
+    requestIcons ();
+    iconReserved = true;
+
+    return true;
+}
+
+void
+PrivateWindow::releaseIconReservation ()
+{
+    if (iconReserved)
+	iconDataBudget.release (MaxIconReply);
+
+    iconReserved = false;
+}
+
+void
+PrivateWindow::receiveIcons ()
+{
+    if (!iconPending)
+	return;
+
+    xcb_generic_error_t      *error = NULL;
+    xcb_get_property_reply_t *reply =
+	xcb_get_property_reply (XGetXCBConnection (screen->dpy ()),
+				iconCookie, &error);
+
+    iconPending = false;
+    releaseIconReservation ();
+
+    if (error)
+	free (error);
+
+    if (!reply)
+	return;
+
+    if (reply->type != XA_CARDINAL || reply->format != 32)
+    {
+	free (reply);
+	return;
+    }
+
+    const uint32_t *data = (const uint32_t *) xcb_get_property_value (reply);
+    size_t         n     = xcb_get_property_value_length (reply) / 4;
+
+    std::vector<compiz::window::icon::Image> images =
+	compiz::window::icon::parse (data, n);
+
+    /* the data is fetched again after it was dropped, the images decoded
+       from it before are only still good if the layout is unchanged */
+    bool same = images.size () == iconImages.size ();
+
+    for (unsigned int i = 0; same && i < images.size (); ++i)
+	same = images[i].width  == iconImages[i].width &&
+	       images[i].height == iconImages[i].height;
+
+    if (!same)
+    {
+	iconImages = images;
+	iconDecoded.assign (images.size (), NULL);
+    }
+
+    if (images.empty ())
+    {
+	free (reply);
+	return;
+    }
+
+    iconData = reply;
+    useIconData (id, n * 4);
+}
+
+void
+PrivateWindow::dropIconData ()
+{
+    iconDataBudget.remove (id);
+
+    if (iconData)
+	free (iconData);
+
+    iconData = NULL;
+}
+
+CompIcon *
+PrivateWindow::decodeIcon (int image)
+{
+    if (image < 0)
+	return NULL;
+
+    if (iconDecoded[image])
+	return iconDecoded[image];
+
+    /* the raw data went over the budget, fetch it again */
+    if (!iconData)
+    {
+	requestIcons ();
+	receiveIcons ();
+
+	if (!iconData || image >= (int) iconImages.size ())
+	    return NULL;
+    }
+    else
+	useIconData (id, xcb_get_property_value_length (iconData));
+
+    const compiz::window::icon::Image &img = iconImages[image];
+    const uint32_t *data = (const uint32_t *) xcb_get_property_value (iconData);
+
+    CompIcon *icon = new CompIcon (img.width, img.height);
+
+    /* EWMH doesn't say if icon data is premultiplied or not but most
+       applications seem to assume data should be unpremultiplied. */
+    compiz::window::icon::premultiply (data + img.offset,
+				       (uint32_t *) icon->data (),
+				       img.width * img.height);
+
+    icons.push_back (icon);
+    iconDecoded[image] = icon;
+
+    return icon;
+}
+
 /* returns icon with dimensions as close as possible to width and height
    but never greater. */
 CompIcon *
@@ -5050,78 +5095,31 @@ CompWindow::getIcon (int width,
     unsigned int i;
 
     /* need to fetch icon property */
-    if (priv->icons.size () == 0 && !priv->noIcons)
-    {
-	Atom          actual;
-	int           format;
-	unsigned long n, left;
-	unsigned char *data;
-
-	int result = XGetWindowProperty (screen->dpy (), priv->id, Atoms::wmIcon,
-					 0L, 65536L, false, XA_CARDINAL,
-					 &actual, &format, &n, &left, &data);
-
-	if (result == Success && data)
+    if (priv->iconImages.empty () && priv->icons.size () == 0 &&
+	!priv->noIcons)
+    {
+	/* whoever asks for one icon, like a switcher, usually goes on to
+	   ask for the icons of every other window too, so get as many of
+	   the requests on the wire as the budget allows before waiting
+	   for the first reply */
+	if (!priv->iconPending)
 	{
-	    CARD32        *p;
-	    CARD32        alpha, red, green, blue;
-	    unsigned long iw, ih;
-	    unsigned long *idata;
-
-	    for (i = 0; i + 2 < n; i += iw * ih + 2)
-	    {
-		idata = (unsigned long *) data;
-
-		iw = idata[i];
-		ih = idata[i + 1];
+	    priv->requestIcons ();
 
-		/* iw * ih may be larger than the value range of unsigned
-		* long, so better do some checking for extremely weird
-		* icon sizes first */
-		if (iw > 2048 || ih > 2048 || iw * ih + 2 > n - i)
+	    foreach (CompWindow *w, screen->windows ())
+		if (w->priv->managed && w->priv->iconImages.empty () &&
+		    !w->priv->icons.size () && !w->priv->prefetchIcons ())
 		    break;
+	}
 
-		if (iw && ih)
-		{
-		    icon = new CompIcon (iw, ih);
-
-		    if (!icon)
-			continue;
-
-		    priv->icons.push_back (icon);
-
-		    p = (CARD32 *) (icon->data ());
+	priv->receiveIcons ();
 
-		    /* EWMH doesn't say if icon data is premultiplied or
-		       not but most applications seem to assume data should
-		       be unpremultiplied. */
-		    for (unsigned long j = 0; j < iw * ih; ++j)
-		    {
-			alpha = (idata[i + j + 2] >> 24) & 0xff;
-			red   = (idata[i + j + 2] >> 16) & 0xff;
-			green = (idata[i + j + 2] >>  8) & 0xff;
-			blue  = (idata[i + j + 2] >>  0) & 0xff;
-
-			red   = (red   * alpha) >> 8;
-			green = (green * alpha) >> 8;
-			blue  = (blue  * alpha) >> 8;
-
-			p[j] =
-			    (alpha << 24) |
-			    (red   << 16) |
-			    (green <<  8) |
-			    (blue  <<  0);
-		    }
-		}
-	    }
-
-	    XFree (data);
-	}
-	else if (priv->hints && (priv->hints->flags & IconPixmapHint))
+	if (priv->iconImages.empty () &&
+	    priv->hints && (priv->hints->flags & IconPixmapHint))
 	    priv->readIconHint ();
 
 	/* don't fetch property again */
-	if (priv->icons.size () == 0)
+	if (priv->iconImages.empty () && priv->icons.size () == 0)
 	    priv->noIcons = true;
     }
 
@@ -5129,6 +5127,10 @@ CompWindow::getIcon (int width,
     if (priv->noIcons)
 	return NULL;
 
+    if (!priv->iconImages.empty ())
+	return priv->decodeIcon (compiz::window::icon::nearest (priv->iconImages,
+								width, height));
+
     icon = NULL;
     wh   = width + height;
 
@@ -5169,6 +5171,17 @@ PrivateWindow::freeIcons ()
 
     priv->icons.resize (0);
     priv->noIcons = false;
+
+    iconImages.clear ();
+    iconDecoded.clear ();
+    dropIconData ();
+
+    if (iconPending)
+	xcb_discard_reply (XGetXCBConnection (screen->dpy ()),
+			   iconCookie.sequence);
+
+    iconPending = false;
+    releaseIconReservation ();
 }
 
 int
@@ -5658,9 +5671,6 @@ PrivateWindow::updatePassiveButtonGrabs ()
     bool onlyActions = (priv->id == screen->activeWindow () ||
 			!screen->getCoreOptions ().optionGetClickToFocus ());
 
-    /* Ungrab everything */
-    XUngrabButton (screen->dpy (), AnyButton, AnyModifier, frame);
-
     /* We don't need the full grab in the following cases:
      * - This window has the focus and either
      *   - it is raised or
@@ -5697,27 +5707,22 @@ PrivateWindow::updatePassiveButtonGrabs ()
     else
     {
 	/* Grab all buttons */
-	XGrabButton (screen->dpy (),
-		     AnyButton,
-		     AnyModifier,
-		     serverFrame, false,
-		     ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
-		     GrabModeSync,
-		     GrabModeAsync,
-		     None,
-		     None);
+	compiz::window::buttongrab::XInterface x (screen->dpy ());
+	compiz::window::buttongrab::Grabs      except;
 
 	if (!(priv->type & CompWindowTypeDesktopMask))
 	{
 	    /* Ungrab Buttons 4 & 5 for vertical scrolling if the window is not the desktop window */
-	    for (int i = Button4; i <= Button5; ++i)
+	    for (unsigned int i = Button4; i <= Button5; ++i)
 	    {
-		XUngrabButton (screen->dpy (), i, 0, frame);
-		XUngrabButton (screen->dpy (), i, LockMask, frame);
-		XUngrabButton (screen->dpy (), i, Mod2Mask, frame);
-		XUngrabButton (screen->dpy (), i, LockMask | Mod2Mask, frame);
+		except.insert (compiz::window::buttongrab::Grab (i, 0));
+		except.insert (compiz::window::buttongrab::Grab (i, LockMask));
+		except.insert (compiz::window::buttongrab::Grab (i, Mod2Mask));
+		except.insert (compiz::window::buttongrab::Grab (i, LockMask | Mod2Mask));
 	    }
 	}
+
+	buttonGrabState.grabAll (x, serverFrame, except);
     }
 }
 
@@ -6493,6 +6498,11 @@ PrivateWindow::PrivateWindow () :
 
     icons (0),
     noIcons (false),
+    iconPending (false),
+    iconReserved (false),
+    iconData (NULL),
+
+    inServerStack (false),
 
     saveMask (0),
     syncCounter (0),
@@ -6500,6 +6510,9 @@ PrivateWindow::PrivateWindow () :
     syncWaitTimer (),
 
     syncWait (false),
+    syncExtended (false),
+    syncFrozen (false),
+    syncFrameDrawn (false),
     closeRequests (false),
     lastCloseRequestTime (0),
 
@@ -6546,8 +6559,7 @@ PrivateWindow::~PrivateWindow ()
     if (hints)
 	XFree (hints);
 
-    if (icons.size ())
-	freeIcons ();
+    freeIcons ();
 
     if (startupId)
 	free (startupId);
@@ -6562,7 +6574,7 @@ PrivateWindow::~PrivateWindow ()
 bool
 CompWindow::syncWait () const
 {
-    return priv->syncWait;
+    return priv->syncWait || priv->syncFrozen;
 }
 
 bool
@@ -6947,6 +6959,9 @@ PrivateWindow::reparent ()
 				 mask,
 				 &attr);
 
+    /* A new frame has no passive grabs yet */
+    buttonGrabState.reset ();
+
     /* Do not get any events from here on */
     XSelectInput (dpy, screen->root (), NoEventMask);
 
@@ -7211,6 +7226,8 @@ PrivateWindow::unreparent ()
     wrapper     = None;
     serverFrame = None;
 
+    buttonGrabState.reset ();
+
     // Finally, (i.e. after updating state) notify the change
     window->windowNotify (CompWindowNotifyUnreparent);
 }
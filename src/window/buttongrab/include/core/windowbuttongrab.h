@@ -0,0 +1,149 @@
+/*
+ * Compiz, passive button grab bookkeeping
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_WINDOWBUTTONGRAB_H
+#define _COMPIZ_WINDOWBUTTONGRAB_H
+
+#include <set>
+
+#include <X11/Xlib.h>
+
+namespace compiz
+{
+namespace window
+{
+namespace buttongrab
+{
+
+/**
+ * One passive grab, button and modifiers may be AnyButton and
+ * AnyModifier
+ */
+struct Grab
+{
+    Grab (unsigned int button, unsigned int modifiers);
+
+    bool operator< (const Grab &other) const;
+    bool operator== (const Grab &other) const;
+
+    unsigned int button;
+    unsigned int modifiers;
+};
+
+typedef std::set<Grab> Grabs;
+
+/**
+ * Where the grabs are sent to
+ */
+class Interface
+{
+    public:
+
+	virtual ~Interface () {}
+
+	virtual void grab (Window frame, const Grab &grab) = 0;
+	virtual void ungrab (Window frame, const Grab &grab) = 0;
+};
+
+/**
+ * Sends the grabs to the server the way core wants them, synchronous
+ * pointer and asynchronous keyboard, for presses, releases and motion
+ */
+class XInterface :
+    public Interface
+{
+    public:
+
+	explicit XInterface (Display *dpy);
+
+	void grab (Window frame, const Grab &grab);
+	void ungrab (Window frame, const Grab &grab);
+
+    private:
+
+	Display *mDpy;
+};
+
+/**
+ * Requests sent and saved over all frames, so that the cost of a focus
+ * change can be measured
+ */
+struct Counters
+{
+    unsigned long updates;
+    unsigned long unchanged;
+    unsigned long grabs;
+    unsigned long ungrabs;
+};
+
+const Counters & counters ();
+void resetCounters ();
+
+/**
+ * The passive grabs that are in place on one frame window. Updating it
+ * only sends the requests needed to get from the grabs already in place
+ * to the new ones, and none at all if they are the same.
+ */
+class State
+{
+    public:
+
+	State ();
+
+	/**
+	 * Grab every button with any modifiers, except for the
+	 * combinations in except
+	 */
+	void grabAll (Interface &iface, Window frame, const Grabs &except);
+
+	/**
+	 * Grab exactly the combinations in grabs
+	 */
+	void grabOnly (Interface &iface, Window frame, const Grabs &grabs);
+
+	/**
+	 * The frame was just created or destroyed, so nothing is grabbed
+	 * on it anymore
+	 */
+	void reset ();
+
+    private:
+
+	enum Mode
+	{
+	    Unknown,
+	    All,
+	    Only
+	};
+
+	void ungrabEverything (Interface &iface, Window frame);
+
+	Mode   mMode;
+	Window mFrame;
+	Grabs  mGrabs;
+};
+
+}
+}
+}
+
+#endif
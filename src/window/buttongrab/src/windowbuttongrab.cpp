@@ -0,0 +1,202 @@
+/*
+ * Compiz, passive button grab bookkeeping
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <core/windowbuttongrab.h>
+
+namespace cwbg = compiz::window::buttongrab;
+
+namespace
+{
+    cwbg::Counters totals = { 0, 0, 0, 0 };
+}
+
+cwbg::Grab::Grab (unsigned int button,
+		  unsigned int modifiers) :
+    button (button),
+    modifiers (modifiers)
+{
+}
+
+bool
+cwbg::Grab::operator< (const Grab &other) const
+{
+    if (button != other.button)
+	return button < other.button;
+
+    return modifiers < other.modifiers;
+}
+
+bool
+cwbg::Grab::operator== (const Grab &other) const
+{
+    return button == other.button && modifiers == other.modifiers;
+}
+
+cwbg::XInterface::XInterface (Display *dpy) :
+    mDpy (dpy)
+{
+}
+
+void
+cwbg::XInterface::grab (Window     frame,
+			const Grab &grab)
+{
+    XGrabButton (mDpy,
+		 grab.button,
+		 grab.modifiers,
+		 frame,
+		 false,
+		 ButtonPressMask | ButtonReleaseMask | ButtonMotionMask,
+		 GrabModeSync,
+		 GrabModeAsync,
+		 None,
+		 None);
+}
+
+void
+cwbg::XInterface::ungrab (Window     frame,
+			  const Grab &grab)
+{
+    XUngrabButton (mDpy, grab.button, grab.modifiers, frame);
+}
+
+const cwbg::Counters &
+cwbg::counters ()
+{
+    return totals;
+}
+
+void
+cwbg::resetCounters ()
+{
+    totals.updates   = 0;
+    totals.unchanged = 0;
+    totals.grabs     = 0;
+    totals.ungrabs   = 0;
+}
+
+cwbg::State::State () :
+    mMode (Unknown),
+    mFrame (None)
+{
+}
+
+void
+cwbg::State::reset ()
+{
+    mMode  = Only;
+    mFrame = None;
+    mGrabs.clear ();
+}
+
+void
+cwbg::State::ungrabEverything (Interface &iface,
+			       Window    frame)
+{
+    iface.ungrab (frame, Grab (AnyButton, AnyModifier));
+    ++totals.ungrabs;
+}
+
+void
+cwbg::State::grabAll (Interface   &iface,
+		      Window      frame,
+		      const Grabs &except)
+{
+    ++totals.updates;
+
+    if (mMode == All && mFrame == frame && mGrabs == except)
+    {
+	++totals.unchanged;
+	return;
+    }
+
+    /* Holes can only be punched into the grab for every button, so
+     * it has to be set up again as a whole */
+    bool clean = mMode == Only && mGrabs.empty () &&
+		 (mFrame == frame || mFrame == None);
+
+    if (!clean)
+	ungrabEverything (iface, frame);
+
+    iface.grab (frame, Grab (AnyButton, AnyModifier));
+    ++totals.grabs;
+
+    for (Grabs::const_iterator it = except.begin (); it != except.end (); ++it)
+    {
+	iface.ungrab (frame, *it);
+	++totals.ungrabs;
+    }
+
+    mMode  = All;
+    mFrame = frame;
+    mGrabs = except;
+}
+
+void
+cwbg::State::grabOnly (Interface   &iface,
+		       Window      frame,
+		       const Grabs &grabs)
+{
+    ++totals.updates;
+
+    if (mMode == Only && mFrame == frame && mGrabs == grabs)
+    {
+	++totals.unchanged;
+	return;
+    }
+
+    Grabs stale, missing;
+
+    if (mMode == Only && (mFrame == frame || mFrame == None))
+    {
+	std::set_difference (mGrabs.begin (), mGrabs.end (),
+			     grabs.begin (), grabs.end (),
+			     std::inserter (stale, stale.begin ()));
+	std::set_difference (grabs.begin (), grabs.end (),
+			     mGrabs.begin (), mGrabs.end (),
+			     std::inserter (missing, missing.begin ()));
+    }
+    else
+    {
+	ungrabEverything (iface, frame);
+	missing = grabs;
+    }
+
+    for (Grabs::const_iterator it = stale.begin (); it != stale.end (); ++it)
+    {
+	iface.ungrab (frame, *it);
+	++totals.ungrabs;
+    }
+
+    for (Grabs::const_iterator it = missing.begin (); it != missing.end (); ++it)
+    {
+	iface.grab (frame, *it);
+	++totals.grabs;
+    }
+
+    mMode  = Only;
+    mFrame = frame;
+    mGrabs = grabs;
+}
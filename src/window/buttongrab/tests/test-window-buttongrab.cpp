@@ -0,0 +1,206 @@
+/*
+ * Compiz, passive button grab bookkeeping
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <core/windowbuttongrab.h>
+
+namespace cwbg = compiz::window::buttongrab;
+
+using ::testing::_;
+using ::testing::InSequence;
+using ::testing::Eq;
+
+namespace
+{
+const Window frame = 1;
+
+class MockInterface :
+    public cwbg::Interface
+{
+    public:
+
+	MOCK_METHOD2 (grab, void (Window, const cwbg::Grab &));
+	MOCK_METHOD2 (ungrab, void (Window, const cwbg::Grab &));
+};
+
+cwbg::Grabs
+grabs (unsigned int count)
+{
+    cwbg::Grabs g;
+
+    for (unsigned int i = 0; i < count; i++)
+	g.insert (cwbg::Grab (Button1 + i, 0));
+
+    return g;
+}
+}
+
+class WindowButtonGrab :
+    public ::testing::Test
+{
+    public:
+
+	WindowButtonGrab ()
+	{
+	    cwbg::resetCounters ();
+	}
+
+	MockInterface iface;
+	cwbg::State   state;
+};
+
+TEST_F (WindowButtonGrab, FirstUpdateClearsUnknownGrabs)
+{
+    InSequence s;
+
+    EXPECT_CALL (iface, ungrab (frame, Eq (cwbg::Grab (AnyButton, AnyModifier))));
+    EXPECT_CALL (iface, grab (frame, Eq (cwbg::Grab (Button1, 0))));
+
+    state.grabOnly (iface, frame, grabs (1));
+}
+
+TEST_F (WindowButtonGrab, FreshFrameNeedsNoUngrab)
+{
+    state.reset ();
+
+    EXPECT_CALL (iface, ungrab (_, _)).Times (0);
+    EXPECT_CALL (iface, grab (frame, _)).Times (2);
+
+    state.grabOnly (iface, frame, grabs (2));
+}
+
+TEST_F (WindowButtonGrab, SameGrabsSendNothing)
+{
+    state.reset ();
+
+    EXPECT_CALL (iface, grab (_, _)).Times (3);
+    state.grabOnly (iface, frame, grabs (3));
+
+    EXPECT_CALL (iface, grab (_, _)).Times (0);
+    EXPECT_CALL (iface, ungrab (_, _)).Times (0);
+    state.grabOnly (iface, frame, grabs (3));
+
+    EXPECT_EQ (2, cwbg::counters ().updates);
+    EXPECT_EQ (1, cwbg::counters ().unchanged);
+}
+
+TEST_F (WindowButtonGrab, OnlyDifferenceIsSent)
+{
+    state.reset ();
+
+    EXPECT_CALL (iface, grab (_, _)).Times (3);
+    state.grabOnly (iface, frame, grabs (3));
+
+    cwbg::Grabs next;
+    next.insert (cwbg::Grab (Button1, 0));
+    next.insert (cwbg::Grab (Button2, 0));
+    next.insert (cwbg::Grab (Button4, Mod1Mask));
+
+    EXPECT_CALL (iface, ungrab (frame, Eq (cwbg::Grab (Button3, 0))));
+    EXPECT_CALL (iface, grab (frame, Eq (cwbg::Grab (Button4, Mod1Mask))));
+    state.grabOnly (iface, frame, next);
+}
+
+TEST_F (WindowButtonGrab, GrabAllPunchesHoles)
+{
+    state.reset ();
+
+    cwbg::Grabs except;
+    except.insert (cwbg::Grab (Button4, 0));
+    except.insert (cwbg::Grab (Button5, 0));
+
+    InSequence s;
+
+    EXPECT_CALL (iface, grab (frame, Eq (cwbg::Grab (AnyButton, AnyModifier))));
+    EXPECT_CALL (iface, ungrab (frame, Eq (cwbg::Grab (Button4, 0))));
+    EXPECT_CALL (iface, ungrab (frame, Eq (cwbg::Grab (Button5, 0))));
+
+    state.grabAll (iface, frame, except);
+}
+
+TEST_F (WindowButtonGrab, GrabAllTwiceSendsNothing)
+{
+    state.reset ();
+
+    EXPECT_CALL (iface, grab (_, _)).Times (1);
+    state.grabAll (iface, frame, cwbg::Grabs ());
+
+    EXPECT_CALL (iface, grab (_, _)).Times (0);
+    EXPECT_CALL (iface, ungrab (_, _)).Times (0);
+    state.grabAll (iface, frame, cwbg::Grabs ());
+}
+
+TEST_F (WindowButtonGrab, LeavingGrabAllStartsOver)
+{
+    state.reset ();
+
+    EXPECT_CALL (iface, grab (_, _)).Times (1);
+    state.grabAll (iface, frame, cwbg::Grabs ());
+
+    InSequence s;
+
+    EXPECT_CALL (iface, ungrab (frame, Eq (cwbg::Grab (AnyButton, AnyModifier))));
+    EXPECT_CALL (iface, grab (frame, Eq (cwbg::Grab (Button1, 0))));
+    state.grabOnly (iface, frame, grabs (1));
+}
+
+TEST_F (WindowButtonGrab, NewFrameStartsOver)
+{
+    const Window other = 2;
+
+    state.reset ();
+
+    EXPECT_CALL (iface, grab (frame, _)).Times (1);
+    state.grabOnly (iface, frame, grabs (1));
+
+    EXPECT_CALL (iface, ungrab (other, Eq (cwbg::Grab (AnyButton, AnyModifier))));
+    EXPECT_CALL (iface, grab (other, _)).Times (1);
+    state.grabOnly (iface, other, grabs (1));
+}
+
+TEST_F (WindowButtonGrab, CountersAddUpRequests)
+{
+    using ::testing::AnyNumber;
+
+    EXPECT_CALL (iface, grab (_, _)).Times (AnyNumber ());
+    EXPECT_CALL (iface, ungrab (_, _)).Times (AnyNumber ());
+
+    state.reset ();
+
+    /* Focus going back and forth between two states */
+    for (unsigned int i = 0; i < 10; i++)
+    {
+	state.grabAll (iface, frame, cwbg::Grabs ());
+	state.grabAll (iface, frame, cwbg::Grabs ());
+	state.grabOnly (iface, frame, grabs (2));
+	state.grabOnly (iface, frame, grabs (2));
+    }
+
+    const cwbg::Counters &c = cwbg::counters ();
+
+    EXPECT_EQ (40, c.updates);
+    EXPECT_EQ (20, c.unchanged);
+    EXPECT_EQ (10 + 10 * 2, c.grabs);
+    EXPECT_EQ (19, c.ungrabs);
+}
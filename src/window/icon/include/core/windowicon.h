@@ -0,0 +1,126 @@
+/*
+ * Compiz, _NET_WM_ICON decoding
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_WINDOWICON_H
+#define _COMPIZ_WINDOWICON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include <X11/Xlib.h>
+
+namespace compiz
+{
+namespace window
+{
+namespace icon
+{
+
+/**
+ * One image inside a _NET_WM_ICON property
+ */
+struct Image
+{
+    unsigned int width;
+    unsigned int height;
+
+    /* Index of the first pixel in the property data */
+    size_t       offset;
+};
+
+/**
+ * Splits _NET_WM_ICON data, n 32 bit values, into the images it
+ * contains without converting any of them. Stops at the first image
+ * which is larger than 2048x2048 or runs past the end of the data.
+ */
+std::vector<Image> parse (const uint32_t *data, size_t n);
+
+/**
+ * Index of the largest image which fits into width x height, as
+ * measured by width + height, or -1 if none does
+ */
+int nearest (const std::vector<Image> &images, int width, int height);
+
+/**
+ * Converts n ARGB pixels to premultiplied alpha, the colour channels
+ * being scaled by (c * a) >> 8. Uses SSE2 where available.
+ */
+void premultiply (const uint32_t *src, uint32_t *dst, size_t n);
+
+/**
+ * Keeps track of how much raw icon data each window holds on to,
+ * most recently used first, and picks the windows that have to let
+ * go of theirs once the total goes over a limit. Data which was asked
+ * for but not received yet counts towards the limit as well.
+ */
+class DataBudget
+{
+    public:
+
+	explicit DataBudget (size_t limit);
+
+	/**
+	 * Marks the data of id, bytes large, as most recently used and
+	 * appends the windows whose data has to be dropped to evicted.
+	 * id itself is never evicted.
+	 */
+	void use (Window id, size_t bytes, std::vector<Window> &evicted);
+
+	void remove (Window id);
+
+	/**
+	 * Makes room for bytes of data still on their way, appending the
+	 * windows whose data has to be dropped for it to evicted. Returns
+	 * false, reserving nothing, if the data on its way alone would
+	 * go over the limit.
+	 */
+	bool reserve (size_t bytes, std::vector<Window> &evicted);
+	void release (size_t bytes);
+
+	size_t size () const;
+	size_t reserved () const;
+	size_t limit () const;
+
+    private:
+
+	typedef std::list<std::pair<Window, size_t> > Entries;
+
+	/* Drops the least recently used data until everything fits,
+	 * keeping at least keep entries */
+	void evict (size_t keep, std::vector<Window> &evicted);
+
+	size_t                                 mLimit;
+	size_t                                 mSize;
+	size_t                                 mReserved;
+	Entries                                mEntries;
+	std::map<Window, Entries::iterator>    mIndex;
+};
+
+}
+}
+}
+
+#endif
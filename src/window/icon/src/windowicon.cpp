@@ -0,0 +1,236 @@
+/*
+ * Compiz, _NET_WM_ICON decoding
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "core/windowicon.h"
+
+namespace cwi = compiz::window::icon;
+
+namespace
+{
+/* Larger icons than this are considered bogus */
+const unsigned int MAX_ICON_SIZE = 2048;
+
+inline uint32_t
+premultiplyPixel (uint32_t pixel)
+{
+    uint32_t alpha = (pixel >> 24) & 0xff;
+    uint32_t red   = (pixel >> 16) & 0xff;
+    uint32_t green = (pixel >>  8) & 0xff;
+    uint32_t blue  = (pixel >>  0) & 0xff;
+
+    red   = (red   * alpha) >> 8;
+    green = (green * alpha) >> 8;
+    blue  = (blue  * alpha) >> 8;
+
+    return (alpha << 24) | (red << 16) | (green << 8) | blue;
+}
+}
+
+std::vector<cwi::Image>
+cwi::parse (const uint32_t *data,
+	    size_t         n)
+{
+    std::vector<Image> images;
+    size_t             i = 0;
+
+    while (i + 2 < n)
+    {
+	unsigned int width  = data[i];
+	unsigned int height = data[i + 1];
+
+	/* check the dimensions first, width * height could overflow */
+	if (width > MAX_ICON_SIZE || height > MAX_ICON_SIZE ||
+	    (size_t) width * height + 2 > n - i)
+	    break;
+
+	if (width && height)
+	{
+	    Image image;
+
+	    image.width  = width;
+	    image.height = height;
+	    image.offset = i + 2;
+
+	    images.push_back (image);
+	}
+
+	i += (size_t) width * height + 2;
+    }
+
+    return images;
+}
+
+int
+cwi::nearest (const std::vector<Image> &images,
+	      int                      width,
+	      int                      height)
+{
+    int found = -1;
+
+    for (unsigned int i = 0; i < images.size (); i++)
+    {
+	const Image &image = images[i];
+
+	if ((int) image.width > width || (int) image.height > height)
+	    continue;
+
+	if (found < 0 ||
+	    image.width + image.height >
+	    images[found].width + images[found].height)
+	    found = i;
+    }
+
+    return found;
+}
+
+void
+cwi::premultiply (const uint32_t *src,
+		  uint32_t       *dst,
+		  size_t         n)
+{
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero      = _mm_setzero_si128 ();
+    const __m128i alphaMask = _mm_set1_epi32 (0xff000000);
+
+    for (; i + 4 <= n; i += 4)
+    {
+	__m128i pixels = _mm_loadu_si128 ((const __m128i *) (src + i));
+
+	/* widen to 16 bits per channel, two pixels per register */
+	__m128i lo = _mm_unpacklo_epi8 (pixels, zero);
+	__m128i hi = _mm_unpackhi_epi8 (pixels, zero);
+
+	/* broadcast each pixel's alpha into all four of its channels */
+	__m128i loAlpha = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (lo, 0xff), 0xff);
+	__m128i hiAlpha = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (hi, 0xff), 0xff);
+
+	lo = _mm_srli_epi16 (_mm_mullo_epi16 (lo, loAlpha), 8);
+	hi = _mm_srli_epi16 (_mm_mullo_epi16 (hi, hiAlpha), 8);
+
+	__m128i result = _mm_packus_epi16 (lo, hi);
+
+	/* alpha itself stays as it was */
+	result = _mm_or_si128 (_mm_andnot_si128 (alphaMask, result),
+			       _mm_and_si128 (alphaMask, pixels));
+
+	_mm_storeu_si128 ((__m128i *) (dst + i), result);
+    }
+#endif
+
+    for (; i < n; i++)
+	dst[i] = premultiplyPixel (src[i]);
+}
+
+cwi::DataBudget::DataBudget (size_t limit) :
+    mLimit (limit),
+    mSize (0),
+    mReserved (0)
+{
+}
+
+void
+cwi::DataBudget::evict (size_t              keep,
+			std::vector<Window> &evicted)
+{
+    while (mSize + mReserved > mLimit && mEntries.size () > keep)
+    {
+	const std::pair<Window, size_t> &oldest = mEntries.back ();
+
+	evicted.push_back (oldest.first);
+	mSize -= oldest.second;
+	mIndex.erase (oldest.first);
+	mEntries.pop_back ();
+    }
+}
+
+void
+cwi::DataBudget::use (Window              id,
+		      size_t              bytes,
+		      std::vector<Window> &evicted)
+{
+    remove (id);
+
+    mEntries.push_front (std::make_pair (id, bytes));
+    mIndex[id] = mEntries.begin ();
+    mSize     += bytes;
+
+    evict (1, evicted);
+}
+
+bool
+cwi::DataBudget::reserve (size_t              bytes,
+			  std::vector<Window> &evicted)
+{
+    if (mReserved + bytes > mLimit)
+	return false;
+
+    mReserved += bytes;
+
+    evict (0, evicted);
+
+    return true;
+}
+
+void
+cwi::DataBudget::release (size_t bytes)
+{
+    mReserved -= std::min (bytes, mReserved);
+}
+
+void
+cwi::DataBudget::remove (Window id)
+{
+    std::map<Window, Entries::iterator>::iterator it = mIndex.find (id);
+
+    if (it == mIndex.end ())
+	return;
+
+    mSize -= it->second->second;
+    mEntries.erase (it->second);
+    mIndex.erase (it);
+}
+
+size_t
+cwi::DataBudget::size () const
+{
+    return mSize;
+}
+
+size_t
+cwi::DataBudget::reserved () const
+{
+    return mReserved;
+}
+
+size_t
+cwi::DataBudget::limit () const
+{
+    return mLimit;
+}
@@ -0,0 +1,249 @@
+/*
+ * Compiz, _NET_WM_ICON decoding
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <core/windowicon.h>
+
+namespace cwi = compiz::window::icon;
+
+using ::testing::ElementsAre;
+
+namespace
+{
+void
+appendImage (std::vector<uint32_t> &data,
+	     uint32_t              width,
+	     uint32_t              height)
+{
+    data.push_back (width);
+    data.push_back (height);
+
+    for (uint32_t i = 0; i < width * height; i++)
+	data.push_back (i);
+}
+
+uint32_t
+referencePremultiply (uint32_t pixel)
+{
+    uint32_t alpha = (pixel >> 24) & 0xff;
+
+    return (alpha << 24) |
+	   (((((pixel >> 16) & 0xff) * alpha) >> 8) << 16) |
+	   (((((pixel >>  8) & 0xff) * alpha) >> 8) << 8) |
+	   ((((pixel >>  0) & 0xff) * alpha) >> 8);
+}
+}
+
+TEST (WindowIcon, ParseFindsAllImages)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 16, 16);
+    appendImage (data, 32, 24);
+    appendImage (data, 1, 1);
+
+    std::vector<cwi::Image> images = cwi::parse (&data[0], data.size ());
+
+    ASSERT_EQ (3u, images.size ());
+    EXPECT_EQ (16u, images[0].width);
+    EXPECT_EQ (2u, images[0].offset);
+    EXPECT_EQ (32u, images[1].width);
+    EXPECT_EQ (24u, images[1].height);
+    EXPECT_EQ (2u + 256 + 2, images[1].offset);
+    EXPECT_EQ (data.size () - 1, images[2].offset);
+}
+
+TEST (WindowIcon, ParseSkipsEmptyImages)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 0, 16);
+    appendImage (data, 8, 8);
+
+    std::vector<cwi::Image> images = cwi::parse (&data[0], data.size ());
+
+    ASSERT_EQ (1u, images.size ());
+    EXPECT_EQ (8u, images[0].width);
+}
+
+TEST (WindowIcon, ParseStopsAtTruncatedImage)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 8, 8);
+    appendImage (data, 16, 16);
+    data.resize (data.size () - 1);
+
+    EXPECT_EQ (1u, cwi::parse (&data[0], data.size ()).size ());
+}
+
+TEST (WindowIcon, ParseStopsAtBogusSize)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 8, 8);
+    data.push_back (0xffffffff);
+    data.push_back (0xffffffff);
+    data.push_back (0);
+
+    EXPECT_EQ (1u, cwi::parse (&data[0], data.size ()).size ());
+}
+
+TEST (WindowIcon, NearestPicksLargestThatFits)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 16, 16);
+    appendImage (data, 48, 48);
+    appendImage (data, 32, 32);
+    appendImage (data, 64, 64);
+
+    std::vector<cwi::Image> images = cwi::parse (&data[0], data.size ());
+
+    EXPECT_EQ (2, cwi::nearest (images, 40, 40));
+    EXPECT_EQ (1, cwi::nearest (images, 48, 48));
+    EXPECT_EQ (3, cwi::nearest (images, 512, 512));
+    EXPECT_EQ (0, cwi::nearest (images, 16, 100));
+    EXPECT_EQ (-1, cwi::nearest (images, 8, 8));
+}
+
+TEST (WindowIcon, NearestKeepsFirstOnTie)
+{
+    std::vector<uint32_t> data;
+
+    appendImage (data, 16, 32);
+    appendImage (data, 32, 16);
+
+    std::vector<cwi::Image> images = cwi::parse (&data[0], data.size ());
+
+    EXPECT_EQ (0, cwi::nearest (images, 32, 32));
+}
+
+TEST (WindowIcon, PremultiplyMatchesScalar)
+{
+    /* odd length so the tail is covered as well */
+    std::vector<uint32_t> src (1027), dst (src.size ());
+
+    srand (1);
+
+    for (unsigned int i = 0; i < src.size (); i++)
+	src[i] = ((uint32_t) rand () << 16) ^ (uint32_t) rand ();
+
+    src[0] = 0xffffffff;
+    src[1] = 0x00ffffff;
+    src[2] = 0x80ff8000;
+
+    cwi::premultiply (&src[0], &dst[0], src.size ());
+
+    for (unsigned int i = 0; i < src.size (); i++)
+	ASSERT_EQ (referencePremultiply (src[i]), dst[i]) << "pixel " << i;
+}
+
+TEST (WindowIcon, PremultiplyInPlace)
+{
+    std::vector<uint32_t> pixels (9, 0x80402010);
+
+    cwi::premultiply (&pixels[0], &pixels[0], pixels.size ());
+
+    for (unsigned int i = 0; i < pixels.size (); i++)
+	EXPECT_EQ (referencePremultiply (0x80402010), pixels[i]);
+}
+
+TEST (WindowIcon, BudgetEvictsLeastRecentlyUsed)
+{
+    cwi::DataBudget     budget (100);
+    std::vector<Window> evicted;
+
+    budget.use (1, 40, evicted);
+    budget.use (2, 40, evicted);
+    budget.use (1, 40, evicted);
+    EXPECT_TRUE (evicted.empty ());
+
+    budget.use (3, 40, evicted);
+    EXPECT_THAT (evicted, ElementsAre (2));
+    EXPECT_EQ (80u, budget.size ());
+}
+
+TEST (WindowIcon, BudgetNeverEvictsWindowInUse)
+{
+    cwi::DataBudget     budget (100);
+    std::vector<Window> evicted;
+
+    budget.use (1, 40, evicted);
+    budget.use (2, 400, evicted);
+
+    EXPECT_THAT (evicted, ElementsAre (1));
+    EXPECT_EQ (400u, budget.size ());
+}
+
+TEST (WindowIcon, BudgetRemove)
+{
+    cwi::DataBudget     budget (100);
+    std::vector<Window> evicted;
+
+    budget.use (1, 40, evicted);
+    budget.use (2, 40, evicted);
+    budget.remove (1);
+    budget.remove (5);
+
+    EXPECT_EQ (40u, budget.size ());
+
+    budget.use (3, 60, evicted);
+    EXPECT_TRUE (evicted.empty ());
+}
+
+TEST (WindowIcon, BudgetReserveEvictsForDataOnItsWay)
+{
+    cwi::DataBudget     budget (100);
+    std::vector<Window> evicted;
+
+    budget.use (1, 40, evicted);
+    budget.use (2, 40, evicted);
+
+    EXPECT_TRUE (budget.reserve (30, evicted));
+    EXPECT_THAT (evicted, ElementsAre (1));
+    EXPECT_EQ (30u, budget.reserved ());
+
+    /* What is still on its way is not evicted for data arriving */
+    budget.use (3, 40, evicted);
+    EXPECT_THAT (evicted, ElementsAre (1, 2));
+    EXPECT_EQ (40u, budget.size ());
+}
+
+TEST (WindowIcon, BudgetReserveStopsAtTheLimit)
+{
+    cwi::DataBudget     budget (100);
+    std::vector<Window> evicted;
+
+    EXPECT_TRUE (budget.reserve (60, evicted));
+    EXPECT_FALSE (budget.reserve (60, evicted));
+    EXPECT_EQ (60u, budget.reserved ());
+
+    budget.release (60);
+
+    EXPECT_TRUE (budget.reserve (60, evicted));
+    EXPECT_TRUE (evicted.empty ());
+}
@@ -0,0 +1,130 @@
+/*
+ * Compiz, tracking of requests awaiting their events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PENDINGEVENTS_H
+#define _COMPIZ_PENDINGEVENTS_H
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+
+#include <X11/Xlib.h>
+
+#define XWINDOWCHANGES_INIT {0, 0, 0, 0, 0, None, 0}
+
+namespace compiz {namespace X11
+{
+class PendingEvent {
+public:
+    PendingEvent (Display *, Window);
+    PendingEvent (unsigned int serial, Window);
+    virtual ~PendingEvent ();
+
+    virtual bool match (XEvent *);
+    unsigned int serial () { return mSerial; } // HACK: will be removed
+    virtual void dump ();
+
+    typedef boost::shared_ptr<PendingEvent> Ptr;
+
+protected:
+
+    virtual Window getEventWindow (XEvent *);
+
+    unsigned int mSerial;
+    Window       mWindow;
+};
+
+class PendingConfigureEvent :
+    public PendingEvent
+{
+public:
+    PendingConfigureEvent (Display *, Window, unsigned int, XWindowChanges *);
+    PendingConfigureEvent (unsigned int serial, Window, unsigned int, XWindowChanges *);
+    virtual ~PendingConfigureEvent ();
+
+    virtual bool match (XEvent *);
+    bool matchVM (unsigned int valueMask);
+    bool matchRequest (XWindowChanges &xwc, unsigned int);
+    virtual void dump ();
+
+    typedef boost::shared_ptr<PendingConfigureEvent> Ptr;
+
+protected:
+
+    virtual Window getEventWindow (XEvent *);
+
+private:
+    unsigned int mValueMask;
+    XWindowChanges mXwc;
+};
+
+/**
+ * Requests awaiting their events, in the order they were sent. They are
+ * kept in a ring ordered by request serial, so an incoming event is
+ * matched by looking up its serial instead of walking every request.
+ */
+class PendingEventQueue
+{
+public:
+
+    static const unsigned int DefaultCapacity = 256;
+
+    PendingEventQueue (Display *, unsigned int capacity = DefaultCapacity);
+    virtual ~PendingEventQueue ();
+
+    void add (PendingEvent::Ptr p);
+    bool match (XEvent *);
+    bool pending ();
+    bool forEachIf (boost::function <bool (compiz::X11::PendingEvent::Ptr)>);
+    void clear (); // HACK will be removed
+    void dump ();
+
+    unsigned int size () const;
+    unsigned int capacity () const;
+
+protected:
+    bool removeIfMatching (const PendingEvent::Ptr &p, XEvent *);
+
+private:
+
+    struct Slot
+    {
+	unsigned int      serial;
+	PendingEvent::Ptr event;
+    };
+
+    Slot & at (unsigned int i);
+    unsigned int lowerBound (unsigned int serial);
+    void compact ();
+    void grow ();
+    void trim ();
+
+    std::vector <Slot> mSlots;
+    unsigned int       mHead;
+    unsigned int       mSpan;
+    unsigned int       mLive;
+};
+
+}}
+
+#endif
@@ -0,0 +1,419 @@
+/*
+ * Compiz, tracking of requests awaiting their events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <core/logmessage.h>
+#include <core/pendingevents.h>
+
+namespace
+{
+    /* Serials wrap around, so order them by distance */
+    inline bool
+    serialBefore (unsigned int a,
+		  unsigned int b)
+    {
+	return (int) (a - b) < 0;
+    }
+}
+
+compiz::X11::PendingEventQueue::Slot &
+compiz::X11::PendingEventQueue::at (unsigned int i)
+{
+    return mSlots[(mHead + i) % mSlots.size ()];
+}
+
+unsigned int
+compiz::X11::PendingEventQueue::lowerBound (unsigned int serial)
+{
+    /* Events mostly come back in the order the requests were sent */
+    if (!mSpan || !serialBefore (at (0).serial, serial))
+	return 0;
+
+    unsigned int low = 1, high = mSpan;
+
+    while (low < high)
+    {
+	unsigned int mid = low + (high - low) / 2;
+
+	if (serialBefore (at (mid).serial, serial))
+	    low = mid + 1;
+	else
+	    high = mid;
+    }
+
+    return low;
+}
+
+void
+compiz::X11::PendingEventQueue::trim ()
+{
+    while (mSpan && !at (0).event)
+    {
+	mHead = (mHead + 1) % mSlots.size ();
+	--mSpan;
+    }
+
+    while (mSpan && !at (mSpan - 1).event)
+	--mSpan;
+
+    if (!mSpan)
+	mHead = 0;
+}
+
+void
+compiz::X11::PendingEventQueue::compact ()
+{
+    unsigned int live = 0;
+
+    for (unsigned int i = 0; i < mSpan; ++i)
+    {
+	Slot &slot = at (i);
+
+	if (!slot.event)
+	    continue;
+
+	if (i != live)
+	{
+	    at (live).serial = slot.serial;
+	    at (live).event.swap (slot.event);
+	}
+
+	++live;
+    }
+
+    mSpan = live;
+}
+
+void
+compiz::X11::PendingEventQueue::grow ()
+{
+    /* Dropping a request would make its event look unexpected, so
+     * there is always room for another one */
+    std::vector <Slot> slots (mSlots.size () * 2);
+
+    for (unsigned int i = 0; i < mSpan; ++i)
+    {
+	slots[i].serial = at (i).serial;
+	slots[i].event.swap (at (i).event);
+    }
+
+    mSlots.swap (slots);
+    mHead = 0;
+}
+
+bool
+compiz::X11::PendingEventQueue::pending ()
+{
+    return mLive != 0;
+}
+
+unsigned int
+compiz::X11::PendingEventQueue::size () const
+{
+    return mLive;
+}
+
+unsigned int
+compiz::X11::PendingEventQueue::capacity () const
+{
+    return mSlots.size ();
+}
+
+void
+compiz::X11::PendingEventQueue::add (PendingEvent::Ptr p)
+{
+    compLogMessage ("core", CompLogLevelDebug, "pending request:");
+    p->dump ();
+
+    if (mSpan == mSlots.size ())
+	compact ();
+
+    if (mSpan == mSlots.size ())
+	grow ();
+
+    unsigned int pos = mSpan++;
+
+    /* Requests are added in the order they are sent, so this only
+     * has to move anything if that ever isn't the case */
+    while (pos && serialBefore (p->serial (), at (pos - 1).serial))
+    {
+	at (pos).serial = at (pos - 1).serial;
+	at (pos).event.swap (at (pos - 1).event);
+	--pos;
+    }
+
+    at (pos).serial = p->serial ();
+    at (pos).event  = p;
+    ++mLive;
+}
+
+bool
+compiz::X11::PendingEventQueue::removeIfMatching (const PendingEvent::Ptr &p, XEvent *event)
+{
+    if (p->match (event))
+    {
+	compLogMessage ("core", CompLogLevelDebug, "received event:");
+	p->dump ();
+	return true;
+    }
+
+    return false;
+}
+
+void
+compiz::X11::PendingEvent::dump ()
+{
+    compLogMessage ("core", CompLogLevelDebug, "- event serial: %i", mSerial);
+    compLogMessage ("core", CompLogLevelDebug,  "- event window 0x%x", mWindow);
+}
+
+void
+compiz::X11::PendingConfigureEvent::dump ()
+{
+    compiz::X11::PendingEvent::dump ();
+
+    compLogMessage ("core", CompLogLevelDebug,  "- x: %i y: %i width: %i height: %i "\
+						 "border: %i, sibling: 0x%x",
+						 mXwc.x, mXwc.y, mXwc.width, mXwc.height, mXwc.border_width, mXwc.sibling);
+}
+
+bool
+compiz::X11::PendingEventQueue::match (XEvent *event)
+{
+    unsigned int serial  = event->xany.serial;
+    bool         matched = false;
+
+    /* Only requests with the same serial can match */
+    for (unsigned int i = lowerBound (serial);
+	 i < mSpan && at (i).serial == serial; ++i)
+    {
+	Slot &slot = at (i);
+
+	if (slot.event && removeIfMatching (slot.event, event))
+	{
+	    slot.event.reset ();
+	    --mLive;
+	    matched = true;
+	}
+    }
+
+    trim ();
+
+    return matched;
+}
+
+bool
+compiz::X11::PendingEventQueue::forEachIf (boost::function<bool (compiz::X11::PendingEvent::Ptr)> f)
+{
+    for (unsigned int i = 0; i < mSpan; ++i)
+	if (at (i).event && f (at (i).event))
+	    return true;
+
+    return false;
+}
+
+void
+compiz::X11::PendingEventQueue::clear ()
+{
+    for (unsigned int i = 0; i < mSpan; ++i)
+	at (i).event.reset ();
+
+    mHead = 0;
+    mSpan = 0;
+    mLive = 0;
+}
+
+void
+compiz::X11::PendingEventQueue::dump ()
+{
+    for (unsigned int i = 0; i < mSpan; ++i)
+	if (at (i).event)
+	    at (i).event->dump ();
+}
+
+compiz::X11::PendingEventQueue::PendingEventQueue (Display      *d,
+						   unsigned int capacity) :
+    mSlots (capacity ? capacity : 1),
+    mHead (0),
+    mSpan (0),
+    mLive (0)
+{
+    /* mClearCheckTimeout.setTimes (0, 0)
+     *
+     * XXX: For whatever reason, calling setTimes (0, 0) here causes
+     * the destructor of the timer object to be called twice later on
+     * in execution and the stack gets smashed. This could be a
+     * compiler bug, but requires further investigation */
+}
+
+compiz::X11::PendingEventQueue::~PendingEventQueue ()
+{
+}
+
+Window
+compiz::X11::PendingEvent::getEventWindow (XEvent *event)
+{
+    return event->xany.window;
+}
+
+bool
+compiz::X11::PendingEvent::match (XEvent *event)
+{
+    if (event->xany.serial != mSerial ||
+	getEventWindow (event)!= mWindow)
+	return false;
+
+    return true;
+}
+
+compiz::X11::PendingEvent::PendingEvent (Display *d, Window w) :
+    mSerial (XNextRequest (d)),
+    mWindow (w)
+{
+}
+
+compiz::X11::PendingEvent::PendingEvent (unsigned int serial, Window w) :
+    mSerial (serial),
+    mWindow (w)
+{
+}
+
+compiz::X11::PendingEvent::~PendingEvent ()
+{
+}
+
+Window
+compiz::X11::PendingConfigureEvent::getEventWindow (XEvent *event)
+{
+    return event->xconfigure.window;
+}
+
+bool
+compiz::X11::PendingConfigureEvent::matchVM (unsigned int valueMask)
+{
+    unsigned int result = mValueMask != 0 ? valueMask & mValueMask : 1;
+
+    return result != 0;
+}
+
+bool
+compiz::X11::PendingConfigureEvent::matchRequest (XWindowChanges &xwc,
+						  unsigned int   valueMask)
+{
+    if (matchVM (valueMask))
+    {
+	if ((valueMask & CWX                       && xwc.x            != mXwc.x)		||
+	    (valueMask & CWY                       && xwc.y            != mXwc.y)		||
+	    (valueMask & CWWidth                   && xwc.width        != mXwc.width)		||
+	    (valueMask & CWHeight                  && xwc.height       != mXwc.height)		||
+	    (valueMask & CWBorderWidth             && xwc.border_width != mXwc.border_width)	||
+	    (valueMask & (CWStackMode | CWSibling) && xwc.sibling      != mXwc.sibling))
+	    return false;
+
+	return true;
+    }
+
+    return false;
+}
+
+bool
+compiz::X11::PendingConfigureEvent::match (XEvent *event)
+{
+    XConfigureEvent *ce     = (XConfigureEvent *) event;
+    bool            matched = true;
+
+    if (!compiz::X11::PendingEvent::match (event))
+	return false;
+
+    XWindowChanges xwc = XWINDOWCHANGES_INIT;
+
+    xwc.x            = ce->x;
+    xwc.y            = ce->y;
+    xwc.width        = ce->width;
+    xwc.height       = ce->height;
+    xwc.border_width = ce->border_width;
+    xwc.sibling      = ce->above;
+
+    matched = matchRequest (xwc, mValueMask);
+
+    /* Remove events from the queue
+     * even if they didn't match what
+     * we expected them to be, but still
+     * complain about it */
+    if (!matched)
+    {
+	compLogMessage ("core", CompLogLevelWarn, "no exact match for ConfigureNotify on 0x%x!", mWindow);
+	compLogMessage ("core", CompLogLevelWarn, "expected the following changes:");
+
+	if (mValueMask & CWX)
+	    compLogMessage ("core", CompLogLevelWarn, "x: %i", mXwc.x);
+
+	if (mValueMask & CWY)
+	    compLogMessage ("core", CompLogLevelWarn, "y: %i", mXwc.y);
+
+	if (mValueMask & CWWidth)
+	    compLogMessage ("core", CompLogLevelWarn, "width: %i", mXwc.width);
+
+	if (mValueMask & CWHeight)
+	    compLogMessage ("core", CompLogLevelWarn, "height: %i", mXwc.height);
+
+	if (mValueMask & CWBorderWidth)
+	    compLogMessage ("core", CompLogLevelWarn, "border: %i", mXwc.border_width);
+
+	if (mValueMask & (CWStackMode | CWSibling))
+	    compLogMessage ("core", CompLogLevelWarn, "sibling: 0x%x", mXwc.sibling);
+
+	compLogMessage ("core", CompLogLevelWarn, "instead got:");
+	compLogMessage ("core", CompLogLevelWarn, "x: %i", ce->x);
+	compLogMessage ("core", CompLogLevelWarn, "y: %i", ce->y);
+	compLogMessage ("core", CompLogLevelWarn, "width: %i", ce->width);
+	compLogMessage ("core", CompLogLevelWarn, "height: %i", ce->height);
+	compLogMessage ("core", CompLogLevelWarn, "above: %i", ce->above);
+	compLogMessage ("core", CompLogLevelWarn, "this should never happen. you should "\
+						  "probably file a bug about this.");
+    }
+
+    return true;
+}
+
+compiz::X11::PendingConfigureEvent::PendingConfigureEvent (Display        *d,
+							   Window         w,
+							   unsigned int   valueMask,
+							   XWindowChanges *xwc) :
+    compiz::X11::PendingEvent::PendingEvent (d, w),
+    mValueMask (valueMask),
+    mXwc (*xwc)
+{
+}
+
+compiz::X11::PendingConfigureEvent::PendingConfigureEvent (unsigned int   serial,
+							   Window         w,
+							   unsigned int   valueMask,
+							   XWindowChanges *xwc) :
+    compiz::X11::PendingEvent::PendingEvent (serial, w),
+    mValueMask (valueMask),
+    mXwc (*xwc)
+{
+}
+
+compiz::X11::PendingConfigureEvent::~PendingConfigureEvent ()
+{
+}
@@ -0,0 +1,331 @@
+/*
+ * Compiz, tracking of requests awaiting their events
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+
+#include <core/pendingevents.h>
+
+namespace cx = compiz::X11;
+
+bool debugOutput;
+char *programName;
+
+namespace
+{
+const Window frame = 1;
+const Window other = 2;
+
+cx::PendingEvent::Ptr
+configure (unsigned int serial,
+	   Window       window,
+	   int          x,
+	   int          y,
+	   unsigned int valueMask = CWX | CWY)
+{
+    XWindowChanges xwc = XWINDOWCHANGES_INIT;
+
+    xwc.x = x;
+    xwc.y = y;
+
+    return cx::PendingEvent::Ptr (new cx::PendingConfigureEvent (serial, window,
+								 valueMask, &xwc));
+}
+
+XEvent
+configureNotify (unsigned int serial,
+		 Window       window,
+		 int          x,
+		 int          y)
+{
+    XEvent event;
+
+    memset (&event, 0, sizeof (event));
+
+    event.xconfigure.type   = ConfigureNotify;
+    event.xconfigure.serial = serial;
+    event.xconfigure.event  = window;
+    event.xconfigure.window = window;
+    event.xconfigure.x      = x;
+    event.xconfigure.y      = y;
+
+    return event;
+}
+
+bool
+isRestack (const cx::PendingEvent::Ptr &p)
+{
+    return boost::static_pointer_cast <cx::PendingConfigureEvent> (p)->matchVM (CWStackMode | CWSibling);
+}
+
+bool
+collect (const cx::PendingEvent::Ptr &p,
+	 std::vector <unsigned int>  &serials)
+{
+    serials.push_back (p->serial ());
+    return false;
+}
+}
+
+TEST (PendingEventQueue, MatchingEventRemovesRequest)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 5, 5));
+    ASSERT_TRUE (queue.pending ());
+
+    XEvent event = configureNotify (10, frame, 5, 5);
+
+    EXPECT_TRUE (queue.match (&event));
+    EXPECT_FALSE (queue.pending ());
+}
+
+TEST (PendingEventQueue, OtherSerialDoesNotMatch)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 5, 5));
+
+    XEvent event = configureNotify (11, frame, 5, 5);
+
+    EXPECT_FALSE (queue.match (&event));
+    EXPECT_TRUE (queue.pending ());
+}
+
+TEST (PendingEventQueue, OtherWindowDoesNotMatch)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 5, 5));
+
+    XEvent event = configureNotify (10, other, 5, 5);
+
+    EXPECT_FALSE (queue.match (&event));
+    EXPECT_TRUE (queue.pending ());
+}
+
+TEST (PendingEventQueue, UnexpectedGeometryStillRemovesRequest)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 5, 5));
+
+    XEvent event = configureNotify (10, frame, 50, 50);
+
+    EXPECT_TRUE (queue.match (&event));
+    EXPECT_FALSE (queue.pending ());
+}
+
+TEST (PendingEventQueue, MatchInTheMiddleKeepsTheRest)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 1, 1));
+    queue.add (configure (12, frame, 2, 2));
+    queue.add (configure (14, frame, 3, 3));
+
+    XEvent event = configureNotify (12, frame, 2, 2);
+    EXPECT_TRUE (queue.match (&event));
+
+    std::vector <unsigned int> serials;
+    queue.forEachIf (boost::bind (collect, _1, boost::ref (serials)));
+
+    ASSERT_EQ (2, serials.size ());
+    EXPECT_EQ (10, serials[0]);
+    EXPECT_EQ (14, serials[1]);
+    EXPECT_EQ (2, queue.size ());
+}
+
+TEST (PendingEventQueue, ForEachIfFindsPendingRestack)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (10, frame, 1, 1));
+    EXPECT_FALSE (queue.forEachIf (boost::bind (isRestack, _1)));
+
+    queue.add (configure (11, frame, 0, 0, CWStackMode | CWSibling));
+    EXPECT_TRUE (queue.forEachIf (boost::bind (isRestack, _1)));
+
+    XEvent event = configureNotify (11, frame, 0, 0);
+    queue.match (&event);
+
+    EXPECT_FALSE (queue.forEachIf (boost::bind (isRestack, _1)));
+}
+
+TEST (PendingEventQueue, MatchRequestComparesRequestedFields)
+{
+    XWindowChanges xwc = XWINDOWCHANGES_INIT;
+
+    xwc.x     = 5;
+    xwc.width = 100;
+
+    cx::PendingConfigureEvent pc (10, frame, CWX | CWWidth, &xwc);
+
+    XWindowChanges request = XWINDOWCHANGES_INIT;
+
+    request.x = 5;
+    EXPECT_TRUE (pc.matchRequest (request, CWX));
+
+    request.x = 6;
+    EXPECT_FALSE (pc.matchRequest (request, CWX));
+
+    /* Fields that were not changed by the request never match */
+    EXPECT_FALSE (pc.matchRequest (request, CWY));
+}
+
+TEST (PendingEventQueue, ClearDropsEverything)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    for (unsigned int i = 0; i < 10; i++)
+	queue.add (configure (i, frame, i, i));
+
+    queue.clear ();
+
+    EXPECT_FALSE (queue.pending ());
+    EXPECT_EQ (0, queue.size ());
+}
+
+TEST (PendingEventQueue, FullQueueGrows)
+{
+    cx::PendingEventQueue queue (NULL, 4);
+
+    for (unsigned int i = 1; i <= 4; i++)
+	queue.add (configure (i, frame, i, i));
+
+    /* Moves the head along so the requests wrap around the ring */
+    XEvent event = configureNotify (1, frame, 1, 1);
+    EXPECT_TRUE (queue.match (&event));
+    event = configureNotify (2, frame, 2, 2);
+    EXPECT_TRUE (queue.match (&event));
+
+    for (unsigned int i = 5; i <= 7; i++)
+	queue.add (configure (i, frame, i, i));
+
+    EXPECT_EQ (5, queue.size ());
+    EXPECT_EQ (8, queue.capacity ());
+
+    for (unsigned int i = 3; i <= 7; i++)
+    {
+	event = configureNotify (i, frame, i, i);
+	EXPECT_TRUE (queue.match (&event));
+    }
+
+    EXPECT_FALSE (queue.pending ());
+}
+
+TEST (PendingEventQueue, MoreRequestsThanTheDefaultCapacity)
+{
+    cx::PendingEventQueue queue (NULL);
+    const unsigned int    n = cx::PendingEventQueue::DefaultCapacity * 3 + 1;
+
+    for (unsigned int i = 1; i <= n; i++)
+	queue.add (configure (i, i % 2 ? frame : other, i, i));
+
+    EXPECT_EQ (n, queue.size ());
+
+    for (unsigned int i = 1; i <= n; i++)
+    {
+	XEvent event = configureNotify (i, i % 2 ? frame : other, i, i);
+	EXPECT_TRUE (queue.match (&event));
+    }
+
+    EXPECT_FALSE (queue.pending ());
+}
+
+TEST (PendingEventQueue, MatchedSlotsAreReusedWhenFull)
+{
+    cx::PendingEventQueue queue (NULL, 4);
+
+    queue.add (configure (1, frame, 1, 1));
+    queue.add (configure (2, frame, 2, 2));
+    queue.add (configure (3, frame, 3, 3));
+    queue.add (configure (4, frame, 4, 4));
+
+    /* Leaves a hole which isn't at either end */
+    XEvent event = configureNotify (3, frame, 3, 3);
+    EXPECT_TRUE (queue.match (&event));
+
+    queue.add (configure (5, frame, 5, 5));
+    EXPECT_EQ (4, queue.size ());
+
+    for (unsigned int i = 1; i <= 5; i++)
+    {
+	if (i == 3)
+	    continue;
+
+	event = configureNotify (i, frame, i, i);
+	EXPECT_TRUE (queue.match (&event));
+    }
+
+    EXPECT_FALSE (queue.pending ());
+}
+
+TEST (PendingEventQueue, SerialsWrapAround)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    queue.add (configure (0xfffffffe, frame, 1, 1));
+    queue.add (configure (0xffffffff, frame, 2, 2));
+    queue.add (configure (0, frame, 3, 3));
+    queue.add (configure (1, frame, 4, 4));
+
+    XEvent event = configureNotify (0, frame, 3, 3);
+    EXPECT_TRUE (queue.match (&event));
+
+    event = configureNotify (0xffffffff, frame, 2, 2);
+    EXPECT_TRUE (queue.match (&event));
+
+    EXPECT_EQ (2, queue.size ());
+}
+
+TEST (PendingEventQueue, ManyRequestsDuringADrag)
+{
+    cx::PendingEventQueue queue (NULL);
+
+    /* Requests are sent faster than their events come back, until
+     * there are as many in flight as the queue holds */
+    unsigned int sent = 0, received = 0;
+
+    while (sent < 1000)
+    {
+	for (unsigned int i = 0; i < 2 && queue.size () < queue.capacity (); i++)
+	{
+	    ++sent;
+	    queue.add (configure (sent, frame, sent, sent));
+	}
+
+	++received;
+	XEvent event = configureNotify (received, frame, received, received);
+	EXPECT_TRUE (queue.match (&event));
+    }
+
+    while (queue.pending ())
+    {
+	++received;
+	XEvent event = configureNotify (received, frame, received, received);
+	EXPECT_TRUE (queue.match (&event));
+    }
+
+    EXPECT_EQ (sent, received);
+}
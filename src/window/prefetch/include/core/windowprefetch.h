@@ -0,0 +1,172 @@
+/*
+ * Compiz, pipelined window attribute and property reads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_WINDOWPREFETCH_H
+#define _COMPIZ_WINDOWPREFETCH_H
+
+#include <vector>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+namespace compiz
+{
+namespace window
+{
+
+class PrivatePropertyPrefetch;
+
+/**
+ * Reads attributes and properties of many windows in one go.
+ *
+ * XGetWindowAttributes and XGetWindowProperty each block on a reply,
+ * so adopting the windows that already exist at startup costs about
+ * fifteen round trips per window. PropertyPrefetch sends every request
+ * over the display's XCB connection first and only then waits for the
+ * replies, which brings the whole set down to about one round trip.
+ *
+ * Each prefetched property is handed out at most once and only while
+ * a Scope for its window is alive. Anything read a second time, or
+ * outside the scope, goes to the server as usual, so a property which
+ * core changes itself while adopting a window is never served stale.
+ */
+class PropertyPrefetch
+{
+    public:
+
+	explicit PropertyPrefetch (Display *dpy);
+	~PropertyPrefetch ();
+
+	/**
+	 * Sends attribute, geometry and property requests for n windows
+	 * without waiting for any of the replies.
+	 */
+	void request (const Window            *windows,
+		      unsigned int            n,
+		      const std::vector<Atom> &properties);
+
+	/**
+	 * Waits for every outstanding reply. Errors, eg, for windows
+	 * which were destroyed in the meantime, are swallowed and the
+	 * affected entries are treated as missing.
+	 */
+	void collect ();
+
+	/**
+	 * Fills in attrib the same way XGetWindowAttributes would. Returns
+	 * false if the window was not requested or no longer exists.
+	 */
+	bool attributes (Window id, XWindowAttributes *attrib) const;
+
+	/**
+	 * Serves a read with the semantics of XGetWindowProperty at
+	 * offset zero. Returns false if the property was not prefetched,
+	 * was already handed out, or is longer than what was fetched, in
+	 * which case the caller has to ask the server.
+	 */
+	bool getProperty (Window        id,
+			  Atom          property,
+			  long          length,
+			  Atom          reqType,
+			  Atom          *actualType,
+			  int           *actualFormat,
+			  unsigned long *nItems,
+			  unsigned long *bytesAfter,
+			  unsigned char **prop);
+
+	/**
+	 * Number of property reads served from the prefetch so far
+	 */
+	unsigned int served () const;
+
+	/**
+	 * Makes the prefetch visible to the read functions below for
+	 * reads of one window. Whatever is left for that window is
+	 * dropped when the scope ends.
+	 */
+	class Scope
+	{
+	    public:
+
+		Scope (PropertyPrefetch &prefetch, Window id);
+		~Scope ();
+
+	    private:
+
+		Scope (const Scope &);
+		Scope & operator= (const Scope &);
+
+		PropertyPrefetch &mPrefetch;
+		Window           mId;
+	};
+
+	/**
+	 * The prefetch whose Scope covers reads of id, or NULL
+	 */
+	static PropertyPrefetch * active (Window id);
+
+    private:
+
+	PropertyPrefetch (const PropertyPrefetch &);
+	PropertyPrefetch & operator= (const PropertyPrefetch &);
+
+	PrivatePropertyPrefetch *priv;
+};
+
+/*
+ * Drop in replacements for the Xlib functions of the same name which
+ * are answered from the active PropertyPrefetch where possible and
+ * otherwise fall through to Xlib.
+ */
+int getWindowProperty (Display       *dpy,
+		       Window        id,
+		       Atom          property,
+		       long          offset,
+		       long          length,
+		       Bool          del,
+		       Atom          reqType,
+		       Atom          *actualType,
+		       int           *actualFormat,
+		       unsigned long *nItems,
+		       unsigned long *bytesAfter,
+		       unsigned char **prop);
+
+XWMHints * getWMHints (Display *dpy, Window id);
+
+Status getWMNormalHints (Display    *dpy,
+			 Window     id,
+			 XSizeHints *hints,
+			 long       *supplied);
+
+Status getClassHint (Display *dpy, Window id, XClassHint *classHint);
+
+Status getTransientForHint (Display *dpy, Window id, Window *transientFor);
+
+Status getWMProtocols (Display *dpy,
+		       Window  id,
+		       Atom    **protocols,
+		       int     *count);
+
+}
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Compiz, pipelined window attribute and property reads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_PRIVATEWINDOWPREFETCH_H
+#define _COMPIZ_PRIVATEWINDOWPREFETCH_H
+
+#include <map>
+#include <utility>
+
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+
+#include "core/windowprefetch.h"
+
+namespace compiz
+{
+namespace window
+{
+
+struct PrefetchedAttributes
+{
+    PrefetchedAttributes ();
+
+    xcb_get_window_attributes_cookie_t attributesCookie;
+    xcb_get_geometry_cookie_t          geometryCookie;
+    xcb_get_window_attributes_reply_t  *attributes;
+    xcb_get_geometry_reply_t           *geometry;
+    bool                               waiting;
+};
+
+struct PrefetchedProperty
+{
+    PrefetchedProperty ();
+
+    xcb_get_property_cookie_t cookie;
+    xcb_get_property_reply_t  *reply;
+    bool                      waiting;
+};
+
+class PrivatePropertyPrefetch
+{
+    public:
+
+	typedef std::map<Window, PrefetchedAttributes> AttributesMap;
+	typedef std::pair<Window, Atom> PropertyKey;
+	typedef std::map<PropertyKey, PrefetchedProperty> PropertyMap;
+
+	PrivatePropertyPrefetch (Display *dpy);
+	~PrivatePropertyPrefetch ();
+
+	void release (PrefetchedAttributes &entry);
+	void release (PrefetchedProperty &entry);
+	void discard (Window id);
+
+	Display          *dpy;
+	xcb_connection_t *connection;
+
+	AttributesMap attributes;
+	PropertyMap   properties;
+
+	unsigned int served;
+
+	static PropertyPrefetch *active;
+	static Window           activeWindow;
+};
+
+}
+}
+
+#endif
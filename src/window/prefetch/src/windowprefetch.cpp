@@ -0,0 +1,663 @@
+/*
+ * Compiz, pipelined window attribute and property reads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include <X11/Xatom.h>
+
+#include "privatewindowprefetch.h"
+
+namespace cw = compiz::window;
+
+namespace
+{
+/* Properties are fetched up to this many 32 bit units. Anything longer
+ * is rare (large WM_CLASS strings, mostly) and is read again in full
+ * from the server when asked for */
+const uint32_t PREFETCH_LENGTH = 1024;
+
+/* Element counts of WM_HINTS and WM_NORMAL_HINTS, see the ICCCM */
+const long WM_HINTS_ELEMENTS = 9;
+const long WM_SIZE_HINTS_ELEMENTS = 18;
+const long OLD_WM_SIZE_HINTS_ELEMENTS = 15;
+
+Visual *
+visualFromId (Display  *dpy,
+	      VisualID id)
+{
+    for (int s = 0; s < ScreenCount (dpy); s++)
+    {
+	Screen *screen = ScreenOfDisplay (dpy, s);
+
+	for (int d = 0; d < screen->ndepths; d++)
+	{
+	    Depth *depth = &screen->depths[d];
+
+	    for (int v = 0; v < depth->nvisuals; v++)
+		if (depth->visuals[v].visualid == id)
+		    return &depth->visuals[v];
+	}
+    }
+
+    return NULL;
+}
+
+Screen *
+screenFromRoot (Display *dpy,
+		Window  root)
+{
+    for (int s = 0; s < ScreenCount (dpy); s++)
+	if (RootWindow (dpy, s) == root)
+	    return ScreenOfDisplay (dpy, s);
+
+    return NULL;
+}
+}
+
+cw::PrefetchedAttributes::PrefetchedAttributes () :
+    attributes (NULL),
+    geometry (NULL),
+    waiting (false)
+{
+}
+
+cw::PrefetchedProperty::PrefetchedProperty () :
+    reply (NULL),
+    waiting (false)
+{
+}
+
+cw::PropertyPrefetch *cw::PrivatePropertyPrefetch::active = NULL;
+Window cw::PrivatePropertyPrefetch::activeWindow = None;
+
+cw::PrivatePropertyPrefetch::PrivatePropertyPrefetch (Display *dpy) :
+    dpy (dpy),
+    connection (XGetXCBConnection (dpy)),
+    served (0)
+{
+}
+
+cw::PrivatePropertyPrefetch::~PrivatePropertyPrefetch ()
+{
+    for (AttributesMap::iterator it = attributes.begin ();
+	 it != attributes.end (); ++it)
+	release (it->second);
+
+    for (PropertyMap::iterator it = properties.begin ();
+	 it != properties.end (); ++it)
+	release (it->second);
+}
+
+void
+cw::PrivatePropertyPrefetch::release (PrefetchedAttributes &entry)
+{
+    if (entry.waiting)
+    {
+	xcb_discard_reply (connection, entry.attributesCookie.sequence);
+	xcb_discard_reply (connection, entry.geometryCookie.sequence);
+	entry.waiting = false;
+    }
+
+    free (entry.attributes);
+    free (entry.geometry);
+
+    entry.attributes = NULL;
+    entry.geometry   = NULL;
+}
+
+void
+cw::PrivatePropertyPrefetch::release (PrefetchedProperty &entry)
+{
+    if (entry.waiting)
+    {
+	xcb_discard_reply (connection, entry.cookie.sequence);
+	entry.waiting = false;
+    }
+
+    free (entry.reply);
+    entry.reply = NULL;
+}
+
+void
+cw::PrivatePropertyPrefetch::discard (Window id)
+{
+    PropertyMap::iterator it = properties.lower_bound (PropertyKey (id, 0));
+
+    while (it != properties.end () && it->first.first == id)
+    {
+	release (it->second);
+	properties.erase (it++);
+    }
+
+    AttributesMap::iterator ait = attributes.find (id);
+
+    if (ait != attributes.end ())
+    {
+	release (ait->second);
+	attributes.erase (ait);
+    }
+}
+
+cw::PropertyPrefetch::PropertyPrefetch (Display *dpy) :
+    priv (new PrivatePropertyPrefetch (dpy))
+{
+}
+
+cw::PropertyPrefetch::~PropertyPrefetch ()
+{
+    if (PrivatePropertyPrefetch::active == this)
+	PrivatePropertyPrefetch::active = NULL;
+
+    delete priv;
+}
+
+void
+cw::PropertyPrefetch::request (const Window            *windows,
+			       unsigned int            n,
+			       const std::vector<Atom> &properties)
+{
+    xcb_connection_t *c = priv->connection;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+	Window               id     = windows[i];
+	PrefetchedAttributes &attrib = priv->attributes[id];
+
+	if (!attrib.waiting && !attrib.attributes)
+	{
+	    attrib.attributesCookie = xcb_get_window_attributes (c, id);
+	    attrib.geometryCookie   = xcb_get_geometry (c, id);
+	    attrib.waiting          = true;
+	}
+
+	for (std::vector<Atom>::const_iterator it = properties.begin ();
+	     it != properties.end (); ++it)
+	{
+	    PrefetchedProperty &property =
+		priv->properties[PrivatePropertyPrefetch::PropertyKey (id, *it)];
+
+	    if (property.waiting || property.reply)
+		continue;
+
+	    property.cookie  = xcb_get_property (c, 0, id, *it,
+						 XCB_GET_PROPERTY_TYPE_ANY,
+						 0, PREFETCH_LENGTH);
+	    property.waiting = true;
+	}
+    }
+
+    xcb_flush (c);
+}
+
+void
+cw::PropertyPrefetch::collect ()
+{
+    xcb_connection_t     *c = priv->connection;
+    xcb_generic_error_t *error;
+
+    for (PrivatePropertyPrefetch::AttributesMap::iterator it =
+	 priv->attributes.begin (); it != priv->attributes.end (); ++it)
+    {
+	PrefetchedAttributes &attrib = it->second;
+
+	if (!attrib.waiting)
+	    continue;
+
+	attrib.waiting = false;
+
+	error = NULL;
+	attrib.attributes =
+	    xcb_get_window_attributes_reply (c, attrib.attributesCookie, &error);
+	free (error);
+
+	error = NULL;
+	attrib.geometry = xcb_get_geometry_reply (c, attrib.geometryCookie,
+						  &error);
+	free (error);
+    }
+
+    for (PrivatePropertyPrefetch::PropertyMap::iterator it =
+	 priv->properties.begin (); it != priv->properties.end (); ++it)
+    {
+	PrefetchedProperty &property = it->second;
+
+	if (!property.waiting)
+	    continue;
+
+	property.waiting = false;
+
+	error = NULL;
+	property.reply = xcb_get_property_reply (c, property.cookie, &error);
+	free (error);
+    }
+}
+
+bool
+cw::PropertyPrefetch::attributes (Window            id,
+				  XWindowAttributes *attrib) const
+{
+    PrivatePropertyPrefetch::AttributesMap::const_iterator it =
+	priv->attributes.find (id);
+
+    if (it == priv->attributes.end ())
+	return false;
+
+    const xcb_get_window_attributes_reply_t *a = it->second.attributes;
+    const xcb_get_geometry_reply_t          *g = it->second.geometry;
+
+    if (!a || !g)
+	return false;
+
+    attrib->x                     = g->x;
+    attrib->y                     = g->y;
+    attrib->width                 = g->width;
+    attrib->height                = g->height;
+    attrib->border_width          = g->border_width;
+    attrib->depth                 = g->depth;
+    attrib->root                  = g->root;
+    attrib->visual                = visualFromId (priv->dpy, a->visual);
+    attrib->c_class               = a->_class;
+    attrib->bit_gravity           = a->bit_gravity;
+    attrib->win_gravity           = a->win_gravity;
+    attrib->backing_store         = a->backing_store;
+    attrib->backing_planes        = a->backing_planes;
+    attrib->backing_pixel         = a->backing_pixel;
+    attrib->save_under            = a->save_under;
+    attrib->colormap              = a->colormap;
+    attrib->map_installed         = a->map_is_installed;
+    attrib->map_state             = a->map_state;
+    attrib->all_event_masks       = a->all_event_masks;
+    attrib->your_event_mask       = a->your_event_mask;
+    attrib->do_not_propagate_mask = a->do_not_propagate_mask;
+    attrib->override_redirect     = a->override_redirect;
+    attrib->screen                = screenFromRoot (priv->dpy, g->root);
+
+    return true;
+}
+
+bool
+cw::PropertyPrefetch::getProperty (Window        id,
+				   Atom          property,
+				   long          length,
+				   Atom          reqType,
+				   Atom          *actualType,
+				   int           *actualFormat,
+				   unsigned long *nItems,
+				   unsigned long *bytesAfter,
+				   unsigned char **prop)
+{
+    PrivatePropertyPrefetch::PropertyMap::iterator it =
+	priv->properties.find (PrivatePropertyPrefetch::PropertyKey (id, property));
+
+    if (it == priv->properties.end () || !it->second.reply)
+	return false;
+
+    const xcb_get_property_reply_t *reply = it->second.reply;
+    unsigned long fetched = xcb_get_property_value_length (reply);
+    unsigned long total   = fetched + reply->bytes_after;
+    unsigned long wanted  = std::min (total, (unsigned long) std::max (length, 0L) * 4);
+    unsigned char *data   = NULL;
+    unsigned long count   = 0;
+
+    if (reply->type != None)
+    {
+	/* A type mismatch reports the actual type and the full size of
+	 * the property but no data, exactly like the server would */
+	if (reqType != AnyPropertyType && reqType != reply->type)
+	    wanted = 0;
+	else if (wanted > fetched)
+	    return false;
+
+	size_t nBytes;
+
+	switch (reply->format)
+	{
+	    case 8:
+		count  = wanted;
+		nBytes = count;
+		break;
+	    case 16:
+		count  = wanted / 2;
+		nBytes = count * sizeof (short);
+		break;
+	    case 32:
+		count  = wanted / 4;
+		nBytes = count * sizeof (long);
+		break;
+	    default:
+		return false;
+	}
+
+	data = (unsigned char *) malloc (nBytes + 1);
+
+	if (!data)
+	    return false;
+
+	const void *value = xcb_get_property_value (reply);
+
+	/* Xlib hands format 32 data out as longs, sign extended */
+	if (reply->format == 32)
+	{
+	    const uint32_t *src = (const uint32_t *) value;
+	    long           *dst = (long *) data;
+
+	    for (unsigned long i = 0; i < count; i++)
+		dst[i] = (int32_t) src[i];
+	}
+	else
+	    memcpy (data, value, nBytes);
+
+	data[nBytes] = '\0';
+    }
+    else
+	total = wanted = 0;
+
+    *actualType   = reply->type;
+    *actualFormat = reply->format;
+    *nItems       = count;
+    *bytesAfter   = total - wanted;
+    *prop         = data;
+
+    priv->release (it->second);
+    priv->properties.erase (it);
+    priv->served++;
+
+    return true;
+}
+
+unsigned int
+cw::PropertyPrefetch::served () const
+{
+    return priv->served;
+}
+
+cw::PropertyPrefetch::Scope::Scope (PropertyPrefetch &prefetch,
+				    Window           id) :
+    mPrefetch (prefetch),
+    mId (id)
+{
+    PrivatePropertyPrefetch::active       = &mPrefetch;
+    PrivatePropertyPrefetch::activeWindow = mId;
+}
+
+cw::PropertyPrefetch::Scope::~Scope ()
+{
+    PrivatePropertyPrefetch::active       = NULL;
+    PrivatePropertyPrefetch::activeWindow = None;
+
+    mPrefetch.priv->discard (mId);
+}
+
+cw::PropertyPrefetch *
+cw::PropertyPrefetch::active (Window id)
+{
+    if (id == None || id != PrivatePropertyPrefetch::activeWindow)
+	return NULL;
+
+    return PrivatePropertyPrefetch::active;
+}
+
+int
+cw::getWindowProperty (Display       *dpy,
+		       Window        id,
+		       Atom          property,
+		       long          offset,
+		       long          length,
+		       Bool          del,
+		       Atom          reqType,
+		       Atom          *actualType,
+		       int           *actualFormat,
+		       unsigned long *nItems,
+		       unsigned long *bytesAfter,
+		       unsigned char **prop)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+
+    if (prefetch && !offset && !del &&
+	prefetch->getProperty (id, property, length, reqType, actualType,
+			       actualFormat, nItems, bytesAfter, prop))
+	return Success;
+
+    return XGetWindowProperty (dpy, id, property, offset, length, del,
+			       reqType, actualType, actualFormat, nItems,
+			       bytesAfter, prop);
+}
+
+/* The hint readers below follow their Xlib counterparts, which do
+ * the same checks on the raw property data */
+
+XWMHints *
+cw::getWMHints (Display *dpy,
+		Window  id)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+    Atom             actualType;
+    int              actualFormat;
+    unsigned long    n, left;
+    unsigned char    *data;
+
+    if (!prefetch ||
+	!prefetch->getProperty (id, XA_WM_HINTS, WM_HINTS_ELEMENTS,
+				XA_WM_HINTS, &actualType, &actualFormat,
+				&n, &left, &data))
+	return XGetWMHints (dpy, id);
+
+    if (actualType != XA_WM_HINTS || actualFormat != 32 ||
+	n < (unsigned long) WM_HINTS_ELEMENTS - 1)
+    {
+	free (data);
+	return NULL;
+    }
+
+    const long *prop  = (const long *) data;
+    XWMHints   *hints = XAllocWMHints ();
+
+    if (hints)
+    {
+	hints->flags         = prop[0];
+	hints->input         = prop[1] ? True : False;
+	hints->initial_state = prop[2];
+	hints->icon_pixmap   = prop[3];
+	hints->icon_window   = prop[4];
+	hints->icon_x        = prop[5];
+	hints->icon_y        = prop[6];
+	hints->icon_mask     = prop[7];
+	hints->window_group  = n >= (unsigned long) WM_HINTS_ELEMENTS ? prop[8] : 0;
+    }
+
+    free (data);
+
+    return hints;
+}
+
+Status
+cw::getWMNormalHints (Display    *dpy,
+		      Window     id,
+		      XSizeHints *hints,
+		      long       *supplied)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+    Atom             actualType;
+    int              actualFormat;
+    unsigned long    n, left;
+    unsigned char    *data;
+
+    if (!prefetch ||
+	!prefetch->getProperty (id, XA_WM_NORMAL_HINTS, WM_SIZE_HINTS_ELEMENTS,
+				XA_WM_SIZE_HINTS, &actualType, &actualFormat,
+				&n, &left, &data))
+	return XGetWMNormalHints (dpy, id, hints, supplied);
+
+    if (actualType != XA_WM_SIZE_HINTS || actualFormat != 32 ||
+	n < (unsigned long) OLD_WM_SIZE_HINTS_ELEMENTS)
+    {
+	free (data);
+	return False;
+    }
+
+    const long *prop = (const long *) data;
+
+    hints->flags        = prop[0];
+    hints->x            = prop[1];
+    hints->y            = prop[2];
+    hints->width        = prop[3];
+    hints->height       = prop[4];
+    hints->min_width    = prop[5];
+    hints->min_height   = prop[6];
+    hints->max_width    = prop[7];
+    hints->max_height   = prop[8];
+    hints->width_inc    = prop[9];
+    hints->height_inc   = prop[10];
+    hints->min_aspect.x = prop[11];
+    hints->min_aspect.y = prop[12];
+    hints->max_aspect.x = prop[13];
+    hints->max_aspect.y = prop[14];
+
+    *supplied = USPosition | USSize | PAllHints;
+
+    if (n >= (unsigned long) WM_SIZE_HINTS_ELEMENTS)
+    {
+	hints->base_width  = prop[15];
+	hints->base_height = prop[16];
+	hints->win_gravity = prop[17];
+
+	*supplied |= PBaseSize | PWinGravity;
+    }
+
+    hints->flags &= *supplied;
+
+    free (data);
+
+    return True;
+}
+
+Status
+cw::getClassHint (Display    *dpy,
+		  Window     id,
+		  XClassHint *classHint)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+    Atom             actualType;
+    int              actualFormat;
+    unsigned long    n, left;
+    unsigned char    *data;
+
+    if (!prefetch ||
+	!prefetch->getProperty (id, XA_WM_CLASS, BUFSIZ, XA_STRING,
+				&actualType, &actualFormat, &n, &left, &data))
+	return XGetClassHint (dpy, id, classHint);
+
+    if (actualType != XA_STRING || actualFormat != 8)
+    {
+	free (data);
+	return 0;
+    }
+
+    /* res_name and res_class are two consecutive NUL terminated strings,
+     * though the second terminator is often left out */
+    size_t nameLength = strlen ((char *) data);
+
+    classHint->res_name = strdup ((char *) data);
+
+    if (nameLength == n)
+	nameLength--;
+
+    classHint->res_class = strdup ((char *) data + nameLength + 1);
+
+    free (data);
+
+    if (!classHint->res_name || !classHint->res_class)
+    {
+	free (classHint->res_name);
+	free (classHint->res_class);
+	return 0;
+    }
+
+    return 1;
+}
+
+Status
+cw::getTransientForHint (Display *dpy,
+			 Window  id,
+			 Window  *transientFor)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+    Atom             actualType;
+    int              actualFormat;
+    unsigned long    n, left;
+    unsigned char    *data;
+
+    if (!prefetch ||
+	!prefetch->getProperty (id, XA_WM_TRANSIENT_FOR, 1L, XA_WINDOW,
+				&actualType, &actualFormat, &n, &left, &data))
+	return XGetTransientForHint (dpy, id, transientFor);
+
+    Status status = 0;
+
+    *transientFor = None;
+
+    if (actualType == XA_WINDOW && actualFormat == 32 && n)
+    {
+	*transientFor = *(Window *) data;
+	status        = 1;
+    }
+
+    free (data);
+
+    return status;
+}
+
+Status
+cw::getWMProtocols (Display *dpy,
+		    Window  id,
+		    Atom    **protocols,
+		    int     *count)
+{
+    PropertyPrefetch *prefetch = PropertyPrefetch::active (id);
+    Atom             actualType;
+    int              actualFormat;
+    unsigned long    n, left;
+    unsigned char    *data;
+    Atom             wmProtocols = prefetch ?
+				   XInternAtom (dpy, "WM_PROTOCOLS", False) :
+				   None;
+
+    if (!prefetch || wmProtocols == None ||
+	!prefetch->getProperty (id, wmProtocols, 1000000L, XA_ATOM,
+				&actualType, &actualFormat, &n, &left, &data))
+	return XGetWMProtocols (dpy, id, protocols, count);
+
+    if (actualType != XA_ATOM || actualFormat != 32)
+    {
+	free (data);
+	return False;
+    }
+
+    *protocols = (Atom *) data;
+    *count     = (int) n;
+
+    return True;
+}
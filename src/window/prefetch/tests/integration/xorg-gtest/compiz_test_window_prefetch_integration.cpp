@@ -0,0 +1,572 @@
+/*
+ * Compiz XOrg GTest, pipelined window attribute and property reads
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <vector>
+#include <string.h>
+#include <time.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#include <xorg/gtest/xorg-gtest.h>
+
+#include "core/windowprefetch.h"
+
+namespace cw = compiz::window;
+
+namespace
+{
+const unsigned int BENCHMARK_WINDOWS = 300;
+
+struct PropertyRead
+{
+    PropertyRead () :
+	result (BadImplementation),
+	type (None),
+	format (0),
+	nItems (0),
+	bytesAfter (0),
+	data (NULL)
+    {
+    }
+
+    ~PropertyRead ()
+    {
+	if (data)
+	    XFree (data);
+    }
+
+    int           result;
+    Atom          type;
+    int           format;
+    unsigned long nItems;
+    unsigned long bytesAfter;
+    unsigned char *data;
+};
+
+size_t
+dataSize (const PropertyRead &read)
+{
+    switch (read.format)
+    {
+	case 16:
+	    return read.nItems * sizeof (short);
+	case 32:
+	    return read.nItems * sizeof (long);
+	default:
+	    return read.nItems;
+    }
+}
+
+void
+expectSameRead (const PropertyRead &expected,
+		const PropertyRead &actual)
+{
+    EXPECT_EQ (expected.result, actual.result);
+    EXPECT_EQ (expected.type, actual.type);
+    EXPECT_EQ (expected.format, actual.format);
+    EXPECT_EQ (expected.nItems, actual.nItems);
+    EXPECT_EQ (expected.bytesAfter, actual.bytesAfter);
+    ASSERT_EQ (expected.data == NULL, actual.data == NULL);
+
+    if (expected.data)
+    {
+	EXPECT_EQ (0, memcmp (expected.data, actual.data, dataSize (expected)));
+    }
+}
+
+double
+secondsSince (const struct timespec &start)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+}
+
+class WindowPrefetch :
+    public xorg::testing::Test
+{
+    public:
+
+	void SetUp ();
+	void TearDown ();
+
+    protected:
+
+	Window createWindow ();
+	void decorate (Window w, unsigned int n);
+
+	void readFromServer (Window       w,
+			     Atom         property,
+			     long         length,
+			     Atom         reqType,
+			     PropertyRead &read);
+	void readFromPrefetch (Window       w,
+			       Atom         property,
+			       long         length,
+			       Atom         reqType,
+			       PropertyRead &read);
+
+	std::vector<Atom>   properties;
+	std::vector<Window> windows;
+
+	Atom cardinalProperty;
+	Atom stringProperty;
+	Atom shortProperty;
+	Atom wmProtocols;
+	Atom wmDeleteWindow;
+};
+
+void
+WindowPrefetch::SetUp ()
+{
+    xorg::testing::Test::SetUp ();
+
+    cardinalProperty = XInternAtom (Display (), "_COMPIZ_TEST_CARDINAL", False);
+    stringProperty   = XInternAtom (Display (), "_COMPIZ_TEST_STRING", False);
+    shortProperty    = XInternAtom (Display (), "_COMPIZ_TEST_SHORT", False);
+    wmProtocols      = XInternAtom (Display (), "WM_PROTOCOLS", False);
+    wmDeleteWindow   = XInternAtom (Display (), "WM_DELETE_WINDOW", False);
+
+    properties.push_back (XA_WM_HINTS);
+    properties.push_back (XA_WM_NORMAL_HINTS);
+    properties.push_back (XA_WM_CLASS);
+    properties.push_back (XA_WM_TRANSIENT_FOR);
+    properties.push_back (wmProtocols);
+    properties.push_back (cardinalProperty);
+    properties.push_back (stringProperty);
+    properties.push_back (shortProperty);
+}
+
+void
+WindowPrefetch::TearDown ()
+{
+    for (std::vector<Window>::iterator it = windows.begin ();
+	 it != windows.end (); ++it)
+	XDestroyWindow (Display (), *it);
+
+    XSync (Display (), False);
+
+    xorg::testing::Test::TearDown ();
+}
+
+Window
+WindowPrefetch::createWindow ()
+{
+    Window w = XCreateSimpleWindow (Display (), DefaultRootWindow (Display ()),
+				    windows.size () % 100, 10, 100, 50, 1, 0, 0);
+
+    windows.push_back (w);
+
+    return w;
+}
+
+void
+WindowPrefetch::decorate (Window       w,
+			  unsigned int n)
+{
+    XWMHints hints;
+
+    hints.flags         = InputHint | StateHint | WindowGroupHint;
+    hints.input         = n % 2;
+    hints.initial_state = NormalState;
+    hints.window_group  = w;
+    XSetWMHints (Display (), w, &hints);
+
+    XSizeHints sizeHints;
+
+    sizeHints.flags       = PMinSize | PMaxSize | PBaseSize | PWinGravity;
+    sizeHints.min_width   = 10;
+    sizeHints.min_height  = 20 + n;
+    sizeHints.max_width   = 1000;
+    sizeHints.max_height  = 2000;
+    sizeHints.base_width  = 5;
+    sizeHints.base_height = 6;
+    sizeHints.win_gravity = StaticGravity;
+    XSetWMNormalHints (Display (), w, &sizeHints);
+
+    XClassHint classHint;
+
+    classHint.res_name  = const_cast <char *> ("prefetch");
+    classHint.res_class = const_cast <char *> ("Prefetch");
+    XSetClassHint (Display (), w, &classHint);
+
+    if (n)
+	XSetTransientForHint (Display (), w, windows.front ());
+
+    XSetWMProtocols (Display (), w, &wmDeleteWindow, 1);
+
+    long cardinals[] = { n, -1, 0x7fffffff, 3 };
+
+    XChangeProperty (Display (), w, cardinalProperty, XA_CARDINAL, 32,
+		     PropModeReplace, (unsigned char *) cardinals, 4);
+
+    const char *string = "a string property";
+
+    XChangeProperty (Display (), w, stringProperty, XA_STRING, 8,
+		     PropModeReplace, (const unsigned char *) string,
+		     strlen (string));
+
+    short shorts[] = { 1, -2, 3 };
+
+    XChangeProperty (Display (), w, shortProperty, XA_INTEGER, 16,
+		     PropModeReplace, (unsigned char *) shorts, 3);
+}
+
+void
+WindowPrefetch::readFromServer (Window       w,
+				Atom         property,
+				long         length,
+				Atom         reqType,
+				PropertyRead &read)
+{
+    read.result = XGetWindowProperty (Display (), w, property, 0L, length,
+				      False, reqType, &read.type,
+				      &read.format, &read.nItems,
+				      &read.bytesAfter, &read.data);
+}
+
+void
+WindowPrefetch::readFromPrefetch (Window       w,
+				  Atom         property,
+				  long         length,
+				  Atom         reqType,
+				  PropertyRead &read)
+{
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&w, 1, properties);
+    prefetch.collect ();
+
+    cw::PropertyPrefetch::Scope scope (prefetch, w);
+
+    read.result = cw::getWindowProperty (Display (), w, property, 0L, length,
+					 False, reqType, &read.type,
+					 &read.format, &read.nItems,
+					 &read.bytesAfter, &read.data);
+
+    EXPECT_EQ (1u, prefetch.served ());
+}
+
+TEST_F (WindowPrefetch, AttributesMatchXGetWindowAttributes)
+{
+    Window w = createWindow ();
+
+    XSelectInput (Display (), w, PropertyChangeMask);
+
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&w, 1, properties);
+    prefetch.collect ();
+
+    XWindowAttributes expected, actual;
+
+    ASSERT_TRUE (XGetWindowAttributes (Display (), w, &expected));
+    ASSERT_TRUE (prefetch.attributes (w, &actual));
+
+    EXPECT_EQ (expected.x, actual.x);
+    EXPECT_EQ (expected.y, actual.y);
+    EXPECT_EQ (expected.width, actual.width);
+    EXPECT_EQ (expected.height, actual.height);
+    EXPECT_EQ (expected.border_width, actual.border_width);
+    EXPECT_EQ (expected.depth, actual.depth);
+    EXPECT_EQ (expected.visual, actual.visual);
+    EXPECT_EQ (expected.root, actual.root);
+    EXPECT_EQ (expected.c_class, actual.c_class);
+    EXPECT_EQ (expected.bit_gravity, actual.bit_gravity);
+    EXPECT_EQ (expected.win_gravity, actual.win_gravity);
+    EXPECT_EQ (expected.backing_store, actual.backing_store);
+    EXPECT_EQ (expected.colormap, actual.colormap);
+    EXPECT_EQ (expected.map_state, actual.map_state);
+    EXPECT_EQ (expected.your_event_mask, actual.your_event_mask);
+    EXPECT_EQ (expected.override_redirect, actual.override_redirect);
+    EXPECT_EQ (expected.screen, actual.screen);
+}
+
+TEST_F (WindowPrefetch, PropertiesMatchXGetWindowProperty)
+{
+    Window w = createWindow ();
+
+    decorate (w, 0);
+
+    const Atom reqTypes[] = { AnyPropertyType, XA_CARDINAL, XA_STRING };
+    const long lengths[] = { 0, 1, 2, 4, 1024 };
+
+    for (std::vector<Atom>::iterator it = properties.begin ();
+	 it != properties.end (); ++it)
+	for (unsigned int t = 0; t < sizeof (reqTypes) / sizeof (Atom); t++)
+	    for (unsigned int l = 0; l < sizeof (lengths) / sizeof (long); l++)
+	    {
+		PropertyRead expected, actual;
+
+		readFromServer (w, *it, lengths[l], reqTypes[t], expected);
+		readFromPrefetch (w, *it, lengths[l], reqTypes[t], actual);
+
+		expectSameRead (expected, actual);
+	    }
+}
+
+TEST_F (WindowPrefetch, MissingPropertyMatchesXGetWindowProperty)
+{
+    Window w = createWindow ();
+
+    PropertyRead expected, actual;
+
+    readFromServer (w, cardinalProperty, 1L, XA_CARDINAL, expected);
+    readFromPrefetch (w, cardinalProperty, 1L, XA_CARDINAL, actual);
+
+    expectSameRead (expected, actual);
+}
+
+TEST_F (WindowPrefetch, HintsMatchXlib)
+{
+    Window w = createWindow ();
+
+    decorate (w, 0);
+    decorate (createWindow (), 1);
+
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&windows.front (), windows.size (), properties);
+    prefetch.collect ();
+
+    Window      t = windows.back ();
+    XWMHints    *expectedHints = XGetWMHints (Display (), t);
+    XSizeHints  expectedSize, actualSize;
+    long        expectedSupplied, actualSupplied;
+    XClassHint  expectedClass, actualClass;
+    Window      expectedTransient, actualTransient;
+    Atom        *expectedProtocols, *actualProtocols;
+    int         expectedCount, actualCount;
+
+    ASSERT_TRUE (XGetWMNormalHints (Display (), t, &expectedSize,
+				    &expectedSupplied));
+    ASSERT_TRUE (XGetClassHint (Display (), t, &expectedClass));
+    ASSERT_TRUE (XGetTransientForHint (Display (), t, &expectedTransient));
+    ASSERT_TRUE (XGetWMProtocols (Display (), t, &expectedProtocols,
+				  &expectedCount));
+
+    cw::PropertyPrefetch::Scope scope (prefetch, t);
+
+    XWMHints *actualHints = cw::getWMHints (Display (), t);
+
+    ASSERT_TRUE (cw::getWMNormalHints (Display (), t, &actualSize,
+				       &actualSupplied));
+    ASSERT_TRUE (cw::getClassHint (Display (), t, &actualClass));
+    ASSERT_TRUE (cw::getTransientForHint (Display (), t, &actualTransient));
+    ASSERT_TRUE (cw::getWMProtocols (Display (), t, &actualProtocols,
+				     &actualCount));
+
+    EXPECT_EQ (5u, prefetch.served ());
+
+    ASSERT_TRUE (expectedHints);
+    ASSERT_TRUE (actualHints);
+    EXPECT_EQ (expectedHints->flags, actualHints->flags);
+    EXPECT_EQ (expectedHints->input, actualHints->input);
+    EXPECT_EQ (expectedHints->initial_state, actualHints->initial_state);
+    EXPECT_EQ (expectedHints->window_group, actualHints->window_group);
+
+    EXPECT_EQ (expectedSupplied, actualSupplied);
+    EXPECT_EQ (expectedSize.flags, actualSize.flags);
+    EXPECT_EQ (expectedSize.min_height, actualSize.min_height);
+    EXPECT_EQ (expectedSize.max_width, actualSize.max_width);
+    EXPECT_EQ (expectedSize.base_width, actualSize.base_width);
+    EXPECT_EQ (expectedSize.win_gravity, actualSize.win_gravity);
+
+    EXPECT_STREQ (expectedClass.res_name, actualClass.res_name);
+    EXPECT_STREQ (expectedClass.res_class, actualClass.res_class);
+
+    EXPECT_EQ (expectedTransient, actualTransient);
+
+    ASSERT_EQ (expectedCount, actualCount);
+    EXPECT_EQ (expectedProtocols[0], actualProtocols[0]);
+
+    XFree (expectedHints);
+    XFree (actualHints);
+    XFree (expectedClass.res_name);
+    XFree (expectedClass.res_class);
+    XFree (actualClass.res_name);
+    XFree (actualClass.res_class);
+    XFree (expectedProtocols);
+    XFree (actualProtocols);
+}
+
+TEST_F (WindowPrefetch, ServedOnceAndOnlyInScope)
+{
+    Window w = createWindow ();
+    Window other = createWindow ();
+
+    decorate (w, 0);
+    decorate (other, 0);
+
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&windows.front (), windows.size (), properties);
+    prefetch.collect ();
+
+    EXPECT_TRUE (cw::PropertyPrefetch::active (w) == NULL);
+
+    {
+	cw::PropertyPrefetch::Scope scope (prefetch, w);
+
+	EXPECT_EQ (&prefetch, cw::PropertyPrefetch::active (w));
+	EXPECT_TRUE (cw::PropertyPrefetch::active (other) == NULL);
+
+	/* Changed after the prefetch, the first read still sees the
+	 * snapshot but the second one has to go to the server */
+	long value = 42;
+
+	XChangeProperty (Display (), w, cardinalProperty, XA_CARDINAL, 32,
+			 PropModeReplace, (unsigned char *) &value, 1);
+
+	PropertyRead first;
+
+	cw::getWindowProperty (Display (), w, cardinalProperty, 0L, 1L, False,
+			       XA_CARDINAL, &first.type, &first.format,
+			       &first.nItems, &first.bytesAfter, &first.data);
+	EXPECT_EQ (1u, prefetch.served ());
+	ASSERT_EQ (1u, first.nItems);
+	EXPECT_EQ (0, *(long *) first.data);
+
+	PropertyRead second, third;
+
+	readFromServer (w, cardinalProperty, 1L, XA_CARDINAL, second);
+	cw::getWindowProperty (Display (), w, cardinalProperty, 0L, 1L, False,
+			       XA_CARDINAL, &third.type, &third.format,
+			       &third.nItems, &third.bytesAfter, &third.data);
+	EXPECT_EQ (1u, prefetch.served ());
+
+	expectSameRead (second, third);
+    }
+
+    EXPECT_TRUE (cw::PropertyPrefetch::active (w) == NULL);
+
+    /* Dropped together with the scope */
+    cw::PropertyPrefetch::Scope scope (prefetch, w);
+    PropertyRead read;
+
+    cw::getWindowProperty (Display (), w, stringProperty, 0L, 1024L, False,
+			   AnyPropertyType, &read.type, &read.format,
+			   &read.nItems, &read.bytesAfter, &read.data);
+    EXPECT_EQ (1u, prefetch.served ());
+}
+
+TEST_F (WindowPrefetch, DestroyedWindowIsMissing)
+{
+    Window w = createWindow ();
+
+    decorate (w, 0);
+
+    windows.pop_back ();
+    XDestroyWindow (Display (), w);
+
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&w, 1, properties);
+    prefetch.collect ();
+
+    XWindowAttributes attrib;
+    PropertyRead      read;
+
+    EXPECT_FALSE (prefetch.attributes (w, &attrib));
+    EXPECT_FALSE (prefetch.getProperty (w, cardinalProperty, 1L, XA_CARDINAL,
+					&read.type, &read.format,
+					&read.nItems, &read.bytesAfter,
+					&read.data));
+}
+
+/* Not a pass / fail test as such: reads the same set of properties
+ * for BENCHMARK_WINDOWS windows once through Xlib and once through
+ * the prefetch and reports both timings */
+TEST_F (WindowPrefetch, BenchmarkAdoption)
+{
+    for (unsigned int i = 0; i < BENCHMARK_WINDOWS; i++)
+	decorate (createWindow (), i);
+
+    XSync (Display (), False);
+
+    struct timespec start;
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	XWindowAttributes attrib;
+
+	XGetWindowAttributes (Display (), windows[i], &attrib);
+
+	for (unsigned int p = 0; p < properties.size (); p++)
+	{
+	    PropertyRead read;
+
+	    readFromServer (windows[i], properties[p], 1024L,
+			    AnyPropertyType, read);
+	}
+    }
+
+    double sequential = secondsSince (start);
+
+    clock_gettime (CLOCK_MONOTONIC, &start);
+
+    cw::PropertyPrefetch prefetch (Display ());
+
+    prefetch.request (&windows.front (), windows.size (), properties);
+    prefetch.collect ();
+
+    for (unsigned int i = 0; i < windows.size (); i++)
+    {
+	XWindowAttributes           attrib;
+	cw::PropertyPrefetch::Scope scope (prefetch, windows[i]);
+
+	EXPECT_TRUE (prefetch.attributes (windows[i], &attrib));
+
+	for (unsigned int p = 0; p < properties.size (); p++)
+	{
+	    PropertyRead read;
+
+	    read.result = cw::getWindowProperty (Display (), windows[i],
+						 properties[p], 0L, 1024L,
+						 False, AnyPropertyType,
+						 &read.type, &read.format,
+						 &read.nItems,
+						 &read.bytesAfter, &read.data);
+	}
+    }
+
+    double pipelined = secondsSince (start);
+
+    EXPECT_EQ (windows.size () * properties.size (),
+	       (size_t) prefetch.served ());
+
+    std::cout << "[ BENCHMARK] " << windows.size () << " windows, "
+	      << properties.size () << " properties each: sequential "
+	      << sequential * 1000 << "ms, pipelined "
+	      << pipelined * 1000 << "ms" << std::endl;
+
+    RecordProperty ("sequential_us", (int) (sequential * 1e6));
+    RecordProperty ("pipelined_us", (int) (pipelined * 1e6));
+}
@@ -0,0 +1,97 @@
+/*
+ * Compiz, transient window index
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _COMPIZ_WINDOWTRANSIENTS_H
+#define _COMPIZ_WINDOWTRANSIENTS_H
+
+#include <map>
+#include <vector>
+
+#include <X11/Xlib.h>
+
+namespace compiz
+{
+namespace window
+{
+namespace transients
+{
+
+/**
+ * Who is transient for whom in one snapshot of the stack.
+ *
+ * Windows are added top-down and referred to by their position in
+ * that order, so every query answers top-down as well and costs only
+ * as much as the windows it returns, instead of a walk of the whole
+ * stack.
+ */
+class Index
+{
+    public:
+
+	typedef std::vector<unsigned int> Positions;
+
+	Index ();
+
+	/**
+	 * Adds the next window down the stack and returns its position.
+	 * groupTransient is whether the window is a group transient for
+	 * its own client leader.
+	 */
+	unsigned int add (Window id,
+			  Window transientFor,
+			  Window clientLeader,
+			  bool   groupTransient);
+
+	/**
+	 * Windows transient for id and, unless leader is None, the group
+	 * transients of leader, top-down
+	 */
+	void transients (Window    id,
+			 Window    leader,
+			 Positions &positions) const;
+
+	/**
+	 * Windows in the group of leader which are not transient for
+	 * anything, top-down
+	 */
+	const Positions & groupMembers (Window leader) const;
+
+	unsigned int size () const;
+	void clear ();
+
+    private:
+
+	typedef std::map<Window, Positions> PositionMap;
+
+	static const Positions & find (const PositionMap &map, Window id);
+
+	PositionMap  mTransients;
+	PositionMap  mGroupTransients;
+	PositionMap  mGroupMembers;
+	unsigned int mSize;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Compiz, transient window index
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include "core/windowtransients.h"
+
+namespace cwt = compiz::window::transients;
+
+namespace
+{
+const cwt::Index::Positions noPositions;
+}
+
+cwt::Index::Index () :
+    mSize (0)
+{
+}
+
+unsigned int
+cwt::Index::add (Window id,
+		 Window transientFor,
+		 Window clientLeader,
+		 bool   groupTransient)
+{
+    unsigned int position = mSize++;
+
+    if (transientFor)
+	mTransients[transientFor].push_back (position);
+
+    if (clientLeader)
+    {
+	if (groupTransient)
+	    mGroupTransients[clientLeader].push_back (position);
+	else if (transientFor == None)
+	    mGroupMembers[clientLeader].push_back (position);
+    }
+
+    return position;
+}
+
+const cwt::Index::Positions &
+cwt::Index::find (const PositionMap &map,
+		  Window            id)
+{
+    PositionMap::const_iterator it = map.find (id);
+
+    return it != map.end () ? it->second : noPositions;
+}
+
+void
+cwt::Index::transients (Window    id,
+			Window    leader,
+			Positions &positions) const
+{
+    const Positions &direct = find (mTransients, id);
+    const Positions &group  = leader ? find (mGroupTransients, leader) :
+				       noPositions;
+
+    positions.clear ();
+    positions.reserve (direct.size () + group.size ());
+
+    /* Both are already top-down */
+    std::set_union (direct.begin (), direct.end (),
+		    group.begin (), group.end (),
+		    std::back_inserter (positions));
+}
+
+const cwt::Index::Positions &
+cwt::Index::groupMembers (Window leader) const
+{
+    return find (mGroupMembers, leader);
+}
+
+unsigned int
+cwt::Index::size () const
+{
+    return mSize;
+}
+
+void
+cwt::Index::clear ()
+{
+    mTransients.clear ();
+    mGroupTransients.clear ();
+    mGroupMembers.clear ();
+    mSize = 0;
+}
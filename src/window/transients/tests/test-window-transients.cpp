@@ -0,0 +1,106 @@
+/*
+ * Compiz, transient window index
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <core/windowtransients.h>
+
+namespace cwt = compiz::window::transients;
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace
+{
+const Window LEADER = 1;
+const Window MAIN = 2;
+const Window DIALOG = 3;
+const Window TOOLBOX = 4;
+const Window NESTED = 5;
+const Window OTHER = 6;
+}
+
+class TransientIndex :
+    public ::testing::Test
+{
+    public:
+
+	cwt::Index           index;
+	cwt::Index::Positions positions;
+};
+
+TEST_F (TransientIndex, PositionsCountFromTheTop)
+{
+    EXPECT_EQ (0, index.add (DIALOG, MAIN, None, false));
+    EXPECT_EQ (1, index.add (MAIN, None, None, false));
+    EXPECT_EQ (2, index.size ());
+
+    index.clear ();
+
+    EXPECT_EQ (0, index.size ());
+    EXPECT_EQ (0, index.add (MAIN, None, None, false));
+}
+
+TEST_F (TransientIndex, FindsDirectTransientsOnly)
+{
+    index.add (NESTED, DIALOG, None, false);
+    index.add (OTHER, None, None, false);
+    index.add (DIALOG, MAIN, None, false);
+    index.add (MAIN, None, None, false);
+
+    index.transients (MAIN, None, positions);
+    EXPECT_THAT (positions, ElementsAre (2));
+
+    index.transients (DIALOG, None, positions);
+    EXPECT_THAT (positions, ElementsAre (0));
+
+    index.transients (OTHER, None, positions);
+    EXPECT_THAT (positions, IsEmpty ());
+}
+
+TEST_F (TransientIndex, MergesGroupTransientsTopDown)
+{
+    index.add (TOOLBOX, None, LEADER, true);
+    index.add (OTHER, None, None, false);
+    index.add (DIALOG, MAIN, LEADER, false);
+    index.add (NESTED, None, LEADER, true);
+    index.add (MAIN, None, LEADER, false);
+
+    index.transients (MAIN, LEADER, positions);
+    EXPECT_THAT (positions, ElementsAre (0, 2, 3));
+
+    /* Without a leader only the direct ones */
+    index.transients (MAIN, None, positions);
+    EXPECT_THAT (positions, ElementsAre (2));
+}
+
+TEST_F (TransientIndex, GroupMembersAreNotTransientForAnything)
+{
+    index.add (TOOLBOX, None, LEADER, true);
+    index.add (DIALOG, MAIN, LEADER, false);
+    index.add (OTHER, None, LEADER, false);
+    index.add (MAIN, None, LEADER, false);
+
+    EXPECT_THAT (index.groupMembers (LEADER), ElementsAre (2, 3));
+    EXPECT_THAT (index.groupMembers (OTHER), IsEmpty ());
+}